@@ -0,0 +1,510 @@
+#include "capture_log.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+
+#ifndef _WIN32
+    #include <algorithm>
+    #include <chrono>
+    #include <filesystem>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+LineFramer::LineFramer(LineHandler handler, size_t maxLineSize)
+    : handler(std::move(handler)), maxLineSize(maxLineSize) {
+}
+
+namespace {
+
+// 不超过 limit 的最长前缀长度（data 至少有 limit + 1 字节），且不在 UTF-8 多字节字符中间结束
+size_t utf8Prefix(const char* data, size_t limit) {
+    size_t size = limit;
+    while (size > 0 && (static_cast<unsigned char>(data[size]) & 0xC0) == 0x80) {
+        size--;
+    }
+    return size > 0 ? size : limit;
+}
+
+} // namespace
+
+void LineFramer::append(const OutputChunk& chunk) {
+    Pending& pending = this->pending[chunk.stream == OutputStream::Stderr ? 1 : 0];
+    const char* data = chunk.data;
+    size_t size = chunk.size;
+    while (size > 0) {
+        const char* newline = static_cast<const char*>(std::memchr(data, '\n', size));
+        if (newline == nullptr) {
+            pending.data.append(data, size);
+            pending.timestampNs = chunk.timestampNs;
+            if (pending.data.size() > maxLineSize) {
+                pending.data.erase(0, emitLine(chunk.stream, chunk.timestampNs, pending.data.data(),
+                                               pending.data.size(), false));
+            }
+            return;
+        }
+
+        size_t lineSize = static_cast<size_t>(newline - data) + 1;
+        if (pending.data.empty()) {
+            // 常见情形：整行都在这段输出中，不复制
+            emitLine(chunk.stream, chunk.timestampNs, data, lineSize, true);
+        } else {
+            pending.data.append(data, lineSize);
+            emitLine(chunk.stream, chunk.timestampNs, pending.data.data(), pending.data.size(), true);
+            pending.data.clear();
+        }
+        data += lineSize;
+        size -= lineSize;
+    }
+}
+
+void LineFramer::flush() {
+    for (int i = 0; i < 2; i++) {
+        if (!pending[i].data.empty()) {
+            emitLine(i == 1 ? OutputStream::Stderr : OutputStream::Stdout, pending[i].timestampNs,
+                     pending[i].data.data(), pending[i].data.size(), true);
+            pending[i].data.clear();
+        }
+    }
+}
+
+size_t LineFramer::emitLine(OutputStream stream, int64_t timestampNs, const char* data, size_t size, bool complete) {
+    size_t emitted = 0;
+    while (size - emitted > maxLineSize) {
+        size_t part = utf8Prefix(data + emitted, maxLineSize);
+        handler(stream, timestampNs, data + emitted, part);
+        emitted += part;
+    }
+    if (complete && emitted < size) {
+        handler(stream, timestampNs, data + emitted, size - emitted);
+        emitted = size;
+    }
+    return emitted;
+}
+
+size_t TimestampFormatter::format(int64_t unixNs, char* out) {
+    int64_t second = unixNs / 1000000000;
+    int64_t remainder = unixNs % 1000000000;
+    if (remainder < 0) {
+        second--;
+        remainder += 1000000000;
+    }
+
+    if (second != cachedSecond) {
+        std::time_t time = static_cast<std::time_t>(second);
+        std::tm local{};
+#ifdef _WIN32
+        localtime_s(&local, &time);
+#else
+        localtime_r(&time, &local);
+#endif
+        char text[72];  // 按各字段 int 的最大宽度留足空间，实际只用前 19 个字符
+        std::snprintf(text, sizeof(text), "%04d-%02d-%02d %02d:%02d:%02d", local.tm_year + 1900, local.tm_mon + 1,
+                      local.tm_mday, local.tm_hour, local.tm_min, local.tm_sec);
+        std::memcpy(cached, text, sizeof(cached));
+        cachedSecond = second;
+    }
+
+    int millis = static_cast<int>(remainder / 1000000);
+    std::memcpy(out, cached, sizeof(cached));
+    out[19] = '.';
+    out[20] = static_cast<char>('0' + millis / 100);
+    out[21] = static_cast<char>('0' + millis / 10 % 10);
+    out[22] = static_cast<char>('0' + millis % 10);
+    return kLength;
+}
+
+#ifndef _WIN32
+
+namespace {
+
+const char kSegmentMagic[8] = {'S', 'C', 'L', 'O', 'G', 'S', '0', '1'};
+const char kIndexMagic[8] = {'S', 'C', 'L', 'O', 'G', 'I', '0', '1'};
+const size_t kWriteBufferSize = 1024 * 1024;
+
+// 分段中每行之前的记录头
+struct SegmentRecord {
+    uint32_t size;      // 行的字节数
+    uint8_t stream;     // OutputStream 或 kCaptureLogEvent
+    uint8_t reserved[3];
+    int64_t monotonicNs;
+    int64_t unixNs;
+};
+
+// 索引项：分段中从 offset 开始的记录，时间不早于 unixNs
+struct IndexEntry {
+    int64_t unixNs;
+    uint64_t offset;
+};
+
+static_assert(sizeof(SegmentRecord) == 24, "segment record layout");
+static_assert(sizeof(IndexEntry) == 16, "index entry layout");
+
+// 分段文件名：20 位补零的起始 Unix 纳秒，按名字排序即按时间排序
+std::string segmentName(int64_t unixNs) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%020lld", static_cast<long long>(unixNs));
+    return name;
+}
+
+bool parseSegmentName(const std::string& fileName, int64_t& unixNs) {
+    if (fileName.size() != 24 || fileName.compare(20, 4, ".seg") != 0) {
+        return false;
+    }
+    unixNs = 0;
+    for (size_t i = 0; i < 20; i++) {
+        if (fileName[i] < '0' || fileName[i] > '9') {
+            return false;
+        }
+        unixNs = unixNs * 10 + (fileName[i] - '0');
+    }
+    return true;
+}
+
+std::string indexName(const std::string& segment) {
+    return segment.substr(0, segment.size() - 4) + ".idx";
+}
+
+bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+void appendBytes(std::vector<char>& buffer, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    buffer.insert(buffer.end(), bytes, bytes + size);
+}
+
+} // namespace
+
+CaptureLogWriter::~CaptureLogWriter() {
+    flush();
+    closeSegment();
+}
+
+bool CaptureLogWriter::open(const std::string& dir, uint64_t maxSegmentSize, uint64_t maxSize) {
+    std::error_code error;
+    std::filesystem::create_directories(dir, error);
+    if (error) {
+        std::cerr << u8"无法创建捕获日志目录: " << dir << std::endl;
+        return false;
+    }
+
+    segments.clear();
+    for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(dir, error)) {
+        int64_t startNs = 0;
+        std::string fileName = entry.path().filename().string();
+        if (parseSegmentName(fileName, startNs)) {
+            segments.emplace_back(fileName, static_cast<uint64_t>(entry.file_size(error)));
+        }
+    }
+    std::sort(segments.begin(), segments.end());
+
+    directory = dir;
+    segmentSize = maxSegmentSize;
+    maxTotalSize = maxSize;
+    anchorUnixNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    anchorMonotonicNs = monotonicNanos();
+    failed = false;
+    enforceRetention();
+    return true;
+}
+
+void CaptureLogWriter::append(uint8_t stream, int64_t monotonicNs, const char* data, size_t size) {
+    if (!isOpen()) {
+        return;
+    }
+
+    int64_t unixNs = anchorUnixNs + (monotonicNs - anchorMonotonicNs);
+    uint64_t recordSize = sizeof(SegmentRecord) + size;
+    if (segmentFd == -1 || (segmentBytes + recordSize > segmentSize && segmentBytes > sizeof(kSegmentMagic))) {
+        flush();
+        closeSegment();
+        enforceRetention();
+        if (!openSegment(unixNs)) {
+            failed = true;
+            return;
+        }
+    }
+
+    if (!indexed || segmentBytes - lastIndexedOffset >= kCaptureIndexInterval) {
+        IndexEntry entry = {unixNs, segmentBytes};
+        appendBytes(indexBuffer, &entry, sizeof(entry));
+        lastIndexedOffset = segmentBytes;
+        indexed = true;
+    }
+
+    SegmentRecord record = {};
+    record.size = static_cast<uint32_t>(size);
+    record.stream = stream;
+    record.monotonicNs = monotonicNs;
+    record.unixNs = unixNs;
+    appendBytes(segmentBuffer, &record, sizeof(record));
+    appendBytes(segmentBuffer, data, size);
+    segmentBytes += recordSize;
+
+    if (segmentBuffer.size() >= kWriteBufferSize) {
+        flush();
+    }
+}
+
+void CaptureLogWriter::flush() {
+    if (segmentFd == -1 || (segmentBuffer.empty() && indexBuffer.empty())) {
+        return;
+    }
+    // 先写数据再写索引，索引项不会指向尚未写入的数据
+    if (!writeAll(segmentFd, segmentBuffer.data(), segmentBuffer.size()) ||
+        !writeAll(indexFd, indexBuffer.data(), indexBuffer.size())) {
+        std::cerr << u8"写入捕获日志失败，停止记录: " << directory << std::endl;
+        failed = true;
+        closeSegment();
+    }
+    segmentBuffer.clear();
+    indexBuffer.clear();
+    if (!segments.empty()) {
+        segments.back().second = segmentBytes;
+    }
+}
+
+bool CaptureLogWriter::openSegment(int64_t unixNs) {
+    // 同一纳秒内不会有两个分段，名字冲突时顺延
+    std::string name;
+    for (int attempt = 0; attempt < 16 && segmentFd == -1; attempt++) {
+        name = segmentName(unixNs + attempt) + ".seg";
+        segmentFd = ::open((directory + "/" + name).c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    }
+    if (segmentFd == -1) {
+        std::cerr << u8"无法创建捕获日志分段: " << directory << std::endl;
+        return false;
+    }
+    indexFd = ::open((directory + "/" + indexName(name)).c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (indexFd == -1) {
+        std::cerr << u8"无法创建捕获日志索引: " << directory << std::endl;
+        close(segmentFd);
+        segmentFd = -1;
+        return false;
+    }
+
+    appendBytes(segmentBuffer, kSegmentMagic, sizeof(kSegmentMagic));
+    appendBytes(indexBuffer, kIndexMagic, sizeof(kIndexMagic));
+    segmentBytes = sizeof(kSegmentMagic);
+    lastIndexedOffset = 0;
+    indexed = false;
+    segments.emplace_back(name, segmentBytes);
+    return true;
+}
+
+void CaptureLogWriter::closeSegment() {
+    if (segmentFd != -1) {
+        close(segmentFd);
+        segmentFd = -1;
+    }
+    if (indexFd != -1) {
+        close(indexFd);
+        indexFd = -1;
+    }
+}
+
+void CaptureLogWriter::enforceRetention() {
+    uint64_t total = 0;
+    for (const auto& segment : segments) {
+        total += segment.second;
+    }
+    // 正在写入的分段不删除
+    size_t keep = segmentFd != -1 ? 1 : 0;
+    while (total > maxTotalSize && segments.size() > keep) {
+        const std::string& oldest = segments.front().first;
+        std::remove((directory + "/" + oldest).c_str());
+        std::remove((directory + "/" + indexName(oldest)).c_str());
+        total -= segments.front().second;
+        segments.erase(segments.begin());
+    }
+}
+
+namespace {
+
+// 顺序读取一个分段中的记录，读取量与返回的记录数成正比
+class SegmentScanner {
+public:
+    SegmentScanner(int fd, uint64_t offset) : fd(fd), offset(offset) {}
+
+    // 读出下一条记录；到达文件末尾或遇到写了一半的记录时返回 false
+    bool next(SegmentRecord& record, std::string& text) {
+        if (!fill(sizeof(SegmentRecord))) {
+            return false;
+        }
+        std::memcpy(&record, buffer.data() + position, sizeof(record));
+        if (!fill(sizeof(SegmentRecord) + record.size)) {
+            return false;
+        }
+        text.assign(buffer.data() + position + sizeof(record), record.size);
+        position += sizeof(record) + record.size;
+        return true;
+    }
+
+private:
+    // 保证缓冲区中从 position 起至少有 size 字节
+    bool fill(size_t size) {
+        if (end - position >= size) {
+            return true;
+        }
+        buffer.erase(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(position));
+        end -= position;
+        position = 0;
+        buffer.resize(std::max(size, kReadSize) + end);
+        while (end < size) {
+            ssize_t bytesRead = pread(fd, buffer.data() + end, buffer.size() - end, static_cast<off_t>(offset));
+            if (bytesRead < 0 && errno == EINTR) {
+                continue;
+            }
+            if (bytesRead <= 0) {
+                return false;
+            }
+            end += static_cast<size_t>(bytesRead);
+            offset += static_cast<uint64_t>(bytesRead);
+        }
+        return true;
+    }
+
+    static constexpr size_t kReadSize = 256 * 1024;
+
+    int fd;
+    uint64_t offset;             // 下一次读取的文件位置
+    std::vector<char> buffer;
+    size_t position = 0;         // 下一条记录在 buffer 中的位置
+    size_t end = 0;              // buffer 中有效数据的末尾
+};
+
+// 在分段的索引中二分查找：返回时间不晚于 unixNs 的最后一个索引项指向的偏移，没有时为首条记录
+uint64_t seekIndex(const std::string& indexPath, int64_t unixNs) {
+    uint64_t offset = sizeof(kSegmentMagic);
+    int fd = open(indexPath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return offset;
+    }
+    off_t size = lseek(fd, 0, SEEK_END);
+    size_t count = size > static_cast<off_t>(sizeof(kIndexMagic)) ?
+                   (static_cast<size_t>(size) - sizeof(kIndexMagic)) / sizeof(IndexEntry) : 0;
+    size_t low = 0;
+    size_t high = count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        IndexEntry entry;
+        off_t position = static_cast<off_t>(sizeof(kIndexMagic) + middle * sizeof(IndexEntry));
+        if (pread(fd, &entry, sizeof(entry), position) != static_cast<ssize_t>(sizeof(entry))) {
+            break;
+        }
+        if (entry.unixNs <= unixNs) {
+            offset = entry.offset;
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    close(fd);
+    return offset;
+}
+
+} // namespace
+
+bool CaptureLogReader::open(const std::string& dir) {
+    std::error_code error;
+    std::filesystem::directory_iterator iterator(dir, error);
+    if (error) {
+        std::cerr << u8"无法打开捕获日志目录: " << dir << std::endl;
+        return false;
+    }
+    directory = dir;
+    segments.clear();
+    for (const std::filesystem::directory_entry& entry : iterator) {
+        int64_t startNs = 0;
+        std::string fileName = entry.path().filename().string();
+        if (parseSegmentName(fileName, startNs)) {
+            segments.emplace_back(startNs, fileName);
+        }
+    }
+    std::sort(segments.begin(), segments.end());
+    return true;
+}
+
+bool CaptureLogReader::lastTimestamp(int64_t& unixNs) const {
+    // 从最后一个分段的最后一个索引项开始向后读，至多读 kCaptureIndexInterval 左右的数据
+    for (auto segment = segments.rbegin(); segment != segments.rend(); ++segment) {
+        std::string path = directory + "/" + segment->second;
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1) {
+            continue;
+        }
+        SegmentScanner scanner(fd, seekIndex(directory + "/" + indexName(segment->second), INT64_MAX));
+        SegmentRecord record;
+        std::string text;
+        bool found = false;
+        while (scanner.next(record, text)) {
+            unixNs = record.unixNs;
+            found = true;
+        }
+        close(fd);
+        if (found) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CaptureLogReader::query(int64_t fromUnixNs, int64_t toUnixNs,
+                             const std::function<bool(const CaptureLogLine&)>& visitor) const {
+    // 起始时间不晚于 fromUnixNs 的最后一个分段，其中可能包含起点
+    auto first = std::upper_bound(segments.begin(), segments.end(), fromUnixNs,
+                                  [](int64_t value, const std::pair<int64_t, std::string>& segment) {
+                                      return value < segment.first;
+                                  });
+    if (first != segments.begin()) {
+        --first;
+    }
+
+    CaptureLogLine line;
+    for (auto segment = first; segment != segments.end() && segment->first <= toUnixNs; ++segment) {
+        std::string path = directory + "/" + segment->second;
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1) {
+            continue;
+        }
+        SegmentScanner scanner(fd, seekIndex(directory + "/" + indexName(segment->second), fromUnixNs));
+        SegmentRecord record;
+        bool stop = false;
+        while (!stop && scanner.next(record, line.text)) {
+            if (record.unixNs > toUnixNs) {
+                // 同一分段内时间不倒退，后面的记录都在范围之外
+                break;
+            }
+            if (record.unixNs < fromUnixNs) {
+                continue;
+            }
+            line.stream = record.stream;
+            line.monotonicNs = record.monotonicNs;
+            line.unixNs = record.unixNs;
+            stop = !visitor(line);
+        }
+        close(fd);
+        if (stop) {
+            break;
+        }
+    }
+    return true;
+}
+
+#endif // _WIN32
@@ -0,0 +1,131 @@
+#ifndef CAPTURE_LOG_H
+#define CAPTURE_LOG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "output_buffer.h"
+
+// 把管道中任意切分的输出整理成完整的行，行尾的 '\n' 保留在行内。每行的时间戳是这一行最后一段
+// 输出到达的时刻，因此按回调顺序（跨 stdout 与 stderr）时间不会倒退。
+// 超过 maxLineSize 的行在 UTF-8 字符边界处拆开，不会把多字节字符切成两半
+class LineFramer {
+public:
+    using LineHandler = std::function<void(OutputStream stream, int64_t timestampNs, const char* data, size_t size)>;
+
+    explicit LineFramer(LineHandler handler, size_t maxLineSize = 64 * 1024);
+
+    void append(const OutputChunk& chunk);
+
+    // 子进程退出后输出尚未以换行结束的最后一行
+    void flush();
+
+private:
+    struct Pending {
+        std::string data;
+        int64_t timestampNs = 0;  // 最近一段输出的到达时刻
+    };
+
+    // 按 maxLineSize 拆分后交给 handler；complete 为 false 时不超过 maxLineSize 的剩余部分留待后续输出，
+    // 返回已交出的字节数
+    size_t emitLine(OutputStream stream, int64_t timestampNs, const char* data, size_t size, bool complete);
+
+    LineHandler handler;
+    size_t maxLineSize;
+    Pending pending[2];  // stdout、stderr
+};
+
+// 把 Unix 纳秒时间格式化为本地时间 "YYYY-MM-DD HH:MM:SS.mmm"。
+// 同一秒内只格式化一次日期时间部分，逐行调用时不经过 stringstream 或 put_time
+class TimestampFormatter {
+public:
+    static constexpr size_t kLength = 23;
+
+    // 写入 out（至少 kLength 字节，不含结尾的 '\0'），返回写入的长度
+    size_t format(int64_t unixNs, char* out);
+
+private:
+    int64_t cachedSecond = INT64_MIN;
+    char cached[19];
+};
+
+// 捕获日志中启动器自己写入的事件（子进程启动、退出），与 stdout、stderr 的编号不重叠
+constexpr uint8_t kCaptureLogEvent = 3;
+
+// 捕获日志中的一行
+struct CaptureLogLine {
+    uint8_t stream = 0;       // OutputStream 或 kCaptureLogEvent
+    int64_t monotonicNs = 0;
+    int64_t unixNs = 0;
+    std::string text;
+};
+
+#ifndef _WIN32
+
+// 只追加的分段捕获日志：目录中的每个分段 <起始 Unix 纳秒>.seg 依次保存各行，旁边的 .idx 是稀疏的
+// 时间 -> 偏移索引（每隔约 kCaptureIndexInterval 字节一项）。行的墙上时间由打开时的墙上时钟加上
+// 单调时钟的增量得出，同一次运行内不会倒退，因此可以二分查找。
+// 分段超过 segmentSize 后换新分段，全部分段超过 maxTotalSize 时删除最旧的分段
+constexpr uint64_t kCaptureIndexInterval = 64 * 1024;
+
+class CaptureLogWriter {
+public:
+    CaptureLogWriter() = default;
+    ~CaptureLogWriter();
+    CaptureLogWriter(const CaptureLogWriter&) = delete;
+    CaptureLogWriter& operator=(const CaptureLogWriter&) = delete;
+
+    // 创建目录并读取已有分段的大小；第一行写入时才创建新的分段
+    bool open(const std::string& directory, uint64_t segmentSize, uint64_t maxTotalSize);
+    bool isOpen() const { return !directory.empty() && !failed; }
+
+    // 追加一行（stream 为 OutputStream 或 kCaptureLogEvent），数据先进入缓冲区
+    void append(uint8_t stream, int64_t monotonicNs, const char* data, size_t size);
+
+    // 把缓冲区写入文件，每批输出处理完后调用
+    void flush();
+
+private:
+    bool openSegment(int64_t unixNs);
+    void closeSegment();
+    void enforceRetention();
+
+    std::string directory;
+    uint64_t segmentSize = 0;
+    uint64_t maxTotalSize = 0;
+    int64_t anchorUnixNs = 0;
+    int64_t anchorMonotonicNs = 0;
+
+    int segmentFd = -1;
+    int indexFd = -1;
+    uint64_t segmentBytes = 0;      // 当前分段已写入（含缓冲区中）的字节数
+    uint64_t lastIndexedOffset = 0;
+    bool indexed = false;           // 当前分段是否已有索引项
+    std::vector<char> segmentBuffer;
+    std::vector<char> indexBuffer;
+    std::vector<std::pair<std::string, uint64_t>> segments;  // (分段名, 大小)，按时间排序，含当前分段
+    bool failed = false;
+};
+
+// 按时间范围读取捕获日志：在分段名与索引中二分查找起点，只读取与结果相邻的数据
+class CaptureLogReader {
+public:
+    bool open(const std::string& directory);
+
+    // 日志中最后一行的墙上时间，日志为空时返回 false
+    bool lastTimestamp(int64_t& unixNs) const;
+
+    // 依次回调 [fromUnixNs, toUnixNs] 之间的每一行，visitor 返回 false 时停止
+    bool query(int64_t fromUnixNs, int64_t toUnixNs, const std::function<bool(const CaptureLogLine&)>& visitor) const;
+
+private:
+    std::string directory;
+    std::vector<std::pair<int64_t, std::string>> segments;  // (起始时间, 分段名)
+};
+
+#endif // _WIN32
+
+#endif // CAPTURE_LOG_H
@@ -0,0 +1,150 @@
+// 按时间范围查询启动器写出的分段捕获日志（--capture-log），把匹配的行连同时间戳打印到标准输出
+#include "capture_log.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <string>
+
+namespace {
+
+// 解析 "YYYY-MM-DD HH:MM:SS[.mmm]"（本地时间）或 Unix 毫秒，结果为 Unix 纳秒
+bool parseTime(const std::string& text, int64_t& unixNs) {
+    if (!text.empty() && text.find_first_not_of("0123456789") == std::string::npos) {
+        unixNs = std::strtoll(text.c_str(), nullptr, 10) * 1000000;
+        return true;
+    }
+    std::tm local{};
+    int millis = 0;
+    int fields = std::sscanf(text.c_str(), "%d-%d-%d %d:%d:%d.%3d", &local.tm_year, &local.tm_mon, &local.tm_mday,
+                             &local.tm_hour, &local.tm_min, &local.tm_sec, &millis);
+    if (fields < 6) {
+        return false;
+    }
+    local.tm_year -= 1900;
+    local.tm_mon -= 1;
+    local.tm_isdst = -1;
+    std::time_t seconds = std::mktime(&local);
+    if (seconds == -1) {
+        return false;
+    }
+    unixNs = static_cast<int64_t>(seconds) * 1000000000 + static_cast<int64_t>(millis) * 1000000;
+    return true;
+}
+
+// 解析 "5s"、"500ms"、"2m"、"1h" 形式的时长，不带单位时按秒计算，结果为纳秒
+bool parseDuration(const std::string& text, int64_t& durationNs) {
+    char* end = nullptr;
+    double value = std::strtod(text.c_str(), &end);
+    if (end == text.c_str() || value < 0) {
+        return false;
+    }
+    std::string unit(end);
+    double scale = unit.empty() || unit == "s" ? 1e9 :
+                   unit == "ms" ? 1e6 :
+                   unit == "m" ? 60e9 :
+                   unit == "h" ? 3600e9 : 0;
+    if (scale == 0) {
+        return false;
+    }
+    durationNs = static_cast<int64_t>(value * scale);
+    return true;
+}
+
+const char* streamName(uint8_t stream) {
+    switch (stream) {
+        case static_cast<uint8_t>(OutputStream::Stdout):
+            return "out";
+        case static_cast<uint8_t>(OutputStream::Stderr):
+            return "err";
+        default:
+            return "---";
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        std::cerr << u8"用法: " << argv[0]
+                  << u8" <捕获日志目录> [--from=时间] [--to=时间] [--last=时长] [--stream=stdout|stderr] [--raw]\n"
+                  << u8"  时间: \"YYYY-MM-DD HH:MM:SS[.mmm]\"（本地时间）或 Unix 毫秒\n"
+                  << u8"  --last: 日志最后一行（子进程退出时即退出事件）之前的时长，如 5s、500ms、2m\n"
+                  << u8"  --raw: 只输出原始内容，不加时间戳与来源" << std::endl;
+        return 2;
+    }
+
+    int64_t from = INT64_MIN;
+    int64_t to = INT64_MAX;
+    int64_t lastNs = -1;
+    bool hasTo = false;
+    uint8_t onlyStream = 0;
+    bool raw = false;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+        bool valid = true;
+        if (key == "--from") {
+            valid = parseTime(value, from);
+        } else if (key == "--to") {
+            valid = parseTime(value, to);
+            hasTo = true;
+        } else if (key == "--last") {
+            valid = parseDuration(value, lastNs);
+        } else if (key == "--stream") {
+            onlyStream = static_cast<uint8_t>(value == "stdout" ? OutputStream::Stdout : OutputStream::Stderr);
+            valid = value == "stdout" || value == "stderr";
+        } else if (key == "--raw") {
+            raw = true;
+        } else {
+            valid = false;
+        }
+        if (!valid) {
+            std::cerr << u8"无效的参数: " << arg << std::endl;
+            return 2;
+        }
+    }
+
+    CaptureLogReader reader;
+    if (!reader.open(argv[1])) {
+        return 1;
+    }
+    if (lastNs >= 0) {
+        if (!hasTo && !reader.lastTimestamp(to)) {
+            std::cerr << u8"捕获日志为空: " << argv[1] << std::endl;
+            return 1;
+        }
+        from = to - lastNs;
+    }
+
+    static char outputBuffer[1 << 16];
+    std::setvbuf(stdout, outputBuffer, _IOFBF, sizeof(outputBuffer));
+    TimestampFormatter formatter;
+    reader.query(from, to, [&](const CaptureLogLine& line) {
+        // 只输出原始内容时不包含启动器写入的事件
+        if ((onlyStream != 0 && line.stream != onlyStream) || (raw && line.stream == kCaptureLogEvent)) {
+            return true;
+        }
+        if (!raw) {
+            char prefix[TimestampFormatter::kLength + 8];
+            size_t length = formatter.format(line.unixNs, prefix);
+            prefix[length++] = ' ';
+            std::memcpy(prefix + length, streamName(line.stream), 3);
+            length += 3;
+            prefix[length++] = ' ';
+            std::fwrite(prefix, 1, length, stdout);
+        }
+        std::fwrite(line.text.data(), 1, line.text.size(), stdout);
+        if (line.text.empty() || line.text.back() != '\n') {
+            std::fputc('\n', stdout);
+        }
+        return !std::ferror(stdout);
+    });
+    std::fflush(stdout);
+    return 0;
+}
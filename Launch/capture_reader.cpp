@@ -0,0 +1,35 @@
+// 读取启动器留下的映射捕获文件（launcher_capture.bin），把保存的子进程输出打印到标准输出
+#include "mapped_capture.h"
+
+#include <iostream>
+#include <string>
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        std::cerr << u8"用法: " << argv[0] << u8" <捕获文件> [--info]" << std::endl;
+        return 2;
+    }
+
+    std::string path = argv[1];
+    bool infoOnly = argc > 2 && std::string(argv[2]) == "--info";
+
+    MappedCaptureFile capture;
+    if (!capture.openExisting(path)) {
+        return 1;
+    }
+
+    const CaptureFileHeader& header = capture.header();
+    const OutputRingBuffer& ring = capture.ring();
+    std::cerr << u8"程序: " << header.programPath << "\n"
+              << u8"启动器 PID: " << header.launcherPid << u8"，子进程 PID: " << header.childPid << "\n"
+              << u8"数据区大小: " << header.dataSize << u8" 字节，回绕次数: " << header.ring.wrapCount << "\n"
+              << u8"累计输出: " << ring.totalBytes() << u8" 字节，保留: " << ring.size()
+              << u8" 字节，丢弃: " << ring.droppedBytes() << u8" 字节" << std::endl;
+
+    if (!infoOnly) {
+        ring.writeTo(std::cout);
+        std::cout.flush();
+    }
+    return 0;
+}
@@ -0,0 +1,455 @@
+#include "cgroup_sandbox.h"
+
+#include <iostream>
+
+#ifdef __linux__
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <csignal>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "process_spawn.h"
+#include "supervisor.h"
+
+namespace {
+
+// 已在 systemd scope 中重新执行过，避免反复重启自身
+const char kRelaunchEnvName[] = "SWARMCLONE_CGROUP_RELAUNCHED";
+
+// 删除仍有进程未回收的 cgroup：每隔 kRemovalIntervalMs 重试一次，最多 kRemovalAttempts 次
+const int kRemovalIntervalMs = 5;
+const int kRemovalAttempts = 40;
+
+// 读取 mountinfo 与 cgroup 的目录，自检时指向伪造的文件
+std::string procRoot = "/proc/self";
+
+bool readText(const std::string& path, std::string& text) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    text = buffer.str();
+    return true;
+}
+
+// 写入 cgroup 接口文件，失败时返回 errno
+int writeText(const std::string& path, const std::string& value) {
+    int fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return errno;
+    }
+    int error = 0;
+    if (write(fd, value.data(), value.size()) != static_cast<ssize_t>(value.size())) {
+        error = errno;
+    }
+    close(fd);
+    return error;
+}
+
+// 读取 "key value" 形式文件中的一项，找不到时返回 0
+uint64_t readKey(const std::string& text, const char* key) {
+    std::istringstream lines(text);
+    std::string name;
+    uint64_t value;
+    while (lines >> name >> value) {
+        if (name == key) {
+            return value;
+        }
+    }
+    return 0;
+}
+
+uint64_t readNumber(const std::string& path) {
+    std::string text;
+    if (!readText(path, text)) {
+        return 0;
+    }
+    return std::strtoull(text.c_str(), nullptr, 10);  // "max" 解析为 0，表示没有上限
+}
+
+// cgroup2 挂载点加上 /proc/self/cgroup 中 "0::" 一行给出的路径
+bool findOwnCgroup(std::string& path, std::string& reason) {
+    std::ifstream mountInfo(procRoot + "/mountinfo");
+    std::string line;
+    std::string mountPoint;
+    while (std::getline(mountInfo, line)) {
+        size_t separator = line.find(" - ");
+        if (separator == std::string::npos || line.compare(separator + 3, 8, "cgroup2 ") != 0) {
+            continue;
+        }
+        std::istringstream fields(line);
+        std::string field;
+        for (int i = 0; i < 5 && fields >> field; i++) {
+        }
+        mountPoint = field;
+        break;
+    }
+    if (mountPoint.empty()) {
+        reason = u8"系统未挂载 cgroup v2";
+        return false;
+    }
+
+    std::ifstream cgroups(procRoot + "/cgroup");
+    while (std::getline(cgroups, line)) {
+        if (line.compare(0, 3, "0::") == 0) {
+            std::string relative = line.substr(3);
+            path = relative == "/" ? mountPoint : mountPoint + relative;
+            return true;
+        }
+    }
+    reason = u8"无法确定启动器所在的 cgroup";
+    return false;
+}
+
+bool isWritableCgroup(const std::string& path) {
+    return access(path.c_str(), W_OK) == 0 && access((path + "/cgroup.subtree_control").c_str(), W_OK) == 0;
+}
+
+std::string formatBytes(uint64_t bytes) {
+    char text[32];
+    if (bytes >= (1ULL << 30)) {
+        std::snprintf(text, sizeof(text), "%.1f GB", bytes / 1073741824.0);
+    } else {
+        std::snprintf(text, sizeof(text), "%.1f MB", bytes / 1048576.0);
+    }
+    return text;
+}
+
+} // namespace
+
+CgroupSandbox::CgroupSandbox(const LaunchOptions& options, EventLoop* loop)
+    : requested(options.cgroupSandbox),
+      memoryMax(options.cgroupMemoryMax),
+      cpuMaxPercent(options.cgroupCpuMaxPercent),
+      pidsMax(options.cgroupPidsMax),
+      ioMax(options.cgroupIoMax),
+      loop(loop) {}
+
+CgroupSandbox::~CgroupSandbox() {
+    if (!currentPath.empty()) {
+        finish();
+    }
+    if (removalTimer != -1) {
+        loop->cancelTimer(removalTimer);
+    }
+    // 启动器退出时不再监管任何进程，可以同步等待内核回收
+    for (int attempt = 0; attempt < kRemovalAttempts && !pendingRemoval.empty(); attempt++) {
+        if (attempt > 0) {
+            usleep(kRemovalIntervalMs * 1000);
+        }
+        removePending();
+    }
+}
+
+void CgroupSandbox::removePending() {
+    pendingRemoval.erase(std::remove_if(pendingRemoval.begin(), pendingRemoval.end(), [](const std::string& path) {
+        return rmdir(path.c_str()) == 0 || errno != EBUSY;
+    }), pendingRemoval.end());
+}
+
+bool CgroupSandbox::setUp() {
+    std::string own;
+    std::string reason;
+    if (!findOwnCgroup(own, reason)) {
+        notes = reason;
+        return false;
+    }
+    if (!isWritableCgroup(own)) {
+        notes = u8"没有写入 " + own + u8" 的权限（cgroup 未委派给当前用户）";
+        return false;
+    }
+
+    // 统计需要 memory 与 cpu 控制器，io、pids 只在设置了对应限制时需要
+    std::vector<std::string> wanted = {"memory", "cpu"};
+    if (!ioMax.empty()) {
+        wanted.push_back("io");
+    }
+    if (pidsMax > 0) {
+        wanted.push_back("pids");
+    }
+    std::string available;
+    readText(own + "/cgroup.controllers", available);
+    std::istringstream availableList(available);
+    std::vector<std::string> availableControllers;
+    for (std::string name; availableList >> name;) {
+        availableControllers.push_back(name);
+    }
+
+    std::string missing;
+    bool movedSelf = false;
+    for (const std::string& controller : wanted) {
+        if (std::find(availableControllers.begin(), availableControllers.end(), controller) ==
+            availableControllers.end()) {
+            missing += " " + controller;
+            continue;
+        }
+        int error = writeText(own + "/cgroup.subtree_control", "+" + controller);
+        if (error == EBUSY && !movedSelf) {
+            // 非根 cgroup 中仍有进程时不能向子 cgroup 开放控制器：先把启动器自己移到一个叶子 cgroup 中。
+            // 这个叶子在启动器退出后变为空，由上层（systemd 或管理员）清理
+            movedSelf = true;
+            std::string leaf = own + "/swarmclone-launcher-" + std::to_string(getpid());
+            if ((mkdir(leaf.c_str(), 0755) == 0 || errno == EEXIST) &&
+                writeText(leaf + "/cgroup.procs", std::to_string(getpid())) == 0) {
+                error = writeText(own + "/cgroup.subtree_control", "+" + controller);
+            }
+        }
+        if (error != 0) {
+            missing += " " + controller;
+        } else {
+            controllers.push_back(controller);
+        }
+    }
+    if (!missing.empty()) {
+        notes = u8"以下控制器未委派或无法启用，相应的限制与统计不可用:" + missing;
+        std::cerr << u8"cgroup 沙箱: " << notes << std::endl;
+    }
+    parentPath = own;
+    return true;
+}
+
+bool CgroupSandbox::hasController(const char* name) const {
+    return std::find(controllers.begin(), controllers.end(), name) != controllers.end();
+}
+
+void CgroupSandbox::writeLimit(const char* file, const std::string& value) {
+    int error = writeText(currentPath + "/" + file, value);
+    if (error != 0) {
+        std::string message = std::string(u8"无法设置 ") + file + " = " + value + ": " + std::strerror(error);
+        std::cerr << u8"cgroup 沙箱: " << message << std::endl;
+        attemptNotes += (attemptNotes.empty() ? "" : u8"；") + message;
+    }
+}
+
+std::string CgroupSandbox::prepare(int attemptNumber) {
+    if (!requested) {
+        return "";
+    }
+    if (!setUpDone) {
+        setUpDone = true;
+        if (!setUp()) {
+            std::cerr << u8"cgroup 沙箱不可用，程序将不受限制地运行: " << notes << std::endl;
+        }
+    }
+    if (parentPath.empty()) {
+        return "";
+    }
+
+    currentPath = parentPath + "/swarmclone-" + std::to_string(getpid()) + "-" + std::to_string(attemptNumber);
+    if (mkdir(currentPath.c_str(), 0755) != 0 && errno != EEXIST) {
+        std::cerr << u8"无法创建 cgroup " << currentPath << ": " << std::strerror(errno) << std::endl;
+        currentPath.clear();
+        return "";
+    }
+    polledPeak = 0;
+    attemptNotes.clear();
+
+    // 控制器不可用时 setUp 已经说明过，这里不再逐项报错
+    if (memoryMax > 0 && hasController("memory")) {
+        writeLimit("memory.max", std::to_string(memoryMax));
+        // 超出上限时直接 OOM，不先换出到交换分区。未启用交换记账时没有这个文件，忽略即可
+        writeText(currentPath + "/memory.swap.max", "0");
+    }
+    if (cpuMaxPercent > 0 && hasController("cpu")) {
+        // 每 100 ms 周期内最多运行 cpuMaxPercent ms 的 CPU 时间
+        writeLimit("cpu.max", std::to_string(cpuMaxPercent * 1000) + " 100000");
+    }
+    for (size_t i = 0; i < ioMax.size() && hasController("io"); i++) {
+        writeLimit("io.max", ioMax[i]);
+    }
+    if (pidsMax > 0 && hasController("pids")) {
+        writeLimit("pids.max", std::to_string(pidsMax));
+    }
+    return currentPath + "/cgroup.procs";
+}
+
+void CgroupSandbox::poll() {
+    if (!currentPath.empty()) {
+        polledPeak = std::max(polledPeak, readNumber(currentPath + "/memory.current"));
+    }
+}
+
+CgroupStats CgroupSandbox::finish() {
+    CgroupStats stats;
+    stats.note = notes;
+    if (!attemptNotes.empty()) {
+        stats.note += (stats.note.empty() ? "" : u8"；") + attemptNotes;
+    }
+    if (currentPath.empty()) {
+        return stats;
+    }
+    stats.path = currentPath;
+
+    std::string text;
+    if (readText(currentPath + "/cpu.stat", text)) {
+        stats.cpuUsageUsec = readKey(text, "usage_usec");
+        stats.cpuUserUsec = readKey(text, "user_usec");
+        stats.cpuSystemUsec = readKey(text, "system_usec");
+        stats.cpuThrottled = readKey(text, "nr_throttled");
+        stats.cpuThrottledUsec = readKey(text, "throttled_usec");
+    }
+    if (readText(currentPath + "/memory.events", text)) {
+        stats.oomEvents = readKey(text, "oom");
+        stats.oomKills = readKey(text, "oom_kill");
+        stats.memoryHighEvents = readKey(text, "high");
+    }
+    stats.memoryMax = readNumber(currentPath + "/memory.max");
+    // memory.peak 需要 Linux 5.19，更早的内核上使用采样得到的峰值
+    stats.memoryPeak = std::max(readNumber(currentPath + "/memory.peak"), polledPeak);
+
+    // 子进程加入失败时 cgroup 中从未有过进程，CPU 用量为 0
+    stats.available = stats.cpuUsageUsec > 0;
+
+    // 结束残留的后代进程后删除 cgroup。cgroup.kill 需要 Linux 5.14，更早的内核上逐个发送 SIGKILL
+    if (writeText(currentPath + "/cgroup.kill", "1") != 0 && readText(currentPath + "/cgroup.procs", text)) {
+        std::istringstream pids(text);
+        for (int pid; pids >> pid;) {
+            kill(pid, SIGKILL);
+        }
+    }
+    // 被杀死的进程由内核异步回收，回收完之前 rmdir 返回 EBUSY。此时不在事件循环中忙等，
+    // 交给定时器在之后的循环中重试
+    if (rmdir(currentPath.c_str()) != 0 && errno == EBUSY) {
+        pendingRemoval.push_back(currentPath);
+        removalAttempts = 0;
+        if (loop && removalTimer == -1) {
+            removalTimer = loop->addTimer(std::chrono::milliseconds(kRemovalIntervalMs), [this]() {
+                removePending();
+                if (pendingRemoval.empty() || ++removalAttempts >= kRemovalAttempts) {
+                    loop->cancelTimer(removalTimer);
+                    removalTimer = -1;
+                }
+            });
+        }
+    }
+    currentPath.clear();
+    return stats;
+}
+
+void setCgroupProcRoot(const std::string& root) {
+    procRoot = root.empty() ? "/proc/self" : root;
+}
+
+void relaunchInDelegatedScope(const LaunchOptions& options, int argc, char* argv[]) {
+    if (!options.cgroupSandbox || std::getenv(kRelaunchEnvName)) {
+        return;
+    }
+    std::string own;
+    std::string reason;
+    if (!findOwnCgroup(own, reason) || isWritableCgroup(own)) {
+        return;
+    }
+    std::string systemdRun = findExecutable("systemd-run");
+    char exe[PATH_MAX];
+    ssize_t exeLength = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+    if (systemdRun.empty() || exeLength <= 0) {
+        return;
+    }
+    exe[exeLength] = '\0';
+
+    std::vector<std::string> scopeArgs;
+    if (geteuid() != 0) {
+        scopeArgs.push_back("--user");
+    }
+    scopeArgs.insert(scopeArgs.end(), {"--scope", "--quiet", "-p", "Delegate=yes", "--"});
+
+    // 先确认 systemd-run 能创建 scope（没有运行 systemd 或会话总线时会失败），否则 exec 后就无法回退
+    LaunchSpec probe;
+    probe.program = systemdRun;
+    probe.args = scopeArgs;
+    probe.args.push_back("/bin/true");
+    int devNull = open("/dev/null", O_WRONLY | O_CLOEXEC);
+    if (devNull != -1) {
+        probe.fdMap = {{STDOUT_FILENO, devNull}, {STDERR_FILENO, devNull}};
+    }
+    std::vector<std::string> warnings;
+    std::string error;
+    pid_t pid = spawnProcess(probe, SpawnMethod::Auto, warnings, error);
+    if (devNull != -1) {
+        close(devNull);
+    }
+    int status = 0;
+    if (pid == -1 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        std::cerr << u8"启动器所在的 cgroup 不可写，且无法通过 systemd-run 获得委派的 cgroup" << std::endl;
+        return;
+    }
+
+    std::vector<std::string> args = {systemdRun};
+    args.insert(args.end(), scopeArgs.begin(), scopeArgs.end());
+    args.push_back(exe);
+    args.insert(args.end(), argv + 1, argv + argc);
+    std::vector<char*> execArgs;
+    for (std::string& arg : args) {
+        execArgs.push_back(&arg[0]);
+    }
+    execArgs.push_back(nullptr);
+
+    std::cout << u8"在委派的 systemd scope 中重新启动启动器" << std::endl;
+    setenv(kRelaunchEnvName, "1", 1);
+    execv(systemdRun.c_str(), execArgs.data());
+    unsetenv(kRelaunchEnvName);
+    std::cerr << u8"重新启动失败: " << std::strerror(errno) << std::endl;
+}
+
+std::string describeCgroupStats(const CgroupStats& stats) {
+    std::string text;
+    if (stats.oomKilled()) {
+        text = u8"因内存不足被 OOM killer 终止（峰值 " + formatBytes(stats.memoryPeak);
+        if (stats.memoryMax > 0) {
+            text += u8"，上限 " + formatBytes(stats.memoryMax);
+        }
+        text += u8"）";
+        return text;
+    }
+    if (stats.memoryPeak > 0) {
+        text = u8"内存峰值 " + formatBytes(stats.memoryPeak);
+    }
+    return text;
+}
+
+#else
+
+CgroupSandbox::CgroupSandbox(const LaunchOptions& options, EventLoop*) : requested(options.cgroupSandbox) {}
+
+CgroupSandbox::~CgroupSandbox() {}
+
+std::string CgroupSandbox::prepare(int) {
+    if (requested && !setUpDone) {
+        setUpDone = true;
+        std::cerr << u8"当前平台不支持 cgroup 沙箱，程序将不受限制地运行" << std::endl;
+    }
+    return "";
+}
+
+void CgroupSandbox::poll() {}
+
+CgroupStats CgroupSandbox::finish() {
+    CgroupStats stats;
+    if (requested) {
+        stats.note = u8"当前平台不支持 cgroup";
+    }
+    return stats;
+}
+
+void setCgroupProcRoot(const std::string&) {}
+
+void relaunchInDelegatedScope(const LaunchOptions&, int, char*[]) {}
+
+std::string describeCgroupStats(const CgroupStats&) {
+    return "";
+}
+
+#endif // __linux__
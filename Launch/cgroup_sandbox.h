@@ -0,0 +1,92 @@
+#ifndef CGROUP_SANDBOX_H
+#define CGROUP_SANDBOX_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "launch_options.h"
+
+class EventLoop;
+
+// 子进程每次运行时的 cgroup v2 统计，进程退出后读取
+struct CgroupStats {
+    bool available = false;     // 子进程确实运行在独立的 cgroup 中
+    std::string path;
+    std::string note;           // 降级或部分限制未生效的原因
+
+    uint64_t memoryMax = 0;     // 0 表示没有上限
+    uint64_t memoryPeak = 0;
+    uint64_t oomEvents = 0;     // memory.events 中的 oom 与 oom_kill
+    uint64_t oomKills = 0;
+    uint64_t memoryHighEvents = 0;
+
+    uint64_t cpuUsageUsec = 0;
+    uint64_t cpuUserUsec = 0;
+    uint64_t cpuSystemUsec = 0;
+    uint64_t cpuThrottled = 0;  // 被 cpu.max 节流的周期数
+    uint64_t cpuThrottledUsec = 0;
+
+    bool oomKilled() const { return oomKills > 0; }
+};
+
+// 把子进程放进启动器所在 cgroup 之下的独立子 cgroup，按配置写入 memory.max、cpu.max、io.max 与 pids.max，
+// 退出时读取 memory.events、memory.peak 与 cpu.stat，用于在崩溃报告中区分 OOM 与普通的信号终止。
+// 启动器自身的 cgroup 不可写、控制器未委派或不是 cgroup v2 时给出说明并照常运行，不做限制。
+// 仅在 Linux 上实现
+class CgroupSandbox {
+public:
+    // 给出 loop 时，退出后仍忙碌的 cgroup 由 loop 上的定时器重试删除；否则留到析构时删除
+    explicit CgroupSandbox(const LaunchOptions& options, EventLoop* loop = nullptr);
+    ~CgroupSandbox();
+    CgroupSandbox(const CgroupSandbox&) = delete;
+    CgroupSandbox& operator=(const CgroupSandbox&) = delete;
+
+    bool enabled() const { return requested; }
+
+    // 为下一次运行创建 cgroup 并写入限制，返回子进程在 exec 前应写入的 cgroup.procs 路径；不可用时返回空字符串
+    std::string prepare(int attemptNumber);
+
+    // 内核不提供 memory.peak 时由采样定时器调用，跟踪 memory.current 的最大值
+    void poll();
+
+    // 子进程退出后读取统计，结束 cgroup 中残留的进程并删除 cgroup。内核尚未回收完进程时不等待，稍后重试
+    CgroupStats finish();
+
+private:
+    bool setUp();
+    void removePending();
+    bool hasController(const char* name) const;
+    void writeLimit(const char* file, const std::string& value);
+
+    bool requested = false;
+    bool setUpDone = false;
+    std::string parentPath;          // 子进程 cgroup 的父目录
+    std::vector<std::string> controllers;
+    uint64_t memoryMax = 0;
+    int cpuMaxPercent = 0;
+    uint64_t pidsMax = 0;
+    std::vector<std::string> ioMax;
+
+    std::string currentPath;
+    std::string notes;               // 启用控制器时的说明，对每次运行都有效
+    std::string attemptNotes;        // 本次运行写入限制失败的原因
+    uint64_t polledPeak = 0;
+
+    EventLoop* loop = nullptr;
+    std::vector<std::string> pendingRemoval;  // 仍有进程未回收、删除失败的 cgroup
+    int removalTimer = -1;
+    int removalAttempts = 0;
+};
+
+// 一行概括：OOM 终止时给出峰值与上限，否则只给出内存峰值；没有数据时返回空字符串
+std::string describeCgroupStats(const CgroupStats& stats);
+
+// 自检用：从 root 下的 mountinfo 与 cgroup 文件（代替 /proc/self）确定启动器所在的 cgroup，空字符串恢复默认
+void setCgroupProcRoot(const std::string& root);
+
+// 启动器自身的 cgroup 不可写时，尝试通过 systemd-run --scope -p Delegate=yes 在一个委派给当前用户的
+// 新 scope 中重新执行启动器。只有确认 systemd-run 可用时才会 exec，成功时不返回
+void relaunchInDelegatedScope(const LaunchOptions& options, int argc, char* argv[]);
+
+#endif // CGROUP_SANDBOX_H
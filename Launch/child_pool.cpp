@@ -0,0 +1,954 @@
+#include "child_pool.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+#ifndef _WIN32
+    #include "capture_log.h"
+    #include "control_socket.h"
+    #include "crash_log.h"
+    #include "hang_watchdog.h"
+    #include "live_output.h"
+    #include "output_buffer.h"
+    #include "supervisor.h"
+    #include "system_info.h"
+    #include "telemetry.h"
+    #include <cerrno>
+    #include <functional>
+    #include <memory>
+    #include <fcntl.h>
+    #include <signal.h>
+    #include <unistd.h>
+    #include <sys/stat.h>
+#endif
+
+namespace {
+
+// 多程序时每个程序的输出缓冲区缺省值，几十个程序的内存占用仍然有限
+const size_t kPoolOutputBufferSize = 1024 * 1024;
+
+std::string trim(const std::string& text) {
+    size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+// 程序名同时用作崩溃日志目录名
+bool validName(const std::string& name) {
+    if (name.empty() || name == "." || name == "..") {
+        return false;
+    }
+    for (char c : name) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_' && c != '.') {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 以 parseLaunchOptions 的方式解析一组 "--key=value"，叠加在 options 之上
+LaunchOptions applyOptions(const std::vector<std::string>& args, const LaunchOptions& options) {
+    std::vector<char*> argv = {const_cast<char*>("launch")};
+    for (const std::string& arg : args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    return parseLaunchOptions(static_cast<int>(argv.size()), argv.data(), options);
+}
+
+struct Section {
+    std::string name;
+    std::string program;
+    std::string workDir;
+    std::vector<std::string> after;
+    std::vector<std::string> args;
+};
+
+} // namespace
+
+bool loadPoolConfig(const std::string& path, int argc, char* argv[], std::vector<PoolChildConfig>& children,
+                    std::string& error) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        error = u8"无法打开配置文件 " + path;
+        return false;
+    }
+
+    std::vector<std::string> defaultArgs;
+    std::vector<Section> sections;
+    bool inDefaults = false;
+    std::string line;
+    for (int lineNumber = 1; std::getline(file, line); lineNumber++) {
+        line = trim(line);
+        if (line.empty() || line[0] == ';' || line[0] == '#') {
+            continue;
+        }
+        std::string where = u8"第 " + std::to_string(lineNumber) + u8" 行：";
+
+        if (line[0] == '[') {
+            if (line.back() != ']') {
+                error = where + u8"小节名缺少 ']'";
+                return false;
+            }
+            std::string name = trim(line.substr(1, line.size() - 2));
+            inDefaults = name == "defaults";
+            if (inDefaults) {
+                continue;
+            }
+            if (!validName(name)) {
+                error = where + u8"无效的程序名 " + name;
+                return false;
+            }
+            for (const Section& section : sections) {
+                if (section.name == name) {
+                    error = where + u8"程序名重复 " + name;
+                    return false;
+                }
+            }
+            sections.emplace_back();
+            sections.back().name = name;
+            continue;
+        }
+
+        size_t eq = line.find('=');
+        std::string key = trim(line.substr(0, eq));
+        std::string value = eq == std::string::npos ? "" : trim(line.substr(eq + 1));
+        if (!inDefaults && sections.empty()) {
+            error = where + u8"设置不属于任何小节";
+            return false;
+        }
+        bool childOnly = key == "program" || key == "workdir" || key == "after";
+        if (inDefaults && childOnly) {
+            error = where + key + u8" 只能在程序的小节中设置";
+            return false;
+        }
+        if (inDefaults) {
+            defaultArgs.push_back("--" + key + (eq == std::string::npos ? "" : "=" + value));
+            continue;
+        }
+
+        Section& section = sections.back();
+        if (key == "program") {
+            section.program = value;
+        } else if (key == "workdir") {
+            section.workDir = value;
+        } else if (key == "after") {
+            size_t start = 0;
+            while (start <= value.size()) {
+                size_t comma = value.find(',', start);
+                size_t length = comma == std::string::npos ? std::string::npos : comma - start;
+                std::string dependency = trim(value.substr(start, length));
+                if (!dependency.empty()) {
+                    section.after.push_back(dependency);
+                }
+                if (comma == std::string::npos) {
+                    break;
+                }
+                start = comma + 1;
+            }
+        } else {
+            section.args.push_back("--" + key + (eq == std::string::npos ? "" : "=" + value));
+        }
+    }
+    if (sections.empty()) {
+        error = u8"配置文件中没有任何程序";
+        return false;
+    }
+
+    // 命令行（"--" 之前的部分）对全部程序生效，[defaults] 与各程序的小节依次覆盖
+    std::vector<std::string> commandLine;
+    for (int i = 1; i < argc && std::string(argv[i]) != "--"; i++) {
+        commandLine.push_back(argv[i]);
+    }
+    LaunchOptions poolDefaults;
+    poolDefaults.outputBufferSize = kPoolOutputBufferSize;
+    LaunchOptions shared = applyOptions(defaultArgs, applyOptions(commandLine, poolDefaults));
+    shared.poolConfigFile.clear();
+
+    std::map<std::string, size_t> indexByName;
+    for (size_t i = 0; i < sections.size(); i++) {
+        indexByName[sections[i].name] = i;
+    }
+    std::vector<PoolChildConfig> loaded;
+    for (const Section& section : sections) {
+        if (section.program.empty()) {
+            error = u8"程序 " + section.name + u8" 没有设置 program";
+            return false;
+        }
+        for (const std::string& dependency : section.after) {
+            if (indexByName.count(dependency) == 0) {
+                error = u8"程序 " + section.name + u8" 依赖的 " + dependency + u8" 不存在";
+                return false;
+            }
+        }
+
+        PoolChildConfig child;
+        child.name = section.name;
+        child.after = section.after;
+        if (section.workDir.empty()) {
+            size_t slash = section.program.find_last_of('/');
+            child.workDir = slash == std::string::npos ? "." : slash == 0 ? "/" : section.program.substr(0, slash);
+            child.program = section.program.substr(slash == std::string::npos ? 0 : slash + 1);
+        } else {
+            child.workDir = section.workDir;
+            child.program = section.program;
+        }
+        LaunchOptions childDefaults = shared;
+        std::string crashLogRoot = shared.crashLogDir.empty() ? "crashlogs" : shared.crashLogDir;
+        childDefaults.crashLogDir = crashLogRoot + "/" + section.name;
+        if (!shared.captureLogDir.empty()) {
+            childDefaults.captureLogDir = shared.captureLogDir + "/" + section.name;
+        }
+        if (!shared.liveOutputName.empty()) {
+            childDefaults.liveOutputName = shared.liveOutputName + "-" + section.name;
+        }
+        child.options = applyOptions(section.args, childDefaults);
+        loaded.push_back(std::move(child));
+    }
+
+    // 按依赖排序（Kahn 算法），没有依赖关系的程序保持配置文件中的顺序
+    std::vector<size_t> pending(loaded.size());
+    for (size_t i = 0; i < loaded.size(); i++) {
+        pending[i] = loaded[i].after.size();
+    }
+    std::vector<bool> placed(loaded.size(), false);
+    children.clear();
+    while (children.size() < loaded.size()) {
+        size_t next = loaded.size();
+        for (size_t i = 0; i < loaded.size() && next == loaded.size(); i++) {
+            if (!placed[i] && pending[i] == 0) {
+                next = i;
+            }
+        }
+        if (next == loaded.size()) {
+            error = u8"存在循环依赖:";
+            for (size_t i = 0; i < loaded.size(); i++) {
+                if (!placed[i]) {
+                    error += " " + loaded[i].name;
+                }
+            }
+            children.clear();
+            return false;
+        }
+        placed[next] = true;
+        for (size_t i = 0; i < loaded.size(); i++) {
+            pending[i] -= std::count(loaded[i].after.begin(), loaded[i].after.end(), loaded[next].name);
+        }
+        children.push_back(loaded[next]);
+    }
+    return true;
+}
+
+#ifndef _WIN32
+
+namespace {
+
+bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written == -1 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+// 每个程序在一个控制台流上最多积压的输出，超出时丢弃新的输出
+const size_t kConsoleQueueLimit = 256 * 1024;
+
+// 捕获日志缓冲区写入文件的间隔；缓冲区写满或换新分段时也会写入
+const int kCaptureFlushIntervalMs = 200;
+
+// 把各程序加上前缀的输出转发到启动器的 stdout 或 stderr。控制台是终端或管道时通过一个独立的非阻塞
+// 打开写出，不影响启动器自身经由 iostream 的阻塞写入；写不完的部分进入各程序自己的有界队列，
+// 由事件循环在可写时轮流写出，控制台读得慢时不阻塞对其他程序的监管。
+// 其他情况（普通文件、无法重新打开）下直接阻塞写出
+class ConsoleForwarder {
+public:
+    ConsoleForwarder(EventLoop& loop, int target);
+    ~ConsoleForwarder();
+    ConsoleForwarder(const ConsoleForwarder&) = delete;
+    ConsoleForwarder& operator=(const ConsoleForwarder&) = delete;
+
+    // 为一个程序创建队列，返回队列编号；prefix 用于丢弃输出时的说明
+    size_t addQueue(const std::string& prefix);
+
+    // droppable 为 false 时（启动器自己的说明）即使队列已满也不丢弃
+    void write(size_t queue, const char* data, size_t size, bool droppable = true);
+
+private:
+    struct Queue {
+        std::string prefix;
+        std::string data;
+        size_t offset = 0;     // data 中已写出的字节数
+        uint64_t dropped = 0;  // 队列满时丢弃、尚未说明的字节数
+    };
+
+    size_t writeSome(size_t queue, const char* data, size_t size);
+    bool writeQueue(size_t queue, size_t limit);
+    void appendDropNote(Queue& queue);
+    void drain();
+    void finishDrain(bool done);
+
+    EventLoop& loop;
+    int target;
+    int fd = -1;               // 非阻塞的独立打开，-1 表示直接阻塞写入 target
+    bool registered = false;   // 有积压，正在等待可写
+    bool broken = false;       // 控制台已关闭，之后的输出全部丢弃
+    bool lineOpen = false;     // 最后写出的字节不是换行，这一行属于 lineOwner
+    size_t lineOwner = 0;
+    size_t nextQueue = 0;      // 轮流写出的起点
+    std::vector<Queue> queues;
+};
+
+ConsoleForwarder::ConsoleForwarder(EventLoop& loop, int target) : loop(loop), target(target) {
+#ifdef __linux__
+    // 重新打开 /proc/self/fd 得到独立的文件描述（O_NONBLOCK 属于文件描述，dup 出的 fd 会共享它）。
+    // 普通文件重新打开会有独立的写入位置，因此只用于终端与管道
+    struct stat info;
+    if (fstat(target, &info) == 0 && (S_ISCHR(info.st_mode) || S_ISFIFO(info.st_mode))) {
+        std::string path = "/proc/self/fd/" + std::to_string(target);
+        fd = open(path.c_str(), O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    }
+#endif
+}
+
+ConsoleForwarder::~ConsoleForwarder() {
+    if (fd == -1) {
+        return;
+    }
+    // 启动器退出前把积压的输出（包括丢弃说明）阻塞写完
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+    drain();
+    close(fd);
+}
+
+size_t ConsoleForwarder::addQueue(const std::string& prefix) {
+    queues.emplace_back();
+    queues.back().prefix = prefix;
+    return queues.size() - 1;
+}
+
+void ConsoleForwarder::write(size_t index, const char* data, size_t size, bool droppable) {
+    if (fd == -1) {
+        writeAll(target, data, size);
+        return;
+    }
+    if (broken) {
+        return;
+    }
+    // 没有积压时先直接写，写不完的部分再排队
+    if (!registered) {
+        size_t written = writeSome(index, data, size);
+        data += written;
+        size -= written;
+        if (size == 0 || broken) {
+            return;
+        }
+    }
+
+    Queue& queue = queues[index];
+    if (droppable && (queue.dropped > 0 || queue.data.size() - queue.offset + size > kConsoleQueueLimit)) {
+        queue.dropped += size;
+    } else {
+        appendDropNote(queue);
+        queue.data.append(data, size);
+    }
+    if (!registered && loop.addFd(fd, nullptr)) {
+        registered = true;
+        loop.setWritable(fd, [this]() { drain(); });
+    } else if (!registered) {
+        // 无法监听可写事件时退回阻塞写出
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+        drain();
+    }
+}
+
+// 写出一次，返回写出的字节数；控制台暂时写不下或已关闭时返回 0
+size_t ConsoleForwarder::writeSome(size_t queue, const char* data, size_t size) {
+    while (true) {
+        ssize_t written = ::write(fd, data, size);
+        if (written == -1 && errno == EINTR) {
+            continue;
+        }
+        if (written == -1 && errno == EAGAIN) {
+            return 0;
+        }
+        if (written <= 0) {
+            broken = true;
+            return 0;
+        }
+        lineOpen = data[written - 1] != '\n';
+        lineOwner = queue;
+        return static_cast<size_t>(written);
+    }
+}
+
+// 写出队列中最多 limit 字节，队列写空时接着写出丢弃说明。控制台写不下时返回 false
+bool ConsoleForwarder::writeQueue(size_t index, size_t limit) {
+    Queue& queue = queues[index];
+    size_t end = queue.offset + std::min(limit, queue.data.size() - queue.offset);
+    while (queue.offset < end) {
+        size_t written = writeSome(index, queue.data.data() + queue.offset, end - queue.offset);
+        if (written == 0) {
+            return false;
+        }
+        queue.offset += written;
+    }
+    if (queue.offset == queue.data.size()) {
+        queue.data.clear();
+        queue.offset = 0;
+        if (queue.dropped > 0) {
+            appendDropNote(queue);
+            return writeQueue(index, std::string::npos);
+        }
+    }
+    return true;
+}
+
+void ConsoleForwarder::appendDropNote(Queue& queue) {
+    if (queue.dropped > 0) {
+        // 说明另起一行，被截断的行不会与之后的输出连在一起
+        queue.data += "\n" + queue.prefix + u8"控制台写出过慢，已丢弃 " + std::to_string(queue.dropped) + u8" 字节输出\n";
+        queue.dropped = 0;
+    }
+}
+
+void ConsoleForwarder::drain() {
+    // 上次停在一行中间时先写完这一行，其他程序的输出不会插进这一行，随后从下一个队列开始轮流写出
+    size_t start = nextQueue;
+    if (lineOpen) {
+        const Queue& owner = queues[lineOwner];
+        size_t newline = owner.data.find('\n', owner.offset);
+        if (!writeQueue(lineOwner, newline == std::string::npos ? std::string::npos : newline + 1 - owner.offset)) {
+            finishDrain(false);
+            return;
+        }
+        start = lineOwner + 1;
+    }
+    for (size_t i = 0; i < queues.size(); i++) {
+        size_t index = (start + i) % queues.size();
+        if (!writeQueue(index, std::string::npos)) {
+            nextQueue = index;
+            finishDrain(false);
+            return;
+        }
+    }
+    finishDrain(true);
+}
+
+void ConsoleForwarder::finishDrain(bool done) {
+    if (broken) {
+        for (Queue& queue : queues) {
+            queue.data.clear();
+            queue.offset = 0;
+            queue.dropped = 0;
+        }
+        done = true;
+    }
+    if (done && registered) {
+        loop.removeFd(fd);
+        registered = false;
+    }
+}
+
+// 一个受监管的程序：等待依赖 -> 运行 -> 退避后重启 -> 停止。全部状态变化都发生在共享的事件循环中，
+// 内存占用只有固定大小的输出缓冲区与采样窗口，不随运行时间增长
+class PoolMember {
+public:
+    enum class State {
+        Waiting,   // 等待依赖就绪
+        Running,
+        Backoff,   // 等待重启
+        Stopped,
+    };
+
+    PoolMember(EventLoop& loop, const PoolChildConfig& config, SystemInventoryPrefetcher& inventory,
+               ConsoleForwarder (&console)[2], std::function<void()> onStateChange);
+    ~PoolMember();
+    PoolMember(const PoolMember&) = delete;
+    PoolMember& operator=(const PoolMember&) = delete;
+
+    const PoolChildConfig& config() const { return settings; }
+    State state() const { return currentState; }
+    // 第一次输出或以退出码 0 结束后，依赖它的程序才会启动
+    bool ready() const { return isReady; }
+    bool failed() const { return hasFailed; }
+
+    void start();
+    // 依赖的程序已停止且未就绪，本程序不再启动
+    void abandon(const std::string& dependency);
+
+    // 控制接口的状态查询、重启与快照
+    ControlChildStatus controlStatus() const;
+    bool requestRestart(std::string& message);
+    bool snapshot(std::string& message);
+
+private:
+    void setState(State state);
+    void scheduleStart(int64_t delayMs);
+    void forward(const OutputChunk& chunk);
+    void print(OutputStream stream, const std::string& text);
+    void handleExit(const ChildExitStatus& status);
+    void logEvent(const std::string& text);
+
+    EventLoop& loop;
+    const PoolChildConfig& settings;
+    SystemInventoryPrefetcher& inventory;
+    std::function<void()> onStateChange;
+    std::string fullPath;
+    std::string prefix;
+    LaunchSpec spec;
+    ConsoleForwarder (&console)[2];  // stdout、stderr
+    size_t consoleQueue[2];
+
+    SupervisedChild child;
+    OutputRingBuffer output;
+    OutputHighlights highlights;
+    CaptureLogWriter captureLog;
+    LiveOutputWriter liveOutput;
+    LineFramer framer;
+    HangWatchdog watchdog;
+    RestartPolicy restartPolicy;
+    std::unique_ptr<ProcessTreeSampler> sampler;
+    int samplerTimer = -1;
+    int restartTimer = -1;
+    int killTimer = -1;
+    int captureFlushTimer = -1;
+    bool restartRequested = false;
+    bool hasExited = false;
+    ChildExitStatus lastExit;
+
+    State currentState = State::Waiting;
+    bool isReady = false;
+    bool hasFailed = false;
+    int attemptNumber = 0;
+    int64_t startUnixMs = 0;
+    int64_t startTimestampNs = 0;
+    int64_t exitTimestampNs = 0;
+    int64_t backoffNs = 0;
+    bool atLineStart[2] = {true, true};  // stdout、stderr 上一次转发是否以换行结束
+    std::string forwardBuffer;
+};
+
+PoolMember::PoolMember(EventLoop& loop, const PoolChildConfig& config, SystemInventoryPrefetcher& inventory,
+                       ConsoleForwarder (&console)[2], std::function<void()> onStateChange)
+    : loop(loop), settings(config), inventory(inventory), onStateChange(std::move(onStateChange)),
+      fullPath(config.workDir + "/" + config.program), prefix("[" + config.name + "] "),
+      spec(buildLaunchSpec(config.workDir, config.program, config.options)), console(console),
+      consoleQueue{console[0].addQueue(prefix), console[1].addQueue(prefix)}, child(loop),
+      output(config.options.outputBufferSize), highlights(highlightPatternsFor(config.options)),
+      framer([this](OutputStream stream, int64_t timestampNs, const char* data, size_t size) {
+          output.append(stream, timestampNs, data, size);
+          captureLog.append(static_cast<uint8_t>(stream), timestampNs, data, size);
+      }),
+      watchdog(loop, config.options), restartPolicy(config.options) {
+    // 多个程序的输出交错在同一个控制台上，由启动器逐行加上程序名转发
+    child.setForwarding(-1, -1, nullptr, false);
+    child.onOutput([this](const OutputChunk& chunk) {
+        highlights.scan(chunk);
+        framer.append(chunk);
+        liveOutput.publish(static_cast<uint8_t>(chunk.stream), chunk.timestampNs, chunk.data, chunk.size);
+        watchdog.noteOutput(chunk.timestampNs);
+        forward(chunk);
+        if (!isReady) {
+            isReady = true;
+            this->onStateChange();
+        }
+    });
+    child.onExit([this](const ChildExitStatus& status) { handleExit(status); });
+
+    const LaunchOptions& options = config.options;
+    if (!options.captureLogDir.empty()) {
+        captureLog.open(options.captureLogDir, options.captureLogSegmentSize, options.captureLogMaxSize);
+        // 多个程序共用一个事件循环，不在每段输出后写文件
+        captureFlushTimer = loop.addTimer(std::chrono::milliseconds(kCaptureFlushIntervalMs), [this]() {
+            captureLog.flush();
+        });
+    }
+    if (!options.liveOutputName.empty()) {
+        liveOutput.create(options.liveOutputName, options.liveOutputSize, fullPath);
+    }
+    if (options.captureMode == CaptureMode::Mapped || !options.captureFile.empty() || options.cgroupSandbox ||
+        options.coreDumpMode != CoreDumpMode::Off) {
+        print(OutputStream::Stderr, u8"多程序监管暂不支持映射捕获文件、滚动捕获文件、cgroup 沙箱与核心转储，已忽略");
+    }
+}
+
+PoolMember::~PoolMember() {
+    for (int timer : {samplerTimer, restartTimer, killTimer, captureFlushTimer}) {
+        if (timer != -1) {
+            loop.cancelTimer(timer);
+        }
+    }
+}
+
+void PoolMember::setState(State state) {
+    currentState = state;
+    onStateChange();
+}
+
+void PoolMember::forward(const OutputChunk& chunk) {
+    int stream = chunk.stream == OutputStream::Stderr ? 1 : 0;
+    bool& lineStart = atLineStart[stream];
+    forwardBuffer.clear();
+    for (size_t i = 0; i < chunk.size; i++) {
+        if (lineStart) {
+            forwardBuffer += prefix;
+        }
+        forwardBuffer += chunk.data[i];
+        lineStart = chunk.data[i] == '\n';
+    }
+    console[stream].write(consoleQueue[stream], forwardBuffer.data(), forwardBuffer.size());
+}
+
+// 启动器关于本程序的说明与子进程的输出经过同一个队列，在控制台上保持先后顺序
+void PoolMember::print(OutputStream stream, const std::string& text) {
+    int index = stream == OutputStream::Stderr ? 1 : 0;
+    std::string line = (atLineStart[index] ? "" : "\n") + prefix + text + "\n";
+    atLineStart[index] = true;
+    console[index].write(consoleQueue[index], line.data(), line.size(), false);
+}
+
+void PoolMember::logEvent(const std::string& text) {
+    int64_t timestampNs = monotonicNanos();
+    captureLog.append(kCaptureLogEvent, timestampNs, text.data(), text.size());
+    captureLog.flush();
+    liveOutput.publish(SC_LIVE_STREAM_EVENT, timestampNs, text.data(), text.size());
+}
+
+void PoolMember::scheduleStart(int64_t delayMs) {
+    // 不在子进程的退出回调中直接启动，而是交给定时器
+    int64_t waitStartNs = monotonicNanos();
+    restartTimer = loop.addTimer(std::chrono::milliseconds(delayMs), [this, waitStartNs]() {
+        loop.cancelTimer(restartTimer);
+        restartTimer = -1;
+        backoffNs = monotonicNanos() - waitStartNs;
+        start();
+    });
+}
+
+void PoolMember::start() {
+    restartRequested = false;
+    attemptNumber++;
+    startUnixMs = unixMillis();
+    startTimestampNs = monotonicNanos();
+    watchdog.prepareChild(child);
+    if (!child.start(spec)) {
+        print(OutputStream::Stderr, u8"无法启动 " + fullPath);
+        hasFailed = true;
+        setState(State::Stopped);
+        return;
+    }
+    if (attemptNumber > 1) {
+        int64_t latencyNs = monotonicNanos() - exitTimestampNs - backoffNs;
+        restartPolicy.recordRestartLatency(latencyNs);
+        std::ostringstream text;
+        text << u8"程序已重启（第 " << attemptNumber << u8" 次运行，耗时 " << latencyNs / 1e6 << " ms）";
+        print(OutputStream::Stdout, text.str());
+    } else {
+        print(OutputStream::Stdout, u8"程序已启动: " + fullPath + " (PID " + std::to_string(child.pid()) + ")");
+    }
+    liveOutput.setChildPid(child.pid());
+    logEvent(u8"程序已启动 (PID " + std::to_string(child.pid()) + ")");
+
+    const LaunchOptions& options = settings.options;
+    if (options.telemetryIntervalMs > 0) {
+        size_t capacity = static_cast<size_t>(options.telemetryWindowSeconds) * 1000 / options.telemetryIntervalMs;
+        sampler.reset(new ProcessTreeSampler(child.pid(), capacity));
+        sampler->sample();
+        samplerTimer = loop.addTimer(std::chrono::milliseconds(options.telemetryIntervalMs), [this]() {
+            sampler->sample();
+        });
+    }
+    watchdog.start(child.pid(), sampler.get());
+    setState(State::Running);
+}
+
+void PoolMember::abandon(const std::string& dependency) {
+    print(OutputStream::Stderr, u8"依赖的 " + dependency + u8" 未能就绪，不再启动");
+    hasFailed = true;
+    setState(State::Stopped);
+}
+
+ControlChildStatus PoolMember::controlStatus() const {
+    static const char* const stateNames[] = {"waiting", "running", "backoff", "stopped"};
+    ControlChildStatus status;
+    status.state = stateNames[static_cast<int>(currentState)];
+    status.pid = child.running() ? child.pid() : -1;
+    status.startUnixMs = startUnixMs;
+    status.restarts = std::max(0, attemptNumber - 1);
+    status.hasExited = hasExited;
+    status.lastExitSignaled = lastExit.signaled;
+    status.lastExitValue = lastExit.signaled ? lastExit.signal : lastExit.exitCode;
+    status.output = &output;
+    status.telemetry = sampler.get();
+    return status;
+}
+
+bool PoolMember::requestRestart(std::string& message) {
+    switch (currentState) {
+        case State::Waiting:
+            message = "waiting for dependencies";
+            return false;
+        case State::Running: {
+            if (restartRequested) {
+                message = "restart already in progress";
+                return false;
+            }
+            restartRequested = true;
+            pid_t pid = child.pid();
+            kill(pid, SIGTERM);
+            killTimer = loop.addTimer(std::chrono::milliseconds(settings.options.hangKillGraceMs), [this, pid]() {
+                loop.cancelTimer(killTimer);
+                killTimer = -1;
+                kill(pid, SIGKILL);
+            });
+            return true;
+        }
+        case State::Backoff:
+            loop.cancelTimer(restartTimer);
+            scheduleStart(0);
+            return true;
+        case State::Stopped:
+            // 已停止的程序（包括崩溃循环后）也可以手动重新启动
+            hasFailed = false;
+            output.clear();
+            highlights.clear();
+            atLineStart[0] = atLineStart[1] = true;
+            scheduleStart(0);
+            setState(State::Backoff);
+            return true;
+    }
+    return false;
+}
+
+bool PoolMember::snapshot(std::string& message) {
+    if (!child.running()) {
+        message = "child is not running";
+        return false;
+    }
+    CrashReport report;
+    report.snapshot = true;
+    report.programPath = fullPath;
+    report.launcherPid = static_cast<int>(getpid());
+    report.childPid = child.pid();
+    report.startUnixMs = startUnixMs;
+    report.exitUnixMs = unixMillis();
+    report.exitTimestampNs = monotonicNanos();
+    report.threadStacks = captureThreadStacks({child.pid()});
+    report.inventory = &inventory.get();
+    report.telemetry = sampler.get();
+    report.output = &output;
+    report.highlights = &highlights;
+    return generateCrashLog(report, settings.options, false, &message);
+}
+
+void PoolMember::handleExit(const ChildExitStatus& status) {
+    // 没有以换行结束的最后一行也要进入输出缓冲区与捕获日志
+    framer.flush();
+    exitTimestampNs = monotonicNanos();
+    int64_t exitUnixMs = unixMillis();
+    watchdog.stop();
+    if (samplerTimer != -1) {
+        loop.cancelTimer(samplerTimer);
+        samplerTimer = -1;
+    }
+    if (killTimer != -1) {
+        loop.cancelTimer(killTimer);
+        killTimer = -1;
+    }
+    hasExited = true;
+    lastExit = status;
+    logEvent(status.signaled ? u8"程序被信号终止: " + std::to_string(status.signal) :
+                               u8"程序退出代码: " + std::to_string(status.exitCode));
+    if (restartRequested) {
+        print(OutputStream::Stdout, u8"已按控制请求重启程序");
+        output.clear();
+        highlights.clear();
+        atLineStart[0] = atLineStart[1] = true;
+        scheduleStart(0);
+        setState(State::Backoff);
+        return;
+    }
+
+    RunAttempt attempt;
+    attempt.number = attemptNumber;
+    attempt.startTimestampNs = startTimestampNs;
+    attempt.exitTimestampNs = exitTimestampNs;
+    bool crashed = false;
+    if (status.exited) {
+        print(OutputStream::Stdout, u8"程序退出代码: " + std::to_string(status.exitCode));
+        crashed = status.exitCode != 0;
+        attempt.outcome = u8"退出码 " + std::to_string(status.exitCode);
+    } else if (status.signaled) {
+        print(OutputStream::Stdout, u8"程序被信号终止: " + std::to_string(status.signal));
+        crashed = true;
+        attempt.outcome = u8"信号 " + std::to_string(status.signal);
+    }
+    if (watchdog.trigger() != HangTrigger::None) {
+        crashed = true;
+        attempt.outcome = std::string(u8"挂起 ") + hangTriggerName(watchdog.trigger()) + u8"，" + attempt.outcome;
+    }
+    attempt.crashed = crashed;
+    if (!crashed) {
+        isReady = true;
+    }
+    RestartPolicy::Decision decision = restartPolicy.recordExit(attempt);
+
+    CrashReport report;
+    report.programPath = fullPath;
+    report.exited = status.exited;
+    report.exitCode = status.exitCode;
+    report.signaled = status.signaled;
+    report.signal = status.signal;
+    report.coreDumped = status.coreDumped;
+    report.launcherPid = static_cast<int>(getpid());
+    report.childPid = child.pid();
+    report.startUnixMs = startUnixMs;
+    report.exitUnixMs = exitUnixMs;
+    report.exitTimestampNs = exitTimestampNs;
+    report.inventory = &inventory.get();
+    report.telemetry = sampler.get();
+    report.output = &output;
+    report.highlights = &highlights;
+    if (watchdog.trigger() != HangTrigger::None) {
+        report.hangTrigger = hangTriggerName(watchdog.trigger());
+        report.hangStalledMs = watchdog.stalledMs();
+        report.threadStacks = watchdog.threadStacks();
+    }
+
+    const LaunchOptions& options = settings.options;
+    if (decision == RestartPolicy::Decision::CrashLoop) {
+        generateCrashLoopReport(report, restartPolicy, options);
+        hasFailed = true;
+        setState(State::Stopped);
+        return;
+    }
+    if (decision == RestartPolicy::Decision::Stop) {
+        if (crashed) {
+            generateCrashLog(report, options, true);
+        }
+        hasFailed = crashed;
+        setState(State::Stopped);
+        return;
+    }
+
+    // 与单程序模式相同：自动重启时不弹窗，同一窗口内接连崩溃只为第一次单独写日志
+    if (crashed && restartPolicy.crashesInWindow() == 1) {
+        std::string crashLogName;
+        generateCrashLog(report, options, false, &crashLogName);
+        restartPolicy.setLastCrashLog(crashLogName);
+    } else if (crashed) {
+        countCrashInStore(report, options);
+    }
+    output.clear();
+    highlights.clear();
+    atLineStart[0] = atLineStart[1] = true;
+    reapNotifications();
+
+    // 退避等待由定时器完成，不阻塞其他程序的监管
+    int64_t delayMs = restartPolicy.nextDelayMs();
+    if (delayMs > 0) {
+        print(OutputStream::Stdout, std::to_string(delayMs) + u8" ms 后重启程序");
+    }
+    scheduleStart(delayMs);
+    setState(State::Backoff);
+}
+
+} // namespace
+
+bool runChildPool(const std::vector<PoolChildConfig>& children, const std::string& controlSocket) {
+    EventLoop loop;
+    SystemInventoryPrefetcher inventory("system_inventory.cache");
+    std::cout.flush();
+    ConsoleForwarder console[2] = {{loop, STDOUT_FILENO}, {loop, STDERR_FILENO}};
+
+    // 状态变化可能发生在另一个程序的回调中，统一推迟到下一轮循环处理
+    std::vector<std::unique_ptr<PoolMember>> members;
+    std::map<std::string, PoolMember*> byName;
+    bool updatePosted = false;
+    std::function<void()> update = [&]() {
+        updatePosted = false;
+        bool allStopped = true;
+        for (const std::unique_ptr<PoolMember>& member : members) {
+            // members 按依赖排序，同一轮中放弃启动的程序会连带其后依赖它的程序
+            if (member->state() == PoolMember::State::Waiting) {
+                bool dependenciesReady = true;
+                std::string blockedBy;
+                for (const std::string& dependency : member->config().after) {
+                    const PoolMember* other = byName[dependency];
+                    if (!other->ready()) {
+                        dependenciesReady = false;
+                        if (other->state() == PoolMember::State::Stopped) {
+                            blockedBy = dependency;
+                        }
+                    }
+                }
+                if (!blockedBy.empty()) {
+                    member->abandon(blockedBy);
+                } else if (dependenciesReady) {
+                    member->start();
+                }
+            }
+            allStopped = allStopped && member->state() == PoolMember::State::Stopped;
+        }
+        if (allStopped) {
+            loop.stop();
+        }
+    };
+    auto onStateChange = [&]() {
+        if (!updatePosted) {
+            updatePosted = true;
+            loop.post(update);
+        }
+    };
+
+    for (const PoolChildConfig& config : children) {
+        members.emplace_back(new PoolMember(loop, config, inventory, console, onStateChange));
+        byName[config.name] = members.back().get();
+    }
+    std::cout << u8"正在监管 " << members.size() << u8" 个程序" << std::endl;
+
+    std::unique_ptr<ControlServer> control;
+    if (!controlSocket.empty()) {
+        control.reset(new ControlServer(loop, controlSocket));
+        for (const std::unique_ptr<PoolMember>& member : members) {
+            PoolMember* target = member.get();
+            ControlChild controlled;
+            controlled.status = [target]() { return target->controlStatus(); };
+            controlled.restart = [target](std::string& message) { return target->requestRestart(message); };
+            controlled.snapshot = [target](std::string& message) { return target->snapshot(message); };
+            control->addChild(target->config().name, std::move(controlled));
+        }
+    }
+
+    onStateChange();
+    loop.run();
+
+    bool success = true;
+    for (const std::unique_ptr<PoolMember>& member : members) {
+        success = success && !member->failed();
+    }
+    return success;
+}
+
+#else
+
+bool runChildPool(const std::vector<PoolChildConfig>&, const std::string&) {
+    std::cerr << u8"Windows 上暂不支持多程序监管" << std::endl;
+    return false;
+}
+
+#endif // _WIN32
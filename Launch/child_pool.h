@@ -0,0 +1,45 @@
+#ifndef CHILD_POOL_H
+#define CHILD_POOL_H
+
+#include <string>
+#include <vector>
+
+#include "launch_options.h"
+
+// 配置文件中的一个受监管程序
+struct PoolChildConfig {
+    std::string name;
+    std::string workDir;             // 子进程的工作目录
+    std::string program;             // 相对于 workDir 或绝对路径
+    std::vector<std::string> after;  // 启动前需要就绪的程序
+    LaunchOptions options;           // 启动器选项，叠加了配置文件中的设置
+};
+
+// 读取多程序监管的配置文件（INI 格式）：
+//
+//     ; 注释
+//     [defaults]              ; 对全部程序生效
+//     restart = on-failure
+//
+//     [llm]                   ; 程序名，只能包含字母、数字、'-'、'_' 与 '.'
+//     program = launcher/llm/llm
+//     arg = --port=8000
+//
+//     [tts]
+//     program = launcher/tts/tts
+//     after = llm             ; 逗号分隔，启动顺序依赖
+//
+// program、workdir 与 after 以外的键与启动器命令行选项同名（去掉前缀 "--"），值为空时只写键名。
+// workdir 缺省为 program 所在目录。每个程序的选项依次由命令行（"--" 之前的部分）、[defaults] 与
+// 自己的小节叠加而成，崩溃日志缺省写入 crashlogs/<程序名>，输出缓冲区缺省为 1 MB。
+// 结果按启动顺序排列（依赖在前）；程序名重复、依赖不存在或存在循环依赖时返回 false
+bool loadPoolConfig(const std::string& path, int argc, char* argv[], std::vector<PoolChildConfig>& children,
+                    std::string& error);
+
+// 在一个事件循环中监管全部程序：每个程序有独立的输出缓冲区、重启策略、挂起看门狗与崩溃日志目录。
+// 依赖的程序第一次输出或以退出码 0 结束后视为就绪，此后才启动依赖它的程序。
+// controlSocket 非空时在该路径上提供控制接口（见 control_socket.h）。
+// 全部程序都停止后返回；有程序以崩溃结束时返回 false。仅在 Linux/macOS 上实现
+bool runChildPool(const std::vector<PoolChildConfig>& children, const std::string& controlSocket);
+
+#endif // CHILD_POOL_H
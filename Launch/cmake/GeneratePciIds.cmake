@@ -0,0 +1,83 @@
+# 根据 pci.ids 生成 pci_ids_generated.h：全部厂商名称，以及常见显卡厂商的设备名称。
+# 用法：cmake -DPCI_IDS_FILE=<pci.ids> -DOUTPUT_FILE=<header> -P GeneratePciIds.cmake
+
+if(NOT PCI_IDS_FILE OR NOT OUTPUT_FILE)
+    message(FATAL_ERROR "需要指定 PCI_IDS_FILE 和 OUTPUT_FILE")
+endif()
+
+# 只保留这些厂商的设备表，其余厂商只保留名称，控制生成的表大小
+set(GPU_VENDORS
+    "1002" # AMD/ATI
+    "10de" # NVIDIA
+    "8086" # Intel
+    "1a03" # ASPEED
+    "102b" # Matrox
+    "15ad" # VMware
+    "1234" # QEMU
+    "1af4" # Red Hat (virtio)
+    "1414" # Microsoft (Hyper-V)
+    "80ee" # VirtualBox
+    "5143" # Qualcomm
+    "1ed5" # Moore Threads
+)
+
+# 厂商行为 "xxxx  名称"，设备行为 "\txxxx  名称"，更深缩进的子系统行与 C 开头的类别表不需要。
+# 名称中可能出现分号与方括号（例如 "Radeon HD 4850 [RV770]"），作为 CMake 列表元素时会被拆开或让其后的
+# 分号失效，因此读取整个文件后先替换为控制字符再按行匹配（每项以换行开头，避免匹配到子系统行中间），写入表项前再换回
+string(ASCII 1 SEMICOLON)
+string(ASCII 2 OPEN_BRACKET)
+string(ASCII 3 CLOSE_BRACKET)
+file(READ "${PCI_IDS_FILE}" PCI_TEXT)
+string(REPLACE ";" "${SEMICOLON}" PCI_TEXT "${PCI_TEXT}")
+string(REPLACE "[" "${OPEN_BRACKET}" PCI_TEXT "${PCI_TEXT}")
+string(REPLACE "]" "${CLOSE_BRACKET}" PCI_TEXT "${PCI_TEXT}")
+string(REGEX MATCHALL "\n\t?[0-9a-f][0-9a-f][0-9a-f][0-9a-f]  [^\n]*" PCI_LINES "${PCI_TEXT}")
+
+set(VENDOR_ENTRIES "")
+set(DEVICE_ENTRIES "")
+set(CURRENT_VENDOR "")
+set(KEEP_DEVICES FALSE)
+
+foreach(LINE IN LISTS PCI_LINES)
+    if(LINE MATCHES "^\n([0-9a-f][0-9a-f][0-9a-f][0-9a-f])  (.*)$")
+        set(CURRENT_VENDOR "${CMAKE_MATCH_1}")
+        set(NAME "${CMAKE_MATCH_2}")
+        string(REPLACE "\\" "\\\\" NAME "${NAME}")
+        string(REPLACE "\"" "\\\"" NAME "${NAME}")
+        string(REPLACE "${SEMICOLON}" ";" NAME "${NAME}")
+        string(REPLACE "${OPEN_BRACKET}" "[" NAME "${NAME}")
+        string(REPLACE "${CLOSE_BRACKET}" "]" NAME "${NAME}")
+        string(APPEND VENDOR_ENTRIES "    {0x${CURRENT_VENDOR}, \"${NAME}\"},\n")
+        list(FIND GPU_VENDORS "${CURRENT_VENDOR}" VENDOR_INDEX)
+        if(VENDOR_INDEX EQUAL -1)
+            set(KEEP_DEVICES FALSE)
+        else()
+            set(KEEP_DEVICES TRUE)
+        endif()
+    elseif(KEEP_DEVICES AND LINE MATCHES "^\n\t([0-9a-f][0-9a-f][0-9a-f][0-9a-f])  (.*)$")
+        set(DEVICE "${CMAKE_MATCH_1}")
+        set(NAME "${CMAKE_MATCH_2}")
+        string(REPLACE "\\" "\\\\" NAME "${NAME}")
+        string(REPLACE "\"" "\\\"" NAME "${NAME}")
+        string(REPLACE "${SEMICOLON}" ";" NAME "${NAME}")
+        string(REPLACE "${OPEN_BRACKET}" "[" NAME "${NAME}")
+        string(REPLACE "${CLOSE_BRACKET}" "]" NAME "${NAME}")
+        string(APPEND DEVICE_ENTRIES "    {0x${CURRENT_VENDOR}${DEVICE}u, \"${NAME}\"},\n")
+    endif()
+endforeach()
+
+file(WRITE "${OUTPUT_FILE}.tmp"
+"// 由 cmake/GeneratePciIds.cmake 根据 pci.ids 自动生成，请勿手动修改
+// 两张表均按 ID 升序排列，供二分查找使用；最后一项为不参与查找的结束标记
+
+static const PciVendorEntry kPciVendors[] = {
+${VENDOR_ENTRIES}    {0xffff, nullptr},
+};
+
+static const PciDeviceEntry kPciDevices[] = {
+${DEVICE_ENTRIES}    {0xffffffffu, nullptr},
+};
+")
+# 内容未变化时不更新时间戳，避免触发重新编译
+configure_file("${OUTPUT_FILE}.tmp" "${OUTPUT_FILE}" COPYONLY)
+file(REMOVE "${OUTPUT_FILE}.tmp")
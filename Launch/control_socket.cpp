@@ -0,0 +1,506 @@
+#include "control_socket.h"
+
+#ifndef _WIN32
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+namespace {
+
+// 单个请求行与同时连接数的上限，防止异常客户端占用过多内存
+const size_t kMaxRequestLine = 4096;
+const size_t kMaxConnections = 32;
+const size_t kDefaultTailBytes = 64 * 1024;
+const int kRateIntervalMs = 1000;
+
+void setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags != -1) {
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    }
+}
+
+bool fillAddress(const std::string& path, sockaddr_un& address) {
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+// 已有启动器在监听同一路径时返回 true；残留的套接字文件连接会失败
+bool socketInUse(const sockaddr_un& address) {
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        return false;
+    }
+    bool inUse = connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+    close(fd);
+    return inUse;
+}
+
+std::string ok(const std::string& body) {
+    return "ok " + std::to_string(body.size()) + "\n" + body;
+}
+
+std::string error(const std::string& message) {
+    return "error " + message + "\n";
+}
+
+// Prometheus 标签值中的反斜杠、引号与换行需要转义
+std::string labelValue(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '\\' || c == '"') {
+            escaped += '\\';
+            escaped += c;
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+double uptimeSeconds(const ControlChildStatus& status, int64_t nowUnixMs) {
+    return status.pid > 0 ? (nowUnixMs - status.startUnixMs) / 1000.0 : 0;
+}
+
+} // namespace
+
+ControlServer::ControlServer(EventLoop& loop, const std::string& socketPath) : loop(loop), path(socketPath) {
+    sockaddr_un address;
+    if (!fillAddress(path, address)) {
+        std::cerr << u8"控制套接字路径过长: " << path << std::endl;
+        return;
+    }
+    if (socketInUse(address)) {
+        std::cerr << u8"控制套接字已被另一个启动器使用: " << path << std::endl;
+        return;
+    }
+    unlink(path.c_str());
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd == -1) {
+        std::cerr << u8"创建控制套接字失败: " << std::strerror(errno) << std::endl;
+        return;
+    }
+    // 只允许启动器所属的用户连接
+    mode_t oldMask = umask(0177);
+    int bound = bind(listenFd, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+    umask(oldMask);
+    if (bound == -1 || listen(listenFd, 8) == -1) {
+        std::cerr << u8"无法监听控制套接字 " << path << ": " << std::strerror(errno) << std::endl;
+        close(listenFd);
+        listenFd = -1;
+        return;
+    }
+    setNonBlocking(listenFd);
+    loop.addFd(listenFd, [this]() { acceptConnections(); });
+    lastRateNs = monotonicNanos();
+    rateTimer = loop.addTimer(std::chrono::milliseconds(kRateIntervalMs), [this]() { updateRates(); });
+    std::cout << u8"控制套接字: " << path << std::endl;
+}
+
+ControlServer::~ControlServer() {
+    while (!connections.empty()) {
+        closeConnection(connections.begin()->first);
+    }
+    if (rateTimer != -1) {
+        loop.cancelTimer(rateTimer);
+    }
+    if (listenFd != -1) {
+        loop.removeFd(listenFd);
+        close(listenFd);
+        unlink(path.c_str());
+    }
+}
+
+void ControlServer::addChild(const std::string& name, ControlChild child) {
+    Entry entry;
+    entry.name = name;
+    entry.child = std::move(child);
+    children.push_back(std::move(entry));
+}
+
+void ControlServer::acceptConnections() {
+    while (true) {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd == -1) {
+            return;
+        }
+        if (connections.size() >= kMaxConnections) {
+            close(fd);
+            continue;
+        }
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        setNonBlocking(fd);
+#ifdef SO_NOSIGPIPE
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+        connections[fd] = Connection();
+        loop.addFd(fd, [this, fd]() { readRequests(fd); });
+    }
+}
+
+void ControlServer::readRequests(int fd) {
+    char buffer[4096];
+    ssize_t count = read(fd, buffer, sizeof(buffer));
+    if (count == -1 && (errno == EAGAIN || errno == EINTR)) {
+        return;
+    }
+    if (count <= 0) {
+        closeConnection(fd);
+        return;
+    }
+
+    Connection& connection = connections[fd];
+    connection.input.append(buffer, static_cast<size_t>(count));
+    size_t newline;
+    while (!connection.closeAfterWrite && (newline = connection.input.find('\n')) != std::string::npos) {
+        std::string line = connection.input.substr(0, newline);
+        connection.input.erase(0, newline + 1);
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        handleRequest(connection, line);
+    }
+    if (connection.input.size() > kMaxRequestLine) {
+        connection.output += error("request too long");
+        connection.closeAfterWrite = true;
+    }
+    flush(fd);
+}
+
+void ControlServer::flush(int fd) {
+    auto it = connections.find(fd);
+    if (it == connections.end()) {
+        return;
+    }
+    Connection& connection = it->second;
+    while (connection.written < connection.output.size()) {
+#ifdef MSG_NOSIGNAL
+        ssize_t count = send(fd, connection.output.data() + connection.written,
+                             connection.output.size() - connection.written, MSG_NOSIGNAL);
+#else
+        ssize_t count = send(fd, connection.output.data() + connection.written,
+                             connection.output.size() - connection.written, 0);
+#endif
+        if (count == -1 && errno == EINTR) {
+            continue;
+        }
+        if (count == -1 && errno == EAGAIN) {
+            // 套接字缓冲区已满，可写时继续
+            if (!connection.waitingWritable) {
+                connection.waitingWritable = true;
+                loop.setWritable(fd, [this, fd]() { flush(fd); });
+            }
+            return;
+        }
+        if (count <= 0) {
+            closeConnection(fd);
+            return;
+        }
+        connection.written += static_cast<size_t>(count);
+    }
+    connection.output.clear();
+    connection.written = 0;
+    if (connection.waitingWritable) {
+        connection.waitingWritable = false;
+        loop.setWritable(fd, nullptr);
+    }
+    if (connection.closeAfterWrite) {
+        closeConnection(fd);
+    }
+}
+
+void ControlServer::closeConnection(int fd) {
+    loop.removeFd(fd);
+    close(fd);
+    connections.erase(fd);
+}
+
+ControlServer::Entry* ControlServer::findChild(const std::string& name, std::string& message) {
+    if (name.empty()) {
+        if (children.size() == 1) {
+            return &children.front();
+        }
+        message = "child name required";
+        return nullptr;
+    }
+    for (Entry& entry : children) {
+        if (entry.name == name) {
+            return &entry;
+        }
+    }
+    message = "no such child: " + name;
+    return nullptr;
+}
+
+void ControlServer::handleRequest(Connection& connection, const std::string& line) {
+    requests++;
+    if (line.compare(0, 4, "GET ") == 0) {
+        std::string body = renderMetrics();
+        bool found = line.compare(4, 9, "/metrics ") == 0 || line.compare(4, 9, "/metrics") == 0;
+        if (!found) {
+            body = "not found\n";
+        }
+        connection.output += std::string(found ? "HTTP/1.0 200 OK\r\n" : "HTTP/1.0 404 Not Found\r\n") +
+                             "Content-Type: text/plain; version=0.0.4\r\n"
+                             "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+        connection.closeAfterWrite = true;
+        return;
+    }
+
+    std::istringstream words(line);
+    std::string command;
+    std::string name;
+    words >> command >> name;
+    std::string message;
+    if (command == "metrics") {
+        connection.output += ok(renderMetrics());
+    } else if (command == "status") {
+        std::string body;
+        for (const Entry& entry : children) {
+            if (name.empty() || entry.name == name) {
+                body += (body.empty() ? "" : "\n") + renderStatus(entry);
+            }
+        }
+        connection.output += body.empty() ? error("no such child: " + name) : ok(body);
+    } else if (command == "tail") {
+        Entry* entry = findChild(name, message);
+        if (!entry) {
+            connection.output += error(message);
+            return;
+        }
+        size_t limit = kDefaultTailBytes;
+        std::string count;
+        if (words >> count) {
+            limit = std::strtoull(count.c_str(), nullptr, 10);
+        }
+        std::ostringstream tail;
+        ControlChildStatus status = entry->child.status();
+        if (status.output) {
+            status.output->writeTo(tail);
+        }
+        std::string body = tail.str();
+        connection.output += ok(body.size() > limit ? body.substr(body.size() - limit) : body);
+    } else if (command == "restart" || command == "snapshot") {
+        Entry* entry = findChild(name, message);
+        if (!entry) {
+            connection.output += error(message);
+            return;
+        }
+        const std::function<bool(std::string&)>& action =
+            command == "restart" ? entry->child.restart : entry->child.snapshot;
+        if (action && action(message)) {
+            connection.output += ok(message.empty() ? "" : message + "\n");
+        } else {
+            connection.output += error(message.empty() ? "not supported" : message);
+        }
+    } else {
+        connection.output += error("unknown command: " + command);
+    }
+}
+
+std::string ControlServer::renderStatus(const Entry& entry) {
+    ControlChildStatus status = entry.child.status();
+    std::ostringstream out;
+    out << "name=" << entry.name << "\n";
+    out << "state=" << status.state << "\n";
+    out << "pid=" << status.pid << "\n";
+    out << "uptime_seconds=" << std::fixed << std::setprecision(3) << uptimeSeconds(status, unixMillis()) << "\n";
+    out << std::defaultfloat;
+    out << "restarts=" << status.restarts << "\n";
+    if (status.hasExited) {
+        out << "last_exit=" << (status.lastExitSignaled ? "signal " : "exit ") << status.lastExitValue << "\n";
+    }
+    if (status.output) {
+        uint64_t total = status.output->totalBytes();
+        out << "output_bytes_total=" << entry.outputBytes + (total >= entry.lastTotal ? total - entry.lastTotal : total)
+            << "\n";
+        out << "output_bytes_per_second=" << entry.bytesPerSecond << "\n";
+        out << "ring_used_bytes=" << status.output->size() << "\n";
+        out << "ring_capacity_bytes=" << status.output->capacity() << "\n";
+    }
+    // 采样器保留上一次运行的数据，程序未运行时不报告
+    if (status.pid > 0 && status.telemetry && status.telemetry->latest()) {
+        const TelemetrySample& sample = *status.telemetry->latest();
+        out << "cpu_percent=" << sample.cpuPercent << "\n";
+        out << "rss_bytes=" << sample.rssBytes << "\n";
+        out << "processes=" << sample.processes << "\n";
+        out << "threads=" << sample.threads << "\n";
+        out << "fds=" << sample.fds << "\n";
+        out << "io_read_bytes=" << sample.readBytes << "\n";
+        out << "io_write_bytes=" << sample.writeBytes << "\n";
+    }
+    return out.str();
+}
+
+std::string ControlServer::renderMetrics() {
+    struct Row {
+        std::string label;
+        ControlChildStatus status;
+        const Entry* entry;
+    };
+    std::vector<Row> rows;
+    for (const Entry& entry : children) {
+        rows.push_back(Row{"{child=\"" + labelValue(entry.name) + "\"}", entry.child.status(), &entry});
+    }
+    int64_t nowUnixMs = unixMillis();
+
+    std::ostringstream out;
+    auto family = [&](const char* name, const char* type, const char* help,
+                      const std::function<bool(const Row&, double&)>& value) {
+        out << "# HELP " << name << " " << help << "\n";
+        out << "# TYPE " << name << " " << type << "\n";
+        for (const Row& row : rows) {
+            double number = 0;
+            if (value(row, number)) {
+                out << name << row.label << " ";
+                // 计数器按整数写出，避免默认精度下变成科学计数法
+                if (number == static_cast<double>(static_cast<int64_t>(number))) {
+                    out << static_cast<int64_t>(number) << "\n";
+                } else {
+                    out << number << "\n";
+                }
+            }
+        }
+    };
+    auto latest = [](const Row& row) -> const TelemetrySample* {
+        return row.status.pid > 0 && row.status.telemetry ? row.status.telemetry->latest() : nullptr;
+    };
+
+    family("launcher_child_up", "gauge", "Whether the child process is running.", [](const Row& row, double& v) {
+        v = row.status.pid > 0 ? 1 : 0;
+        return true;
+    });
+    family("launcher_child_pid", "gauge", "Process id of the running child.", [](const Row& row, double& v) {
+        v = row.status.pid;
+        return row.status.pid > 0;
+    });
+    family("launcher_child_uptime_seconds", "gauge", "Seconds since the current run started.",
+           [nowUnixMs](const Row& row, double& v) {
+        v = uptimeSeconds(row.status, nowUnixMs);
+        return row.status.pid > 0;
+    });
+    family("launcher_child_restarts_total", "counter", "Restarts performed by the launcher.",
+           [](const Row& row, double& v) {
+        v = row.status.restarts;
+        return true;
+    });
+    family("launcher_child_last_exit_code", "gauge", "Exit code of the last run that exited normally.",
+           [](const Row& row, double& v) {
+        v = row.status.lastExitValue;
+        return row.status.hasExited && !row.status.lastExitSignaled;
+    });
+    family("launcher_child_last_exit_signal", "gauge", "Signal that terminated the last run.",
+           [](const Row& row, double& v) {
+        v = row.status.lastExitValue;
+        return row.status.hasExited && row.status.lastExitSignaled;
+    });
+    family("launcher_child_output_bytes_total", "counter", "Bytes written to stdout and stderr.",
+           [](const Row& row, double& v) {
+        if (!row.status.output) {
+            return false;
+        }
+        uint64_t total = row.status.output->totalBytes();
+        v = static_cast<double>(row.entry->outputBytes +
+                                (total >= row.entry->lastTotal ? total - row.entry->lastTotal : total));
+        return true;
+    });
+    family("launcher_child_output_bytes_per_second", "gauge", "Output rate over the last second.",
+           [](const Row& row, double& v) {
+        v = row.entry->bytesPerSecond;
+        return row.status.output != nullptr;
+    });
+    family("launcher_child_output_buffer_used_bytes", "gauge", "Bytes retained in the crash log output buffer.",
+           [](const Row& row, double& v) {
+        v = row.status.output ? static_cast<double>(row.status.output->size()) : 0;
+        return row.status.output != nullptr;
+    });
+    family("launcher_child_output_buffer_capacity_bytes", "gauge", "Capacity of the crash log output buffer.",
+           [](const Row& row, double& v) {
+        v = row.status.output ? static_cast<double>(row.status.output->capacity()) : 0;
+        return row.status.output != nullptr;
+    });
+    family("launcher_child_cpu_percent", "gauge", "CPU usage of the process tree, relative to one core.",
+           [&latest](const Row& row, double& v) {
+        const TelemetrySample* sample = latest(row);
+        v = sample ? sample->cpuPercent : 0;
+        return sample != nullptr;
+    });
+    family("launcher_child_resident_memory_bytes", "gauge", "Resident memory of the process tree.",
+           [&latest](const Row& row, double& v) {
+        const TelemetrySample* sample = latest(row);
+        v = sample ? static_cast<double>(sample->rssBytes) : 0;
+        return sample != nullptr;
+    });
+    family("launcher_child_threads", "gauge", "Threads in the process tree.", [&latest](const Row& row, double& v) {
+        const TelemetrySample* sample = latest(row);
+        v = sample ? sample->threads : 0;
+        return sample != nullptr;
+    });
+    family("launcher_child_processes", "gauge", "Processes in the process tree.", [&latest](const Row& row, double& v) {
+        const TelemetrySample* sample = latest(row);
+        v = sample ? sample->processes : 0;
+        return sample != nullptr;
+    });
+    family("launcher_child_open_fds", "gauge", "Open file descriptors in the process tree.",
+           [&latest](const Row& row, double& v) {
+        const TelemetrySample* sample = latest(row);
+        v = sample ? sample->fds : 0;
+        return sample != nullptr;
+    });
+    family("launcher_child_io_read_bytes", "gauge", "Bytes read from storage by the current run.",
+           [&latest](const Row& row, double& v) {
+        const TelemetrySample* sample = latest(row);
+        v = sample ? static_cast<double>(sample->readBytes) : 0;
+        return sample != nullptr;
+    });
+    family("launcher_child_io_write_bytes", "gauge", "Bytes written to storage by the current run.",
+           [&latest](const Row& row, double& v) {
+        const TelemetrySample* sample = latest(row);
+        v = sample ? static_cast<double>(sample->writeBytes) : 0;
+        return sample != nullptr;
+    });
+    out << "# HELP launcher_control_requests_total Requests served by the control socket.\n";
+    out << "# TYPE launcher_control_requests_total counter\n";
+    out << "launcher_control_requests_total " << requests << "\n";
+    return out.str();
+}
+
+void ControlServer::updateRates() {
+    int64_t now = monotonicNanos();
+    double seconds = (now - lastRateNs) / 1e9;
+    lastRateNs = now;
+    for (Entry& entry : children) {
+        ControlChildStatus status = entry.child.status();
+        if (!status.output) {
+            continue;
+        }
+        // 重启后输出缓冲区从 0 重新计数
+        uint64_t total = status.output->totalBytes();
+        uint64_t delta = total >= entry.lastTotal ? total - entry.lastTotal : total;
+        entry.outputBytes += delta;
+        entry.lastTotal = total;
+        entry.bytesPerSecond = seconds > 0 ? delta / seconds : 0;
+    }
+}
+
+#endif // _WIN32
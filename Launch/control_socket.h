@@ -0,0 +1,98 @@
+#ifndef CONTROL_SOCKET_H
+#define CONTROL_SOCKET_H
+
+#ifndef _WIN32
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "output_buffer.h"
+#include "supervisor.h"
+#include "telemetry.h"
+
+// 控制接口看到的一个受监管程序的当前状态
+struct ControlChildStatus {
+    const char* state = "running";          // waiting、running、backoff、stopped
+    int pid = -1;                           // 未运行时为 -1
+    int64_t startUnixMs = 0;                // 本次运行的启动时刻
+    int restarts = 0;                       // 累计重启次数
+    bool hasExited = false;                 // 是否有过退出，下面两项只在此时有效
+    bool lastExitSignaled = false;
+    int lastExitValue = 0;                  // 退出码或信号
+    const OutputRingBuffer* output = nullptr;
+    const ProcessTreeSampler* telemetry = nullptr;  // 未启用采样时为空
+};
+
+// 控制接口对一个程序可以执行的操作，全部在监管事件循环中调用。失败时在 message 中说明原因
+struct ControlChild {
+    std::function<ControlChildStatus()> status;
+    // 结束当前运行并立即重新启动，不计入崩溃次数
+    std::function<bool(std::string& message)> restart;
+    // 不终止程序，按崩溃日志的格式写出当前状态，message 为生成的文件名
+    std::function<bool(std::string& message)> snapshot;
+};
+
+// 本地控制接口：监听 Unix 域套接字，在监管事件循环中处理请求，不创建线程。
+// 每个请求是一行文本，响应为 "ok <字节数>\n<内容>" 或 "error <原因>\n"，连接可以连续发送多个请求：
+//
+//     status [程序名]           各程序的状态，key=value 形式，程序之间空一行
+//     metrics                   Prometheus 文本格式的指标
+//     restart <程序名>          结束并立即重启程序
+//     tail <程序名> [字节数]    输出缓冲区中最近的输出，缺省 64 KB
+//     snapshot <程序名>         不终止程序，生成一份快照报告
+//
+// 只有一个程序时可以省略程序名。以 "GET /metrics" 开头的请求按 HTTP/1.0 返回指标后关闭连接，
+// 可用 curl --unix-socket 或经 socat 转发给 Prometheus 抓取
+class ControlServer {
+public:
+    ControlServer(EventLoop& loop, const std::string& socketPath);
+    ~ControlServer();
+    ControlServer(const ControlServer&) = delete;
+    ControlServer& operator=(const ControlServer&) = delete;
+
+    bool listening() const { return listenFd != -1; }
+
+    void addChild(const std::string& name, ControlChild child);
+
+private:
+    struct Connection {
+        std::string input;
+        std::string output;
+        size_t written = 0;
+        bool closeAfterWrite = false;
+        bool waitingWritable = false;  // 响应未写完，正在等待可写事件
+    };
+    struct Entry {
+        std::string name;
+        ControlChild child;
+        uint64_t lastTotal = 0;        // 上一次计算速率时输出缓冲区的累计字节数
+        uint64_t outputBytes = 0;      // 跨越重启的累计输出字节数
+        double bytesPerSecond = 0;
+    };
+
+    void acceptConnections();
+    void readRequests(int fd);
+    void flush(int fd);
+    void closeConnection(int fd);
+    void handleRequest(Connection& connection, const std::string& line);
+    Entry* findChild(const std::string& name, std::string& error);
+    std::string renderStatus(const Entry& entry);
+    std::string renderMetrics();
+    void updateRates();
+
+    EventLoop& loop;
+    std::string path;
+    int listenFd = -1;
+    int rateTimer = -1;
+    int64_t lastRateNs = 0;
+    uint64_t requests = 0;
+    std::map<int, Connection> connections;
+    std::vector<Entry> children;
+};
+
+#endif // _WIN32
+
+#endif // CONTROL_SOCKET_H
@@ -0,0 +1,687 @@
+#include "core_dump.h"
+
+#ifdef __linux__
+
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+
+#include <cxxabi.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <glob.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "proc_fs.h"
+
+namespace {
+
+// 出错线程保留 sp 之上这么多字节的栈，其余线程只保留栈顶
+const uint64_t kFaultingStackBytes = 256 * 1024;
+const uint64_t kOtherStackBytes = 16 * 1024;
+const uint64_t kRedZoneBytes = 256;
+const size_t kMaxFrames = 64;
+const uint64_t kStackScanBytes = 16 * 1024;
+
+// elf_prstatus 中各字段的偏移（64 位 Linux 上与架构无关）
+const size_t kPrstatusCursigOffset = 12;
+const size_t kPrstatusPidOffset = 32;
+const size_t kPrstatusRegsOffset = 112;
+
+// 只读映射整个文件
+class MappedFile {
+public:
+    ~MappedFile() {
+        if (data) {
+            munmap(const_cast<unsigned char*>(data), size);
+        }
+    }
+
+    bool open(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1) {
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+            close(fd);
+            return false;
+        }
+        void* address = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (address == MAP_FAILED) {
+            return false;
+        }
+        data = static_cast<const unsigned char*>(address);
+        size = static_cast<size_t>(st.st_size);
+        return true;
+    }
+
+    bool contains(uint64_t offset, uint64_t length) const {
+        return offset <= size && length <= size - offset;
+    }
+
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+};
+
+template <typename T>
+T readAt(const unsigned char* p) {
+    T value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+// ELF 文件的可执行段与函数符号，用于把运行时地址换算成 “函数名+偏移”
+class ElfSymbols {
+public:
+    bool load(const std::string& path) {
+        if (!file.open(path) || file.size < sizeof(Elf64_Ehdr)) {
+            return false;
+        }
+        const Elf64_Ehdr* header = reinterpret_cast<const Elf64_Ehdr*>(file.data);
+        if (std::memcmp(header->e_ident, ELFMAG, SELFMAG) != 0 || header->e_ident[EI_CLASS] != ELFCLASS64) {
+            return false;
+        }
+
+        if (file.contains(header->e_phoff, static_cast<uint64_t>(header->e_phnum) * sizeof(Elf64_Phdr))) {
+            for (int i = 0; i < header->e_phnum; i++) {
+                Elf64_Phdr phdr = readAt<Elf64_Phdr>(file.data + header->e_phoff + i * sizeof(Elf64_Phdr));
+                if (phdr.p_type == PT_LOAD) {
+                    segments.push_back(phdr);
+                }
+            }
+        }
+
+        // 优先使用完整符号表，被 strip 的文件退回到动态符号表
+        if (!loadSymbols(header, SHT_SYMTAB)) {
+            loadSymbols(header, SHT_DYNSYM);
+        }
+        std::sort(symbols.begin(), symbols.end(),
+                  [](const Symbol& a, const Symbol& b) { return a.address < b.address; });
+        return true;
+    }
+
+    bool fileOffsetToAddress(uint64_t offset, uint64_t& address, bool& executable) const {
+        for (const Elf64_Phdr& segment : segments) {
+            if (offset >= segment.p_offset && offset < segment.p_offset + segment.p_filesz) {
+                address = offset - segment.p_offset + segment.p_vaddr;
+                executable = (segment.p_flags & PF_X) != 0;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const char* lookup(uint64_t address, uint64_t& displacement) const {
+        auto it = std::upper_bound(symbols.begin(), symbols.end(), address,
+                                   [](uint64_t value, const Symbol& symbol) { return value < symbol.address; });
+        if (it == symbols.begin()) {
+            return nullptr;
+        }
+        --it;
+        // 大小为 0 的符号（手写汇编等）只在紧邻时采用
+        uint64_t limit = it->size > 0 ? it->size : 4096;
+        if (address - it->address >= limit) {
+            return nullptr;
+        }
+        displacement = address - it->address;
+        return it->name;
+    }
+
+private:
+    struct Symbol {
+        uint64_t address;
+        uint64_t size;
+        const char* name;
+    };
+
+    bool loadSymbols(const Elf64_Ehdr* header, uint32_t type) {
+        if (header->e_shentsize != sizeof(Elf64_Shdr) ||
+            !file.contains(header->e_shoff, static_cast<uint64_t>(header->e_shnum) * sizeof(Elf64_Shdr))) {
+            return false;
+        }
+        const Elf64_Shdr* sections = reinterpret_cast<const Elf64_Shdr*>(file.data + header->e_shoff);
+        bool found = false;
+        for (int i = 0; i < header->e_shnum; i++) {
+            const Elf64_Shdr& section = sections[i];
+            if (section.sh_type != type || section.sh_link >= header->e_shnum ||
+                !file.contains(section.sh_offset, section.sh_size)) {
+                continue;
+            }
+            const Elf64_Shdr& strings = sections[section.sh_link];
+            if (!file.contains(strings.sh_offset, strings.sh_size) || strings.sh_size == 0) {
+                continue;
+            }
+            const char* stringTable = reinterpret_cast<const char*>(file.data + strings.sh_offset);
+            size_t count = section.sh_size / sizeof(Elf64_Sym);
+            for (size_t j = 0; j < count; j++) {
+                Elf64_Sym symbol = readAt<Elf64_Sym>(file.data + section.sh_offset + j * sizeof(Elf64_Sym));
+                if (ELF64_ST_TYPE(symbol.st_info) != STT_FUNC || symbol.st_value == 0 ||
+                    symbol.st_name >= strings.sh_size) {
+                    continue;
+                }
+                symbols.push_back({symbol.st_value, symbol.st_size, stringTable + symbol.st_name});
+            }
+            found = true;
+        }
+        return found;
+    }
+
+    MappedFile file;
+    std::vector<Elf64_Phdr> segments;
+    std::vector<Symbol> symbols;
+};
+
+// 按地址查找模块并符号化，模块文件只在第一次用到时加载
+class Symbolizer {
+public:
+    explicit Symbolizer(const std::vector<MappedModule>& modules) : modules(modules) {}
+
+    // 地址是否位于某个模块的可执行段中
+    bool isCode(uint64_t address) {
+        uint64_t elfAddress;
+        bool executable;
+        const MappedModule* module = resolve(address, elfAddress, executable);
+        return module && (module->executable || executable);
+    }
+
+    // 地址是否恰好是某个函数的入口
+    bool isFunctionEntry(uint64_t address) {
+        uint64_t elfAddress = 0;
+        bool executable = false;
+        const MappedModule* module = resolve(address, elfAddress, executable);
+        ElfSymbols* elf = module ? symbolsFor(module->path) : nullptr;
+        uint64_t displacement = 1;
+        return elf && elfAddress != 0 && elf->lookup(elfAddress, displacement) && displacement == 0;
+    }
+
+    std::string describe(uint64_t address) {
+        char text[64];
+        std::snprintf(text, sizeof(text), "0x%016llx ", static_cast<unsigned long long>(address));
+        std::string result = text;
+
+        uint64_t elfAddress = 0;
+        bool executable = false;
+        const MappedModule* module = resolve(address, elfAddress, executable);
+        if (!module) {
+            return result + "?";
+        }
+
+        size_t slash = module->path.rfind('/');
+        result += slash == std::string::npos ? module->path : module->path.substr(slash + 1);
+
+        ElfSymbols* elf = symbolsFor(module->path);
+        uint64_t displacement = 0;
+        const char* name = (elf && elfAddress != 0) ? elf->lookup(elfAddress, displacement) : nullptr;
+        if (name) {
+            int status = 0;
+            char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+            std::snprintf(text, sizeof(text), "+0x%llx", static_cast<unsigned long long>(displacement));
+            result += "!" + std::string(status == 0 && demangled ? demangled : name) + text;
+            std::free(demangled);
+        } else {
+            std::snprintf(text, sizeof(text), "+0x%llx",
+                          static_cast<unsigned long long>(address - module->start + module->offset));
+            result += text;
+        }
+        return result;
+    }
+
+private:
+    const MappedModule* resolve(uint64_t address, uint64_t& elfAddress, bool& executable) {
+        for (const MappedModule& module : modules) {
+            if (address >= module.start && address < module.end) {
+                ElfSymbols* elf = symbolsFor(module.path);
+                elfAddress = 0;
+                executable = false;
+                if (elf) {
+                    elf->fileOffsetToAddress(address - module.start + module.offset, elfAddress, executable);
+                }
+                return &module;
+            }
+        }
+        return nullptr;
+    }
+
+    ElfSymbols* symbolsFor(const std::string& path) {
+        auto it = cache.find(path);
+        if (it == cache.end()) {
+            std::unique_ptr<ElfSymbols> elf(new ElfSymbols());
+            if (!elf->load(path)) {
+                elf.reset();
+            }
+            it = cache.emplace(path, std::move(elf)).first;
+        }
+        return it->second.get();
+    }
+
+    const std::vector<MappedModule>& modules;
+    std::map<std::string, std::unique_ptr<ElfSymbols>> cache;
+};
+
+struct CoreThread {
+    int tid = 0;
+    int signal = 0;
+    uint64_t pc = 0;
+    uint64_t sp = 0;
+    uint64_t fp = 0;
+    uint64_t lr = 0;
+    bool hasRegisters = false;
+};
+
+// 从 prstatus 的通用寄存器中取出 pc、sp、fp（以及 aarch64 的 lr）
+bool extractRegisters(uint16_t machine, const unsigned char* regs, size_t size, CoreThread& thread) {
+    auto reg = [regs](size_t index) { return readAt<uint64_t>(regs + index * 8); };
+    if (machine == EM_X86_64 && size >= 27 * 8) {
+        thread.fp = reg(4);    // rbp
+        thread.pc = reg(16);   // rip
+        thread.sp = reg(19);   // rsp
+        return true;
+    }
+    if (machine == EM_AARCH64 && size >= 34 * 8) {
+        thread.fp = reg(29);
+        thread.lr = reg(30);
+        thread.sp = reg(31);
+        thread.pc = reg(32);
+        return true;
+    }
+    return false;
+}
+
+void parseFileNote(const unsigned char* desc, size_t size, std::vector<MappedModule>& modules) {
+    if (size < 16) {
+        return;
+    }
+    uint64_t count = readAt<uint64_t>(desc);
+    uint64_t pageSize = readAt<uint64_t>(desc + 8);
+    if (count > (size - 16) / 24) {
+        return;
+    }
+    const char* names = reinterpret_cast<const char*>(desc + 16 + count * 24);
+    const char* namesEnd = reinterpret_cast<const char*>(desc + size);
+    for (uint64_t i = 0; i < count && names < namesEnd; i++) {
+        const unsigned char* entry = desc + 16 + i * 24;
+        MappedModule module;
+        module.start = readAt<uint64_t>(entry);
+        module.end = readAt<uint64_t>(entry + 8);
+        module.offset = readAt<uint64_t>(entry + 16) * pageSize;
+        size_t length = strnlen(names, static_cast<size_t>(namesEnd - names));
+        module.path.assign(names, length);
+        names += length + 1;
+        modules.push_back(module);
+    }
+}
+
+} // namespace
+
+std::vector<MappedModule> readProcessMaps(int pid) {
+    std::vector<MappedModule> modules;
+    std::ifstream maps("/proc/" + std::to_string(pid) + "/maps");
+    std::string line;
+    while (std::getline(maps, line)) {
+        unsigned long long start, end, offset;
+        char perms[8] = {};
+        int pathStart = 0;
+        if (std::sscanf(line.c_str(), "%llx-%llx %7s %llx %*s %*s %n", &start, &end, perms, &offset, &pathStart) < 4 ||
+            pathStart <= 0 || line[pathStart] != '/') {
+            continue;
+        }
+        MappedModule module;
+        module.start = start;
+        module.end = end;
+        module.offset = offset;
+        module.executable = perms[2] == 'x';
+        module.path = line.substr(static_cast<size_t>(pathStart));
+        modules.push_back(module);
+    }
+    return modules;
+}
+
+std::string locateCoreFile(int pid, const std::string& programName, const std::string& workDir,
+                           int64_t notBeforeUnixMs, std::string& reason) {
+    char buffer[512];
+    if (readSmallFile("/proc/sys/kernel/core_pattern", buffer, sizeof(buffer)) <= 0) {
+        reason = u8"无法读取 core_pattern";
+        return "";
+    }
+    std::string corePattern = buffer;
+    if (corePattern[0] == '|') {
+        reason = u8"核心转储交由 " + corePattern.substr(1) + u8" 处理";
+        return "";
+    }
+
+    // 展开能确定的占位符，其余（时间、信号等）用通配符匹配
+    std::string comm = programName.substr(programName.rfind('/') + 1).substr(0, 15);
+    std::string pattern;
+    bool hasPid = false;
+    for (size_t i = 0; i < corePattern.size(); i++) {
+        if (corePattern[i] != '%' || i + 1 >= corePattern.size()) {
+            pattern += corePattern[i];
+            continue;
+        }
+        char specifier = corePattern[++i];
+        switch (specifier) {
+            case '%': pattern += '%'; break;
+            case 'p': case 'P': case 'i': case 'I':
+                pattern += std::to_string(pid);
+                hasPid = true;
+                break;
+            case 'e': pattern += comm; break;
+            case 'u': pattern += std::to_string(getuid()); break;
+            case 'g': pattern += std::to_string(getgid()); break;
+            case 'h': {
+                char host[256] = {};
+                gethostname(host, sizeof(host) - 1);
+                pattern += host;
+                break;
+            }
+            default: pattern += '*'; break;
+        }
+    }
+    if (!hasPid && readSmallFile("/proc/sys/kernel/core_uses_pid", buffer, sizeof(buffer)) > 0 &&
+        std::strcmp(buffer, "1") == 0) {
+        pattern += "." + std::to_string(pid);
+    }
+    if (pattern[0] != '/') {
+        pattern = workDir + "/" + pattern;
+    }
+
+    glob_t matches;
+    std::string newest;
+    int64_t newestMs = 0;
+    if (glob(pattern.c_str(), 0, nullptr, &matches) == 0) {
+        for (size_t i = 0; i < matches.gl_pathc; i++) {
+            struct stat st;
+            if (stat(matches.gl_pathv[i], &st) != 0 || !S_ISREG(st.st_mode)) {
+                continue;
+            }
+            int64_t mtimeMs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000 + st.st_mtim.tv_nsec / 1000000;
+            // 文件系统时间戳可能比墙上时钟粗，留一秒余量
+            if (mtimeMs + 1000 >= notBeforeUnixMs && mtimeMs >= newestMs) {
+                newest = matches.gl_pathv[i];
+                newestMs = mtimeMs;
+            }
+        }
+    }
+    globfree(&matches);
+
+    if (newest.empty()) {
+        reason = u8"未找到核心文件 " + pattern;
+    }
+    return newest;
+}
+
+bool trimCoreDump(const std::string& corePath, const std::string& minidumpPath,
+                  const std::vector<MappedModule>& fallbackModules, NativeCrashInfo& info) {
+    MappedFile core;
+    if (!core.open(corePath) || core.size < sizeof(Elf64_Ehdr)) {
+        std::cerr << u8"无法读取核心文件: " << corePath << std::endl;
+        return false;
+    }
+    info.coreBytes = core.size;
+
+    const Elf64_Ehdr* header = reinterpret_cast<const Elf64_Ehdr*>(core.data);
+    if (std::memcmp(header->e_ident, ELFMAG, SELFMAG) != 0 || header->e_ident[EI_CLASS] != ELFCLASS64 ||
+        header->e_ident[EI_DATA] != ELFDATA2LSB || header->e_type != ET_CORE ||
+        header->e_phentsize != sizeof(Elf64_Phdr) ||
+        !core.contains(header->e_phoff, static_cast<uint64_t>(header->e_phnum) * sizeof(Elf64_Phdr))) {
+        std::cerr << u8"不是受支持的核心文件: " << corePath << std::endl;
+        return false;
+    }
+
+    std::vector<Elf64_Phdr> loads;
+    std::vector<Elf64_Phdr> notes;
+    for (int i = 0; i < header->e_phnum; i++) {
+        Elf64_Phdr phdr = readAt<Elf64_Phdr>(core.data + header->e_phoff + i * sizeof(Elf64_Phdr));
+        if (!core.contains(phdr.p_offset, phdr.p_filesz)) {
+            continue;  // 转储被截断（例如超过 RLIMIT_CORE）
+        }
+        if (phdr.p_type == PT_LOAD) {
+            loads.push_back(phdr);
+        } else if (phdr.p_type == PT_NOTE) {
+            notes.push_back(phdr);
+        }
+    }
+
+    // 解析线程寄存器、信号与模块列表。内核把触发转储的线程放在最前面
+    std::vector<CoreThread> threads;
+    std::vector<MappedModule> modules;
+    uint64_t faultAddress = 0;
+    bool hasFaultAddress = false;
+    for (const Elf64_Phdr& note : notes) {
+        const unsigned char* p = core.data + note.p_offset;
+        const unsigned char* end = p + note.p_filesz;
+        while (end - p >= static_cast<ptrdiff_t>(sizeof(Elf64_Nhdr))) {
+            Elf64_Nhdr nhdr = readAt<Elf64_Nhdr>(p);
+            size_t nameSize = (nhdr.n_namesz + 3) & ~static_cast<size_t>(3);
+            size_t descSize = (nhdr.n_descsz + 3) & ~static_cast<size_t>(3);
+            const unsigned char* desc = p + sizeof(Elf64_Nhdr) + nameSize;
+            if (desc + descSize > end) {
+                break;
+            }
+            if (nhdr.n_type == NT_PRSTATUS && nhdr.n_descsz > kPrstatusRegsOffset) {
+                CoreThread thread;
+                thread.signal = readAt<int16_t>(desc + kPrstatusCursigOffset);
+                thread.tid = readAt<int32_t>(desc + kPrstatusPidOffset);
+                thread.hasRegisters = extractRegisters(header->e_machine, desc + kPrstatusRegsOffset,
+                                                       nhdr.n_descsz - kPrstatusRegsOffset, thread);
+                threads.push_back(thread);
+            } else if (nhdr.n_type == NT_FILE) {
+                parseFileNote(desc, nhdr.n_descsz, modules);
+            } else if (nhdr.n_type == NT_SIGINFO && nhdr.n_descsz >= 24 && !hasFaultAddress) {
+                // siginfo_t：si_signo、si_errno、si_code 之后对齐到 8 字节是 si_addr
+                int signo = readAt<int32_t>(desc);
+                if (signo == SIGSEGV || signo == SIGBUS || signo == SIGILL || signo == SIGFPE) {
+                    faultAddress = readAt<uint64_t>(desc + 16);
+                    hasFaultAddress = true;
+                }
+            }
+            p = desc + descSize;
+        }
+    }
+    if (modules.empty()) {
+        modules = fallbackModules;
+    }
+
+    info.threadCount = threads.size();
+    info.modules = modules;
+    if (!threads.empty()) {
+        info.faultingThread = threads[0].tid;
+        info.signal = threads[0].signal;
+    }
+
+    auto findLoad = [&loads](uint64_t address) -> const Elf64_Phdr* {
+        for (const Elf64_Phdr& load : loads) {
+            if (address >= load.p_vaddr && address < load.p_vaddr + load.p_filesz) {
+                return &load;
+            }
+        }
+        return nullptr;
+    };
+    auto readWord = [&](uint64_t address, uint64_t& value) {
+        const Elf64_Phdr* load = findLoad(address);
+        if (!load || address + 8 > load->p_vaddr + load->p_filesz) {
+            return false;
+        }
+        value = readAt<uint64_t>(core.data + load->p_offset + (address - load->p_vaddr));
+        return true;
+    };
+
+    // 出错线程的调用栈：优先沿帧指针回溯，帧太少时扫描栈上指向代码的值
+    Symbolizer symbolizer(modules);
+    if (hasFaultAddress) {
+        char text[64];
+        std::snprintf(text, sizeof(text), "0x%016llx", static_cast<unsigned long long>(faultAddress));
+        info.backtrace.push_back(u8"访问地址 " + std::string(text));
+    }
+    if (!threads.empty() && threads[0].hasRegisters) {
+        const CoreThread& thread = threads[0];
+        std::vector<uint64_t> frames;
+        frames.push_back(thread.pc);
+        if (thread.lr != 0 && thread.lr != thread.pc) {
+            frames.push_back(thread.lr);
+        }
+        // x86_64 上停在函数入口时帧还没建立，返回地址就在栈顶
+        uint64_t topOfStack = 0;
+        if (header->e_machine == EM_X86_64 && symbolizer.isFunctionEntry(thread.pc) &&
+            readWord(thread.sp, topOfStack) && symbolizer.isCode(topOfStack)) {
+            frames.push_back(topOfStack);
+        }
+
+        uint64_t fp = thread.fp;
+        while (frames.size() < kMaxFrames && fp != 0 && (fp & 7) == 0 && fp >= thread.sp) {
+            uint64_t next = 0;
+            uint64_t returnAddress = 0;
+            if (!readWord(fp, next) || !readWord(fp + 8, returnAddress) || returnAddress == 0 ||
+                !symbolizer.isCode(returnAddress)) {
+                break;
+            }
+            if (frames.back() != returnAddress) {
+                frames.push_back(returnAddress);
+            }
+            if (next <= fp) {
+                break;
+            }
+            fp = next;
+        }
+
+        for (size_t i = 0; i < frames.size(); i++) {
+            char prefix[24];
+            std::snprintf(prefix, sizeof(prefix), "#%-2zu ", i);
+            info.backtrace.push_back(prefix + symbolizer.describe(frames[i]));
+        }
+
+        if (frames.size() < 3) {
+            size_t scanned = 0;
+            for (uint64_t address = thread.sp; address < thread.sp + kStackScanBytes && scanned < 32; address += 8) {
+                uint64_t value = 0;
+                if (!readWord(address, value)) {
+                    break;
+                }
+                if (value != thread.pc && symbolizer.isCode(value)) {
+                    info.backtrace.push_back(u8"?   " + symbolizer.describe(value) + u8"（栈扫描）");
+                    scanned++;
+                }
+            }
+        }
+    }
+
+    // 精简核心文件：原样保留全部注释段（各线程寄存器、模块列表等），内存只保留各线程的栈顶
+    struct Region {
+        uint64_t start;
+        uint64_t size;
+        uint64_t sourceOffset;
+    };
+    std::vector<Region> regions;
+    for (size_t i = 0; i < threads.size(); i++) {
+        if (!threads[i].hasRegisters) {
+            continue;
+        }
+        uint64_t sp = threads[i].sp;
+        const Elf64_Phdr* load = findLoad(sp);
+        if (!load) {
+            continue;
+        }
+        uint64_t start = std::max<uint64_t>(load->p_vaddr, sp > kRedZoneBytes ? (sp - kRedZoneBytes) & ~15ULL : 0);
+        uint64_t end = std::min<uint64_t>(load->p_vaddr + load->p_filesz,
+                                          sp + (i == 0 ? kFaultingStackBytes : kOtherStackBytes));
+        bool overlaps = false;
+        for (const Region& region : regions) {
+            if (start < region.start + region.size && region.start < end) {
+                overlaps = true;
+            }
+        }
+        if (!overlaps && end > start) {
+            regions.push_back({start, end - start, load->p_offset + (start - load->p_vaddr)});
+        }
+    }
+
+    uint64_t notesSize = 0;
+    for (const Elf64_Phdr& note : notes) {
+        notesSize += note.p_filesz;
+    }
+
+    Elf64_Ehdr outHeader = *header;
+    outHeader.e_phoff = sizeof(Elf64_Ehdr);
+    outHeader.e_phnum = static_cast<Elf64_Half>(1 + regions.size());
+    outHeader.e_shoff = 0;
+    outHeader.e_shnum = 0;
+    outHeader.e_shstrndx = SHN_UNDEF;
+
+    uint64_t offset = sizeof(Elf64_Ehdr) + outHeader.e_phnum * sizeof(Elf64_Phdr);
+    std::vector<Elf64_Phdr> outPhdrs;
+    Elf64_Phdr notePhdr{};
+    notePhdr.p_type = PT_NOTE;
+    notePhdr.p_offset = offset;
+    notePhdr.p_filesz = notesSize;
+    notePhdr.p_align = 4;
+    outPhdrs.push_back(notePhdr);
+    offset += notesSize;
+    for (const Region& region : regions) {
+        offset = (offset + 15) & ~15ULL;
+        Elf64_Phdr load{};
+        load.p_type = PT_LOAD;
+        load.p_flags = PF_R | PF_W;
+        load.p_offset = offset;
+        load.p_vaddr = region.start;
+        load.p_filesz = region.size;
+        load.p_memsz = region.size;
+        load.p_align = 1;
+        outPhdrs.push_back(load);
+        offset += region.size;
+    }
+
+    std::ofstream out(minidumpPath, std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << u8"无法创建精简核心文件: " << minidumpPath << std::endl;
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(&outHeader), sizeof(outHeader));
+    out.write(reinterpret_cast<const char*>(outPhdrs.data()),
+              static_cast<std::streamsize>(outPhdrs.size() * sizeof(Elf64_Phdr)));
+    for (const Elf64_Phdr& note : notes) {
+        out.write(reinterpret_cast<const char*>(core.data + note.p_offset), static_cast<std::streamsize>(note.p_filesz));
+    }
+    for (size_t i = 0; i < regions.size(); i++) {
+        static const char zeros[16] = {};
+        uint64_t position = static_cast<uint64_t>(out.tellp());
+        out.write(zeros, static_cast<std::streamsize>(outPhdrs[i + 1].p_offset - position));
+        out.write(reinterpret_cast<const char*>(core.data + regions[i].sourceOffset),
+                  static_cast<std::streamsize>(regions[i].size));
+    }
+    out.close();
+    if (out.fail()) {
+        std::cerr << u8"写入精简核心文件失败: " << minidumpPath << std::endl;
+        return false;
+    }
+
+    info.minidumpPath = minidumpPath;
+    info.minidumpBytes = offset;
+    return true;
+}
+
+#else
+
+std::vector<MappedModule> readProcessMaps(int) {
+    return {};
+}
+
+std::string locateCoreFile(int, const std::string&, const std::string&, int64_t, std::string& reason) {
+    reason = u8"当前平台不支持收集核心转储";
+    return "";
+}
+
+bool trimCoreDump(const std::string&, const std::string&, const std::vector<MappedModule>&, NativeCrashInfo&) {
+    return false;
+}
+
+#endif // __linux__
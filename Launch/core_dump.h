@@ -0,0 +1,47 @@
+#ifndef CORE_DUMP_H
+#define CORE_DUMP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 子进程被信号终止后的本机崩溃现场：从核心转储中提取出错线程的寄存器、各线程栈与已映射模块，
+// 写成只有几十 KB 的精简 ELF 核心文件（gdb <程序> <文件> 可直接打开），并给出符号化的调用栈。
+// 仅在 Linux 上实现，其他平台上各函数直接返回失败。
+
+// 进程中映射的一个文件
+struct MappedModule {
+    uint64_t start = 0;
+    uint64_t end = 0;
+    uint64_t offset = 0;  // 映射起点在文件中的偏移
+    bool executable = false;
+    std::string path;
+};
+
+// 读取 /proc/<pid>/maps 中映射了文件的区域，用于核心转储缺少模块列表时的符号化
+std::vector<MappedModule> readProcessMaps(int pid);
+
+// 根据 /proc/sys/kernel/core_pattern 找到子进程刚生成的核心文件。workDir 为子进程的工作目录，
+// 只接受修改时间不早于 notBeforeUnixMs 的文件。找不到时返回空字符串并在 reason 中说明原因
+std::string locateCoreFile(int pid, const std::string& programName, const std::string& workDir,
+                           int64_t notBeforeUnixMs, std::string& reason);
+
+// 精简后的核心转储摘要
+struct NativeCrashInfo {
+    int signal = 0;
+    int faultingThread = 0;
+    size_t threadCount = 0;
+    std::vector<std::string> backtrace;  // 出错线程的调用栈，已尽量符号化
+    std::vector<MappedModule> modules;
+    std::string minidumpPath;            // 精简核心文件，为空表示未写出
+    uint64_t coreBytes = 0;
+    uint64_t minidumpBytes = 0;
+};
+
+// 读取 corePath，写出精简核心文件到 minidumpPath 并填充 info。
+// 核心文件不含模块列表（NT_FILE）时使用 fallbackModules（运行期间的 maps 快照）
+bool trimCoreDump(const std::string& corePath, const std::string& minidumpPath,
+                  const std::vector<MappedModule>& fallbackModules, NativeCrashInfo& info);
+
+#endif // CORE_DUMP_H
@@ -0,0 +1,49 @@
+// 列出崩溃库（--crash-store）中最常见的崩溃，只读取索引文件
+#include "crash_store.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <string>
+
+int main(int argc, char* argv[])
+{
+    std::string root = "crashlogs";
+    size_t limit = 20;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 6, "--top=") == 0) {
+            limit = static_cast<size_t>(std::strtoul(arg.c_str() + 6, nullptr, 10));
+        } else if (arg.compare(0, 2, "--") == 0) {
+            std::cerr << u8"用法: " << argv[0] << u8" [崩溃库目录，缺省为 crashlogs] [--top=N]" << std::endl;
+            return 2;
+        } else {
+            root = arg;
+        }
+    }
+
+    CrashStore store(root, 0, 0);
+    if (!store.load()) {
+        std::cerr << u8"找不到崩溃库索引: " << root << std::endl;
+        return 1;
+    }
+
+    std::vector<CrashBucket> buckets = store.topBuckets(limit);
+    std::printf("%8s  %-19s  %-16s  %-14s  %s\n", "count", "last", "bucket", "outcome", "summary");
+    for (const CrashBucket& bucket : buckets) {
+        char last[32] = "-";
+        std::time_t seconds = static_cast<std::time_t>(bucket.lastUnixMs / 1000);
+        std::tm local{};
+#ifdef _WIN32
+        localtime_s(&local, &seconds);
+#else
+        localtime_r(&seconds, &local);
+#endif
+        std::strftime(last, sizeof(last), "%Y-%m-%d %H:%M:%S", &local);
+        std::string outcome = bucket.module.empty() ? bucket.outcome : bucket.outcome + " " + bucket.module;
+        std::printf("%8llu  %-19s  %-16s  %-14s  %s\n", static_cast<unsigned long long>(bucket.count), last,
+                    bucket.id.c_str(), outcome.c_str(), bucket.summary.c_str());
+    }
+    return 0;
+}
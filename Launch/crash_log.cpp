@@ -1,7 +1,20 @@
 #include "crash_log.h"
+#include "capture_log.h"
+#include "crash_store.h"
+#include "live_output.h"
+#include "startup_trace.h"
 #include "system_info.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
 #include <iostream>
+#include <memory>
+
+#ifdef LAUNCH_HAVE_LZ4
+    #include "lz4_frame.h"
+#endif
 
 #ifdef _WIN32
     #include <windows.h>
@@ -16,7 +29,18 @@
     #pragma comment(lib, "ole32.lib")
     #pragma comment(lib, "oleaut32.lib")
 #else
+    #include "cgroup_sandbox.h"
+    #include "control_socket.h"
+    #include "core_dump.h"
+    #include "hang_watchdog.h"
+    #ifdef __linux__
+        #include "proc_fs.h"
+    #endif
+    #include "mapped_capture.h"
+    #include "supervisor.h"
+    #include <signal.h>
     #include <unistd.h>
+    #include <sys/resource.h>
     #include <sys/wait.h>
     #ifdef __APPLE__
         #include <sys/types.h>
@@ -24,47 +48,172 @@
     #endif
 #endif
 
+// 打开文件并通过 render 写出内容；compress 时经由 LZ4 帧编码器边生成边压缩
+static bool writeArtifact(const std::string& fileName, bool compress, std::ios::openmode mode,
+                          const std::function<void(std::ostream&)>& render) {
+    std::ofstream file(fileName, compress ? std::ios::out | std::ios::binary : mode);
+    if (!file.is_open()) {
+        return false;
+    }
+
+#ifdef LAUNCH_HAVE_LZ4
+    if (compress) {
+        Lz4FrameWriter encoder(file);
+        std::ostream compressed(&encoder);
+        render(compressed);
+        return encoder.finish() && compressed.good();
+    }
+#endif
+
+    render(file);
+    file.close();
+    return !file.fail();
+}
+
+static bool useCompression(const LaunchOptions& options) {
+#ifndef LAUNCH_HAVE_LZ4
+    if (options.compressCrashLog) {
+        std::cerr << u8"此版本构建时未启用 LZ4，崩溃日志不压缩" << std::endl;
+    }
+    return false;
+#else
+    return options.compressCrashLog;
+#endif
+}
+
+// 崩溃产物的路径前缀：设置了 crashLogDir 时返回 "目录/"，需要时创建目录
+static std::string artifactPrefix(const LaunchOptions& options) {
+    if (options.crashLogDir.empty()) {
+        return "";
+    }
+    std::error_code error;
+    std::filesystem::create_directories(options.crashLogDir, error);
+    if (error) {
+        std::cerr << u8"无法创建崩溃日志目录 " << options.crashLogDir << ": " << error.message() << std::endl;
+        return "";
+    }
+    return options.crashLogDir + "/";
+}
+
+// 崩溃库位于 crashLogDir，未设置时为 crashlogs
+static CrashStore crashStoreFor(const LaunchOptions& options) {
+    return CrashStore(options.crashLogDir.empty() ? "crashlogs" : options.crashLogDir, options.crashStoreKeep,
+                      options.crashStoreQuota);
+}
+
+// 启用崩溃库时精简核心文件随报告归入桶中：需要完整报告的崩溃把它移入桶目录并计入配额，
+// 只计数的崩溃在签名算出后直接删除。返回报告中应引用的崩溃现场（移动后指向 moved）
+static const NativeCrashInfo* storeMinidump(const CrashReport& report, const CrashStore::Entry& entry,
+                                            NativeCrashInfo& moved, std::vector<std::string>& writtenFiles) {
+    if (!report.native || report.native->minidumpPath.empty()) {
+        return report.native;
+    }
+    const std::string& path = report.native->minidumpPath;
+    if (!entry.fullReport) {
+        std::remove(path.c_str());
+        return report.native;
+    }
+    moved = *report.native;
+    moved.minidumpPath = entry.reportDir + std::filesystem::path(path).filename().string();
+    if (std::rename(path.c_str(), moved.minidumpPath.c_str()) != 0) {
+        std::cerr << u8"无法把精简核心文件移入崩溃库: " << path << std::endl;
+        return report.native;
+    }
+    writtenFiles.push_back(moved.minidumpPath);
+    return &moved;
+}
+
 // 生成崩溃日志文件
-bool generateCrashLog(const std::string& fullPath, const std::vector<std::string>& programOutput) {
-    std::string crashLogName = "crashlog_" + getCurrentTimestamp() + ".log";
-    std::ofstream crashLog(crashLogName);
+bool generateCrashLog(const CrashReport& report, const LaunchOptions& options, bool notifyUser,
+                      std::string* writtenName) {
+    bool compress = useCompression(options);
+    ReportFormat format = options.reportFormat;
+    std::string suffix = compress ? ".lz4" : "";
+    std::string timestamp = getCurrentTimestamp();
+    std::string baseName = artifactPrefix(options) + (report.snapshot ? "snapshot_" : "crashlog_") + timestamp;
+
+    // 启用崩溃库时按签名归入桶中，同一种崩溃超过保留份数后只计数，不再写完整日志
+    CrashStore store = crashStoreFor(options);
+    CrashStore::Entry storeEntry;
+    std::vector<std::string> writtenFiles;
+    CrashReport storedReport;
+    NativeCrashInfo storedNative;
+    const CrashReport* rendered = &report;
+    bool useStore = options.crashStore && !report.snapshot;
+    if (useStore) {
+        store.load();
+        CrashSignature signature = computeCrashSignature(report);
+        storeEntry = store.record(report, signature, timestamp);
+        storedReport = report;
+        storedReport.native = storeMinidump(report, storeEntry, storedNative, writtenFiles);
+        rendered = &storedReport;
+        if (!storeEntry.fullReport) {
+            std::cout << u8"崩溃已计入崩溃库 " << storeEntry.reportDir << u8"（同类第 " << storeEntry.occurrence
+                      << u8" 次），不再重复生成完整日志" << std::endl;
+            if (writtenName) {
+                *writtenName = storeEntry.reportDir;
+            }
+            if (notifyUser) {
+                std::string message = std::string(u8"程序已崩溃，与之前记录的崩溃相同（第 ") +
+                                      std::to_string(storeEntry.occurrence) + u8" 次），日志位于：\n" +
+                                      storeEntry.reportDir + u8"\n请将此目录提交给软件维护人员。";
+                ShowMessageBox(message, u8"程序崩溃");
+            }
+            return true;
+        }
+        baseName = storeEntry.reportDir + "crashlog_" + timestamp;
+    }
+    std::string crashLogName = baseName + ".log" + suffix;
+    writtenFiles.push_back(crashLogName);
 
-    if (crashLog.is_open()) {
+    bool written = writeArtifact(crashLogName, compress, std::ios::out, [rendered](std::ostream& crashLog) {
         // 写入 UTF-8 BOM 头，帮助一些编辑器识别编码
         const unsigned char bom[] = {0xEF, 0xBB, 0xBF};
         crashLog.write(reinterpret_cast<const char*>(bom), sizeof(bom));
-
-        crashLog << fullPath << u8"于" << getFormattedTime() << u8"遇到严重问题而崩溃。请将本日志提交给软件维护人员，方便我们解决问题。\n";
-        crashLog << "--------------------\n";
-
-        // 系统信息
-        #ifdef _WIN32
-            crashLog << u8"系统版本：" << getWindowsVersion() << "\n";
-        #else
-            crashLog << "系统版本：" << getUnixVersion() << "\n";
-        #endif
-        crashLog << u8"处理器：" << getCpuInfo() << "\n";
-        crashLog << u8"运行内存：" << getMemoryInfo() << "\n";
-        crashLog << u8"显卡：\n";
-        std::vector<std::string> gpus = getGpuInfo();
-        for (size_t i = 0; i < gpus.size(); i++) {
-            crashLog << "GPU" << i << "：" << gpus[i] << "\n";
+        writeTextReport(crashLog, *rendered);
+    });
+
+    if (written) {
+        // 结构化报告供自动化工具读取，写入失败不影响文本日志
+        if (format != ReportFormat::None) {
+            std::string reportName = baseName + (format == ReportFormat::Cbor ? ".cbor" : ".jsonl") + suffix;
+            bool reportWritten = writeArtifact(reportName, compress, std::ios::out | std::ios::binary,
+                                               [rendered, format](std::ostream& reportFile) {
+                if (format == ReportFormat::Cbor) {
+                    CborWriter writer(reportFile);
+                    writeStructuredReport(writer, *rendered);
+                } else {
+                    JsonLinesWriter writer(reportFile);
+                    writeStructuredReport(writer, *rendered);
+                }
+            });
+            if (reportWritten) {
+                writtenFiles.push_back(reportName);
+                std::cout << u8"结构化崩溃报告已生成: " << reportName << std::endl;
+            } else {
+                std::cerr << u8"无法创建结构化崩溃报告: " << reportName << std::endl;
+            }
         }
-        crashLog << u8"系统类型：" << getSystemType() << "\n";
-        crashLog << "--------------------\n";
-        crashLog << u8"以下是自程序启动后到崩溃前输出的全部信息：\n";
 
-        // 程序输出
-        for (const auto& line : programOutput) {
-            crashLog << line;
+        if (useStore) {
+            store.commit(storeEntry, writtenFiles);
         }
 
-        crashLog.close();
-        std::cout << u8"崩溃日志已生成: " << crashLogName << std::endl;
+        double latencyMs = (monotonicNanos() - report.exitTimestampNs) / 1e6;
+        if (report.snapshot) {
+            std::cout << u8"快照报告已生成: " << crashLogName << std::endl;
+        } else {
+            std::cout << u8"崩溃日志已生成: " << crashLogName << u8"（退出后 " << latencyMs << u8" ms）" << std::endl;
+        }
+        if (writtenName) {
+            *writtenName = crashLogName;
+        }
         
         // 弹窗提示用户
-        std::string message = std::string(u8"程序已崩溃，崩溃日志已生成：\n") + crashLogName + u8"\n请将此日志文件提交给软件维护人员。";
-        ShowMessageBox(message, u8"程序崩溃");
+        if (notifyUser) {
+            std::string message = std::string(u8"程序已崩溃，崩溃日志已生成：\n") + crashLogName + u8"\n请将此日志文件提交给软件维护人员。";
+            ShowMessageBox(message, u8"程序崩溃");
+        }
         
         return true;
     } else {
@@ -73,8 +222,173 @@ bool generateCrashLog(const std::string& fullPath, const std::vector<std::string
     }
 }
 
+void countCrashInStore(const CrashReport& report, const LaunchOptions& options) {
+    if (!options.crashStore) {
+        return;
+    }
+    CrashStore store = crashStoreFor(options);
+    store.load();
+    CrashStore::Entry entry = store.record(report, computeCrashSignature(report), getCurrentTimestamp(), false);
+    NativeCrashInfo unused;
+    std::vector<std::string> writtenFiles;
+    storeMinidump(report, entry, unused, writtenFiles);
+    std::cout << u8"崩溃已计入崩溃库 " << entry.reportDir << u8"（同类第 " << entry.occurrence << u8" 次）" << std::endl;
+}
+
+// 崩溃循环汇总报告：窗口内每次运行的摘要，加上最后一次崩溃的完整日志
+bool generateCrashLoopReport(const CrashReport& lastCrash, const RestartPolicy& policy,
+                             const LaunchOptions& options) {
+    bool compress = useCompression(options);
+    std::string timestamp = getCurrentTimestamp();
+    std::string reportDir = artifactPrefix(options);
+
+    // 最后一次崩溃只在这里计入崩溃库（之前的各次已在重启时计入），汇总报告写在它的桶中
+    CrashStore store = crashStoreFor(options);
+    CrashStore::Entry storeEntry;
+    std::vector<std::string> writtenFiles;
+    CrashReport storedCrash = lastCrash;
+    NativeCrashInfo storedNative;
+    if (options.crashStore) {
+        store.load();
+        storeEntry = store.record(lastCrash, computeCrashSignature(lastCrash), timestamp);
+        storedCrash.native = storeMinidump(lastCrash, storeEntry, storedNative, writtenFiles);
+        reportDir = storeEntry.reportDir;
+    }
+    std::string reportName = reportDir + "crashloop_" + timestamp + ".log" + (compress ? ".lz4" : "");
+
+    bool written = writeArtifact(reportName, compress, std::ios::out, [&](std::ostream& out) {
+        const unsigned char bom[] = {0xEF, 0xBB, 0xBF};
+        out.write(reinterpret_cast<const char*>(bom), sizeof(bom));
+        out << lastCrash.programPath << u8"在 " << options.crashLoopWindowSeconds << u8" 秒内崩溃了 "
+            << policy.crashesInWindow() << u8" 次，启动器已停止自动重启。\n";
+        out << u8"各次运行：\n";
+        policy.writeSummary(out);
+        out << "====================\n";
+        out << u8"最后一次崩溃：\n";
+        writeTextReport(out, storedCrash);
+    });
+    if (!written) {
+        std::cerr << u8"无法创建崩溃循环报告" << std::endl;
+        return false;
+    }
+
+    if (options.crashStore) {
+        writtenFiles.push_back(reportName);
+        store.commit(storeEntry, writtenFiles);
+    }
+    std::cout << u8"崩溃循环报告已生成: " << reportName << std::endl;
+    std::string message = std::string(u8"程序反复崩溃，已停止自动重启。汇总报告：\n") + reportName +
+                          u8"\n请将此文件提交给软件维护人员。";
+    ShowMessageBox(message, u8"程序崩溃");
+    return true;
+}
+
+#ifndef _WIN32
+// 把命令行中与子进程启动相关的选项转换为 LaunchSpec
+LaunchSpec buildLaunchSpec(const std::string& workDir, const std::string& programName,
+                           const LaunchOptions& options) {
+    static const struct {
+        const char* name;
+        int resource;
+    } resourceNames[] = {
+        {"as", RLIMIT_AS}, {"core", RLIMIT_CORE}, {"cpu", RLIMIT_CPU}, {"data", RLIMIT_DATA},
+        {"fsize", RLIMIT_FSIZE}, {"memlock", RLIMIT_MEMLOCK}, {"nofile", RLIMIT_NOFILE},
+        {"nproc", RLIMIT_NPROC}, {"stack", RLIMIT_STACK},
+    };
+
+    LaunchSpec spec;
+    spec.program = programName;
+    spec.workDir = workDir;
+    spec.args = options.programArgs;
+    spec.env = options.childEnv;
+
+    // 只给出软限制时保留当前的硬限制
+    auto addLimit = [&spec](int resource, uint64_t soft, uint64_t hard, bool setHard) {
+        struct rlimit current;
+        if (!setHard && getrlimit(resource, &current) == 0) {
+            hard = current.rlim_max == RLIM_INFINITY ? kLimitUnlimited : static_cast<uint64_t>(current.rlim_max);
+        }
+        spec.limits.push_back({resource, soft, hard});
+    };
+    for (const ResourceLimitOption& option : options.resourceLimits) {
+        for (const auto& entry : resourceNames) {
+            if (option.name == entry.name) {
+                addLimit(entry.resource, option.soft, option.hard, option.setHard);
+            }
+        }
+    }
+
+    // 核心转储：软限制提高到 coreDumpLimit（0 表示不限制），不超过硬限制
+    if (options.coreDumpMode != CoreDumpMode::Off) {
+        struct rlimit current;
+        if (getrlimit(RLIMIT_CORE, &current) == 0) {
+            uint64_t hard = current.rlim_max == RLIM_INFINITY ? kLimitUnlimited : static_cast<uint64_t>(current.rlim_max);
+            uint64_t wanted = options.coreDumpLimit == 0 ? kLimitUnlimited : options.coreDumpLimit;
+            spec.limits.push_back({RLIMIT_CORE, std::min(wanted, hard), hard});
+        }
+    }
+
+    spec.setNice = options.setNice;
+    spec.niceValue = options.niceValue;
+    spec.ioClass = options.ioPriorityClass;
+    spec.ioLevel = options.ioPriorityLevel;
+#ifdef __linux__
+    // CPU 列表已在解析命令行时校验
+    for (long cpu : parseCpuList(options.cpuAffinity.c_str())) {
+        spec.cpuAffinity.push_back(static_cast<int>(cpu));
+    }
+#endif
+    return spec;
+}
+
+// 找到子进程的核心转储并精简为小文件，原始文件在 mini 模式下删除。失败时 note 中说明原因
+static bool collectNativeCrash(const LaunchOptions& options, const std::string& workDir, const std::string& programName,
+                               pid_t pid, int64_t startUnixMs, const std::vector<MappedModule>& mapsSnapshot,
+                               NativeCrashInfo& info, std::string& note) {
+    std::string corePath = locateCoreFile(pid, programName, workDir, startUnixMs, note);
+    if (corePath.empty()) {
+        return false;
+    }
+    std::string minidumpName = artifactPrefix(options) + "core_" + getCurrentTimestamp() + ".mini.core";
+    if (!trimCoreDump(corePath, minidumpName, mapsSnapshot, info)) {
+        note = u8"无法精简核心文件 " + corePath;
+        return false;
+    }
+    if (options.coreDumpMode == CoreDumpMode::Mini) {
+        std::remove(corePath.c_str());
+    } else {
+        note = u8"原始核心文件保留在 " + corePath;
+    }
+    std::cout << u8"核心转储已精简: " << minidumpName << " (" << info.coreBytes / 1024 << " KB -> "
+              << info.minidumpBytes / 1024 << " KB)" << std::endl;
+    return true;
+}
+#endif
+
+// 子进程第一次输出：把预读耗时记入启动耗时记录（仍在预读时记到当前时刻为止），并让预读器记录热点页清单
+static void notifyPrefetcher(PayloadPrefetcher* prefetcher) {
+    if (!prefetcher || !prefetcher->childStarted() || !prefetcher->active()) {
+        return;
+    }
+    int64_t endNs = prefetcher->finishTimestampNs() != 0 ? prefetcher->finishTimestampNs() : monotonicNanos();
+    traceBackgroundPhase("prefetch payload", prefetcher->startTimestampNs(), endNs, "MB",
+                         prefetcher->advisedBytes() / 1048576.0);
+}
+
+// 内置的错误模式加上 --highlight-pattern 追加的模式，关闭高亮时为空
+std::vector<std::string> highlightPatternsFor(const LaunchOptions& options) {
+    if (!options.highlights) {
+        return {};
+    }
+    std::vector<std::string> patterns = defaultHighlightPatterns();
+    patterns.insert(patterns.end(), options.highlightPatterns.begin(), options.highlightPatterns.end());
+    return patterns;
+}
+
 // 运行程序并处理崩溃
-bool runProgramWithCrashLogging(const std::string& relativePath, const std::string& programName) {
+bool runProgramWithCrashLogging(const std::string& relativePath, const std::string& programName,
+                                const LaunchOptions& options, PayloadPrefetcher* prefetcher) {
+    int64_t setupStartNs = monotonicNanos();
     std::string fullPath = relativePath + "/" + programName;
 
     #ifdef _WIN32
@@ -88,9 +402,38 @@ bool runProgramWithCrashLogging(const std::string& relativePath, const std::stri
 
     std::cout << u8"准备运行程序: " << fullPath << std::endl;
 
-    std::vector<std::string> programOutput;
+    // 在程序运行期间于后台准备崩溃日志所需的系统信息
+    int64_t phaseStartNs = monotonicNanos();
+    SystemInventoryPrefetcher inventory("system_inventory.cache");
+    traceStartupPhase("start inventory prefetch", phaseStartNs, monotonicNanos());
 
 #ifdef _WIN32
+    OutputRingBuffer programOutput(options.outputBufferSize);
+    OutputHighlights highlights(highlightPatternsFor(options));
+    LineFramer framer([&programOutput](OutputStream stream, int64_t timestampNs, const char* data, size_t size) {
+        programOutput.append(stream, timestampNs, data, size);
+    });
+    LiveOutputWriter liveOutput;
+    if (!options.liveOutputName.empty()) {
+        liveOutput.create(options.liveOutputName, options.liveOutputSize, fullPath);
+    }
+    if (options.captureMode == CaptureMode::Mapped) {
+        std::cerr << u8"Windows 上暂不支持映射捕获文件，改为在内存中保留输出" << std::endl;
+    }
+    if (!options.captureLogDir.empty()) {
+        std::cerr << u8"Windows 上暂不支持分段捕获日志，已忽略" << std::endl;
+    }
+    if (options.restartMode != RestartMode::Never) {
+        std::cerr << u8"Windows 上暂不支持自动重启，程序只运行一次" << std::endl;
+    }
+    if (!options.programArgs.empty() || !options.childEnv.empty() || !options.resourceLimits.empty() ||
+        options.setNice || options.ioPriorityClass != IoPriorityClass::Unchanged || !options.cpuAffinity.empty()) {
+        std::cerr << u8"Windows 上暂不支持子进程参数、环境变量、资源限制与调度设置，已忽略" << std::endl;
+    }
+    if (options.cgroupSandbox) {
+        std::cerr << u8"Windows 上不支持 cgroup 沙箱，程序将不受限制地运行" << std::endl;
+    }
+
     // Windows实现
     HANDLE hReadPipe, hWritePipe;
     SECURITY_ATTRIBUTES sa;
@@ -120,6 +463,9 @@ bool runProgramWithCrashLogging(const std::string& relativePath, const std::stri
     ZeroMemory(&pi, sizeof(pi));
 
     // 创建进程
+    int64_t startUnixMs = unixMillis();
+    traceStartupPhase("prepare supervision", setupStartNs, monotonicNanos());
+    int64_t spawnStartNs = monotonicNanos();
     if (!CreateProcess(
         NULL,                   // 应用程序名称
         const_cast<LPSTR>(fullPath.c_str()), // 命令行
@@ -144,23 +490,32 @@ bool runProgramWithCrashLogging(const std::string& relativePath, const std::stri
     }
 
     CloseHandle(hWritePipe);
+    traceStartupPhase("spawn", spawnStartNs, monotonicNanos());
+    traceChildStarted(static_cast<int>(pi.dwProcessId), monotonicNanos());
 
     // 读取程序输出
     char buffer[4096];
     DWORD bytesRead;
     while (true) {
-        if (!ReadFile(hReadPipe, buffer, sizeof(buffer) - 1, &bytesRead, NULL) || bytesRead == 0) {
+        if (!ReadFile(hReadPipe, buffer, sizeof(buffer), &bytesRead, NULL) || bytesRead == 0) {
             if (GetLastError() == ERROR_BROKEN_PIPE) {
                 break; // 管道已断开
             }
         }
-        buffer[bytesRead] = '\0';
-        programOutput.push_back(buffer);
-        std::cout << buffer; // 输出到日志文件
+        OutputChunk chunk{OutputStream::Stdout, monotonicNanos(), buffer, bytesRead};
+        highlights.scan(chunk);
+        framer.append(chunk);
+        liveOutput.publish(static_cast<uint8_t>(chunk.stream), chunk.timestampNs, chunk.data, chunk.size);
+        std::cout.write(buffer, bytesRead); // 输出到日志文件
+        notifyPrefetcher(prefetcher);
+        traceChildFirstOutput(static_cast<int>(pi.dwProcessId), monotonicNanos());
     }
+    framer.flush();
+    writeStartupTrace();
 
     // 等待进程结束
     WaitForSingleObject(pi.hProcess, INFINITE);
+    int64_t exitTimestampNs = monotonicNanos();
 
     // 获取退出代码
     DWORD exitCode;
@@ -169,7 +524,19 @@ bool runProgramWithCrashLogging(const std::string& relativePath, const std::stri
 
         // 如果程序异常退出（崩溃）
         if (exitCode != 0) {
-            generateCrashLog(fullPath, programOutput);
+            CrashReport report;
+            report.programPath = fullPath;
+            report.exited = true;
+            report.exitCode = static_cast<int>(exitCode);
+            report.launcherPid = static_cast<int>(GetCurrentProcessId());
+            report.childPid = static_cast<int>(pi.dwProcessId);
+            report.startUnixMs = startUnixMs;
+            report.exitUnixMs = unixMillis();
+            report.exitTimestampNs = exitTimestampNs;
+            report.inventory = &inventory.get();
+            report.output = &programOutput;
+            report.highlights = &highlights;
+            generateCrashLog(report, options, true);
 
             // 关闭进程和线程句柄
             CloseHandle(pi.hProcess);
@@ -201,73 +568,321 @@ bool runProgramWithCrashLogging(const std::string& relativePath, const std::stri
     #endif
 
 #else
-    // Linux/macOS实现
-    int stdoutPipe[2];
-    if (pipe(stdoutPipe) == -1) {
-        std::cerr << u8"创建管道失败" << std::endl;
-        return false;
+    // Linux/macOS实现：stdout、stderr 与子进程退出在同一个事件循环中处理
+    EventLoop loop;
+    SupervisedChild child(loop);
+    ChildExitStatus exitStatus;
+    int64_t exitTimestampNs = 0;
+    int64_t exitUnixMs = 0;
+
+    // 控制台与捕获文件的转发由 SupervisedChild 完成，这里只保留崩溃日志需要的输出
+    RollingCaptureFile captureFile;
+    if (!options.captureFile.empty()) {
+        captureFile.open(options.captureFile, options.captureFileSize);
     }
+    std::cout.flush();
+    child.setForwarding(STDOUT_FILENO, STDERR_FILENO, &captureFile, options.zeroCopyTee);
+
+    // 崩溃日志需要的输出尾部：默认保存在内存中，mapped 模式下直接写入映射的捕获文件
+    MappedCaptureFile mappedCapture;
+    std::unique_ptr<OutputRingBuffer> ownedOutput;
+    if (options.captureMode == CaptureMode::Mapped) {
+        mappedCapture.create(options.mappedCaptureFile, options.outputBufferSize, fullPath);
+    }
+    if (!mappedCapture.isOpen()) {
+        StartupPhase phase("allocate output buffer");
+        ownedOutput.reset(new OutputRingBuffer(options.outputBufferSize));
+    }
+    OutputRingBuffer& programOutput = mappedCapture.isOpen() ? mappedCapture.ring() : *ownedOutput;
 
-    pid_t pid = fork();
-
-    if (pid == 0) {
-        // 子进程
-        close(stdoutPipe[0]); // 关闭读端
-
-        // 重定向标准输出和错误到管道
-        dup2(stdoutPipe[1], STDOUT_FILENO);
-        dup2(stdoutPipe[1], STDERR_FILENO);
-        close(stdoutPipe[1]);
+    // 输出缓冲区与捕获日志按完整的行记录
+    CaptureLogWriter captureLog;
+    if (!options.captureLogDir.empty()) {
+        captureLog.open(options.captureLogDir, options.captureLogSegmentSize, options.captureLogMaxSize);
+    }
+    LineFramer framer([&programOutput, &captureLog](OutputStream stream, int64_t timestampNs, const char* data,
+                                                    size_t size) {
+        programOutput.append(stream, timestampNs, data, size);
+        captureLog.append(static_cast<uint8_t>(stream), timestampNs, data, size);
+    });
+    OutputHighlights highlights(highlightPatternsFor(options));
+
+    // 实时输出环发布未分行的原始输出，跟随的读者不必等待换行
+    LiveOutputWriter liveOutput;
+    if (!options.liveOutputName.empty()) {
+        liveOutput.create(options.liveOutputName, options.liveOutputSize, fullPath);
+    }
+    auto logEvent = [&captureLog, &liveOutput](const std::string& text) {
+        int64_t timestampNs = monotonicNanos();
+        captureLog.append(kCaptureLogEvent, timestampNs, text.data(), text.size());
+        captureLog.flush();
+        liveOutput.publish(SC_LIVE_STREAM_EVENT, timestampNs, text.data(), text.size());
+    };
+
+    // 挂起看门狗与采样器共用监管循环的定时器
+    HangWatchdog watchdog(loop, options);
+
+    child.onOutput([&framer, &captureLog, &highlights, &liveOutput, &watchdog, &child,
+                    prefetcher](const OutputChunk& chunk) {
+        highlights.scan(chunk);
+        framer.append(chunk);
+        liveOutput.publish(static_cast<uint8_t>(chunk.stream), chunk.timestampNs, chunk.data, chunk.size);
+        captureLog.flush();
+        watchdog.noteOutput(chunk.timestampNs);
+        notifyPrefetcher(prefetcher);
+        traceChildFirstOutput(child.pid(), chunk.timestampNs);
+    });
+    child.onExit([&](const ChildExitStatus& status) {
+        framer.flush();
+        exitStatus = status;
+        exitTimestampNs = monotonicNanos();
+        exitUnixMs = unixMillis();
+        loop.stop();
+    });
+
+    LaunchSpec spec = buildLaunchSpec(relativePath, programName, options);
+
+    RestartPolicy restartPolicy(options);
+    CgroupSandbox cgroup(options, &loop);
+    std::unique_ptr<ProcessTreeSampler> sampler;
+    int attemptNumber = 0;
+    int64_t startUnixMs = 0;
+    int64_t backoffNs = 0;
+    bool crashed = false;
+
+    // 控制接口：重启请求先结束当前运行，退出后跳过重启策略直接开始下一次运行
+    bool restartRequested = false;
+    int restartKillTimer = -1;
+    std::unique_ptr<ControlServer> control;
+    if (!options.controlSocket.empty()) {
+        control.reset(new ControlServer(loop, options.controlSocket));
+        ControlChild controlled;
+        controlled.status = [&]() {
+            ControlChildStatus status;
+            status.state = child.running() ? "running" : "backoff";
+            status.pid = child.running() ? child.pid() : -1;
+            status.startUnixMs = startUnixMs;
+            status.restarts = attemptNumber - 1;
+            status.hasExited = exitTimestampNs != 0;
+            status.lastExitSignaled = exitStatus.signaled;
+            status.lastExitValue = exitStatus.signaled ? exitStatus.signal : exitStatus.exitCode;
+            status.output = &programOutput;
+            status.telemetry = sampler.get();
+            return status;
+        };
+        controlled.restart = [&](std::string& message) {
+            if (restartRequested) {
+                message = "restart already in progress";
+                return false;
+            }
+            restartRequested = true;
+            if (!child.running()) {
+                loop.stop();  // 结束退避等待
+                return true;
+            }
+            kill(child.pid(), SIGTERM);
+            pid_t pid = child.pid();
+            restartKillTimer = loop.addTimer(std::chrono::milliseconds(options.hangKillGraceMs), [&, pid]() {
+                loop.cancelTimer(restartKillTimer);
+                restartKillTimer = -1;
+                kill(pid, SIGKILL);
+            });
+            return true;
+        };
+        controlled.snapshot = [&](std::string& message) {
+            if (!child.running()) {
+                message = "child is not running";
+                return false;
+            }
+            CrashReport report;
+            report.snapshot = true;
+            report.programPath = fullPath;
+            report.launcherPid = static_cast<int>(getpid());
+            report.childPid = child.pid();
+            report.startUnixMs = startUnixMs;
+            report.exitUnixMs = unixMillis();
+            report.exitTimestampNs = monotonicNanos();
+            report.threadStacks = captureThreadStacks({child.pid()});
+            report.inventory = &inventory.get();
+            report.telemetry = sampler.get();
+            report.output = &programOutput;
+            report.highlights = &highlights;
+            return generateCrashLog(report, options, false, &message);
+        };
+        control->addChild(programName, std::move(controlled));
+    }
 
-        // 切换到指定目录
-        if (chdir(relativePath.c_str()) != 0) {
-            std::cerr << u8"无法切换到目录: " << relativePath << std::endl;
-            exit(EXIT_FAILURE);
+    while (true) {
+        attemptNumber++;
+        startUnixMs = unixMillis();
+        int64_t startTimestampNs = monotonicNanos();
+        watchdog.prepareChild(child);
+        spec.cgroupProcs = cgroup.prepare(attemptNumber);
+        traceStartupPhase("prepare supervision", setupStartNs, monotonicNanos());
+        restartRequested = false;
+        if (!child.start(spec)) {
+            cgroup.finish();
+            mappedCapture.remove();
+            return false;
+        }
+        mappedCapture.setChildPid(child.pid());
+        liveOutput.setChildPid(child.pid());
+        logEvent(u8"程序已启动 (PID " + std::to_string(child.pid()) + ")");
+        if (attemptNumber > 1) {
+            // 重启耗时：从检测到上一次退出到新进程 exec 完成，扣除退避等待
+            int64_t latencyNs = monotonicNanos() - exitTimestampNs - backoffNs;
+            restartPolicy.recordRestartLatency(latencyNs);
+            std::cout << u8"程序已重启（第 " << attemptNumber << u8" 次运行，耗时 " << latencyNs / 1e6 << " ms）" << std::endl;
         }
 
-        // 执行程序
-        execl(programName.c_str(), programName.c_str(), NULL);
-
-        // 如果execl返回，说明出错了
-        std::cerr << u8"执行程序失败: " << programName << std::endl;
-        exit(EXIT_FAILURE);
-    } else if (pid > 0) {
-        // 父进程
-        close(stdoutPipe[1]); // 关闭写端
-
-        // 读取程序输出
-        char buffer[4096];
-        ssize_t bytesRead;
-        while ((bytesRead = read(stdoutPipe[0], buffer, sizeof(buffer) - 1)) > 0) {
-            buffer[bytesRead] = '\0';
-            programOutput.push_back(buffer);
-            std::cout << buffer; // 实时输出到控制台
+        // 定时采集子进程树的资源占用
+        int samplerTimer = -1;
+        if (options.telemetryIntervalMs > 0) {
+            size_t capacity = static_cast<size_t>(options.telemetryWindowSeconds) * 1000 / options.telemetryIntervalMs;
+            sampler.reset(new ProcessTreeSampler(child.pid(), capacity));
+            sampler->sample();
+            samplerTimer = loop.addTimer(std::chrono::milliseconds(options.telemetryIntervalMs), [&sampler, &cgroup]() {
+                sampler->sample();
+                cgroup.poll();
+            });
+        }
+        watchdog.start(child.pid(), sampler.get());
+
+        // 运行期间定时记录模块映射，供核心文件缺少模块列表时符号化
+        std::vector<MappedModule> mapsSnapshot;
+        int mapsTimer = -1;
+        if (options.coreDumpMode != CoreDumpMode::Off && options.mapsSnapshotIntervalMs > 0) {
+            mapsSnapshot = readProcessMaps(child.pid());
+            mapsTimer = loop.addTimer(std::chrono::milliseconds(options.mapsSnapshotIntervalMs), [&child, &mapsSnapshot]() {
+                std::vector<MappedModule> modules = readProcessMaps(child.pid());
+                if (!modules.empty()) {
+                    mapsSnapshot.swap(modules);
+                }
+            });
         }
 
-        close(stdoutPipe[0]);
+        loop.run();
+        watchdog.stop();
+        writeStartupTrace();
+        logEvent(exitStatus.signaled ? u8"程序被信号终止: " + std::to_string(exitStatus.signal) :
+                                       u8"程序退出代码: " + std::to_string(exitStatus.exitCode));
+        if (samplerTimer != -1) {
+            loop.cancelTimer(samplerTimer);
+        }
+        if (mapsTimer != -1) {
+            loop.cancelTimer(mapsTimer);
+        }
+        CgroupStats cgroupStats = cgroup.finish();
+        if (restartKillTimer != -1) {
+            loop.cancelTimer(restartKillTimer);
+            restartKillTimer = -1;
+        }
+        if (restartRequested) {
+            std::cout << u8"已按控制请求重启程序" << std::endl;
+            programOutput.clear();
+            highlights.clear();
+            backoffNs = 0;
+            continue;
+        }
 
-        int status;
-        waitpid(pid, &status, 0);
+        RunAttempt attempt;
+        attempt.number = attemptNumber;
+        attempt.startTimestampNs = startTimestampNs;
+        attempt.exitTimestampNs = exitTimestampNs;
+        crashed = false;
+        if (exitStatus.exited) {
+            std::cout << u8"程序退出代码: " << exitStatus.exitCode << std::endl;
+            crashed = exitStatus.exitCode != 0;
+            attempt.outcome = u8"退出码 " + std::to_string(exitStatus.exitCode);
+        } else if (exitStatus.signaled) {
+            // 程序被信号终止
+            std::cout << u8"程序被信号终止: " << exitStatus.signal << std::endl;
+            crashed = true;
+            attempt.outcome = u8"信号 " + std::to_string(exitStatus.signal);
+            if (cgroupStats.oomKilled() && exitStatus.signal == SIGKILL) {
+                attempt.outcome += u8"（" + describeCgroupStats(cgroupStats) + u8"）";
+            }
+        }
+        if (watchdog.trigger() != HangTrigger::None) {
+            // 被看门狗终止的挂起即使最终以 0 退出也按崩溃处理
+            crashed = true;
+            attempt.outcome = std::string(u8"挂起 ") + hangTriggerName(watchdog.trigger()) + u8"，" + attempt.outcome;
+        }
+        attempt.crashed = crashed;
+        RestartPolicy::Decision decision = restartPolicy.recordExit(attempt);
+
+        CrashReport report;
+        report.programPath = fullPath;
+        report.exited = exitStatus.exited;
+        report.exitCode = exitStatus.exitCode;
+        report.signaled = exitStatus.signaled;
+        report.signal = exitStatus.signal;
+        report.coreDumped = exitStatus.coreDumped;
+        report.launcherPid = static_cast<int>(getpid());
+        report.childPid = child.pid();
+        report.startUnixMs = startUnixMs;
+        report.exitUnixMs = exitUnixMs;
+        report.exitTimestampNs = exitTimestampNs;
+        report.inventory = &inventory.get();
+        report.telemetry = sampler.get();
+        report.output = &programOutput;
+        report.highlights = &highlights;
+        if (cgroup.enabled()) {
+            report.cgroup = &cgroupStats;
+        }
+        if (watchdog.trigger() != HangTrigger::None) {
+            report.hangTrigger = hangTriggerName(watchdog.trigger());
+            report.hangStalledMs = watchdog.stalledMs();
+            report.threadStacks = watchdog.threadStacks();
+        }
 
-        if (WIFEXITED(status)) {
-            int exitCode = WEXITSTATUS(status);
-            std::cout << u8"程序退出代码: " << exitCode << std::endl;
+        NativeCrashInfo nativeCrash;
+        if (options.coreDumpMode != CoreDumpMode::Off && exitStatus.signaled) {
+            if (!exitStatus.coreDumped) {
+                report.coreDumpNote = u8"子进程未生成核心转储（信号不产生转储，或受 RLIMIT_CORE 硬限制约束）";
+            } else if (collectNativeCrash(options, relativePath, programName, child.pid(), startUnixMs, mapsSnapshot,
+                                          nativeCrash, report.coreDumpNote)) {
+                report.native = &nativeCrash;
+            }
+        }
 
-            if (exitCode != 0) {
-                generateCrashLog(fullPath, programOutput);
-                return false;
+        if (decision == RestartPolicy::Decision::CrashLoop) {
+            generateCrashLoopReport(report, restartPolicy, options);
+            break;
+        }
+        if (decision == RestartPolicy::Decision::Stop) {
+            if (crashed) {
+                generateCrashLog(report, options, true);
             }
-        } else if (WIFSIGNALED(status)) {
-            // 程序被信号终止
-            int signal = WTERMSIG(status);
-            std::cout << u8"程序被信号终止: " << signal << std::endl;
+            break;
+        }
 
-            generateCrashLog(fullPath, programOutput);
-            return false;
+        // 自动重启时不弹窗；同一窗口内接连崩溃只为第一次单独写日志，其余记入崩溃循环报告
+        if (crashed && restartPolicy.crashesInWindow() == 1) {
+            std::string crashLogName;
+            generateCrashLog(report, options, false, &crashLogName);
+            restartPolicy.setLastCrashLog(crashLogName);
+        } else if (crashed) {
+            countCrashInStore(report, options);
         }
-    } else {
-        // fork失败
-        std::cerr << u8"fork失败，无法创建子进程" << std::endl;
+
+        programOutput.clear();
+        highlights.clear();
+        reapNotifications();
+        int64_t delayMs = restartPolicy.nextDelayMs();
+        int64_t waitStartNs = monotonicNanos();
+        if (delayMs > 0) {
+            std::cout << delayMs << u8" ms 后重启程序" << std::endl;
+            int delayTimer = loop.addTimer(std::chrono::milliseconds(delayMs), [&loop]() { loop.stop(); });
+            loop.run();
+            loop.cancelTimer(delayTimer);
+        }
+        backoffNs = monotonicNanos() - waitStartNs;
+    }
+
+    // 启动器正常走到这里时输出已写入崩溃日志，捕获文件只在启动器自身异常退出时才需要保留
+    mappedCapture.remove();
+    if (crashed) {
         return false;
     }
 #endif
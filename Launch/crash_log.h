@@ -6,8 +6,35 @@
 #include <chrono>
 #include <fstream>
 
-bool generateCrashLog(const std::string& fullPath, const std::vector<std::string>& programOutput);
-bool runProgramWithCrashLogging(const std::string& relativePath, const std::string& programName);
-void ShowMessageBox(const std::string& message, const std::string& title);
+#include "crash_report.h"
+#include "launch_options.h"
+#include "notification.h"
+#include "payload_prefetch.h"
+#include "restart_policy.h"
+
+#ifndef _WIN32
+    #include "process_spawn.h"
+#endif
+
+// 写出文本崩溃日志，按 options 额外写出结构化报告或以 .lz4 压缩；report.exitTimestampNs 同时用于统计生成耗时。
+// notifyUser 为 false 时不弹窗（自动重启时使用），writtenName 非空时返回日志文件名。
+// report.snapshot 时写出以 snapshot_ 开头的快照报告
+bool generateCrashLog(const CrashReport& report, const LaunchOptions& options, bool notifyUser,
+                      std::string* writtenName = nullptr);
+// 自动重启时不单独写日志的崩溃只计入崩溃库（--crash-store），使桶内次数与实际崩溃次数一致
+void countCrashInStore(const CrashReport& report, const LaunchOptions& options);
+// 检测到崩溃循环时写出一份汇总报告并提示用户
+bool generateCrashLoopReport(const CrashReport& lastCrash, const RestartPolicy& policy,
+                             const LaunchOptions& options);
+// options 对应的错误摘要模式：缺省模式加上 --highlight-pattern 追加的，--no-highlights 时为空
+std::vector<std::string> highlightPatternsFor(const LaunchOptions& options);
+// prefetcher 非空时在子进程第一次输出时通知它（记录预读耗时与热点页清单）
+bool runProgramWithCrashLogging(const std::string& relativePath, const std::string& programName,
+                                const LaunchOptions& options, PayloadPrefetcher* prefetcher = nullptr);
+
+#ifndef _WIN32
+// 把 options 中与子进程启动相关的设置（参数、环境变量、资源限制、调度）转换为 LaunchSpec
+LaunchSpec buildLaunchSpec(const std::string& workDir, const std::string& programName, const LaunchOptions& options);
+#endif
 
 #endif // CRASH_LOG_H
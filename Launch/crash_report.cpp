@@ -0,0 +1,646 @@
+#include "crash_report.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+// ---------------- JsonLinesWriter ----------------
+
+void JsonLinesWriter::separator() {
+    if (afterKey) {
+        afterKey = false;
+        return;
+    }
+    if (!firstInScope.empty()) {
+        if (!firstInScope.back()) {
+            out.put(',');
+        }
+        firstInScope.back() = false;
+    }
+}
+
+void JsonLinesWriter::beginObject() {
+    separator();
+    out.put('{');
+    firstInScope.push_back(true);
+}
+
+void JsonLinesWriter::endObject() {
+    firstInScope.pop_back();
+    out.put('}');
+}
+
+void JsonLinesWriter::beginArray() {
+    separator();
+    out.put('[');
+    firstInScope.push_back(true);
+}
+
+void JsonLinesWriter::endArray() {
+    firstInScope.pop_back();
+    out.put(']');
+}
+
+void JsonLinesWriter::key(const char* name) {
+    separator();
+    writeString(name, std::strlen(name));
+    out.put(':');
+    afterKey = true;
+}
+
+void JsonLinesWriter::value(const std::string& text) {
+    separator();
+    writeString(text.data(), text.size());
+}
+
+void JsonLinesWriter::value(int64_t number) {
+    separator();
+    out << number;
+}
+
+void JsonLinesWriter::value(double number) {
+    separator();
+    if (!std::isfinite(number)) {
+        out << "null";
+        return;
+    }
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.6g", number);
+    out << buffer;
+}
+
+void JsonLinesWriter::value(bool flag) {
+    separator();
+    out << (flag ? "true" : "false");
+}
+
+void JsonLinesWriter::null() {
+    separator();
+    out << "null";
+}
+
+void JsonLinesWriter::bytes(const char* data, size_t size) {
+    separator();
+    writeString(data, size);
+}
+
+void JsonLinesWriter::endRecord() {
+    out.put('\n');
+}
+
+// 返回从 p 开始的合法 UTF-8 字符的字节数，非法时返回 0
+static size_t utf8SequenceLength(const unsigned char* p, const unsigned char* end) {
+    unsigned char lead = p[0];
+    size_t length;
+    unsigned char minSecond = 0x80;
+    unsigned char maxSecond = 0xBF;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        length = 3;
+        if (lead == 0xE0) minSecond = 0xA0;   // 过长编码
+        if (lead == 0xED) maxSecond = 0x9F;   // 代理项
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        if (lead == 0xF0) minSecond = 0x90;
+        if (lead == 0xF4) maxSecond = 0x8F;
+    } else {
+        return 0;
+    }
+
+    if (static_cast<size_t>(end - p) < length || p[1] < minSecond || p[1] > maxSecond) {
+        return 0;
+    }
+    for (size_t i = 2; i < length; i++) {
+        if ((p[i] & 0xC0) != 0x80) {
+            return 0;
+        }
+    }
+    return length;
+}
+
+void JsonLinesWriter::writeString(const char* data, size_t size) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    const unsigned char* end = p + size;
+    const unsigned char* run = p;  // 尚未写出、无需转义的一段
+
+    auto flushRun = [&](const unsigned char* upTo) {
+        if (upTo > run) {
+            out.write(reinterpret_cast<const char*>(run), upTo - run);
+        }
+    };
+
+    out.put('"');
+    while (p < end) {
+        unsigned char c = *p;
+        if (c >= 0x20 && c < 0x80 && c != '"' && c != '\\') {
+            p++;
+            continue;
+        }
+        if (c >= 0x80) {
+            size_t length = utf8SequenceLength(p, end);
+            if (length > 0) {
+                p += length;
+                continue;
+            }
+            flushRun(p);
+            out << "\\ufffd";
+            run = ++p;
+            continue;
+        }
+
+        flushRun(p);
+        switch (c) {
+            case '"': out << "\\\""; break;
+            case '\\': out << "\\\\"; break;
+            case '\n': out << "\\n"; break;
+            case '\r': out << "\\r"; break;
+            case '\t': out << "\\t"; break;
+            default: {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                out << escaped;
+            }
+        }
+        run = ++p;
+    }
+    flushRun(p);
+    out.put('"');
+}
+
+// ---------------- CborWriter ----------------
+
+CborWriter::CborWriter(std::ostream& out) : out(out) {}
+
+void CborWriter::writeHead(uint8_t majorType, uint64_t argument) {
+    unsigned char buffer[9];
+    size_t length;
+    uint8_t major = static_cast<uint8_t>(majorType << 5);
+    if (argument < 24) {
+        buffer[0] = static_cast<unsigned char>(major | argument);
+        length = 1;
+    } else {
+        int bytes;
+        if (argument <= 0xFF) {
+            buffer[0] = major | 24;
+            bytes = 1;
+        } else if (argument <= 0xFFFF) {
+            buffer[0] = major | 25;
+            bytes = 2;
+        } else if (argument <= 0xFFFFFFFFULL) {
+            buffer[0] = major | 26;
+            bytes = 4;
+        } else {
+            buffer[0] = major | 27;
+            bytes = 8;
+        }
+        for (int i = 0; i < bytes; i++) {
+            buffer[1 + i] = static_cast<unsigned char>(argument >> (8 * (bytes - 1 - i)));
+        }
+        length = 1 + bytes;
+    }
+    out.write(reinterpret_cast<const char*>(buffer), static_cast<std::streamsize>(length));
+}
+
+void CborWriter::beginObject() {
+    out.put(static_cast<char>(0xBF));
+}
+
+void CborWriter::endObject() {
+    out.put(static_cast<char>(0xFF));
+}
+
+void CborWriter::beginArray() {
+    out.put(static_cast<char>(0x9F));
+}
+
+void CborWriter::endArray() {
+    out.put(static_cast<char>(0xFF));
+}
+
+void CborWriter::key(const char* name) {
+    size_t length = std::strlen(name);
+    writeHead(3, length);
+    out.write(name, static_cast<std::streamsize>(length));
+}
+
+void CborWriter::value(const std::string& text) {
+    writeHead(3, text.size());
+    out.write(text.data(), static_cast<std::streamsize>(text.size()));
+}
+
+void CborWriter::value(int64_t number) {
+    if (number >= 0) {
+        writeHead(0, static_cast<uint64_t>(number));
+    } else {
+        writeHead(1, static_cast<uint64_t>(-1 - number));
+    }
+}
+
+void CborWriter::value(double number) {
+    uint64_t bits;
+    std::memcpy(&bits, &number, sizeof(bits));
+    unsigned char buffer[9];
+    buffer[0] = 0xFB;
+    for (int i = 0; i < 8; i++) {
+        buffer[1 + i] = static_cast<unsigned char>(bits >> (8 * (7 - i)));
+    }
+    out.write(reinterpret_cast<const char*>(buffer), sizeof(buffer));
+}
+
+void CborWriter::value(bool flag) {
+    out.put(static_cast<char>(flag ? 0xF5 : 0xF4));
+}
+
+void CborWriter::null() {
+    out.put(static_cast<char>(0xF6));
+}
+
+void CborWriter::bytes(const char* data, size_t size) {
+    writeHead(2, size);
+    out.write(data, static_cast<std::streamsize>(size));
+}
+
+// ---------------- 报告内容 ----------------
+
+static const char* streamName(OutputStream stream) {
+    return stream == OutputStream::Stderr ? "stderr" : "stdout";
+}
+
+void writeStructuredReport(StructuredWriter& writer, const CrashReport& report) {
+    writer.beginObject();
+    writer.key("type");
+    writer.value("crash");
+    writer.key("version");
+    writer.value(1);
+    writer.key("program");
+    writer.value(report.programPath);
+    writer.key("reason");
+    bool oomKilled = report.cgroup && report.cgroup->oomKilled() && report.signaled;
+    writer.value(report.snapshot ? "snapshot" : !report.hangTrigger.empty() ? "hang" : oomKilled ? "oom" :
+                 report.signaled ? "signal" : "exit");
+    writer.key("exit_code");
+    if (report.exited) {
+        writer.value(report.exitCode);
+    } else {
+        writer.null();
+    }
+    writer.key("signal");
+    if (report.signaled) {
+        writer.value(report.signal);
+    } else {
+        writer.null();
+    }
+    writer.key("core_dumped");
+    writer.value(report.coreDumped);
+    writer.key("launcher_pid");
+    writer.value(report.launcherPid);
+    writer.key("child_pid");
+    writer.value(report.childPid);
+    writer.key("start_unix_ms");
+    writer.value(report.startUnixMs);
+    writer.key("exit_unix_ms");
+    writer.value(report.exitUnixMs);
+
+    if (!report.hangTrigger.empty()) {
+        writer.key("hang");
+        writer.beginObject();
+        writer.key("trigger");
+        writer.value(report.hangTrigger);
+        writer.key("stalled_ms");
+        writer.value(report.hangStalledMs);
+        writer.key("threads");
+        writer.value(report.threadStacks);
+        writer.endObject();
+    }
+
+    if (report.highlights && report.highlights->matchCount() > 0) {
+        writer.key("highlights");
+        writer.beginObject();
+        writer.key("matches");
+        writer.value(report.highlights->matchCount());
+        writer.key("dropped");
+        writer.value(report.highlights->droppedCount());
+        writer.key("items");
+        writer.beginArray();
+        for (const OutputHighlight* highlight : report.highlights->highlights()) {
+            writer.beginObject();
+            writer.key("stream");
+            writer.value(streamName(highlight->stream));
+            writer.key("offset_ms");
+            writer.value((highlight->timestampNs - report.exitTimestampNs) / 1000000);
+            writer.key("pattern");
+            writer.value(highlight->pattern);
+            writer.key("text");
+            writer.bytes(highlight->text.data(), highlight->text.size());
+            writer.endObject();
+        }
+        writer.endArray();
+        writer.endObject();
+    }
+
+    if (report.native) {
+        const NativeCrashInfo& native = *report.native;
+        writer.key("native");
+        writer.beginObject();
+        writer.key("signal");
+        writer.value(static_cast<int64_t>(native.signal));
+        writer.key("faulting_thread");
+        writer.value(static_cast<int64_t>(native.faultingThread));
+        writer.key("threads");
+        writer.value(static_cast<int64_t>(native.threadCount));
+        writer.key("backtrace");
+        writer.beginArray();
+        for (const std::string& frame : native.backtrace) {
+            writer.value(frame);
+        }
+        writer.endArray();
+        writer.key("modules");
+        writer.beginArray();
+        for (const MappedModule& module : native.modules) {
+            writer.beginObject();
+            writer.key("start");
+            writer.value(static_cast<int64_t>(module.start));
+            writer.key("end");
+            writer.value(static_cast<int64_t>(module.end));
+            writer.key("offset");
+            writer.value(static_cast<int64_t>(module.offset));
+            writer.key("path");
+            writer.value(module.path);
+            writer.endObject();
+        }
+        writer.endArray();
+        writer.key("minidump");
+        writer.value(native.minidumpPath);
+        writer.key("core_bytes");
+        writer.value(static_cast<int64_t>(native.coreBytes));
+        writer.key("minidump_bytes");
+        writer.value(static_cast<int64_t>(native.minidumpBytes));
+        if (!report.coreDumpNote.empty()) {
+            writer.key("note");
+            writer.value(report.coreDumpNote);
+        }
+        writer.endObject();
+    } else if (!report.coreDumpNote.empty()) {
+        writer.key("native");
+        writer.beginObject();
+        writer.key("note");
+        writer.value(report.coreDumpNote);
+        writer.endObject();
+    }
+
+    if (report.cgroup) {
+        const CgroupStats& cgroup = *report.cgroup;
+        writer.key("cgroup");
+        writer.beginObject();
+        writer.key("available");
+        writer.value(cgroup.available);
+        if (cgroup.available) {
+            writer.key("path");
+            writer.value(cgroup.path);
+            writer.key("memory_max");
+            if (cgroup.memoryMax > 0) {
+                writer.value(cgroup.memoryMax);
+            } else {
+                writer.null();
+            }
+            writer.key("memory_peak");
+            writer.value(cgroup.memoryPeak);
+            writer.key("oom");
+            writer.value(cgroup.oomEvents);
+            writer.key("oom_kill");
+            writer.value(cgroup.oomKills);
+            writer.key("memory_high");
+            writer.value(cgroup.memoryHighEvents);
+            writer.key("cpu_usage_usec");
+            writer.value(cgroup.cpuUsageUsec);
+            writer.key("cpu_user_usec");
+            writer.value(cgroup.cpuUserUsec);
+            writer.key("cpu_system_usec");
+            writer.value(cgroup.cpuSystemUsec);
+            writer.key("cpu_throttled");
+            writer.value(cgroup.cpuThrottled);
+            writer.key("cpu_throttled_usec");
+            writer.value(cgroup.cpuThrottledUsec);
+        }
+        if (!cgroup.note.empty()) {
+            writer.key("note");
+            writer.value(cgroup.note);
+        }
+        writer.endObject();
+    }
+
+    writer.key("inventory");
+    if (report.inventory) {
+        const SystemInventory& inventory = *report.inventory;
+        writer.beginObject();
+        writer.key("os");
+        writer.value(inventory.osVersion);
+        writer.key("cpu");
+        writer.value(inventory.cpu);
+        writer.key("memory");
+        writer.value(inventory.memory);
+        writer.key("gpus");
+        writer.beginArray();
+        for (const auto& gpu : inventory.gpus) {
+            writer.value(gpu);
+        }
+        writer.endArray();
+        writer.key("system_type");
+        writer.value(inventory.systemType);
+        writer.endObject();
+    } else {
+        writer.null();
+    }
+
+    if (report.output) {
+        writer.key("output_total_bytes");
+        writer.value(report.output->totalBytes());
+        writer.key("output_retained_bytes");
+        writer.value(static_cast<uint64_t>(report.output->size()));
+        writer.key("output_dropped_bytes");
+        writer.value(report.output->droppedBytes());
+    }
+    if (report.telemetry) {
+        writer.key("telemetry_self_cpu");
+        writer.value(report.telemetry->selfCpuShare());
+    }
+    writer.endObject();
+    writer.endRecord();
+
+    // 时间统一为相对退出时刻的毫秒数（负数）
+    auto relativeMs = [&report](int64_t timestampNs) {
+        return (timestampNs - report.exitTimestampNs) / 1e6;
+    };
+
+    if (report.telemetry) {
+        report.telemetry->forEachSample([&](const TelemetrySample& sample) {
+            writer.beginObject();
+            writer.key("type");
+            writer.value("telemetry");
+            writer.key("t_ms");
+            writer.value(relativeMs(sample.timestampNs));
+            writer.key("cpu_percent");
+            writer.value(static_cast<double>(sample.cpuPercent));
+            writer.key("rss_bytes");
+            writer.value(sample.rssBytes);
+            writer.key("processes");
+            writer.value(static_cast<int64_t>(sample.processes));
+            writer.key("threads");
+            writer.value(static_cast<int64_t>(sample.threads));
+            writer.key("fds");
+            writer.value(static_cast<int64_t>(sample.fds));
+            writer.key("read_bytes");
+            writer.value(sample.readBytes);
+            writer.key("write_bytes");
+            writer.value(sample.writeBytes);
+            writer.key("context_switches");
+            writer.value(sample.contextSwitches);
+            writer.endObject();
+            writer.endRecord();
+        });
+    }
+
+    if (report.output) {
+        report.output->forEachChunk([&](const OutputChunk& chunk) {
+            writer.beginObject();
+            writer.key("type");
+            writer.value("output");
+            writer.key("stream");
+            writer.value(streamName(chunk.stream));
+            writer.key("t_ms");
+            writer.value(relativeMs(chunk.timestampNs));
+            writer.key("data");
+            writer.bytes(chunk.data, chunk.size);
+            writer.endObject();
+            writer.endRecord();
+        });
+    }
+}
+
+void writeTextReport(std::ostream& out, const CrashReport& report) {
+    if (report.snapshot) {
+        out << report.programPath << u8"于" << getFormattedTime() << u8"运行中的状态快照（按请求生成，程序未被终止）。\n";
+        out << "--------------------\n";
+        if (!report.threadStacks.empty()) {
+            out << u8"快照时的线程状态：\n" << report.threadStacks;
+            out << "--------------------\n";
+        }
+    } else if (!report.hangTrigger.empty()) {
+        out << report.programPath << u8"于" << getFormattedTime() << u8"失去响应（" << report.hangTrigger
+            << u8"，持续 " << report.hangStalledMs << u8" ms），已被启动器终止。请将本日志提交给软件维护人员，方便我们解决问题。\n";
+        out << "--------------------\n";
+        out << u8"终止前的线程状态：\n" << report.threadStacks;
+        out << "--------------------\n";
+    } else if (report.cgroup && report.cgroup->oomKilled() && report.signaled) {
+        out << report.programPath << u8"于" << getFormattedTime() << describeCgroupStats(*report.cgroup)
+            << u8"。请检查内存上限设置，或将本日志提交给软件维护人员，方便我们解决问题。\n";
+        out << "--------------------\n";
+    } else {
+        out << report.programPath << u8"于" << getFormattedTime() << u8"遇到严重问题而崩溃。请将本日志提交给软件维护人员，方便我们解决问题。\n";
+        out << "--------------------\n";
+    }
+
+    // 输出中匹配到的错误摘要，时间相对于退出（快照）时刻
+    if (report.highlights && report.highlights->matchCount() > 0) {
+        std::vector<const OutputHighlight*> highlights = report.highlights->highlights();
+        out << u8"错误摘要：输出中共有 " << report.highlights->matchCount() << u8" 处匹配";
+        if (report.highlights->droppedCount() > 0) {
+            out << u8"，较早的 " << report.highlights->droppedCount() << u8" 条摘要已被丢弃";
+        }
+        out << "\n";
+        for (const OutputHighlight* highlight : highlights) {
+            // 用 snprintf 格式化，不改动 out 的精度设置，之后写出的数值不受影响
+            char offset[32];
+            std::snprintf(offset, sizeof(offset), "%.3f", (highlight->timestampNs - report.exitTimestampNs) / 1e9);
+            out << "[" << offset << " s "
+                << streamName(highlight->stream) << u8"，匹配 \"";
+            for (char c : highlight->pattern) {
+                out << (c == '\n' ? "\\n" : c == '\t' ? "\\t" : std::string(1, c));
+            }
+            out << "\"]\n" << highlight->text;
+            if (!highlight->text.empty() && highlight->text.back() != '\n') {
+                out << "\n";
+            }
+        }
+        out << "--------------------\n";
+    }
+
+    if (report.native) {
+        const NativeCrashInfo& native = *report.native;
+        out << u8"本机崩溃现场：信号 " << native.signal << u8"，出错线程 " << native.faultingThread
+            << u8"（共 " << native.threadCount << u8" 个线程），已映射模块 " << native.modules.size() << u8" 个\n";
+        out << u8"出错线程调用栈：\n";
+        for (const std::string& frame : native.backtrace) {
+            out << "    " << frame << "\n";
+        }
+        if (!native.minidumpPath.empty()) {
+            out << u8"精简核心文件：" << native.minidumpPath << u8"（" << native.minidumpBytes / 1024 << u8" KB，原始核心文件 "
+                << native.coreBytes / 1024 << " KB）\n";
+        }
+        if (!report.coreDumpNote.empty()) {
+            out << u8"核心转储：" << report.coreDumpNote << "\n";
+        }
+        out << "--------------------\n";
+    } else if (!report.coreDumpNote.empty()) {
+        out << u8"核心转储：" << report.coreDumpNote << "\n";
+        out << "--------------------\n";
+    }
+
+    if (report.cgroup) {
+        const CgroupStats& cgroup = *report.cgroup;
+        if (cgroup.available) {
+            out << u8"cgroup：" << cgroup.path << "\n";
+            out << u8"内存峰值：" << cgroup.memoryPeak / 1048576 << " MB";
+            if (cgroup.memoryMax > 0) {
+                out << u8"，上限 " << cgroup.memoryMax / 1048576 << " MB";
+            }
+            out << u8"，OOM 事件 " << cgroup.oomEvents << u8" 次，OOM 终止 " << cgroup.oomKills << u8" 次\n";
+            out << u8"CPU 时间：用户态 " << cgroup.cpuUserUsec / 1e6 << u8" 秒，内核态 " << cgroup.cpuSystemUsec / 1e6
+                << u8" 秒，被节流 " << cgroup.cpuThrottled << u8" 个周期（" << cgroup.cpuThrottledUsec / 1000 << " ms）\n";
+        }
+        if (!cgroup.note.empty()) {
+            out << u8"cgroup 说明：" << cgroup.note << "\n";
+        }
+        out << "--------------------\n";
+    }
+
+    // 系统信息（已在程序运行期间于后台获取）
+    if (report.inventory) {
+        const SystemInventory& inventory = *report.inventory;
+        out << u8"系统版本：" << inventory.osVersion << "\n";
+        out << u8"处理器：" << inventory.cpu << "\n";
+        out << u8"运行内存：" << inventory.memory << "\n";
+        out << u8"显卡：\n";
+        for (size_t i = 0; i < inventory.gpus.size(); i++) {
+            out << "GPU" << i << u8"：" << inventory.gpus[i] << "\n";
+        }
+        out << u8"系统类型：" << inventory.systemType << "\n";
+        out << "--------------------\n";
+    }
+
+    // 崩溃前一段时间内进程树的资源占用
+    if (report.telemetry && report.telemetry->size() > 0) {
+        out << (report.snapshot ? u8"快照前的资源占用（子进程及其后代，时间相对于快照时刻）：\n" :
+                                  u8"崩溃前的资源占用（子进程及其后代，时间相对于退出时刻）：\n");
+        report.telemetry->writeTable(out, report.exitTimestampNs, 120);
+        out << u8"采样器 CPU 占用：" << report.telemetry->selfCpuShare() * 100 << "%\n";
+        out << "--------------------\n";
+    }
+
+    if (!report.output) {
+        return;
+    }
+    const OutputRingBuffer& programOutput = *report.output;
+    if (report.snapshot) {
+        out << u8"以下是快照时输出缓冲区中保留的 " << programOutput.size() << u8" 字节信息：\n";
+    } else if (programOutput.droppedBytes() > 0) {
+        out << u8"以下是崩溃前输出的最后 " << programOutput.size() << u8" 字节信息（更早的 "
+            << programOutput.droppedBytes() << u8" 字节已被丢弃）：\n";
+    } else {
+        out << u8"以下是自程序启动后到崩溃前输出的全部信息：\n";
+    }
+
+    // 程序输出
+    programOutput.writeTo(out);
+}
@@ -0,0 +1,143 @@
+#ifndef CRASH_REPORT_H
+#define CRASH_REPORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "cgroup_sandbox.h"
+#include "core_dump.h"
+#include "output_buffer.h"
+#include "pattern_scanner.h"
+#include "system_info.h"
+#include "telemetry.h"
+
+// 一次崩溃的全部信息。文本日志与结构化报告都由它渲染，数据只引用、不复制
+struct CrashReport {
+    std::string programPath;
+
+    bool exited = false;          // 正常退出但退出码非 0
+    int exitCode = 0;
+    bool signaled = false;        // 被信号终止
+    int signal = 0;
+    bool coreDumped = false;
+
+    int launcherPid = 0;
+    int childPid = 0;
+    int64_t startUnixMs = 0;      // 子进程启动时刻（墙上时钟）
+    int64_t exitUnixMs = 0;       // 检测到退出的时刻（墙上时钟）
+    int64_t exitTimestampNs = 0;  // 检测到退出的时刻（单调时钟）
+
+    // 按控制请求在程序运行中生成的快照：程序未退出，退出时刻字段为快照时刻
+    bool snapshot = false;
+
+    // 因挂起被看门狗终止时的触发原因（为空表示不是挂起）、持续时长与采集到的线程状态
+    std::string hangTrigger;
+    int64_t hangStalledMs = 0;
+    std::string threadStacks;
+
+    // 从核心转储中提取的本机崩溃现场；未能收集时 coreDumpNote 说明原因
+    const NativeCrashInfo* native = nullptr;
+    std::string coreDumpNote;
+
+    // 子进程所在 cgroup 的内存、OOM 与 CPU 统计；未启用 cgroup 沙箱时为空
+    const CgroupStats* cgroup = nullptr;
+
+    const SystemInventory* inventory = nullptr;
+    const ProcessTreeSampler* telemetry = nullptr;
+    const OutputRingBuffer* output = nullptr;
+
+    // 输出中匹配到的错误摘要（异常、致命错误、栈帧），放在报告开头；未启用时为空
+    const OutputHighlights* highlights = nullptr;
+};
+
+// 流式结构化写入器：边生成边写出，不构建中间文档树
+class StructuredWriter {
+public:
+    virtual ~StructuredWriter() = default;
+
+    virtual void beginObject() = 0;
+    virtual void endObject() = 0;
+    virtual void beginArray() = 0;
+    virtual void endArray() = 0;
+    virtual void key(const char* name) = 0;
+
+    virtual void value(const std::string& text) = 0;
+    virtual void value(int64_t number) = 0;
+    virtual void value(double number) = 0;
+    virtual void value(bool flag) = 0;
+    virtual void null() = 0;
+
+    // 任意字节（例如子进程输出），可能不是合法的 UTF-8
+    virtual void bytes(const char* data, size_t size) = 0;
+
+    // 一条记录结束
+    virtual void endRecord() = 0;
+
+    void value(const char* text) { value(std::string(text)); }
+    void value(int number) { value(static_cast<int64_t>(number)); }
+    void value(uint64_t number) { value(static_cast<int64_t>(number)); }
+};
+
+// JSON Lines 写入器；非法的 UTF-8 字节替换为 U+FFFD
+class JsonLinesWriter : public StructuredWriter {
+public:
+    explicit JsonLinesWriter(std::ostream& out) : out(out) {}
+
+    void beginObject() override;
+    void endObject() override;
+    void beginArray() override;
+    void endArray() override;
+    void key(const char* name) override;
+    void value(const std::string& text) override;
+    void value(int64_t number) override;
+    void value(double number) override;
+    void value(bool flag) override;
+    void null() override;
+    void bytes(const char* data, size_t size) override;
+    void endRecord() override;
+    using StructuredWriter::value;
+
+private:
+    void separator();
+    void writeString(const char* data, size_t size);
+
+    std::ostream& out;
+    std::vector<bool> firstInScope;
+    bool afterKey = false;
+};
+
+// CBOR 写入器，对象与数组使用不定长编码，因此无需预先知道元素个数
+class CborWriter : public StructuredWriter {
+public:
+    explicit CborWriter(std::ostream& out);
+
+    void beginObject() override;
+    void endObject() override;
+    void beginArray() override;
+    void endArray() override;
+    void key(const char* name) override;
+    void value(const std::string& text) override;
+    void value(int64_t number) override;
+    void value(double number) override;
+    void value(bool flag) override;
+    void null() override;
+    void bytes(const char* data, size_t size) override;
+    void endRecord() override {}
+    using StructuredWriter::value;
+
+private:
+    void writeHead(uint8_t majorType, uint64_t argument);
+
+    std::ostream& out;
+};
+
+// 按固定字段写出结构化报告：一条 crash 记录，随后是 telemetry 与 output 记录
+void writeStructuredReport(StructuredWriter& writer, const CrashReport& report);
+
+// 写出面向用户的文本崩溃日志
+void writeTextReport(std::ostream& out, const CrashReport& report);
+
+#endif // CRASH_REPORT_H
@@ -0,0 +1,420 @@
+#include "crash_store.h"
+#include "payload_verify.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+const char kIndexName[] = "crash_index.txt";
+const char kIndexHeader[] = "# SwarmClone crash index v1";
+const char kOccurrencesName[] = "occurrences.log";
+const size_t kSignatureLines = 3;
+const size_t kMaxLineLength = 200;
+
+bool isHexDigit(char c) {
+    return std::isxdigit(static_cast<unsigned char>(c)) != 0;
+}
+
+// 去掉索引字段中的制表符与换行
+std::string indexField(const std::string& text) {
+    std::string result = text;
+    std::replace(result.begin(), result.end(), '\t', ' ');
+    std::replace(result.begin(), result.end(), '\n', ' ');
+    std::replace(result.begin(), result.end(), '\r', ' ');
+    return result.empty() ? "-" : result;
+}
+
+// 出错线程栈顶一帧（"#0  0x... 模块!函数+0x..."）中的模块名
+std::string faultingModule(const std::vector<std::string>& backtrace) {
+    for (const std::string& frame : backtrace) {
+        if (frame.compare(0, 2, "#0") != 0) {
+            continue;
+        }
+        size_t address = frame.find("0x");
+        size_t start = address == std::string::npos ? std::string::npos : frame.find(' ', address);
+        if (start == std::string::npos) {
+            return "";
+        }
+        start++;
+        size_t end = frame.find_first_of("!+ ", start);
+        return frame.substr(start, end == std::string::npos ? std::string::npos : end - start);
+    }
+    return "";
+}
+
+} // namespace
+
+std::string normalizeCrashLine(const std::string& line) {
+    std::string result;
+    result.reserve(line.size());
+    size_t i = 0;
+    while (i < line.size() && result.size() < kMaxLineLength) {
+        char c = line[i];
+        if (c == '0' && i + 2 < line.size() && (line[i + 1] == 'x' || line[i + 1] == 'X') && isHexDigit(line[i + 2])) {
+            // 0x 开头的地址
+            i += 2;
+            while (i < line.size() && isHexDigit(line[i])) {
+                i++;
+            }
+            result += "0x#";
+            continue;
+        }
+        if (isHexDigit(c)) {
+            // 不带 0x 的长十六进制串（地址、GUID、哈希）与十进制数字
+            size_t end = i;
+            bool hasDigit = false;
+            while (end < line.size() && isHexDigit(line[end])) {
+                hasDigit = hasDigit || std::isdigit(static_cast<unsigned char>(line[end]));
+                end++;
+            }
+            bool wordStart = i == 0 || !std::isalnum(static_cast<unsigned char>(line[i - 1]));
+            if (hasDigit && (end - i >= 8 || std::isdigit(static_cast<unsigned char>(c))) && wordStart) {
+                result += '#';
+                i = end;
+                continue;
+            }
+        }
+        if (std::isdigit(static_cast<unsigned char>(c))) {
+            while (i < line.size() && std::isdigit(static_cast<unsigned char>(line[i]))) {
+                i++;
+            }
+            result += '#';
+            continue;
+        }
+        if (c == ' ' || c == '\t' || c == '\r') {
+            if (!result.empty() && result.back() != ' ') {
+                result += ' ';
+            }
+            i++;
+            continue;
+        }
+        result += c;
+        i++;
+    }
+    while (!result.empty() && result.back() == ' ') {
+        result.pop_back();
+    }
+    // 截断时不留下半个 UTF-8 字符
+    if (result.size() >= kMaxLineLength) {
+        size_t last = result.size() - 1;
+        while (last > 0 && (static_cast<unsigned char>(result[last]) & 0xC0) == 0x80) {
+            last--;
+        }
+        unsigned char lead = static_cast<unsigned char>(result[last]);
+        size_t expected = (lead & 0xE0) == 0xC0 ? 2 : (lead & 0xF0) == 0xE0 ? 3 : (lead & 0xF8) == 0xF0 ? 4 : 1;
+        if (result.size() - last < expected) {
+            result.resize(last);
+        }
+    }
+    return result;
+}
+
+CrashSignature computeCrashSignature(const CrashReport& report) {
+    CrashSignature signature;
+    if (!report.hangTrigger.empty()) {
+        signature.outcome = "hang:" + report.hangTrigger;
+    } else if (report.signaled) {
+        signature.outcome = "signal:" + std::to_string(report.signal);
+    } else {
+        signature.outcome = "exit:" + std::to_string(report.exitCode);
+    }
+    if (report.native) {
+        signature.module = faultingModule(report.native->backtrace);
+    }
+
+    // 最后几行非空输出，stderr 与全部输出各保留一份
+    std::vector<std::string> lastError;
+    std::vector<std::string> lastAny;
+    if (report.output) {
+        std::string partial[2];
+        auto keep = [](std::vector<std::string>& lines, std::string line) {
+            if (line.find_first_not_of(" \t\r") == std::string::npos) {
+                return;
+            }
+            lines.push_back(std::move(line));
+            if (lines.size() > kSignatureLines) {
+                lines.erase(lines.begin());
+            }
+        };
+        report.output->forEachChunk([&](const OutputChunk& chunk) {
+            bool isError = chunk.stream == OutputStream::Stderr;
+            std::string& pending = partial[isError ? 1 : 0];
+            size_t start = 0;
+            for (size_t i = 0; i < chunk.size; i++) {
+                if (chunk.data[i] == '\n') {
+                    pending.append(chunk.data + start, i - start);
+                    if (isError) {
+                        keep(lastError, pending);
+                    }
+                    keep(lastAny, pending);
+                    pending.clear();
+                    start = i + 1;
+                }
+            }
+            pending.append(chunk.data + start, chunk.size - start);
+        });
+        if (!partial[1].empty()) {
+            keep(lastError, partial[1]);
+        }
+        for (const std::string& line : partial) {
+            keep(lastAny, line);
+        }
+    }
+    signature.rawLines = lastError.empty() ? lastAny : lastError;
+    for (const std::string& line : signature.rawLines) {
+        signature.lines.push_back(normalizeCrashLine(line));
+    }
+
+    std::string canonical = signature.outcome + "\n" + signature.module;
+    for (const std::string& line : signature.lines) {
+        canonical += "\n" + line;
+    }
+    char id[17];
+    std::snprintf(id, sizeof(id), "%016llx",
+                  static_cast<unsigned long long>(Xxh64::hash(canonical.data(), canonical.size())));
+    signature.id = id;
+    return signature;
+}
+
+CrashStore::CrashStore(const std::string& root, uint64_t keepPerBucket, uint64_t quotaBytes)
+    : root(root), keepPerBucket(keepPerBucket), quotaBytes(quotaBytes) {
+}
+
+bool CrashStore::load() {
+    buckets.clear();
+    std::ifstream index(root + "/" + kIndexName);
+    if (!index.is_open()) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(index, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::vector<std::string> fields;
+        std::istringstream stream(line);
+        std::string field;
+        while (std::getline(stream, field, '\t')) {
+            fields.push_back(field == "-" ? "" : field);
+        }
+        if (fields.size() != 9) {
+            continue;
+        }
+        CrashBucket bucket;
+        bucket.id = fields[0];
+        bucket.count = std::strtoull(fields[1].c_str(), nullptr, 10);
+        bucket.fullReports = std::strtoull(fields[2].c_str(), nullptr, 10);
+        bucket.bytes = std::strtoull(fields[3].c_str(), nullptr, 10);
+        bucket.firstUnixMs = std::strtoll(fields[4].c_str(), nullptr, 10);
+        bucket.lastUnixMs = std::strtoll(fields[5].c_str(), nullptr, 10);
+        bucket.outcome = fields[6];
+        bucket.module = fields[7];
+        bucket.summary = fields[8];
+        buckets.push_back(std::move(bucket));
+    }
+    return true;
+}
+
+CrashBucket* CrashStore::findBucket(const std::string& id) {
+    for (CrashBucket& bucket : buckets) {
+        if (bucket.id == id) {
+            return &bucket;
+        }
+    }
+    return nullptr;
+}
+
+std::string CrashStore::bucketDir(const std::string& id) const {
+    return root + "/bucket_" + id;
+}
+
+CrashStore::Entry CrashStore::record(const CrashReport& report, const CrashSignature& signature,
+                                     const std::string& timestamp, bool allowFullReport) {
+    CrashBucket* bucket = findBucket(signature.id);
+    if (!bucket) {
+        CrashBucket created;
+        created.id = signature.id;
+        created.firstUnixMs = report.exitUnixMs;
+        created.outcome = signature.outcome;
+        created.module = signature.module;
+        created.summary = signature.lines.empty() ? "" : signature.lines.back();
+        buckets.push_back(std::move(created));
+        bucket = &buckets.back();
+    }
+    bucket->count++;
+    bucket->lastUnixMs = report.exitUnixMs;
+
+    Entry entry;
+    entry.bucketId = signature.id;
+    entry.occurrence = bucket->count;
+    entry.reportDir = bucketDir(signature.id) + "/";
+    std::error_code error;
+    std::filesystem::create_directories(bucketDir(signature.id), error);
+    if (error) {
+        std::cerr << u8"无法创建崩溃库目录 " << bucketDir(signature.id) << ": " << error.message() << std::endl;
+    }
+
+    if (allowFullReport && bucket->fullReports < keepPerBucket) {
+        bucket->fullReports++;
+        entry.fullReport = true;
+        return entry;
+    }
+
+    // 同一个桶的后续崩溃只保留与签名不同的部分：时间、PID、运行时长与未归一化的错误输出
+    std::string occurrences = bucketDir(signature.id) + "/" + kOccurrencesName;
+    std::ofstream out(occurrences, std::ios::app | std::ios::binary);
+    std::ostringstream delta;
+    delta << timestamp << "\tpid=" << report.childPid << "\tuptime_ms=" << (report.exitUnixMs - report.startUnixMs)
+          << "\t" << signature.outcome << "\n";
+    for (const std::string& line : signature.rawLines) {
+        delta << "    " << line.substr(0, 4 * kMaxLineLength) << "\n";
+    }
+    std::string text = delta.str();
+    out << text;
+    if (out.good()) {
+        bucket->bytes += text.size();
+    }
+    out.close();
+    enforceQuota();
+    saveIndex();
+    return entry;
+}
+
+bool CrashStore::commit(const Entry& entry, const std::vector<std::string>& writtenFiles) {
+    CrashBucket* bucket = findBucket(entry.bucketId);
+    if (!bucket) {
+        return false;
+    }
+    for (const std::string& path : writtenFiles) {
+        std::error_code error;
+        uintmax_t size = std::filesystem::file_size(path, error);
+        if (!error) {
+            bucket->bytes += size;
+        }
+    }
+    enforceQuota();
+    return saveIndex();
+}
+
+void CrashStore::enforceQuota() {
+    uint64_t total = 0;
+    for (const CrashBucket& bucket : buckets) {
+        total += bucket.bytes;
+    }
+    if (total <= quotaBytes) {
+        return;
+    }
+
+    // 只有超出配额时才遍历桶目录：先删除各桶第一份报告以外的文件，再删除第一份报告，均按修改时间从旧到新
+    struct Candidate {
+        bool firstReport;
+        std::filesystem::file_time_type modified;
+        uint64_t size;
+        std::filesystem::path path;
+        CrashBucket* bucket;
+    };
+    std::vector<Candidate> candidates;
+    for (CrashBucket& bucket : buckets) {
+        std::error_code error;
+        std::vector<std::filesystem::path> files;
+        for (const auto& item : std::filesystem::directory_iterator(bucketDir(bucket.id), error)) {
+            if (item.is_regular_file(error)) {
+                files.push_back(item.path());
+            }
+        }
+        // 报告文件名为 crashlog_ 或 crashloop_ 加时间戳，时间戳最小的一组（同名不同扩展名）是最早的报告。
+        // 桶中的精简核心文件（core_）等其他产物不参与比较
+        std::string firstStem;
+        std::string firstTime;
+        for (const std::filesystem::path& file : files) {
+            std::string name = file.filename().string();
+            if (name.rfind("crashlog_", 0) != 0 && name.rfind("crashloop_", 0) != 0) {
+                continue;
+            }
+            std::string stem = name.substr(0, name.find('.'));
+            std::string time = stem.substr(stem.find('_') + 1);
+            if (firstStem.empty() || time < firstTime) {
+                firstStem = stem;
+                firstTime = time;
+            }
+        }
+        for (const std::filesystem::path& file : files) {
+            std::string name = file.filename().string();
+            Candidate candidate;
+            candidate.firstReport = !firstStem.empty() && name.substr(0, name.find('.')) == firstStem;
+            candidate.modified = std::filesystem::last_write_time(file, error);
+            candidate.size = static_cast<uint64_t>(std::filesystem::file_size(file, error));
+            candidate.path = file;
+            candidate.bucket = &bucket;
+            candidates.push_back(std::move(candidate));
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        if (a.firstReport != b.firstReport) {
+            return !a.firstReport;
+        }
+        return a.modified < b.modified;
+    });
+
+    // 以实际占用为准，修正索引中记录的大小
+    for (CrashBucket& bucket : buckets) {
+        bucket.bytes = 0;
+    }
+    total = 0;
+    for (const Candidate& candidate : candidates) {
+        candidate.bucket->bytes += candidate.size;
+        total += candidate.size;
+    }
+    for (const Candidate& candidate : candidates) {
+        if (total <= quotaBytes) {
+            break;
+        }
+        std::error_code error;
+        if (std::filesystem::remove(candidate.path, error)) {
+            candidate.bucket->bytes -= candidate.size;
+            total -= candidate.size;
+        }
+    }
+}
+
+bool CrashStore::saveIndex() const {
+    std::string path = root + "/" + kIndexName;
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::trunc | std::ios::binary);
+        if (!out.is_open()) {
+            std::cerr << u8"无法写入崩溃库索引: " << path << std::endl;
+            return false;
+        }
+        out << kIndexHeader << "\n# id\tcount\tfull\tbytes\tfirst_ms\tlast_ms\toutcome\tmodule\tsummary\n";
+        for (const CrashBucket& bucket : buckets) {
+            out << bucket.id << "\t" << bucket.count << "\t" << bucket.fullReports << "\t" << bucket.bytes << "\t"
+                << bucket.firstUnixMs << "\t" << bucket.lastUnixMs << "\t" << indexField(bucket.outcome) << "\t"
+                << indexField(bucket.module) << "\t" << indexField(bucket.summary) << "\n";
+        }
+        if (!out.good()) {
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(tmpPath, path, error);
+    return !error;
+}
+
+std::vector<CrashBucket> CrashStore::topBuckets(size_t limit) const {
+    std::vector<CrashBucket> result = buckets;
+    std::stable_sort(result.begin(), result.end(), [](const CrashBucket& a, const CrashBucket& b) {
+        return a.count > b.count;
+    });
+    if (result.size() > limit) {
+        result.resize(limit);
+    }
+    return result;
+}
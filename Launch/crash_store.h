@@ -0,0 +1,80 @@
+#ifndef CRASH_STORE_H
+#define CRASH_STORE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "crash_report.h"
+
+// 崩溃签名：退出方式、出错模块与最后几行错误输出（去掉数字与地址）。签名相同的崩溃归入同一个桶
+struct CrashSignature {
+    std::string id;                  // 签名的 XXH64，16 位十六进制
+    std::string outcome;             // exit:<退出码>、signal:<信号> 或 hang:<触发原因>
+    std::string module;              // 出错线程栈顶所在的模块，没有核心转储时为空
+    std::vector<std::string> lines;  // 归一化后的最后几行错误输出
+    std::vector<std::string> rawLines;  // 与 lines 对应的原始内容
+};
+
+// 把一行输出中的十六进制地址与数字替换为 '#'，合并连续空白，用于比较不同次运行的同一条错误
+std::string normalizeCrashLine(const std::string& line);
+
+// 从报告中的退出状态、核心转储调用栈与输出缓冲区计算签名。错误输出优先取 stderr，没有时取全部输出
+CrashSignature computeCrashSignature(const CrashReport& report);
+
+// 索引中的一个桶
+struct CrashBucket {
+    std::string id;
+    uint64_t count = 0;        // 累计次数
+    uint64_t fullReports = 0;  // 写出过完整报告的次数
+    uint64_t bytes = 0;        // 桶目录当前占用的字节数
+    int64_t firstUnixMs = 0;
+    int64_t lastUnixMs = 0;
+    std::string outcome;
+    std::string module;
+    std::string summary;       // 第一条归一化错误输出
+};
+
+// 本地崩溃库：root 下每个桶一个目录 bucket_<签名>，前 keepPerBucket 次崩溃保存完整报告，之后只累加次数并在
+// 桶内的 occurrences.log 追加一行时间、PID 与原始错误输出。root/crash_index.txt 记录每个桶的次数与占用，
+// 列出最常见的崩溃只需读取索引，与报告总数无关。全部桶超过 quotaBytes 时按时间删除最旧的报告，
+// 每个桶的第一份完整报告最后删除；索引中的次数不受删除影响
+class CrashStore {
+public:
+    CrashStore(const std::string& root, uint64_t keepPerBucket, uint64_t quotaBytes);
+
+    // 读取索引，不存在时视为空库
+    bool load();
+
+    // 记录一次崩溃并返回它所在的桶。需要完整报告时 fullReport 为 true，由调用方写入 reportDir（以 '/' 结尾）；
+    // 否则已在 occurrences.log 中追加记录并写回索引。allowFullReport 为 false 时（不单独写日志的崩溃）总是只计数
+    struct Entry {
+        std::string bucketId;
+        uint64_t occurrence = 0;   // 桶内第几次
+        bool fullReport = false;
+        std::string reportDir;
+    };
+    Entry record(const CrashReport& report, const CrashSignature& signature, const std::string& timestamp,
+                 bool allowFullReport = true);
+
+    // 完整报告写出后调用：计入桶的占用，超出配额时清理，并写回索引
+    bool commit(const Entry& entry, const std::vector<std::string>& writtenFiles);
+
+    // 按次数从多到少排列的桶
+    std::vector<CrashBucket> topBuckets(size_t limit) const;
+
+    const std::string& directory() const { return root; }
+
+private:
+    CrashBucket* findBucket(const std::string& id);
+    std::string bucketDir(const std::string& id) const;
+    void enforceQuota();
+    bool saveIndex() const;
+
+    std::string root;
+    uint64_t keepPerBucket;
+    uint64_t quotaBytes;
+    std::vector<CrashBucket> buckets;
+};
+
+#endif // CRASH_STORE_H
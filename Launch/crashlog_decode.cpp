@@ -0,0 +1,34 @@
+// 解压启动器生成的压缩崩溃日志（crashlog_*.log.lz4 等），输出到标准输出或指定文件
+#include "lz4_frame.h"
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        std::cerr << u8"用法: " << argv[0] << u8" <压缩文件> [输出文件]" << std::endl;
+        return 2;
+    }
+
+    std::ifstream in(argv[1], std::ios::binary);
+    if (!in.is_open()) {
+        std::cerr << u8"无法打开文件: " << argv[1] << std::endl;
+        return 1;
+    }
+
+    if (argc > 2) {
+        std::ofstream out(argv[2], std::ios::binary);
+        if (!out.is_open()) {
+            std::cerr << u8"无法创建输出文件: " << argv[2] << std::endl;
+            return 1;
+        }
+        return decodeLz4Frames(in, out) && out.good() ? 0 : 1;
+    }
+
+    std::ios::sync_with_stdio(false);
+    bool ok = decodeLz4Frames(in, std::cout);
+    std::cout.flush();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,401 @@
+#include "hang_watchdog.h"
+
+#ifndef _WIN32
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "process_spawn.h"
+
+#ifdef __linux__
+    #include "proc_fs.h"
+    #include <dirent.h>
+#endif
+
+namespace {
+
+// CPU 占用达到单核的这个比例即视为满载
+const float kCpuPinnedPercent = 90.0f;
+
+// 单个进程的 gdb 调用栈最多等待的时间
+const int kGdbTimeoutMs = 20000;
+
+int64_t millisToNanos(int ms) {
+    return ms > 0 ? static_cast<int64_t>(ms) * 1000000LL : 0;
+}
+
+} // namespace
+
+const char* hangTriggerName(HangTrigger trigger) {
+    switch (trigger) {
+        case HangTrigger::OutputSilence: return "output-silence";
+        case HangTrigger::HeartbeatLost: return "heartbeat-lost";
+        case HangTrigger::CpuStall: return "cpu-stall";
+        default: return "none";
+    }
+}
+
+HangWatchdog::HangWatchdog(EventLoop& loop, const LaunchOptions& options)
+    : loop(loop),
+      outputTimeoutNs(millisToNanos(options.hangOutputTimeoutMs)),
+      heartbeatTimeoutNs(millisToNanos(options.hangHeartbeatTimeoutMs)),
+      cpuStallNs(millisToNanos(options.hangCpuStallMs)),
+      checkIntervalMs(std::max(options.hangCheckIntervalMs, 10)),
+      killGraceMs(std::max(options.hangKillGraceMs, 0)),
+      useGdb(options.hangUseGdb) {}
+
+HangWatchdog::~HangWatchdog() {
+    stop();
+}
+
+bool HangWatchdog::enabled() const {
+    return outputTimeoutNs > 0 || heartbeatTimeoutNs > 0 || cpuStallNs > 0;
+}
+
+void HangWatchdog::prepareChild(SupervisedChild& child) {
+    closeHeartbeat();
+    if (heartbeatTimeoutNs <= 0) {
+        return;
+    }
+
+    int fds[2];
+    if (pipe(fds) == -1) {
+        std::cerr << u8"创建心跳管道失败，心跳检测不可用" << std::endl;
+        return;
+    }
+    for (int fd : fds) {
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    }
+    heartbeatRead = fds[0];
+    heartbeatWrite = fds[1];
+    child.inheritFd(heartbeatWrite, kHeartbeatEnvName);
+}
+
+void HangWatchdog::start(pid_t pid, const ProcessTreeSampler* processSampler) {
+    childPid = pid;
+    sampler = processSampler;
+    firedTrigger = HangTrigger::None;
+    firedStallMs = 0;
+    stacks.clear();
+    lastOutputNs = monotonicNanos();
+    lastHeartbeatNs = 0;
+    stallSinceNs = 0;
+    lastSampleNs = 0;
+    lastIoBytes = 0;
+
+    // 写端已由子进程继承，启动器必须关闭自己的副本，否则子进程退出后读不到 EOF
+    if (heartbeatWrite != -1) {
+        close(heartbeatWrite);
+        heartbeatWrite = -1;
+        loop.addFd(heartbeatRead, [this]() { readHeartbeat(); });
+    }
+
+    if (enabled()) {
+        checkTimer = loop.addTimer(std::chrono::milliseconds(checkIntervalMs), [this]() { check(); });
+    }
+}
+
+void HangWatchdog::stop() {
+    if (checkTimer != -1) {
+        loop.cancelTimer(checkTimer);
+        checkTimer = -1;
+    }
+    bool terminating = killTimer != -1 || gdbPid != -1;
+    if (gdbPid != -1) {
+        // 子进程在采集调用栈期间退出：结束 gdb，已读到的输出保留在 stacks 中
+        kill(gdbPid, SIGKILL);
+        finishGdb();
+    }
+    if (killTimer != -1) {
+        loop.cancelTimer(killTimer);
+        killTimer = -1;
+    }
+    if (terminating) {
+        // 子进程已退出，但忽略了 SIGQUIT 或仍在等待 gdb 的后代进程不能留下
+        signalHungProcesses(SIGKILL);
+    }
+    hungPids.clear();
+    closeHeartbeat();
+    childPid = -1;
+}
+
+void HangWatchdog::closeHeartbeat() {
+    if (heartbeatRead != -1) {
+        loop.removeFd(heartbeatRead);
+        close(heartbeatRead);
+        heartbeatRead = -1;
+    }
+    if (heartbeatWrite != -1) {
+        close(heartbeatWrite);
+        heartbeatWrite = -1;
+    }
+}
+
+void HangWatchdog::readHeartbeat() {
+    char buffer[256];
+    while (true) {
+        ssize_t bytesRead = read(heartbeatRead, buffer, sizeof(buffer));
+        if (bytesRead > 0) {
+            lastHeartbeatNs = monotonicNanos();
+            stallSinceNs = 0;
+            continue;
+        }
+        if (bytesRead == -1 && errno == EINTR) {
+            continue;
+        }
+        if (bytesRead == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        }
+        // 子进程关闭了心跳管道：视为不再提供心跳
+        loop.removeFd(heartbeatRead);
+        close(heartbeatRead);
+        heartbeatRead = -1;
+        lastHeartbeatNs = 0;
+        return;
+    }
+}
+
+void HangWatchdog::check() {
+    if (childPid <= 0 || firedTrigger != HangTrigger::None) {
+        return;
+    }
+    int64_t now = monotonicNanos();
+
+    if (outputTimeoutNs > 0 && now - lastOutputNs >= outputTimeoutNs) {
+        fire(HangTrigger::OutputSilence, now - lastOutputNs);
+        return;
+    }
+
+    if (heartbeatTimeoutNs > 0 && lastHeartbeatNs != 0 && now - lastHeartbeatNs >= heartbeatTimeoutNs) {
+        fire(HangTrigger::HeartbeatLost, now - lastHeartbeatNs);
+        return;
+    }
+
+    if (cpuStallNs > 0 && sampler) {
+        const TelemetrySample* sample = sampler->latest();
+        if (sample && sample->timestampNs != lastSampleNs) {
+            uint64_t ioBytes = sample->readBytes + sample->writeBytes;
+            int64_t lastProgressNs = std::max(lastOutputNs, lastHeartbeatNs);
+            bool pinned = sample->cpuPercent >= kCpuPinnedPercent;
+            bool noProgress = lastSampleNs != 0 && ioBytes == lastIoBytes && lastProgressNs < lastSampleNs;
+            if (pinned && noProgress) {
+                if (stallSinceNs == 0) {
+                    stallSinceNs = lastSampleNs;
+                }
+            } else {
+                stallSinceNs = 0;
+            }
+            lastSampleNs = sample->timestampNs;
+            lastIoBytes = ioBytes;
+        }
+        if (stallSinceNs != 0 && now - stallSinceNs >= cpuStallNs) {
+            fire(HangTrigger::CpuStall, now - stallSinceNs);
+        }
+    }
+}
+
+void HangWatchdog::fire(HangTrigger trigger, int64_t stalledNs) {
+    firedTrigger = trigger;
+    firedStallMs = stalledNs / 1000000;
+    std::cerr << u8"检测到程序无响应（" << hangTriggerName(trigger) << u8"，已持续 " << firedStallMs
+              << u8" ms），正在采集线程状态并终止程序" << std::endl;
+
+    // 先在进程树还处于挂起状态时采集现场，再发送信号。后代进程一并处理，避免留下孤儿进程
+#ifdef __linux__
+    collectProcessTree(childPid, hungPids);
+#else
+    hungPids.assign(1, childPid);
+#endif
+    stacks = captureThreadStacks(hungPids);
+
+    if (useGdb) {
+        gdbPath = findExecutable("gdb");
+        if (gdbPath.empty()) {
+            stacks += u8"未找到 gdb，跳过用户态调用栈\n";
+        } else {
+            gdbNext = 0;
+            startNextGdb();
+            return;
+        }
+    }
+    terminateHung();
+}
+
+void HangWatchdog::startNextGdb() {
+    while (gdbNext < hungPids.size()) {
+        int pid = hungPids[gdbNext++];
+        int fds[2];
+        if (pipe(fds) == -1) {
+            break;
+        }
+        fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+        fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+        LaunchSpec spec;
+        spec.program = gdbPath;
+        spec.args = {"-batch", "-nx", "-p", std::to_string(pid), "-ex", "thread apply all bt"};
+        spec.fdMap = {{STDOUT_FILENO, fds[1]}, {STDERR_FILENO, fds[1]}};
+        std::vector<std::string> warnings;
+        std::string error;
+        gdbPid = spawnProcess(spec, SpawnMethod::Auto, warnings, error);
+        close(fds[1]);
+        if (gdbPid == -1) {
+            close(fds[0]);
+            stacks += u8"无法启动 gdb: " + error + "\n";
+            break;
+        }
+        fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL, 0) | O_NONBLOCK);
+        gdbOutput = fds[0];
+        stacks += u8"进程 " + std::to_string(pid) + u8" 的 gdb 调用栈：\n";
+        loop.addFd(gdbOutput, [this]() { readGdbOutput(); });
+        gdbTimer = loop.addTimer(std::chrono::milliseconds(kGdbTimeoutMs), [this]() {
+            // 结束后管道读到 EOF，由 readGdbOutput 继续下一个进程
+            loop.cancelTimer(gdbTimer);
+            gdbTimer = -1;
+            stacks += u8"gdb 超时，已终止\n";
+            kill(gdbPid, SIGKILL);
+        });
+        return;
+    }
+    terminateHung();
+}
+
+void HangWatchdog::readGdbOutput() {
+    char buffer[4096];
+    while (true) {
+        ssize_t bytesRead = read(gdbOutput, buffer, sizeof(buffer));
+        if (bytesRead > 0) {
+            stacks.append(buffer, static_cast<size_t>(bytesRead));
+            continue;
+        }
+        if (bytesRead == -1 && errno == EINTR) {
+            continue;
+        }
+        if (bytesRead == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        }
+        finishGdb();
+        startNextGdb();
+        return;
+    }
+}
+
+// 关闭输出管道并回收 gdb。管道读到 EOF 时 gdb 已经退出或正在退出，waitpid 不会长时间阻塞
+void HangWatchdog::finishGdb() {
+    loop.removeFd(gdbOutput);
+    close(gdbOutput);
+    gdbOutput = -1;
+    if (gdbTimer != -1) {
+        loop.cancelTimer(gdbTimer);
+        gdbTimer = -1;
+    }
+    int status = 0;
+    while (waitpid(gdbPid, &status, 0) == -1 && errno == EINTR) {
+    }
+    gdbPid = -1;
+}
+
+void HangWatchdog::terminateHung() {
+    // SIGQUIT 让运行时有机会自行输出诊断信息（例如 Python faulthandler、JVM 线程转储）
+    signalHungProcesses(SIGQUIT);
+    killTimer = loop.addTimer(std::chrono::milliseconds(killGraceMs), [this]() {
+        loop.cancelTimer(killTimer);
+        killTimer = -1;
+        std::cerr << u8"程序未响应 SIGQUIT，发送 SIGKILL" << std::endl;
+        signalHungProcesses(SIGKILL);
+    });
+}
+
+void HangWatchdog::signalHungProcesses(int signal) {
+    for (int pid : hungPids) {
+        kill(pid, signal);
+    }
+}
+
+static void appendThreadStacks(std::ostream& out, pid_t pid) {
+#ifdef __linux__
+    char path[128];
+    char buffer[8192];
+
+    std::string processName = "?";
+    std::snprintf(path, sizeof(path), "/proc/%d/comm", static_cast<int>(pid));
+    if (readSmallFile(path, buffer, sizeof(buffer)) > 0) {
+        processName = buffer;
+    }
+    out << u8"进程 " << pid << " (" << processName << u8")：\n";
+
+    std::snprintf(path, sizeof(path), "/proc/%d/task", static_cast<int>(pid));
+    DIR* dir = opendir(path);
+    if (!dir) {
+        out << u8"  无法读取 " << path << "\n";
+        return;
+    }
+    std::vector<int> tids;
+    while (dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] != '.') {
+            tids.push_back(std::atoi(entry->d_name));
+        }
+    }
+    closedir(dir);
+    std::sort(tids.begin(), tids.end());
+
+    for (int tid : tids) {
+        std::string name = "?";
+        std::snprintf(path, sizeof(path), "/proc/%d/task/%d/comm", static_cast<int>(pid), tid);
+        if (readSmallFile(path, buffer, sizeof(buffer)) > 0) {
+            name = buffer;
+        }
+
+        // 状态字母位于进程名之后
+        char state = '?';
+        std::snprintf(path, sizeof(path), "/proc/%d/task/%d/stat", static_cast<int>(pid), tid);
+        if (readSmallFile(path, buffer, sizeof(buffer)) > 0) {
+            const char* p = std::strrchr(buffer, ')');
+            if (p && p[1] == ' ') {
+                state = p[2];
+            }
+        }
+
+        std::string wchan = "-";
+        std::snprintf(path, sizeof(path), "/proc/%d/task/%d/wchan", static_cast<int>(pid), tid);
+        if (readSmallFile(path, buffer, sizeof(buffer)) > 0 && std::strcmp(buffer, "0") != 0) {
+            wchan = buffer;
+        }
+
+        out << u8"  线程 " << tid << " (" << name << u8") 状态 " << state << " wchan " << wchan << "\n";
+
+        // 内核栈通常需要 root 权限，读不到时跳过
+        std::snprintf(path, sizeof(path), "/proc/%d/task/%d/stack", static_cast<int>(pid), tid);
+        if (readSmallFile(path, buffer, sizeof(buffer)) > 0 && buffer[0] != '\0') {
+            std::istringstream frames(buffer);
+            std::string frame;
+            while (std::getline(frames, frame)) {
+                out << "      " << frame << "\n";
+            }
+        }
+    }
+#else
+    out << u8"进程 " << pid << "\n";
+#endif
+}
+
+std::string captureThreadStacks(const std::vector<int>& pids) {
+    std::ostringstream out;
+    for (int pid : pids) {
+        appendThreadStacks(out, pid);
+    }
+    return out.str();
+}
+
+#endif // _WIN32
@@ -0,0 +1,108 @@
+#ifndef HANG_WATCHDOG_H
+#define HANG_WATCHDOG_H
+
+#ifndef _WIN32
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+#include "launch_options.h"
+#include "supervisor.h"
+#include "telemetry.h"
+
+// 子进程通过该环境变量得知心跳管道的写端编号，定期向其中写入任意字节即可
+constexpr const char kHeartbeatEnvName[] = "SWARMCLONE_HEARTBEAT_FD";
+
+// 挂起检测的触发原因
+enum class HangTrigger {
+    None,
+    OutputSilence,   // 长时间没有任何输出
+    HeartbeatLost,   // 心跳中断（只有收到过第一次心跳后才启用）
+    CpuStall,        // CPU 满载，但没有输出、心跳或 I/O
+};
+
+const char* hangTriggerName(HangTrigger trigger);
+
+// 运行在监管事件循环中的挂起看门狗。检测完全由定时器驱动，不额外占用线程；
+// 触发后采集各线程状态并依次发送 SIGQUIT、SIGKILL，子进程退出后照常走崩溃日志流程。
+// 使用 gdb 时逐个进程启动 gdb，输出管道同样由事件循环读取，全部结束后才发送信号，期间循环照常处理其他事件
+class HangWatchdog {
+public:
+    HangWatchdog(EventLoop& loop, const LaunchOptions& options);
+    ~HangWatchdog();
+    HangWatchdog(const HangWatchdog&) = delete;
+    HangWatchdog& operator=(const HangWatchdog&) = delete;
+
+    bool enabled() const;
+
+    // 在 child.start() 之前调用：创建心跳管道并让子进程继承写端
+    void prepareChild(SupervisedChild& child);
+
+    // 在 child.start() 之后调用，开始监视；sampler 为空时不做 CPU 检测
+    void start(pid_t pid, const ProcessTreeSampler* sampler);
+
+    // 子进程退出后调用，停止全部定时器
+    void stop();
+
+    // 子进程有输出时调用
+    void noteOutput(int64_t timestampNs) { lastOutputNs = timestampNs; }
+
+    // 本次运行是否因挂起被终止，以及触发时采集到的信息
+    HangTrigger trigger() const { return firedTrigger; }
+    int64_t stalledMs() const { return firedStallMs; }
+    const std::string& threadStacks() const { return stacks; }
+
+private:
+    void check();
+    void fire(HangTrigger trigger, int64_t stalledNs);
+    void startNextGdb();
+    void readGdbOutput();
+    void finishGdb();
+    void terminateHung();
+    void signalHungProcesses(int signal);
+    void readHeartbeat();
+    void closeHeartbeat();
+
+    EventLoop& loop;
+    int64_t outputTimeoutNs;
+    int64_t heartbeatTimeoutNs;
+    int64_t cpuStallNs;
+    int checkIntervalMs;
+    int killGraceMs;
+    bool useGdb;
+
+    pid_t childPid = -1;
+    const ProcessTreeSampler* sampler = nullptr;
+    int heartbeatRead = -1;
+    int heartbeatWrite = -1;
+    int checkTimer = -1;
+    int killTimer = -1;
+
+    std::string gdbPath;               // 为空时不使用 gdb
+    size_t gdbNext = 0;                // 下一个要附加 gdb 的 hungPids 下标
+    pid_t gdbPid = -1;
+    int gdbOutput = -1;
+    int gdbTimer = -1;
+
+    int64_t lastOutputNs = 0;
+    int64_t lastHeartbeatNs = 0;       // 0 表示尚未收到心跳
+    int64_t stallSinceNs = 0;          // CPU 满载且无进展的起始时刻
+    int64_t lastSampleNs = 0;
+    uint64_t lastIoBytes = 0;
+
+    std::vector<int> hungPids;       // 触发时的进程树快照，子进程在最前
+    HangTrigger firedTrigger = HangTrigger::None;
+    int64_t firedStallMs = 0;
+    std::string stacks;
+};
+
+// 采集各进程中各线程的名称、状态、wchan 与内核栈（/proc/<pid>/task/*）
+std::string captureThreadStacks(const std::vector<int>& pids);
+
+#endif // _WIN32
+
+#endif // HANG_WATCHDOG_H
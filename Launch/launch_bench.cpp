@@ -0,0 +1,1061 @@
+// 启动器关键路径的性能测试，需在配置时打开 LAUNCH_BUILD_BENCH。
+// 用法：launch_bench [--json[=文件]] [用例名前缀...]，不带用例名时运行全部用例。
+// --json 时另外把全部结果写成 JSON（缺省为 launch_bench.json），便于跟踪历次结果。有指标低于目标时返回 1。
+// launch_bench --self-check 只检查各项功能的降级路径与捕获路径的内存上界，有失败时返回 1
+
+#include "capture_log.h"
+#include "crash_log.h"
+#include "live_output.h"
+#ifdef LAUNCH_HAVE_LZ4
+    #include "lz4_frame.h"
+#endif
+#include "pattern_scanner.h"
+#include "system_info.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+    #include "process_spawn.h"
+    #include <sys/wait.h>
+#endif
+#ifdef __linux__
+    #include "cgroup_sandbox.h"
+    #include "payload_prefetch.h"
+    #include "proc_fs.h"
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/resource.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchCase {
+    const char* name;
+    std::function<void()> run;
+};
+
+// 一个用例的结果：耗时样本（微秒）的统计与附加指标（吞吐量、内存等）
+struct BenchResult {
+    std::string name;
+    size_t count = 0;
+    double median = 0;
+    double p99 = 0;
+    double max = 0;
+    std::vector<std::pair<std::string, double>> metrics;
+};
+
+std::vector<BenchResult> results;
+
+// 输出一组耗时样本（微秒）的中位数、p99 与最大值，metrics 附在同一行之后
+void report(const char* name, std::vector<double>& samples,
+            const std::vector<std::pair<std::string, double>>& metrics = {}) {
+    if (samples.empty()) {
+        return;
+    }
+    std::sort(samples.begin(), samples.end());
+    BenchResult result;
+    result.name = name;
+    result.count = samples.size();
+    result.median = samples[samples.size() / 2];
+    result.p99 = samples[std::min(samples.size() - 1, samples.size() * 99 / 100)];
+    result.max = samples.back();
+    result.metrics = metrics;
+    std::printf("%-40s n=%-5zu median %9.1f us  p99 %9.1f us  max %9.1f us", name, result.count, result.median,
+                result.p99, result.max);
+    for (const auto& metric : metrics) {
+        std::printf("  %s %.1f", metric.first.c_str(), metric.second);
+    }
+    std::printf("\n");
+    results.push_back(std::move(result));
+}
+
+// 低于下限的指标个数，非 0 时 launch_bench 返回 1
+int belowFloor = 0;
+
+// 检查性能目标。耗时在未优化的构建中没有意义，只在定义了 NDEBUG 的构建中计为失败
+void expectAtLeast(const char* name, const char* metric, double value, double floor) {
+    if (value >= floor) {
+        return;
+    }
+#ifdef NDEBUG
+    belowFloor++;
+    std::printf("%-40s FAILED  %s %.1f < %.1f\n", name, metric, value, floor);
+#else
+    std::printf("%-40s %s %.1f < %.1f (not checked in unoptimized builds)\n", name, metric, value, floor);
+#endif
+}
+
+// 只有附加指标、没有耗时样本的结果
+void reportMetrics(const char* name, const std::vector<std::pair<std::string, double>>& metrics) {
+    std::printf("%-40s", name);
+    for (const auto& metric : metrics) {
+        std::printf(" %s %.1f", metric.first.c_str(), metric.second);
+    }
+    std::printf("\n");
+    BenchResult result;
+    result.name = name;
+    result.metrics = metrics;
+    results.push_back(std::move(result));
+}
+
+// 把全部结果写成一个 JSON 对象：{"results": [{"name": ..., "n": ..., "median_us": ..., ...}]}
+bool writeJson(const std::string& path) {
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        std::fprintf(stderr, "cannot write %s\n", path.c_str());
+        return false;
+    }
+    std::fprintf(file, "{\"results\": [");
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& result = results[i];
+        std::fprintf(file, "%s\n  {\"name\": \"%s\"", i == 0 ? "" : ",", result.name.c_str());
+        if (result.count > 0) {
+            std::fprintf(file, ", \"n\": %zu, \"median_us\": %.3f, \"p99_us\": %.3f, \"max_us\": %.3f", result.count,
+                         result.median, result.p99, result.max);
+        }
+        for (const auto& metric : result.metrics) {
+            std::fprintf(file, ", \"%s\": %.3f", metric.first.c_str(), metric.second);
+        }
+        std::fprintf(file, "}");
+    }
+    std::fprintf(file, "\n]}\n");
+    return std::fclose(file) == 0;
+}
+
+#ifdef __linux__
+// 改为读取 sysfs/CPUID 之前的实现，作为 probe/cpu 与 probe/gpu 的对照：逐行扫描 /proc/cpuinfo，
+// 以及通过 popen 运行 lspci | grep -i vga（未安装 lspci 时只剩 shell 与 grep 的开销，是下限）
+std::string baselineCpuInfo() {
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.find("model name") != std::string::npos) {
+            size_t pos = line.find(":");
+            if (pos != std::string::npos) {
+                return line.substr(pos + 2);
+            }
+        }
+    }
+    return "";
+}
+
+std::vector<std::string> baselineGpuInfo() {
+    std::vector<std::string> gpus;
+    FILE* pipe = popen("lspci 2>/dev/null | grep -i vga", "r");
+    if (pipe) {
+        char buffer[256];
+        while (fgets(buffer, sizeof(buffer), pipe) != NULL) {
+            std::string line(buffer);
+            size_t pos = line.find(": ");
+            if (pos != std::string::npos) {
+                gpus.push_back(line.substr(pos + 2));
+            }
+        }
+        pclose(pipe);
+    }
+    return gpus;
+}
+#endif
+
+// 系统信息探测：崩溃日志中的各项系统信息，缓存未命中时在启动阶段逐项采集。
+// Linux 上另外测量旧实现（/proc/cpuinfo、lspci）作为对照
+void benchProbes() {
+    const int iterations = 20;
+    const std::pair<const char*, std::function<void()>> probes[] = {
+        {"probe/cpu", [] { getCpuInfo(); }},
+        {"probe/gpu", [] { getGpuInfo(); }},
+#ifdef __linux__
+        {"probe/cpu-baseline-proc-cpuinfo", [] { baselineCpuInfo(); }},
+        {"probe/gpu-baseline-lspci", [] { baselineGpuInfo(); }},
+#endif
+        {"probe/memory", [] { getMemoryInfo(); }},
+#ifdef _WIN32
+        {"probe/os-version", [] { getWindowsVersion(); }},
+#else
+        {"probe/os-version", [] { getUnixVersion(); }},
+#endif
+    };
+    for (const auto& probe : probes) {
+        std::vector<double> samples;
+        for (int i = 0; i < iterations; i++) {
+            Clock::time_point start = Clock::now();
+            probe.second();
+            samples.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+        }
+        report(probe.first, samples);
+    }
+}
+
+// 时间戳格式化：崩溃日志文件名使用的 getCurrentTimestamp（stringstream + put_time）
+// 与捕获日志查询逐行使用的 TimestampFormatter，每个样本为 1000 次调用
+void benchTimestamp() {
+    const int iterations = 200;
+    const int calls = 1000;
+    std::vector<double> samples;
+    for (int i = 0; i < iterations; i++) {
+        Clock::time_point start = Clock::now();
+        for (int n = 0; n < calls; n++) {
+            getCurrentTimestamp();
+        }
+        samples.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+    }
+    report("timestamp/put-time/x1000", samples);
+
+    samples.clear();
+    TimestampFormatter formatter;
+    char text[TimestampFormatter::kLength];
+    volatile char sink = 0;
+    int64_t unixNs = unixMillis() * 1000000;
+    for (int i = 0; i < iterations; i++) {
+        Clock::time_point start = Clock::now();
+        for (int n = 0; n < calls; n++) {
+            // 每次前进 1 ms，与逐行输出的时间分布相近
+            formatter.format(unixNs + static_cast<int64_t>(i * calls + n) * 1000000, text);
+            sink = sink + text[22];
+        }
+        samples.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+    }
+    report("timestamp/cached-second/x1000", samples);
+}
+
+// 生成崩溃日志的耗时与缓冲区中输出量的关系：文本日志，以及同时写出 JSON Lines 结构化报告
+void benchCrashLog() {
+    const int iterations = 5;
+    SystemInventory inventory = collectSystemInventory();
+    std::string line = "2026-01-01 00:00:00 [INFO] worker 12: processed request in 3.2 ms, queue depth 7\n";
+
+    // 生成日志时的提示信息不计入输出
+    std::ostringstream discarded;
+    std::streambuf* coutBuf = std::cout.rdbuf(discarded.rdbuf());
+    for (size_t sizeMb : {1, 8, 64}) {
+        OutputRingBuffer output(sizeMb * 1024 * 1024);
+        for (size_t written = 0; written < sizeMb * 1024 * 1024; written += line.size()) {
+            output.append(OutputStream::Stdout, monotonicNanos(), line.data(), line.size());
+        }
+        CrashReport crash;
+        crash.programPath = "launcher/SwarmCloneLauncher";
+        crash.exited = true;
+        crash.exitCode = 1;
+        crash.inventory = &inventory;
+        crash.output = &output;
+
+        for (ReportFormat format : {ReportFormat::None, ReportFormat::JsonLines}) {
+            LaunchOptions options;
+            options.crashLogDir = "launch_bench_crashlogs";
+            options.reportFormat = format;
+            std::vector<double> samples;
+            for (int i = 0; i < iterations; i++) {
+                crash.exitTimestampNs = monotonicNanos();
+                Clock::time_point start = Clock::now();
+                generateCrashLog(crash, options, false);
+                samples.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+            }
+            char name[64];
+            std::snprintf(name, sizeof(name), "crashlog/%s/output=%zuMB", format == ReportFormat::None ? "text" : "jsonl",
+                          sizeMb);
+            std::sort(samples.begin(), samples.end());
+            double megabytesPerSecond = static_cast<double>(sizeMb) / (samples[samples.size() / 2] / 1e6);
+            report(name, samples, {{"mb_per_s", megabytesPerSecond}});
+        }
+    }
+    std::cout.rdbuf(coutBuf);
+    std::error_code error;
+    std::filesystem::remove_all("launch_bench_crashlogs", error);
+}
+
+#ifdef LAUNCH_HAVE_LZ4
+// 丢弃写入内容的输出流，只测量压缩本身
+class DiscardBuffer : public std::streambuf {
+protected:
+    int_type overflow(int_type ch) override { return traits_type::not_eof(ch); }
+    std::streamsize xsputn(const char*, std::streamsize size) override { return size; }
+};
+
+// 以 LZ4 帧格式流式压缩 64 MB 合成日志（--compress-crash-log）的吞吐量与压缩比。
+// 日志行的时间、线程、耗时与请求编号各不相同，每隔一段夹带一段异常与栈回溯，接近真实输出的重复程度
+void benchCompress() {
+    const int iterations = 5;
+    const size_t corpusSize = 64 * 1024 * 1024;
+    std::mt19937 rng(42);
+    std::string corpus;
+    corpus.reserve(corpusSize + 1024);
+    char line[256];
+    for (uint64_t n = 0; corpus.size() < corpusSize; n++) {
+        int length = std::snprintf(line, sizeof(line),
+                                   "2026-01-01 00:%02u:%02u.%03u [%s] worker %u: request %08x processed in %u.%u ms, "
+                                   "queue depth %u\n", static_cast<unsigned>(n / 60000 % 60),
+                                   static_cast<unsigned>(n / 1000 % 60), static_cast<unsigned>(n % 1000),
+                                   rng() % 20 == 0 ? "WARN" : "INFO", static_cast<unsigned>(rng() % 16),
+                                   static_cast<unsigned>(rng()), static_cast<unsigned>(rng() % 50),
+                                   static_cast<unsigned>(rng() % 10), static_cast<unsigned>(rng() % 32));
+        corpus.append(line, static_cast<size_t>(length));
+        if (n % 5000 == 4999) {
+            corpus += "Unhandled exception. System.InvalidOperationException: queue closed\n"
+                      "   at Worker.Process(Request request)\n   at Worker.Run()\n   at Program.Main(String[] args)\n";
+        }
+    }
+
+    std::vector<double> samples;
+    uint64_t compressedBytes = 0;
+    for (int i = 0; i < iterations; i++) {
+        DiscardBuffer discard;
+        std::ostream sink(&discard);
+        Clock::time_point start = Clock::now();
+        Lz4FrameWriter writer(sink);
+        std::ostream out(&writer);
+        // 与写崩溃日志时相同，按行大小的片段写入
+        for (size_t offset = 0; offset < corpus.size(); offset += 4096) {
+            size_t size = std::min<size_t>(4096, corpus.size() - offset);
+            out.write(corpus.data() + offset, static_cast<std::streamsize>(size));
+        }
+        writer.finish();
+        samples.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+        compressedBytes = writer.outputBytes();
+    }
+    std::sort(samples.begin(), samples.end());
+    double megabytesPerSecond = static_cast<double>(corpus.size()) / 1048576 / (samples[samples.size() / 2] / 1e6);
+    report("compress/lz4/64MB-log", samples,
+           {{"mb_per_s", megabytesPerSecond}, {"ratio", static_cast<double>(corpus.size()) / compressedBytes}});
+}
+#endif
+
+// 错误摘要在捕获路径上逐段扫描的吞吐量：普通日志行，以及每 64 KB 夹带一段异常与栈回溯。
+// 目标为单核 2 GB/s 以上，AVX2 实现低于目标时记为失败；SSE2 实现逐个模式比较锚点，达不到这个目标
+void benchHighlights() {
+    const int iterations = 20;
+    const size_t totalSize = 64 * 1024 * 1024;
+    const size_t chunkSize = 64 * 1024;
+    std::string line = "2026-01-01 00:00:00 [INFO] worker 12: processed request in 3.2 ms, queue depth 7\n";
+    std::string error = "Unhandled exception. System.InvalidOperationException: queue closed\n"
+                        "   at Worker.Process()\n   at Worker.Run()\n";
+
+    for (bool withErrors : {false, true}) {
+        std::string data;
+        data.reserve(totalSize + chunkSize);
+        while (data.size() < totalSize) {
+            if (withErrors && data.size() % chunkSize + line.size() >= chunkSize) {
+                data += error;
+            }
+            data += line;
+        }
+
+        OutputHighlights highlights(defaultHighlightPatterns());
+        std::vector<double> samples;
+        for (int i = 0; i < iterations; i++) {
+            highlights.clear();
+            Clock::time_point start = Clock::now();
+            for (size_t offset = 0; offset < data.size(); offset += chunkSize) {
+                highlights.scan(OutputChunk{OutputStream::Stderr, static_cast<int64_t>(offset), data.data() + offset,
+                                            std::min(chunkSize, data.size() - offset)});
+            }
+            samples.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+        }
+        char name[64];
+        std::snprintf(name, sizeof(name), "highlights/scan/%s/%s", PatternScanner({"FATAL"}).implementation(),
+                      withErrors ? "errors" : "clean");
+        std::sort(samples.begin(), samples.end());
+        double megabytesPerSecond = static_cast<double>(data.size()) / 1048576 / (samples[samples.size() / 2] / 1e6);
+        report(name, samples,
+               {{"mb_per_s", megabytesPerSecond}, {"matches", static_cast<double>(highlights.matchCount())}});
+        if (std::strcmp(PatternScanner({"FATAL"}).implementation(), "avx2") == 0) {
+            expectAtLeast(name, "mb_per_s", megabytesPerSecond, 2048);
+        }
+    }
+}
+
+// 实时输出环：只有写入者时的发布吞吐量，以及写入者按 200 MB/s 发布 4 KB 记录（与管道单次读取的大小相近）时
+// 1 个与 4 个读者的延迟（记录发布到被读出的时间）、最大落后字节数与因落后超过一圈而跳过的字节数
+void benchLiveOutput() {
+    const size_t recordSize = 4096;
+    const size_t ringSize = 4 * 1024 * 1024;
+    std::string payload(recordSize, 'x');
+
+    {
+        LiveOutputWriter writer;
+        if (!writer.create("launch_bench_live", ringSize, "launch_bench")) {
+            return;
+        }
+        const size_t total = size_t(1024) * 1024 * 1024;
+        std::vector<double> samples;
+        for (int i = 0; i < 5; i++) {
+            Clock::time_point start = Clock::now();
+            for (size_t written = 0; written < total / 5; written += recordSize) {
+                writer.publish(SC_LIVE_STREAM_STDOUT, monotonicNanos(), payload.data(), payload.size());
+            }
+            samples.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+        }
+        std::sort(samples.begin(), samples.end());
+        double megabytesPerSecond = static_cast<double>(total / 5) / 1048576 / (samples[samples.size() / 2] / 1e6);
+        report("live/publish/4KB/no-readers", samples, {{"mb_per_s", megabytesPerSecond}});
+    }
+
+    for (int readerCount : {1, 4}) {
+        LiveOutputWriter writer;
+        if (!writer.create("launch_bench_live", ringSize, "launch_bench")) {
+            return;
+        }
+        std::atomic<bool> writerDone{false};
+        std::vector<std::vector<double>> latencies(readerCount);
+        std::vector<uint64_t> maxLag(readerCount), skippedBytes(readerCount);
+        std::vector<std::thread> readers;
+        for (int r = 0; r < readerCount; r++) {
+            readers.emplace_back([&, r]() {
+                LiveOutputReader reader;
+                if (!reader.open("launch_bench_live", false)) {
+                    return;
+                }
+                std::vector<char> buffer(recordSize);
+                sc_live_record record;
+                while (true) {
+                    int result = reader.next(record, buffer.data(), buffer.size());
+                    if (result == SC_LIVE_RECORD) {
+                        int64_t publishedNs = record.timestamp_unix_ns - reader.info()->monoToUnixNs;
+                        latencies[r].push_back((monotonicNanos() - publishedNs) / 1e3);
+                        maxLag[r] = std::max(maxLag[r], reader.lag());
+                    } else if (writerDone.load()) {
+                        break;
+                    } else {
+                        // 与图形界面的做法相同：没有新记录时短暂休眠
+                        std::this_thread::sleep_for(std::chrono::microseconds(200));
+                    }
+                }
+                skippedBytes[r] = reader.skippedBytes();
+            });
+        }
+
+        // 每毫秒发布一批，共 1 秒
+        const size_t bytesPerMs = 200 * 1024 * 1024 / 1000;
+        Clock::time_point start = Clock::now();
+        size_t written = 0;
+        for (int ms = 1; ms <= 1000; ms++) {
+            for (size_t batch = 0; batch < bytesPerMs; batch += recordSize) {
+                writer.publish(SC_LIVE_STREAM_STDOUT, monotonicNanos(), payload.data(), payload.size());
+                written += recordSize;
+            }
+            std::this_thread::sleep_until(start + std::chrono::milliseconds(ms));
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        writerDone = true;
+        for (std::thread& thread : readers) {
+            thread.join();
+        }
+
+        std::vector<double> samples;
+        uint64_t lag = 0;
+        uint64_t skipped = 0;
+        for (int r = 0; r < readerCount; r++) {
+            samples.insert(samples.end(), latencies[r].begin(), latencies[r].end());
+            lag = std::max(lag, maxLag[r]);
+            skipped += skippedBytes[r];
+        }
+        char name[64];
+        std::snprintf(name, sizeof(name), "live/follow/4KB/readers=%d", readerCount);
+        report(name, samples, {{"mb_per_s", static_cast<double>(written) / 1048576 / seconds},
+                               {"max_lag_kb", static_cast<double>(lag) / 1024},
+                               {"skipped_mb", static_cast<double>(skipped) / 1048576}});
+    }
+}
+
+#ifndef _WIN32
+// 子进程启动耗时：从调用 spawnProcess 到确认 exec 成功。
+// 启动器占用的内存越多，fork 复制页表的开销越大，因此分别在不同的常驻内存下测量
+void benchSpawn() {
+    const int iterations = 200;
+    LaunchSpec spec;
+    spec.program = "/bin/true";
+
+    for (size_t residentMb : {0, 256, 1024}) {
+        std::vector<char> ballast(residentMb * 1024 * 1024);
+        for (size_t i = 0; i < ballast.size(); i += 4096) {
+            ballast[i] = 1;
+        }
+
+        for (SpawnMethod method : {SpawnMethod::Auto, SpawnMethod::Fork}) {
+            std::vector<double> samples;
+            for (int i = 0; i < iterations; i++) {
+                std::vector<std::string> warnings;
+                std::string error;
+                Clock::time_point start = Clock::now();
+                pid_t pid = spawnProcess(spec, method, warnings, error);
+                Clock::time_point end = Clock::now();
+                if (pid == -1) {
+                    std::fprintf(stderr, "spawn failed: %s\n", error.c_str());
+                    return;
+                }
+                waitpid(pid, nullptr, 0);
+                samples.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+            }
+            char name[64];
+            std::snprintf(name, sizeof(name), "spawn/%s/rss=%zuMB", method == SpawnMethod::Auto ? "clone-vfork" : "fork",
+                          residentMb);
+            report(name, samples);
+        }
+    }
+}
+#endif
+
+#ifdef __linux__
+// 本程序的完整路径，读取失败时返回空字符串
+std::string selfExecutable() {
+    char self[4096];
+    ssize_t length = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    if (length <= 0) {
+        return "";
+    }
+    return std::string(self, static_cast<size_t>(length));
+}
+
+// 同一构建目录中的 launch，不存在时返回空字符串
+std::string builtLauncher() {
+    std::string self = selfExecutable();
+    std::string launcher = self.substr(0, self.find_last_of('/') + 1) + "launch";
+    if (access(launcher.c_str(), X_OK) != 0) {
+        std::fprintf(stderr, "%s not found\n", launcher.c_str());
+        return "";
+    }
+    return launcher;
+}
+
+// 运行中的进程的内存峰值（/proc/<pid>/status 的 VmHWM，KB），进程已退出时返回 -1
+long readPeakRssKb(pid_t pid) {
+    char path[64];
+    std::snprintf(path, sizeof(path), "/proc/%d/status", static_cast<int>(pid));
+    char text[4096];
+    if (readSmallFile(path, text, sizeof(text)) <= 0) {
+        return -1;
+    }
+    const char* field = std::strstr(text, "VmHWM:");
+    return field ? std::strtol(field + 6, nullptr, 10) : -1;
+}
+
+// 运行 launch 直到退出，标准输出与标准错误丢弃，返回耗时（微秒）。peakRssKb 返回启动器自身的内存峰值：
+// wait4 的 ru_maxrss 取的是启动器与它回收的子进程中最大的一个，因此改为在运行期间每 10 ms 读取一次 VmHWM。
+// cpuUs 非空时返回 CPU 时间（微秒）：[0] 为启动器自身（退出后从 /proc/<pid>/stat 读取），
+// [1] 为 wait4 的 ru_utime + ru_stime，包括启动器回收的子进程
+double runLauncher(const std::string& launcher, const std::vector<std::string>& args, const std::string& workDir,
+                   long& peakRssKb, double* cpuUs = nullptr) {
+    LaunchSpec spec;
+    spec.program = launcher;
+    spec.args = args;
+    spec.args.push_back("--notify-log=/dev/null");
+    spec.workDir = workDir;
+    int devNull = open("/dev/null", O_WRONLY | O_CLOEXEC);
+    spec.fdMap = {{STDOUT_FILENO, devNull}, {STDERR_FILENO, devNull}};
+    std::vector<std::string> warnings;
+    std::string error;
+    Clock::time_point start = Clock::now();
+    pid_t pid = spawnProcess(spec, SpawnMethod::Auto, warnings, error);
+    close(devNull);
+    if (pid == -1) {
+        std::fprintf(stderr, "spawn failed: %s\n", error.c_str());
+        return -1;
+    }
+    std::atomic<bool> exited{false};
+    std::atomic<long> peak{0};
+    std::thread sampler([&]() {
+        while (!exited.load()) {
+            long current = readPeakRssKb(pid);
+            if (current > peak.load()) {
+                peak = current;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    });
+
+    // 先等待进程退出但不回收，此时 VmHWM 已随地址空间释放，采样线程停在最后一次读到的值
+    siginfo_t info;
+    waitid(P_PID, static_cast<id_t>(pid), &info, WEXITED | WNOWAIT);
+    double elapsed = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    exited = true;
+    sampler.join();
+
+    // 僵尸进程的 stat 中 utime、stime（第 14、15 个字段）只含它自己
+    char path[64];
+    std::snprintf(path, sizeof(path), "/proc/%d/stat", static_cast<int>(pid));
+    char stat[1024];
+    unsigned long long ownTicks = 0;
+    if (readSmallFile(path, stat, sizeof(stat)) > 0 && std::strrchr(stat, ')') != nullptr) {
+        unsigned long long utime = 0;
+        unsigned long long stime = 0;
+        if (std::sscanf(std::strrchr(stat, ')') + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu", &utime,
+                        &stime) == 2) {
+            ownTicks = utime + stime;
+        }
+    }
+    int status = 0;
+    struct rusage usage;
+    wait4(pid, &status, 0, &usage);
+    peakRssKb = peak.load();
+    if (cpuUs) {
+        cpuUs[0] = static_cast<double>(ownTicks) * 1e6 / static_cast<double>(sysconf(_SC_CLK_TCK));
+        cpuUs[1] = (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1e6 +
+                   static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+    }
+    return elapsed;
+}
+
+const char kCaptureDir[] = "launch_bench_capture";
+const int kCaptureMegabytes = 256;
+
+// 让 launch 启动的程序改为运行本程序的 --write-output 模式，写出 megabytes MB 后退出
+void writeCaptureScript(int megabytes) {
+    std::filesystem::create_directories(std::string(kCaptureDir) + "/launcher");
+    std::string script = std::string(kCaptureDir) + "/launcher/SwarmCloneLauncher";
+    std::FILE* file = std::fopen(script.c_str(), "w");
+    std::fprintf(file, "#!/bin/sh\nexec '%s' --write-output=%d\n", selfExecutable().c_str(), megabytes);
+    std::fclose(file);
+    chmod(script.c_str(), 0755);
+}
+
+// 分别让子进程写出 256 MB 与 2 GB，测量启动器自身的 VmHWM。输出缓冲区是固定容量的环，峰值应与输出量无关
+bool measureCaptureRss(const std::string& launcher, long peakRssKb[2]) {
+    int megabytes[2] = {kCaptureMegabytes, 2048};
+    for (int i = 0; i < 2; i++) {
+        writeCaptureScript(megabytes[i]);
+        if (runLauncher(launcher, {}, kCaptureDir, peakRssKb[i]) < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 输出捕获的吞吐量：launch 以单程序模式运行本程序的 --write-output 模式，子进程尽快写出 256 MB 文本行，
+// 启动器读取后转发到控制台（这里是 /dev/null）并保留在输出缓冲区中。分别测量默认设置（Linux 上 tee/splice
+// 转发）、关闭零拷贝转发与同时写分段捕获日志。cpu_pct 为启动器自身的 CPU 时间占运行时长的比例，
+// tree_cpu_pct 还包括写出输出的子进程。随后用 measureCaptureRss 比较 256 MB 与 2 GB 输出时的内存峰值
+void benchCapture() {
+    const int iterations = 3;
+    std::string launcher = builtLauncher();
+    if (launcher.empty()) {
+        return;
+    }
+    writeCaptureScript(kCaptureMegabytes);
+
+    const std::pair<const char*, std::vector<std::string>> variants[] = {
+        {"capture/256MB/default", {}},
+        {"capture/256MB/no-zero-copy", {"--no-zero-copy"}},
+        {"capture/256MB/capture-log", {"--capture-log=capture_log"}},
+    };
+    for (const auto& variant : variants) {
+        std::vector<double> samples;
+        long maxRssKb = 0;
+        double totalUs = 0;
+        double cpuTotalUs[2] = {0, 0};
+        for (int i = 0; i < iterations; i++) {
+            long peakRssKb = 0;
+            double cpuUs[2] = {0, 0};
+            double elapsed = runLauncher(launcher, variant.second, kCaptureDir, peakRssKb, cpuUs);
+            if (elapsed < 0) {
+                return;
+            }
+            samples.push_back(elapsed);
+            maxRssKb = std::max(maxRssKb, peakRssKb);
+            totalUs += elapsed;
+            cpuTotalUs[0] += cpuUs[0];
+            cpuTotalUs[1] += cpuUs[1];
+            std::filesystem::remove_all(std::string(kCaptureDir) + "/capture_log");
+        }
+        std::sort(samples.begin(), samples.end());
+        double megabytesPerSecond = kCaptureMegabytes / (samples[samples.size() / 2] / 1e6);
+        report(variant.first, samples,
+               {{"mb_per_s", megabytesPerSecond}, {"cpu_pct", cpuTotalUs[0] / totalUs * 100},
+                {"tree_cpu_pct", cpuTotalUs[1] / totalUs * 100}, {"peak_rss_kb", static_cast<double>(maxRssKb)}});
+    }
+
+    const size_t ringKb = LaunchOptions().outputBufferSize / 1024;
+    long peakRssKb[2] = {0, 0};
+    if (!measureCaptureRss(launcher, peakRssKb)) {
+        return;
+    }
+    reportMetrics("capture/peak-rss", {{"ring_kb", static_cast<double>(ringKb)},
+                                       {"rss_256MB_kb", static_cast<double>(peakRssKb[0])},
+                                       {"rss_2GB_kb", static_cast<double>(peakRssKb[1])},
+                                       {"growth_kb", static_cast<double>(peakRssKb[1] - peakRssKb[0])}});
+    std::filesystem::remove_all(kCaptureDir);
+}
+
+// --write-output 模式：向标准输出写出 megabytes MB 的文本行
+void writeOutput(int megabytes) {
+    std::string block;
+    for (int i = 0; block.size() < 64 * 1024 - 100; i++) {
+        char line[128];
+        int length = std::snprintf(line, sizeof(line), "%08d INFO worker: synthetic output for capture benchmark\n", i);
+        block.append(line, static_cast<size_t>(length));
+    }
+    size_t total = static_cast<size_t>(megabytes) * 1024 * 1024;
+    for (size_t written = 0; written < total; written += block.size()) {
+        const char* data = block.data();
+        size_t size = block.size();
+        while (size > 0) {
+            ssize_t count = write(STDOUT_FILENO, data, size);
+            if (count <= 0) {
+                return;
+            }
+            data += count;
+            size -= static_cast<size_t>(count);
+        }
+    }
+}
+
+const char kPayloadDir[] = "launch_bench_payload";
+const char kPayloadManifest[] = "launch_bench_payload.manifest";
+
+// 模拟载荷：一个 128 MB 的主程序与 32 个 2 MB 的资源文件
+std::vector<std::string> createPayload() {
+    mkdir(kPayloadDir, 0755);
+    std::vector<std::string> files = {std::string(kPayloadDir) + "/SwarmCloneLauncher"};
+    for (int i = 0; i < 32; i++) {
+        files.push_back(std::string(kPayloadDir) + "/asset" + std::to_string(i) + ".bin");
+    }
+    std::mt19937_64 random(1);
+    std::vector<uint64_t> block(1 << 17);  // 1 MB
+    for (size_t i = 0; i < files.size(); i++) {
+        std::FILE* file = std::fopen(files[i].c_str(), "wb");
+        for (int mb = 0; mb < (i == 0 ? 128 : 2); mb++) {
+            for (uint64_t& word : block) {
+                word = random();
+            }
+            std::fwrite(block.data(), sizeof(uint64_t), block.size(), file);
+        }
+        std::fclose(file);
+    }
+    return files;
+}
+
+// 把载荷逐出页缓存：不需要 root，也不影响其他文件
+void evictPayload(const std::vector<std::string>& files) {
+    for (const std::string& path : files) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+}
+
+// 模拟子进程启动时的访问：主程序中分散的 1/16 的页与每个资源文件开头的 64 KB，经由 mmap 缺页读入
+void touchPayload(const std::vector<std::string>& files) {
+    std::mt19937 random(2);
+    volatile unsigned char sink = 0;
+    for (size_t i = 0; i < files.size(); i++) {
+        int fd = open(files[i].c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat info;
+        fstat(fd, &info);
+        size_t size = static_cast<size_t>(info.st_size);
+        unsigned char* data = static_cast<unsigned char*>(mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0));
+        close(fd);
+        size_t pages = size / 4096;
+        if (i == 0) {
+            for (size_t n = 0; n < pages / 16; n++) {
+                sink = sink + data[(random() % pages) * 4096];
+            }
+        } else {
+            for (size_t page = 0; page < 16; page++) {
+                sink = sink + data[page * 4096];
+            }
+        }
+        munmap(data, size);
+    }
+}
+
+// 冷页缓存下从启动到子进程完成启动访问的耗时：不预读、预读整个目录、按热点页清单预读。
+// 子进程是本程序的 --touch-payload 模式，预读与它并行，和启动器中的情形一致
+void benchPrefetch() {
+    const int iterations = 5;
+    std::vector<std::string> files = createPayload();
+    std::string self = selfExecutable();
+    if (self.empty()) {
+        return;
+    }
+    LaunchSpec spec;
+    spec.program = self;
+    spec.args = {"--touch-payload"};
+
+    // 冷启动一次，记录热点页清单
+    evictPayload(files);
+    touchPayload(files);
+    recordPrefetchManifest(kPayloadManifest, kPayloadDir);
+
+    for (PrefetchMode mode : {PrefetchMode::Off, PrefetchMode::Dir, PrefetchMode::Auto}) {
+        LaunchOptions options;
+        options.prefetchMode = mode;
+        options.prefetchManifest = kPayloadManifest;
+        std::vector<double> samples;
+        for (int i = 0; i < iterations; i++) {
+            evictPayload(files);
+            Clock::time_point start = Clock::now();
+            PayloadPrefetcher prefetcher(kPayloadDir, "SwarmCloneLauncher", options);
+            std::vector<std::string> warnings;
+            std::string error;
+            pid_t pid = spawnProcess(spec, SpawnMethod::Auto, warnings, error);
+            if (pid == -1) {
+                std::fprintf(stderr, "spawn failed: %s\n", error.c_str());
+                return;
+            }
+            waitpid(pid, nullptr, 0);
+            samples.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+        }
+        const char* name = mode == PrefetchMode::Off ? "prefetch/cold/none" :
+                           mode == PrefetchMode::Dir ? "prefetch/cold/dir" : "prefetch/cold/manifest";
+        report(name, samples);
+    }
+
+    for (const std::string& path : files) {
+        std::remove(path.c_str());
+    }
+    std::remove(kPayloadManifest);
+    rmdir(kPayloadDir);
+}
+
+const char kPoolConfig[] = "launch_bench_pool.ini";
+
+// 写出 count 个程序的多程序监管配置；chain 时每个程序依赖前一个
+void writePoolConfig(int count, const char* command, bool chain) {
+    std::FILE* file = std::fopen(kPoolConfig, "w");
+    std::fprintf(file, "[defaults]\ncrash-log-dir = launch_bench_crashlogs\n");
+    for (int i = 0; i < count; i++) {
+        std::fprintf(file, "\n[child%d]\nprogram = /bin/sh\narg = -c\narg = %s\n", i, command);
+        if (chain && i > 0) {
+            std::fprintf(file, "after = child%d\n", i - 1);
+        }
+    }
+    std::fclose(file);
+}
+
+// 运行构建目录中的 launch --config，返回耗时（微秒），peakRssKb 返回启动器进程自身的 VmHWM（见 runLauncher），
+// 不含被监管的程序
+double runPool(const std::string& launcher, long& peakRssKb) {
+    return runLauncher(launcher, {std::string("--config=") + kPoolConfig}, "", peakRssKb);
+}
+
+// 多程序监管：一个启动器启动并监管 50 个程序直到全部退出（同时启动，以及按依赖链逐个启动），
+// 再比较 1 个与 50 个程序同时运行时启动器自身的 VmHWM，得到启动器为每个程序多占用的内存
+void benchPool() {
+    const int iterations = 10;
+    const int count = 50;
+    std::string launcher = builtLauncher();
+    if (launcher.empty()) {
+        return;
+    }
+
+    for (bool chain : {false, true}) {
+        writePoolConfig(count, "exit 0", chain);
+        std::vector<double> samples;
+        for (int i = 0; i < iterations; i++) {
+            long peakRssKb = 0;
+            double elapsed = runPool(launcher, peakRssKb);
+            if (elapsed < 0) {
+                return;
+            }
+            samples.push_back(elapsed);
+        }
+        report(chain ? "pool/50-children/chain" : "pool/50-children/parallel", samples);
+    }
+
+    long peakRssKb[2] = {0, 0};
+    int counts[2] = {1, count};
+    for (int i = 0; i < 2; i++) {
+        writePoolConfig(counts[i], "sleep 0.5", false);
+        runPool(launcher, peakRssKb[i]);
+    }
+    reportMetrics("pool/peak-rss", {{"one_child_kb", static_cast<double>(peakRssKb[0])},
+                                    {"fifty_children_kb", static_cast<double>(peakRssKb[1])},
+                                    {"per_child_kb", static_cast<double>(peakRssKb[1] - peakRssKb[0]) / (count - 1)}});
+
+    std::remove(kPoolConfig);
+    std::filesystem::remove_all("launch_bench_crashlogs");
+}
+
+const char kCgroupDir[] = "launch_bench_cgroup";
+
+void writeFile(const std::string& path, const std::string& text) {
+    std::ofstream(path) << text;
+}
+
+// 按启动器的顺序运行一次 /bin/true：prepare、启动子进程、finish，返回子进程是否正常退出
+bool runSandboxed(CgroupSandbox& sandbox, CgroupStats& stats) {
+    LaunchSpec spec;
+    spec.program = "/bin/true";
+    spec.cgroupProcs = sandbox.prepare(1);
+    std::vector<std::string> warnings;
+    std::string error;
+    pid_t pid = spawnProcess(spec, SpawnMethod::Auto, warnings, error);
+    if (pid == -1) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+    }
+    int status = 0;
+    bool exited = pid != -1 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    if (!spec.cgroupProcs.empty()) {
+        // 内核会从 cgroup.procs 中移除已退出的进程，伪造的文件需要手动清空，否则 finish 会向这个 PID 发送 SIGKILL
+        writeFile(spec.cgroupProcs, "");
+    }
+    stats = sandbox.finish();
+    return exited;
+}
+
+// cgroup 沙箱的降级自检：用伪造的 /proc/self/mountinfo、/proc/self/cgroup 与 cgroupfs 目录依次模拟
+// 没有 cgroup v2、cgroup 不存在、未委派、控制器缺失以及找不到 systemd-run，子进程都应照常运行，
+// 统计标记为不可用并说明原因
+bool selfCheckCgroup() {
+    std::string root = std::filesystem::absolute(kCgroupDir).string();
+    std::string attempt = "swarmclone-" + std::to_string(getpid()) + "-1";
+    std::filesystem::remove_all(root);
+    std::filesystem::create_directories(root + "/proc");
+    std::filesystem::create_directories(root + "/fs/undelegated");
+    std::filesystem::create_directories(root + "/fs/delegated/" + attempt);
+    // 可写但只委派了 pids 控制器；伪造的目录不会像内核那样自动生成接口文件，预先创建子进程要写入的 cgroup.procs
+    writeFile(root + "/fs/delegated/cgroup.subtree_control", "");
+    writeFile(root + "/fs/delegated/cgroup.controllers", "pids\n");
+    writeFile(root + "/fs/delegated/" + attempt + "/cgroup.procs", "");
+    setCgroupProcRoot(root + "/proc");
+
+    const std::string cgroup2Mount = "30 23 0:26 / " + root + "/fs rw,nosuid - cgroup2 cgroup2 rw\n";
+    const struct {
+        const char* name;
+        std::string mountInfo;
+        std::string cgroup;
+    } scenarios[] = {
+        {"cgroup/no-cgroup-v2", "25 23 0:22 / /sys/fs/cgroup/memory rw - cgroup cgroup rw,memory\n", "0::/\n"},
+        {"cgroup/nonexistent", cgroup2Mount, "0::/missing\n"},
+        {"cgroup/not-delegated", cgroup2Mount, "0::/undelegated\n"},
+        {"cgroup/missing-controllers", cgroup2Mount, "0::/delegated\n"},
+        {"cgroup/no-systemd-run", cgroup2Mount, "0::/undelegated\n"},
+    };
+
+    LaunchOptions options;
+    options.cgroupSandbox = true;
+    options.cgroupMemoryMax = 64 << 20;
+    options.cgroupCpuMaxPercent = 50;
+    bool passed = true;
+    for (const auto& scenario : scenarios) {
+        writeFile(root + "/proc/mountinfo", scenario.mountInfo);
+        writeFile(root + "/proc/cgroup", scenario.cgroup);
+        if (std::strcmp(scenario.name, "cgroup/no-systemd-run") == 0) {
+            // PATH 中没有 systemd-run 时应直接返回，不 exec，随后由 CgroupSandbox 降级
+            std::string path = std::getenv("PATH") ? std::getenv("PATH") : "";
+            std::string self = "launch_bench";
+            char* args[] = {&self[0], nullptr};
+            setenv("PATH", (root + "/proc").c_str(), 1);
+            relaunchInDelegatedScope(options, 1, args);
+            setenv("PATH", path.c_str(), 1);
+        }
+        CgroupSandbox sandbox(options);
+        CgroupStats stats;
+        bool ok = runSandboxed(sandbox, stats) && !stats.available && !stats.note.empty();
+        std::printf("%-40s %s  %s\n", scenario.name, ok ? "ok" : "FAILED", stats.note.c_str());
+        passed = passed && ok;
+    }
+
+    setCgroupProcRoot("");
+    std::filesystem::remove_all(root);
+    return passed;
+}
+
+// 捕获路径的内存上界：输出 2 GB 与 256 MB 时启动器峰值之差不应超过输出缓冲区环的容量加少量余量
+bool selfCheckCaptureRss() {
+    const long slackKb = 1024;
+    std::string launcher = builtLauncher();
+    long peakRssKb[2] = {0, 0};
+    if (launcher.empty() || !measureCaptureRss(launcher, peakRssKb)) {
+        std::printf("%-40s FAILED  could not run launch\n", "capture/peak-rss");
+        std::filesystem::remove_all(kCaptureDir);
+        return false;
+    }
+    std::filesystem::remove_all(kCaptureDir);
+    long boundKb = static_cast<long>(LaunchOptions().outputBufferSize / 1024) + slackKb;
+    long growthKb = peakRssKb[1] - peakRssKb[0];
+    bool ok = peakRssKb[0] > 0 && growthKb <= boundKb;
+    std::printf("%-40s %s  256 MB: %ld KB, 2 GB: %ld KB, growth %ld KB (bound %ld KB)\n", "capture/peak-rss",
+                ok ? "ok" : "FAILED", peakRssKb[0], peakRssKb[1], growthKb, boundKb);
+    return ok;
+}
+#endif
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+#ifdef __linux__
+    if (argc == 2 && std::strcmp(argv[1], "--self-check") == 0) {
+        bool passed = selfCheckCgroup();
+        passed = selfCheckCaptureRss() && passed;
+        return passed ? 0 : 1;
+    }
+    // benchPrefetch 启动的子进程
+    if (argc == 2 && std::strcmp(argv[1], "--touch-payload") == 0) {
+        std::vector<std::string> files = {std::string(kPayloadDir) + "/SwarmCloneLauncher"};
+        for (int i = 0; i < 32; i++) {
+            files.push_back(std::string(kPayloadDir) + "/asset" + std::to_string(i) + ".bin");
+        }
+        touchPayload(files);
+        return 0;
+    }
+    // benchCapture 启动的子进程
+    if (argc == 2 && std::strncmp(argv[1], "--write-output=", 15) == 0) {
+        writeOutput(std::atoi(argv[1] + 15));
+        return 0;
+    }
+#endif
+
+    std::vector<BenchCase> cases = {
+#ifndef _WIN32
+        {"spawn", benchSpawn},
+#endif
+#ifdef __linux__
+        {"capture", benchCapture},
+        {"prefetch", benchPrefetch},
+        {"pool", benchPool},
+#endif
+        {"probe", benchProbes},
+        {"crashlog", benchCrashLog},
+#ifdef LAUNCH_HAVE_LZ4
+        {"compress", benchCompress},
+#endif
+        {"timestamp", benchTimestamp},
+        {"highlights", benchHighlights},
+        {"live", benchLiveOutput},
+    };
+
+    std::string jsonPath;
+    std::vector<const char*> prefixes;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--json") == 0) {
+            jsonPath = "launch_bench.json";
+        } else if (std::strncmp(argv[i], "--json=", 7) == 0) {
+            jsonPath = argv[i] + 7;
+        } else {
+            prefixes.push_back(argv[i]);
+        }
+    }
+
+    for (const BenchCase& benchCase : cases) {
+        bool selected = prefixes.empty();
+        for (const char* prefix : prefixes) {
+            selected = selected || std::strncmp(benchCase.name, prefix, std::strlen(prefix)) == 0;
+        }
+        if (selected) {
+            benchCase.run();
+        }
+    }
+    if (!jsonPath.empty() && !writeJson(jsonPath)) {
+        return 1;
+    }
+    return belowFloor == 0 ? 0 : 1;
+}
@@ -0,0 +1,48 @@
+// launch_live.h 的实现，包装 LiveOutputReader
+#include "launch_live.h"
+#include "live_output.h"
+
+#include <new>
+
+struct sc_live_reader {
+    LiveOutputReader reader;
+};
+
+sc_live_reader* sc_live_open(const char* name, int from_oldest) {
+    if (name == nullptr) {
+        return nullptr;
+    }
+    sc_live_reader* handle = new (std::nothrow) sc_live_reader;
+    if (handle == nullptr) {
+        return nullptr;
+    }
+    if (!handle->reader.open(name, from_oldest != 0)) {
+        delete handle;
+        return nullptr;
+    }
+    return handle;
+}
+
+int sc_live_read(sc_live_reader* reader, sc_live_record* record, char* buffer, size_t capacity) {
+    if (reader == nullptr || record == nullptr) {
+        return SC_LIVE_CLOSED;
+    }
+    return reader->reader.next(*record, buffer, capacity);
+}
+
+uint64_t sc_live_lag(const sc_live_reader* reader) {
+    return reader ? reader->reader.lag() : 0;
+}
+
+uint64_t sc_live_skipped(const sc_live_reader* reader) {
+    return reader ? reader->reader.skippedBytes() : 0;
+}
+
+int32_t sc_live_child_pid(const sc_live_reader* reader) {
+    const LiveOutputHeader* info = reader ? reader->reader.info() : nullptr;
+    return info ? info->childPid.load(std::memory_order_relaxed) : 0;
+}
+
+void sc_live_close(sc_live_reader* reader) {
+    delete reader;
+}
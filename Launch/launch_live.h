@@ -0,0 +1,80 @@
+/*
+ * 启动器实时输出环（launch --live-output）的 C 接口，供图形界面的控制台页面或其他工具跟随子进程输出。
+ * 由 launch_live 动态库实现；C# 等语言可以直接 P/Invoke 这些函数。
+ *
+ * 共享内存名称：POSIX 上为 shm_open("/<名称>")，Windows 上为 "Local\<名称>"。布局如下，整数均为本机字节序：
+ *   偏移 0     magic "SCLIVE01"、版本、数据区偏移、数据区大小（2 的幂）、创建时间、时钟换算、PID、状态、程序路径
+ *   偏移 64*k  head（u64，已写入的字节数）、tail（u64，最旧的完整记录位置），写入者用 release 语义更新
+ *   数据区     16 字节对齐的记录：u32 长度、u8 来源、3 字节保留、i64 单调时钟时间戳，随后是内容
+ * 位置对数据区大小取模即为数据区内的偏移。读者复制记录后必须重新读取 tail，tail 已越过该记录说明复制期间
+ * 被覆盖，应丢弃并从 tail 继续。使用本接口时这些细节均已处理。
+ */
+#ifndef LAUNCH_LIVE_H
+#define LAUNCH_LIVE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+    #ifdef LAUNCH_LIVE_BUILD
+        #define SC_LIVE_API __declspec(dllexport)
+    #else
+        #define SC_LIVE_API __declspec(dllimport)
+    #endif
+#else
+    #define SC_LIVE_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SC_LIVE_VERSION 1
+
+/* 记录来源 */
+#define SC_LIVE_PADDING 0       /* 数据区末尾的填充，读者不会收到 */
+#define SC_LIVE_STREAM_STDOUT 1
+#define SC_LIVE_STREAM_STDERR 2
+#define SC_LIVE_STREAM_EVENT 3  /* 启动器事件，例如程序启动与退出 */
+
+/* 共享内存状态 */
+#define SC_LIVE_STATE_LIVE 1
+#define SC_LIVE_STATE_CLOSED 2  /* 启动器已退出，不会再有新记录 */
+
+/* sc_live_read 的返回值 */
+#define SC_LIVE_RECORD 1        /* 读到一条记录 */
+#define SC_LIVE_EMPTY 0         /* 暂无新记录，稍后再试 */
+#define SC_LIVE_CLOSED (-1)     /* 启动器已关闭且记录已读完 */
+#define SC_LIVE_TOO_SMALL (-2)  /* 缓冲区不足，record->size 为所需大小 */
+
+typedef struct sc_live_record {
+    uint32_t size;              /* 内容字节数 */
+    uint8_t stream;             /* SC_LIVE_STREAM_* */
+    int64_t timestamp_unix_ns;  /* 启动器收到这段输出的时刻 */
+} sc_live_record;
+
+typedef struct sc_live_reader sc_live_reader;
+
+/* 连接名为 name 的实时输出环，不存在或格式不符时返回 NULL。
+ * from_oldest 非 0 时先读出环中保留的历史记录，否则只读取之后写入的记录 */
+SC_LIVE_API sc_live_reader* sc_live_open(const char* name, int from_oldest);
+
+/* 读取下一条记录到 buffer；不阻塞，没有新记录时返回 SC_LIVE_EMPTY */
+SC_LIVE_API int sc_live_read(sc_live_reader* reader, sc_live_record* record, char* buffer, size_t capacity);
+
+/* 读者落后于写入者的字节数 */
+SC_LIVE_API uint64_t sc_live_lag(const sc_live_reader* reader);
+
+/* 因落后超过一圈而跳过的字节数 */
+SC_LIVE_API uint64_t sc_live_skipped(const sc_live_reader* reader);
+
+/* 子进程 PID，尚未启动时为 0 */
+SC_LIVE_API int32_t sc_live_child_pid(const sc_live_reader* reader);
+
+SC_LIVE_API void sc_live_close(sc_live_reader* reader);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LAUNCH_LIVE_H */
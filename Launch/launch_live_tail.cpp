@@ -0,0 +1,65 @@
+// 跟随启动器的实时输出环（--live-output），stdout 与 stderr 的内容分别原样写到标准输出与标准错误，
+// 启动器事件与跳过的输出以 [...] 标出。只通过 launch_live.h 的 C 接口读取
+#include "launch_live.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main(int argc, char* argv[])
+{
+    std::string name = "swarmclone-live";
+    bool fromOldest = true;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--new") == 0) {
+            fromOldest = false;
+        } else if (argv[i][0] == '-') {
+            std::fprintf(stderr, u8"用法: %s [共享内存名称，缺省为 swarmclone-live] [--new 只显示之后的输出]\n", argv[0]);
+            return 2;
+        } else {
+            name = argv[i];
+        }
+    }
+
+    sc_live_reader* reader = sc_live_open(name.c_str(), fromOldest ? 1 : 0);
+    if (reader == nullptr) {
+        std::fprintf(stderr, u8"找不到实时输出环: %s\n", name.c_str());
+        return 1;
+    }
+
+    std::vector<char> buffer(64 * 1024);
+    uint64_t reportedSkip = 0;
+    while (true) {
+        sc_live_record record;
+        int result = sc_live_read(reader, &record, buffer.data(), buffer.size());
+        if (result == SC_LIVE_TOO_SMALL) {
+            buffer.resize(record.size);
+            continue;
+        }
+        if (sc_live_skipped(reader) != reportedSkip) {
+            std::fprintf(stderr, u8"\n[读取过慢，跳过了 %llu 字节输出]\n",
+                         static_cast<unsigned long long>(sc_live_skipped(reader) - reportedSkip));
+            reportedSkip = sc_live_skipped(reader);
+        }
+        if (result == SC_LIVE_CLOSED) {
+            break;
+        }
+        if (result == SC_LIVE_EMPTY) {
+            // 写入端不发通知，空闲时以短间隔轮询
+            std::fflush(stdout);
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            continue;
+        }
+        if (record.stream == SC_LIVE_STREAM_EVENT) {
+            std::fflush(stdout);
+            std::fprintf(stderr, "[%.*s]\n", static_cast<int>(record.size), buffer.data());
+        } else {
+            std::fwrite(buffer.data(), 1, record.size, record.stream == SC_LIVE_STREAM_STDERR ? stderr : stdout);
+        }
+    }
+    sc_live_close(reader);
+    return 0;
+}
@@ -0,0 +1,373 @@
+#include "launch_options.h"
+#include "proc_fs.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+bool parseByteSize(const std::string& text, size_t& result) {
+    if (text.empty()) {
+        return false;
+    }
+
+    char* end = nullptr;
+    unsigned long long value = std::strtoull(text.c_str(), &end, 10);
+    if (end == text.c_str()) {
+        return false;
+    }
+
+    std::string suffix(end);
+    if (!suffix.empty() && (suffix.back() == 'B' || suffix.back() == 'b')) {
+        suffix.pop_back();
+    }
+
+    unsigned long long multiplier = 1;
+    if (suffix.empty()) {
+        multiplier = 1;
+    } else if (suffix.size() == 1) {
+        switch (std::toupper(static_cast<unsigned char>(suffix[0]))) {
+            case 'K': multiplier = 1024ULL; break;
+            case 'M': multiplier = 1024ULL * 1024; break;
+            case 'G': multiplier = 1024ULL * 1024 * 1024; break;
+            default: return false;
+        }
+    } else {
+        return false;
+    }
+
+    result = static_cast<size_t>(value * multiplier);
+    return true;
+}
+
+// 解析 [minimum, maximum] 范围内的十进制整数，格式错误或超出范围时返回 false 且不修改 result
+static bool parseInteger(const std::string& text, long minimum, long maximum, int& result) {
+    char* end = nullptr;
+    errno = 0;
+    long value = std::strtol(text.c_str(), &end, 10);
+    if (text.empty() || *end != '\0' || errno == ERANGE || value < minimum || value > maximum) {
+        return false;
+    }
+    result = static_cast<int>(value);
+    return true;
+}
+
+static bool parseLimitValue(const std::string& text, uint64_t& result) {
+    if (text == "unlimited" || text == "infinity") {
+        result = kLimitUnlimited;
+        return true;
+    }
+    size_t value = 0;
+    if (!parseByteSize(text, value)) {
+        return false;
+    }
+    result = value;
+    return true;
+}
+
+bool parseResourceLimit(const std::string& text, ResourceLimitOption& result) {
+    static const char* const knownNames[] = {"as", "core", "cpu", "data", "fsize", "memlock", "nofile", "nproc", "stack"};
+
+    size_t eq = text.find('=');
+    if (eq == std::string::npos) {
+        return false;
+    }
+    result.name = text.substr(0, eq);
+    bool known = false;
+    for (const char* name : knownNames) {
+        known = known || result.name == name;
+    }
+    if (!known) {
+        return false;
+    }
+
+    std::string values = text.substr(eq + 1);
+    size_t colon = values.find(':');
+    result.setHard = colon != std::string::npos;
+    if (!parseLimitValue(values.substr(0, colon), result.soft)) {
+        return false;
+    }
+    return !result.setHard || parseLimitValue(values.substr(colon + 1), result.hard);
+}
+
+LaunchOptions parseLaunchOptions(int argc, char* argv[], const LaunchOptions& initial) {
+    LaunchOptions options = initial;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg(argv[i]);
+        if (arg == "--") {
+            options.programArgs.insert(options.programArgs.end(), argv + i + 1, argv + argc);
+            break;
+        }
+        std::string key = arg;
+        std::string value;
+
+        size_t eq = arg.find('=');
+        if (eq != std::string::npos) {
+            key = arg.substr(0, eq);
+            value = arg.substr(eq + 1);
+        }
+
+        if (key == "--output-buffer") {
+            if (!parseByteSize(value, options.outputBufferSize)) {
+                std::cerr << u8"无效的输出缓冲区大小: " << value << std::endl;
+            }
+        } else if (key == "--capture-mode") {
+            if (value == "memory") {
+                options.captureMode = CaptureMode::Memory;
+            } else if (value == "mapped") {
+                options.captureMode = CaptureMode::Mapped;
+            } else {
+                std::cerr << u8"无效的捕获模式: " << value << std::endl;
+            }
+        } else if (key == "--capture-mapped-file") {
+            options.mappedCaptureFile = value;
+        } else if (key == "--capture-file") {
+            options.captureFile = value;
+        } else if (key == "--capture-file-size") {
+            if (!parseByteSize(value, options.captureFileSize)) {
+                std::cerr << u8"无效的捕获文件大小: " << value << std::endl;
+            }
+        } else if (key == "--capture-log") {
+            options.captureLogDir = value.empty() ? "capture_log" : value;
+        } else if (key == "--capture-log-segment-size") {
+            if (!parseByteSize(value, options.captureLogSegmentSize)) {
+                std::cerr << u8"无效的捕获日志分段大小: " << value << std::endl;
+            }
+        } else if (key == "--capture-log-max-size") {
+            if (!parseByteSize(value, options.captureLogMaxSize)) {
+                std::cerr << u8"无效的捕获日志大小上限: " << value << std::endl;
+            }
+        } else if (key == "--live-output") {
+            options.liveOutputName = value.empty() ? "swarmclone-live" : value;
+        } else if (key == "--live-output-size") {
+            if (!parseByteSize(value, options.liveOutputSize)) {
+                std::cerr << u8"无效的实时输出环大小: " << value << std::endl;
+            }
+        } else if (key == "--telemetry-interval") {
+            if (!parseInteger(value, 0, INT_MAX, options.telemetryIntervalMs)) {
+                std::cerr << u8"无效的资源采样间隔: " << value << std::endl;
+            }
+        } else if (key == "--telemetry-window") {
+            // 采样环的容量按时长除以间隔计算，负数转换为 size_t 后会变成极大的容量
+            if (!parseInteger(value, 1, INT_MAX, options.telemetryWindowSeconds)) {
+                std::cerr << u8"无效的资源采样时长: " << value << std::endl;
+            }
+        } else if (key == "--no-zero-copy") {
+            options.zeroCopyTee = false;
+        } else if (key == "--crash-report-format") {
+            if (value == "none") {
+                options.reportFormat = ReportFormat::None;
+            } else if (value == "jsonl") {
+                options.reportFormat = ReportFormat::JsonLines;
+            } else if (value == "cbor") {
+                options.reportFormat = ReportFormat::Cbor;
+            } else {
+                std::cerr << u8"无效的崩溃报告格式: " << value << std::endl;
+            }
+        } else if (key == "--compress-crash-log") {
+            options.compressCrashLog = true;
+        } else if (key == "--crash-log-dir") {
+            options.crashLogDir = value;
+        } else if (key == "--crash-store") {
+            options.crashStore = true;
+        } else if (key == "--crash-store-keep") {
+            options.crashStore = true;
+            options.crashStoreKeep = static_cast<size_t>(std::max(0, std::atoi(value.c_str())));
+        } else if (key == "--crash-store-quota") {
+            options.crashStore = true;
+            if (!parseByteSize(value, options.crashStoreQuota)) {
+                std::cerr << u8"无效的崩溃库配额: " << value << std::endl;
+            }
+        } else if (key == "--highlight-pattern") {
+            if (value.empty()) {
+                std::cerr << u8"摘要模式不能为空" << std::endl;
+            } else {
+                options.highlightPatterns.push_back(value);
+            }
+        } else if (key == "--no-highlights") {
+            options.highlights = false;
+        } else if (key == "--restart") {
+            if (value == "never") {
+                options.restartMode = RestartMode::Never;
+            } else if (value == "on-failure") {
+                options.restartMode = RestartMode::OnFailure;
+            } else if (value == "always") {
+                options.restartMode = RestartMode::Always;
+            } else {
+                std::cerr << u8"无效的重启策略: " << value << std::endl;
+            }
+        } else if (key == "--restart-delay") {
+            if (!parseInteger(value, 0, INT_MAX, options.restartDelayMs)) {
+                std::cerr << u8"无效的重启延迟: " << value << std::endl;
+            }
+        } else if (key == "--restart-max-delay") {
+            if (!parseInteger(value, 0, INT_MAX, options.restartMaxDelayMs)) {
+                std::cerr << u8"无效的最大重启延迟: " << value << std::endl;
+            }
+        } else if (key == "--crash-loop-limit") {
+            if (!parseInteger(value, 1, INT_MAX, options.crashLoopLimit)) {
+                std::cerr << u8"无效的崩溃循环次数上限: " << value << std::endl;
+            }
+        } else if (key == "--crash-loop-window") {
+            if (!parseInteger(value, 1, INT_MAX, options.crashLoopWindowSeconds)) {
+                std::cerr << u8"无效的崩溃循环统计时长: " << value << std::endl;
+            }
+        } else if (key == "--hang-output-timeout") {
+            if (!parseInteger(value, 0, INT_MAX, options.hangOutputTimeoutMs)) {
+                std::cerr << u8"无效的输出超时: " << value << std::endl;
+            }
+        } else if (key == "--hang-heartbeat-timeout") {
+            if (!parseInteger(value, 0, INT_MAX, options.hangHeartbeatTimeoutMs)) {
+                std::cerr << u8"无效的心跳超时: " << value << std::endl;
+            }
+        } else if (key == "--hang-cpu-stall") {
+            if (!parseInteger(value, 0, INT_MAX, options.hangCpuStallMs)) {
+                std::cerr << u8"无效的 CPU 满载时长: " << value << std::endl;
+            }
+        } else if (key == "--hang-check-interval") {
+            if (!parseInteger(value, 1, INT_MAX, options.hangCheckIntervalMs)) {
+                std::cerr << u8"无效的挂起检查间隔: " << value << std::endl;
+            }
+        } else if (key == "--hang-kill-grace") {
+            if (!parseInteger(value, 0, INT_MAX, options.hangKillGraceMs)) {
+                std::cerr << u8"无效的 SIGQUIT 等待时长: " << value << std::endl;
+            }
+        } else if (key == "--hang-gdb") {
+            options.hangUseGdb = true;
+        } else if (key == "--core-dump") {
+            if (value == "off") {
+                options.coreDumpMode = CoreDumpMode::Off;
+            } else if (value == "mini") {
+                options.coreDumpMode = CoreDumpMode::Mini;
+            } else if (value == "full") {
+                options.coreDumpMode = CoreDumpMode::Full;
+            } else {
+                std::cerr << u8"无效的核心转储模式: " << value << std::endl;
+            }
+        } else if (key == "--core-limit") {
+            if (!parseByteSize(value, options.coreDumpLimit)) {
+                std::cerr << u8"无效的核心转储大小限制: " << value << std::endl;
+            }
+        } else if (key == "--maps-snapshot-interval") {
+            // 0 表示不定时记录
+            if (!parseInteger(value, 0, INT_MAX, options.mapsSnapshotIntervalMs)) {
+                std::cerr << u8"无效的模块映射记录间隔: " << value << std::endl;
+            }
+        } else if (key == "--notify-socket") {
+            options.notifySocket = value;
+        } else if (key == "--notify-log") {
+            options.notifyLogFile = value;
+        } else if (key == "--arg") {
+            options.programArgs.push_back(value);
+        } else if (key == "--env") {
+            if (value.find('=') == std::string::npos || value[0] == '=') {
+                std::cerr << u8"无效的环境变量: " << value << std::endl;
+            } else {
+                options.childEnv.push_back(value);
+            }
+        } else if (key == "--rlimit") {
+            ResourceLimitOption limit;
+            if (parseResourceLimit(value, limit)) {
+                options.resourceLimits.push_back(limit);
+            } else {
+                std::cerr << u8"无效的资源限制: " << value << std::endl;
+            }
+        } else if (key == "--nice") {
+            if (parseInteger(value, -20, 19, options.niceValue)) {
+                options.setNice = true;
+            } else {
+                std::cerr << u8"无效的 nice 值: " << value << std::endl;
+            }
+        } else if (key == "--ionice") {
+            std::string ioClass = value.substr(0, value.find(':'));
+            if (value.find(':') != std::string::npos &&
+                !parseInteger(value.substr(value.find(':') + 1), 0, 7, options.ioPriorityLevel)) {
+                std::cerr << u8"无效的 I/O 优先级: " << value << std::endl;
+            } else if (ioClass == "realtime") {
+                options.ioPriorityClass = IoPriorityClass::RealTime;
+            } else if (ioClass == "best-effort") {
+                options.ioPriorityClass = IoPriorityClass::BestEffort;
+            } else if (ioClass == "idle") {
+                options.ioPriorityClass = IoPriorityClass::Idle;
+            } else {
+                std::cerr << u8"无效的 I/O 优先级: " << value << std::endl;
+            }
+        } else if (key == "--cpu-affinity") {
+#if defined(__linux__)
+            if (parseCpuList(value.c_str()).empty()) {
+                std::cerr << u8"无效的 CPU 列表: " << value << std::endl;
+            } else {
+                options.cpuAffinity = value;
+            }
+#else
+            std::cerr << u8"当前平台不支持设置 CPU 亲和性" << std::endl;
+#endif
+        } else if (key == "--verify") {
+            if (value == "auto") {
+                options.verifyMode = VerifyMode::Auto;
+            } else if (value == "full" || value.empty()) {
+                options.verifyMode = VerifyMode::Full;
+            } else if (value == "off") {
+                options.verifyMode = VerifyMode::Off;
+            } else {
+                std::cerr << u8"无效的校验模式: " << value << std::endl;
+            }
+        } else if (key == "--verify-cache") {
+            options.verifyCacheFile = value;
+        } else if (key == "--write-payload-manifest") {
+            options.writePayloadManifest = true;
+        } else if (key == "--prefetch") {
+            if (value.empty() || value == "auto") {
+                options.prefetchMode = PrefetchMode::Auto;
+            } else if (value == "dir") {
+                options.prefetchMode = PrefetchMode::Dir;
+            } else if (value == "off") {
+                options.prefetchMode = PrefetchMode::Off;
+            } else {
+                std::cerr << u8"无效的预读模式: " << value << std::endl;
+            }
+        } else if (key == "--prefetch-threads") {
+            if (!parseInteger(value, 1, 256, options.prefetchThreads)) {
+                std::cerr << u8"无效的预读线程数: " << value << std::endl;
+            }
+        } else if (key == "--prefetch-manifest") {
+            options.prefetchManifest = value;
+        } else if (key == "--trace-startup") {
+            options.startupTraceFile = value.empty() ? "launcher_startup_trace.json" : value;
+        } else if (key == "--control-socket") {
+            options.controlSocket = value.empty() ? "launcher.sock" : value;
+        } else if (key == "--config") {
+            options.poolConfigFile = value;
+        } else if (key == "--cgroup") {
+            options.cgroupSandbox = true;
+        } else if (key == "--cgroup-memory-max") {
+            if (parseByteSize(value, options.cgroupMemoryMax)) {
+                options.cgroupSandbox = true;
+            } else {
+                std::cerr << u8"无效的 cgroup 内存上限: " << value << std::endl;
+            }
+        } else if (key == "--cgroup-cpu-max") {
+            // 百分比以一个 CPU 为 100，上限为全部 CPU
+            long cpus = std::max(1u, std::thread::hardware_concurrency());
+            if (parseInteger(value, 1, 100 * cpus, options.cgroupCpuMaxPercent)) {
+                options.cgroupSandbox = true;
+            } else {
+                std::cerr << u8"无效的 cgroup CPU 上限: " << value << std::endl;
+            }
+        } else if (key == "--cgroup-io-max") {
+            options.cgroupIoMax.push_back(value);
+            options.cgroupSandbox = true;
+        } else if (key == "--cgroup-pids-max") {
+            options.cgroupPidsMax = std::strtoull(value.c_str(), nullptr, 10);
+            options.cgroupSandbox = true;
+        } else {
+            std::cerr << u8"忽略未知参数: " << arg << std::endl;
+        }
+    }
+
+    return options;
+}
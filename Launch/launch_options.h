@@ -0,0 +1,194 @@
+#ifndef LAUNCH_OPTIONS_H
+#define LAUNCH_OPTIONS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 崩溃日志所需输出尾部的保存方式
+enum class CaptureMode {
+    Memory,  // 保存在启动器内存中
+    Mapped,  // 写入预分配的内存映射文件，启动器异常退出后仍可读取
+};
+
+// 崩溃日志旁附带的结构化报告格式
+enum class ReportFormat {
+    None,
+    JsonLines,  // 每行一个 JSON 对象
+    Cbor,       // CBOR 序列（RFC 8742），输出内容以字节串保存，不做编码转换
+};
+
+// 子进程退出后是否自动重启
+enum class RestartMode {
+    Never,      // 只运行一次（默认）
+    OnFailure,  // 仅在崩溃（非 0 退出码或被信号终止）后重启
+    Always,     // 无论如何退出都重启
+};
+
+// 子进程被信号终止时如何处理核心转储
+enum class CoreDumpMode {
+    Off,   // 不干预，沿用系统设置（默认）
+    Mini,  // 生成核心转储，精简为只含线程栈与模块列表的小文件后删除原始文件
+    Full,  // 同 Mini，但保留原始核心文件
+};
+
+// 启动前按安装清单校验载荷文件
+enum class VerifyMode {
+    Auto,  // 有清单时校验，大小与修改时间未变的文件沿用上一次的校验结果（默认）
+    Full,  // 忽略缓存，重新计算全部文件的哈希
+    Off,   // 只检查程序文件是否存在
+};
+
+// 启动前对载荷目录的页缓存预读
+enum class PrefetchMode {
+    Off,   // 不预读（默认）
+    Auto,  // 按上一次启动记录的热点页清单预读；没有有效清单时本次记录
+    Dir,   // 预读载荷目录中的全部文件
+};
+
+// 子进程的 I/O 调度优先级（Linux ioprio）
+enum class IoPriorityClass {
+    Unchanged,   // 沿用启动器自身的设置（默认）
+    RealTime,
+    BestEffort,
+    Idle,
+};
+
+// 子进程的一项资源限制，名称与 ulimit/prlimit 相同（nofile、as、stack 等）
+constexpr uint64_t kLimitUnlimited = UINT64_MAX;
+
+struct ResourceLimitOption {
+    std::string name;
+    uint64_t soft = kLimitUnlimited;
+    uint64_t hard = kLimitUnlimited;
+    bool setHard = false;  // 未指定硬限制时保持不变
+};
+
+// 启动器运行参数，由命令行 --key=value 形式的选项填充
+struct LaunchOptions {
+    // 崩溃日志中保留的子进程输出上限（字节）
+    size_t outputBufferSize = 8 * 1024 * 1024;
+    CaptureMode captureMode = CaptureMode::Memory;
+    std::string mappedCaptureFile = "launcher_capture.bin";
+
+    // 子进程输出的滚动捕获文件，为空时不写入
+    std::string captureFile;
+    size_t captureFileSize = 64 * 1024 * 1024;
+
+    // 按行记录子进程输出的分段捕获日志目录（见 capture_log.h），为空时不写入。
+    // 单个分段与全部分段的大小上限
+    std::string captureLogDir;
+    size_t captureLogSegmentSize = 64 * 1024 * 1024;
+    size_t captureLogMaxSize = size_t(1024) * 1024 * 1024;
+
+    // 发布子进程输出的实时输出环（见 launch_live.h）的共享内存名称与数据区大小，名称为空时不发布
+    std::string liveOutputName;
+    size_t liveOutputSize = 4 * 1024 * 1024;
+
+    // 子进程资源占用的采样间隔（毫秒，0 表示关闭）与崩溃日志中保留的时长（秒）
+    int telemetryIntervalMs = 250;
+    int telemetryWindowSeconds = 300;
+
+    // Linux 上用 tee/splice 在内核中转发输出到控制台和捕获文件
+    bool zeroCopyTee = true;
+
+    // 除文本崩溃日志外额外写出的机器可读报告
+    ReportFormat reportFormat = ReportFormat::None;
+
+    // 以 LZ4 帧格式流式压缩崩溃日志与结构化报告（需要构建时启用 LAUNCH_CRASHLOG_LZ4）
+    bool compressCrashLog = false;
+
+    // 崩溃日志、崩溃循环报告与精简核心转储的存放目录（不存在时创建），为空时写入当前目录
+    std::string crashLogDir;
+
+    // 崩溃库（见 crash_store.h）：按签名归并崩溃日志，每种崩溃只保留前 crashStoreKeep 份完整日志，
+    // 全部日志不超过 crashStoreQuota 字节。库位于 crashLogDir，未设置时为 crashlogs
+    bool crashStore = false;
+    size_t crashStoreKeep = 3;
+    size_t crashStoreQuota = 256 * 1024 * 1024;
+
+    // 崩溃日志开头的错误摘要（见 pattern_scanner.h）：在捕获路径上查找的模式，缺省模式之外追加 highlightPatterns
+    bool highlights = true;
+    std::vector<std::string> highlightPatterns;
+
+    // 自动重启：连续快速退出时的退避从 restartDelayMs 起按指数增长（带随机抖动），不超过 restartMaxDelayMs；
+    // crashLoopWindowSeconds 秒内崩溃 crashLoopLimit 次后停止重启，改为写出一份汇总报告
+    RestartMode restartMode = RestartMode::Never;
+    int restartDelayMs = 200;
+    int restartMaxDelayMs = 30000;
+    int crashLoopLimit = 5;
+    int crashLoopWindowSeconds = 60;
+
+    // 挂起检测（毫秒，0 表示关闭）：长时间无输出、心跳中断、CPU 满载但没有任何进展。
+    // 触发后采集各线程状态，发送 SIGQUIT，hangKillGraceMs 后仍未退出则发送 SIGKILL
+    int hangOutputTimeoutMs = 0;
+    int hangHeartbeatTimeoutMs = 0;
+    int hangCpuStallMs = 0;
+    int hangCheckIntervalMs = 100;
+    int hangKillGraceMs = 2000;
+    bool hangUseGdb = false;  // 可用时额外用 gdb -batch 采集各线程调用栈
+
+    // 核心转储：coreDumpLimit 为子进程的 RLIMIT_CORE（字节，0 表示不限制，受硬限制约束）；
+    // 运行期间每隔 mapsSnapshotIntervalMs 毫秒记录一次模块映射，供核心文件缺少模块列表时符号化
+    CoreDumpMode coreDumpMode = CoreDumpMode::Off;
+    size_t coreDumpLimit = 0;
+    int mapsSnapshotIntervalMs = 5000;
+
+    // 无图形会话时的通知去向：本地通知套接字（为空时读取 SWARMCLONE_NOTIFY_SOCKET），其次是日志文件
+    std::string notifySocket;
+    std::string notifyLogFile = "launcher_notifications.log";
+
+    // 传给子进程的参数与额外环境变量（"KEY=VALUE"）
+    std::vector<std::string> programArgs;
+    std::vector<std::string> childEnv;
+
+    // 子进程的资源限制、nice 值、I/O 优先级（0~7）与 CPU 亲和性（"0-3,6" 形式的列表，为空时不限制）
+    std::vector<ResourceLimitOption> resourceLimits;
+    bool setNice = false;
+    int niceValue = 0;
+    IoPriorityClass ioPriorityClass = IoPriorityClass::Unchanged;
+    int ioPriorityLevel = 4;
+    std::string cpuAffinity;
+
+    // cgroup v2 沙箱：子进程每次运行都放进独立的 cgroup，退出后读取内存峰值、OOM 与 CPU 统计。
+    // 内存上限（字节）、CPU 上限（百分比，150 表示 1.5 个核）与进程数上限为 0 时不限制；
+    // io.max 按原样写入，例如 "8:0 rbps=10485760 wbps=10485760"。设置任一上限都会启用沙箱
+    bool cgroupSandbox = false;
+    size_t cgroupMemoryMax = 0;
+    int cgroupCpuMaxPercent = 0;
+    std::vector<std::string> cgroupIoMax;
+    size_t cgroupPidsMax = 0;
+
+    // 载荷完整性校验：载荷目录中的安装清单与已校验状态的缓存文件；writePayloadManifest 时只生成清单后退出
+    VerifyMode verifyMode = VerifyMode::Auto;
+    std::string payloadManifest = "payload.manifest";
+    std::string verifyCacheFile = "payload_verify.cache";
+    bool writePayloadManifest = false;
+
+    // 载荷预读：预读线程数（不超过 CPU 数）与热点页清单文件
+    PrefetchMode prefetchMode = PrefetchMode::Off;
+    int prefetchThreads = 4;
+    std::string prefetchManifest = "launcher_prefetch.manifest";
+
+    // 启动耗时分解的 Chrome trace 输出文件，为空时不记录
+    std::string startupTraceFile;
+
+    // 多程序监管：按配置文件同时监管多个程序，为空时只运行 launcher 目录中的主程序
+    std::string poolConfigFile;
+
+    // 本地控制接口的 Unix 域套接字路径，为空时不启用
+    std::string controlSocket;
+};
+
+// 解析 "8M"、"512K"、"1G" 或纯数字形式的字节数，失败时返回 false
+bool parseByteSize(const std::string& text, size_t& result);
+
+// 解析 "nofile=4096"、"as=8G:unlimited" 形式的资源限制（软限制[:硬限制]）
+bool parseResourceLimit(const std::string& text, ResourceLimitOption& result);
+
+// 解析命令行参数，遇到无法识别的选项时输出警告并忽略。"--" 之后的参数全部原样传给子进程。
+// 未出现的选项取 initial 中的值
+LaunchOptions parseLaunchOptions(int argc, char* argv[], const LaunchOptions& initial = LaunchOptions());
+
+#endif // LAUNCH_OPTIONS_H
@@ -0,0 +1,358 @@
+#include "live_output.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+namespace {
+
+const char kLiveMagic[8] = {'S', 'C', 'L', 'I', 'V', 'E', '0', '1'};
+const size_t kLiveHeaderSize = 4096;
+const size_t kMinDataSize = 64 * 1024;
+
+static_assert(sizeof(LiveOutputHeader) <= kLiveHeaderSize, "live output header must fit in one page");
+
+inline uint64_t recordLength(uint32_t size) {
+    return sizeof(LiveRecordHeader) + ((static_cast<uint64_t>(size) + 15) & ~uint64_t(15));
+}
+
+size_t roundUpPowerOfTwo(size_t size) {
+    size_t result = kMinDataSize;
+    while (result < size) {
+        result <<= 1;
+    }
+    return result;
+}
+
+#ifndef _WIN32
+std::string sharedMemoryPath(const std::string& name) {
+    return "/" + name;
+}
+#endif
+
+} // namespace
+
+// ---------------- LiveOutputWriter ----------------
+
+LiveOutputWriter::~LiveOutputWriter() {
+    close();
+}
+
+bool LiveOutputWriter::create(const std::string& name, size_t dataSize, const std::string& programPath) {
+    close();
+    dataSize = roundUpPowerOfTwo(dataSize);
+    size_t length = kLiveHeaderSize + dataSize;
+
+#ifdef _WIN32
+    std::string objectName = "Local\\" + name;
+    HANDLE handle = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                       static_cast<DWORD>(static_cast<uint64_t>(length) >> 32),
+                                       static_cast<DWORD>(length & 0xffffffffu), objectName.c_str());
+    if (handle == NULL) {
+        std::cerr << u8"无法创建实时输出共享内存: " << name << std::endl;
+        return false;
+    }
+    if (GetLastError() == ERROR_ALREADY_EXISTS) {
+        std::cerr << u8"实时输出共享内存已被另一个启动器使用: " << name << std::endl;
+        CloseHandle(handle);
+        return false;
+    }
+    void* view = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, length);
+    if (view == NULL) {
+        std::cerr << u8"无法映射实时输出共享内存: " << name << std::endl;
+        CloseHandle(handle);
+        return false;
+    }
+    mappingHandle = handle;
+    mapping = view;
+#else
+    // 替换上一次启动器异常退出时留下的同名共享内存；仍连接着它的读者会一直停在旧的内容上
+    std::string path = sharedMemoryPath(name);
+    shm_unlink(path.c_str());
+    int fd = shm_open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd == -1) {
+        std::cerr << u8"无法创建实时输出共享内存: " << name << " (" << std::strerror(errno) << ")" << std::endl;
+        return false;
+    }
+    #ifdef __linux__
+    // 预先分配并映射全部页面，写入时不会因缺页进入内核，也不会因 /dev/shm 已满收到 SIGBUS
+    int allocResult = posix_fallocate(fd, 0, static_cast<off_t>(length));
+    int mapFlags = MAP_SHARED | MAP_POPULATE;
+    #else
+    int allocResult = ftruncate(fd, static_cast<off_t>(length));
+    int mapFlags = MAP_SHARED;
+    #endif
+    if (allocResult != 0) {
+        std::cerr << u8"无法为实时输出共享内存分配空间: " << name << std::endl;
+        ::close(fd);
+        shm_unlink(path.c_str());
+        return false;
+    }
+    void* view = mmap(nullptr, length, PROT_READ | PROT_WRITE, mapFlags, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        std::cerr << u8"无法映射实时输出共享内存: " << name << std::endl;
+        shm_unlink(path.c_str());
+        return false;
+    }
+    mapping = view;
+#endif
+
+    sharedName = name;
+    mappingSize = length;
+    header = static_cast<LiveOutputHeader*>(mapping);
+    ring = static_cast<char*>(mapping) + kLiveHeaderSize;
+    mask = dataSize - 1;
+    writePos = 0;
+    oldestPos = 0;
+    recordCount = 0;
+
+    header->version = SC_LIVE_VERSION;
+    header->headerSize = kLiveHeaderSize;
+    header->dataSize = dataSize;
+    header->createdUnixMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    header->monoToUnixNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count() -
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#ifdef _WIN32
+    header->launcherPid = static_cast<int32_t>(GetCurrentProcessId());
+#else
+    header->launcherPid = static_cast<int32_t>(getpid());
+#endif
+    header->childPid.store(0, std::memory_order_relaxed);
+    std::strncpy(header->programPath, programPath.c_str(), sizeof(header->programPath) - 1);
+    header->head.store(0, std::memory_order_relaxed);
+    header->tail.store(0, std::memory_order_relaxed);
+    header->records.store(0, std::memory_order_relaxed);
+    header->state.store(SC_LIVE_STATE_LIVE, std::memory_order_relaxed);
+
+    // 其余字段写好之后才写入 magic，读者据此判断共享内存已初始化
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(header->magic, kLiveMagic, sizeof(kLiveMagic));
+    return true;
+}
+
+void LiveOutputWriter::publish(uint8_t stream, int64_t timestampNs, const char* data, size_t size) {
+    if (!header) {
+        return;
+    }
+    size_t maxRecord = static_cast<size_t>(header->dataSize / 4) - sizeof(LiveRecordHeader);
+    while (size > 0) {
+        size_t part = size < maxRecord ? size : maxRecord;
+        publishRecord(stream, timestampNs, data, part);
+        data += part;
+        size -= part;
+    }
+}
+
+void LiveOutputWriter::publishRecord(uint8_t stream, int64_t timestampNs, const char* data, size_t size) {
+    uint64_t dataSize = header->dataSize;
+    uint64_t length = recordLength(static_cast<uint32_t>(size));
+    uint64_t offset = writePos & mask;
+    uint64_t padding = dataSize - offset < length ? dataSize - offset : 0;
+    uint64_t end = writePos + padding + length;
+
+    // 先把将被覆盖的旧记录移出 [tail, head)，再写入新内容。读者复制记录后重新读取 tail，
+    // 与这里的 release 栅栏配对，就能发现复制期间记录已被覆盖（seqlock）
+    if (oldestPos + dataSize < end) {
+        while (oldestPos + dataSize < end) {
+            const LiveRecordHeader* old = reinterpret_cast<const LiveRecordHeader*>(ring + (oldestPos & mask));
+            oldestPos += old->stream == SC_LIVE_PADDING ? dataSize - (oldestPos & mask) : recordLength(old->size);
+        }
+        header->tail.store(oldestPos, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    // 记录不跨越数据区末尾，剩余空间不够时写一条填充记录，从开头继续
+    if (padding > 0) {
+        LiveRecordHeader fill{};
+        fill.stream = SC_LIVE_PADDING;
+        std::memcpy(ring + offset, &fill, sizeof(fill));
+    }
+    LiveRecordHeader record{};
+    record.size = static_cast<uint32_t>(size);
+    record.stream = stream;
+    record.timestampNs = timestampNs;
+    char* target = ring + ((writePos + padding) & mask);
+    std::memcpy(target, &record, sizeof(record));
+    std::memcpy(target + sizeof(record), data, size);
+
+    writePos = end;
+    header->head.store(end, std::memory_order_release);
+    header->records.store(++recordCount, std::memory_order_relaxed);
+}
+
+void LiveOutputWriter::setChildPid(int pid) {
+    if (header) {
+        header->childPid.store(pid, std::memory_order_relaxed);
+    }
+}
+
+void LiveOutputWriter::close() {
+    if (!mapping) {
+        return;
+    }
+    header->state.store(SC_LIVE_STATE_CLOSED, std::memory_order_release);
+#ifdef _WIN32
+    UnmapViewOfFile(mapping);
+    CloseHandle(mappingHandle);
+    mappingHandle = nullptr;
+#else
+    shm_unlink(sharedMemoryPath(sharedName).c_str());
+    munmap(mapping, mappingSize);
+#endif
+    mapping = nullptr;
+    mappingSize = 0;
+    header = nullptr;
+    ring = nullptr;
+}
+
+// ---------------- LiveOutputReader ----------------
+
+LiveOutputReader::~LiveOutputReader() {
+    close();
+}
+
+bool LiveOutputReader::open(const std::string& name, bool fromOldest) {
+    close();
+#ifdef _WIN32
+    std::string objectName = "Local\\" + name;
+    HANDLE handle = OpenFileMappingA(FILE_MAP_READ, FALSE, objectName.c_str());
+    if (handle == NULL) {
+        return false;
+    }
+    // 映射视图会保持共享内存存在，句柄可以立即关闭
+    void* view = MapViewOfFile(handle, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(handle);
+    if (view == NULL) {
+        return false;
+    }
+    MEMORY_BASIC_INFORMATION region;
+    if (VirtualQuery(view, &region, sizeof(region)) == 0) {
+        UnmapViewOfFile(view);
+        return false;
+    }
+    mapping = view;
+    mappingSize = region.RegionSize;
+#else
+    int fd = shm_open(sharedMemoryPath(name).c_str(), O_RDONLY, 0);
+    if (fd == -1) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < kLiveHeaderSize) {
+        ::close(fd);
+        return false;
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        return false;
+    }
+    mapping = view;
+    mappingSize = static_cast<size_t>(st.st_size);
+#endif
+
+    header = static_cast<const LiveOutputHeader*>(mapping);
+    bool valid = std::memcmp(header->magic, kLiveMagic, sizeof(kLiveMagic)) == 0;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t dataSize = header->dataSize;
+    if (!valid || header->version != SC_LIVE_VERSION || header->headerSize < sizeof(LiveOutputHeader) ||
+        dataSize < kMinDataSize || (dataSize & (dataSize - 1)) != 0 || header->headerSize + dataSize > mappingSize) {
+        close();
+        return false;
+    }
+    ring = static_cast<const char*>(mapping) + header->headerSize;
+    mask = dataSize - 1;
+    position = fromOldest ? header->tail.load(std::memory_order_acquire) : header->head.load(std::memory_order_acquire);
+    skipped = 0;
+    skips = 0;
+    return true;
+}
+
+void LiveOutputReader::close() {
+    if (!mapping) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(mapping);
+#else
+    munmap(mapping, mappingSize);
+#endif
+    mapping = nullptr;
+    mappingSize = 0;
+    header = nullptr;
+    ring = nullptr;
+}
+
+int LiveOutputReader::next(sc_live_record& record, char* data, size_t capacity) {
+    if (!header) {
+        return SC_LIVE_CLOSED;
+    }
+    uint64_t dataSize = header->dataSize;
+    while (true) {
+        // 先读状态再读 head：关闭前写入的记录一定能看到
+        uint32_t state = header->state.load(std::memory_order_acquire);
+        uint64_t head = header->head.load(std::memory_order_acquire);
+        if (position >= head) {
+            return state == SC_LIVE_STATE_CLOSED ? SC_LIVE_CLOSED : SC_LIVE_EMPTY;
+        }
+        uint64_t tail = header->tail.load(std::memory_order_acquire);
+        if (position < tail) {
+            // 落后超过一圈，跳到最旧的完整记录
+            skipped += tail - position;
+            skips++;
+            position = tail;
+            continue;
+        }
+
+        uint64_t offset = position & mask;
+        LiveRecordHeader entry;
+        std::memcpy(&entry, ring + offset, sizeof(entry));
+        bool padding = entry.stream == SC_LIVE_PADDING;
+        uint64_t nextPosition = padding ? position + (dataSize - offset) : position + recordLength(entry.size);
+        // 头部可能正被覆盖，内容先按读到的长度复制，是否有效由之后的 tail 检查决定
+        bool inRange = padding || offset + sizeof(entry) + entry.size <= dataSize;
+        bool fits = entry.size <= capacity;
+        if (!padding && inRange && fits) {
+            std::memcpy(data, ring + offset + sizeof(entry), entry.size);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header->tail.load(std::memory_order_relaxed) > position) {
+            continue;
+        }
+        if (!inRange || nextPosition > head) {
+            // 记录没有被覆盖却不完整，说明共享内存已损坏，不再读取
+            close();
+            return SC_LIVE_CLOSED;
+        }
+        if (padding) {
+            position = nextPosition;
+            continue;
+        }
+        record.size = entry.size;
+        if (!fits) {
+            return SC_LIVE_TOO_SMALL;
+        }
+        record.stream = entry.stream;
+        record.timestamp_unix_ns = entry.timestampNs + header->monoToUnixNs;
+        position = nextPosition;
+        return SC_LIVE_RECORD;
+    }
+}
+
+uint64_t LiveOutputReader::lag() const {
+    return header ? header->head.load(std::memory_order_relaxed) - position : 0;
+}
@@ -0,0 +1,117 @@
+#ifndef LIVE_OUTPUT_H
+#define LIVE_OUTPUT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "launch_live.h"
+
+// 实时输出环（--live-output）的共享内存布局，字段含义与 launch_live.h 中的说明一致。
+// 只有启动器写入；读者以只读方式映射，互不影响，也不会拖慢写入
+struct LiveOutputHeader {
+    char magic[8];                     // "SCLIVE01"
+    uint32_t version;
+    uint32_t headerSize;               // 数据区在共享内存中的偏移
+    uint64_t dataSize;                 // 数据区大小，2 的幂
+    int64_t createdUnixMs;
+    int64_t monoToUnixNs;              // 记录时间戳（单调时钟）加上它即为 Unix 纳秒
+    int32_t launcherPid;
+    std::atomic<int32_t> childPid;
+    std::atomic<uint32_t> state;       // SC_LIVE_STATE_*
+    char programPath[256];
+
+    // 写入位置与最旧的完整记录位置（均为自创建以来的绝对字节数），由写入者一起更新，读者一起读取，
+    // 因此放在同一缓存行，并与上面的只读字段分开
+    alignas(64) std::atomic<uint64_t> head;
+    std::atomic<uint64_t> tail;
+    std::atomic<uint64_t> records;     // 已写入的记录数，仅用于统计
+};
+
+// 每条记录的头部，记录按 16 字节对齐，不跨越数据区末尾
+struct LiveRecordHeader {
+    uint32_t size;                     // 内容字节数
+    uint8_t stream;                    // SC_LIVE_STREAM_*，SC_LIVE_PADDING 表示跳到数据区开头
+    uint8_t reserved[3];
+    int64_t timestampNs;               // 单调时钟
+};
+
+static_assert(sizeof(LiveRecordHeader) == 16, "live record header must stay 16 bytes");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "live output ring needs lock-free 64-bit atomics");
+
+// 把子进程输出发布到具名共享内存环。写入只有 memcpy 与原子存储，不进行系统调用，也不等待读者：
+// 读者落后超过一圈时由读者自己发现并跳到最旧的完整记录（见 LiveOutputReader）
+class LiveOutputWriter {
+public:
+    LiveOutputWriter() = default;
+    ~LiveOutputWriter();
+    LiveOutputWriter(const LiveOutputWriter&) = delete;
+    LiveOutputWriter& operator=(const LiveOutputWriter&) = delete;
+
+    // 创建名为 name 的共享内存（已存在时替换），dataSize 向上取整到 2 的幂
+    bool create(const std::string& name, size_t dataSize, const std::string& programPath);
+
+    // 发布一段输出或事件；超过数据区四分之一的内容拆成多条记录
+    void publish(uint8_t stream, int64_t timestampNs, const char* data, size_t size);
+
+    void setChildPid(int pid);
+
+    // 标记为已关闭并删除共享内存名称，已连接的读者读完剩余记录后收到 SC_LIVE_CLOSED
+    void close();
+
+    bool isOpen() const { return header != nullptr; }
+    const std::string& name() const { return sharedName; }
+
+private:
+    void publishRecord(uint8_t stream, int64_t timestampNs, const char* data, size_t size);
+
+    std::string sharedName;
+    void* mapping = nullptr;
+    size_t mappingSize = 0;
+#ifdef _WIN32
+    void* mappingHandle = nullptr;
+#endif
+    LiveOutputHeader* header = nullptr;
+    char* ring = nullptr;
+    uint64_t mask = 0;
+    uint64_t writePos = 0;   // head 与 tail 的本地副本，只有写入者修改
+    uint64_t oldestPos = 0;
+    uint64_t recordCount = 0;
+};
+
+// 跟随实时输出环的读者。每条记录先复制出来再确认复制期间没有被覆盖（seqlock），
+// 被覆盖或落后超过一圈时跳到最旧的完整记录并计入 skippedBytes
+class LiveOutputReader {
+public:
+    LiveOutputReader() = default;
+    ~LiveOutputReader();
+    LiveOutputReader(const LiveOutputReader&) = delete;
+    LiveOutputReader& operator=(const LiveOutputReader&) = delete;
+
+    // 连接已有的共享内存；fromOldest 为 false 时只读取之后写入的记录
+    bool open(const std::string& name, bool fromOldest = true);
+    void close();
+
+    // 读取下一条记录，返回 SC_LIVE_RECORD、SC_LIVE_EMPTY 或 SC_LIVE_CLOSED。
+    // data 的容量不足时返回 SC_LIVE_TOO_SMALL，record.size 为需要的大小，位置不变
+    int next(sc_live_record& record, char* data, size_t capacity);
+
+    // 写入位置与读取位置之差（字节）
+    uint64_t lag() const;
+    uint64_t skippedBytes() const { return skipped; }
+    uint64_t skipCount() const { return skips; }
+    const LiveOutputHeader* info() const { return header; }
+
+private:
+    void* mapping = nullptr;
+    size_t mappingSize = 0;
+    const LiveOutputHeader* header = nullptr;
+    const char* ring = nullptr;
+    uint64_t mask = 0;
+    uint64_t position = 0;
+    uint64_t skipped = 0;
+    uint64_t skips = 0;
+};
+
+#endif // LIVE_OUTPUT_H
@@ -0,0 +1,574 @@
+#include "lz4_frame.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+const uint32_t kPrime1 = 2654435761U;
+const uint32_t kPrime2 = 2246822519U;
+const uint32_t kPrime3 = 3266489917U;
+const uint32_t kPrime4 = 668265263U;
+const uint32_t kPrime5 = 374761393U;
+
+const uint32_t kFrameMagic = 0x184D2204U;
+const uint32_t kSkippableMagicMask = 0xFFFFFFF0U;
+const uint32_t kSkippableMagic = 0x184D2A50U;
+const uint32_t kUncompressedBlockFlag = 0x80000000U;
+
+// 块格式约束：最后 5 个字节必须是字面量，最后一个匹配至少在块结束前 12 个字节开始
+const size_t kMinMatch = 4;
+const size_t kLastLiterals = 5;
+const size_t kMatchFindLimit = 12;
+const size_t kMaxDistance = 65535;
+const int kHashLog = 14;
+
+// 非独立块最多引用前 64 KB 的输出
+const size_t kWindowSize = 64 * 1024;
+
+inline uint32_t rotl32(uint32_t value, int bits) {
+    return (value << bits) | (value >> (32 - bits));
+}
+
+inline uint32_t readLE32(const void* p) {
+    const unsigned char* b = static_cast<const unsigned char*>(p);
+    return static_cast<uint32_t>(b[0]) | (static_cast<uint32_t>(b[1]) << 8) |
+           (static_cast<uint32_t>(b[2]) << 16) | (static_cast<uint32_t>(b[3]) << 24);
+}
+
+inline void writeLE32(unsigned char* p, uint32_t value) {
+    p[0] = static_cast<unsigned char>(value);
+    p[1] = static_cast<unsigned char>(value >> 8);
+    p[2] = static_cast<unsigned char>(value >> 16);
+    p[3] = static_cast<unsigned char>(value >> 24);
+}
+
+// 仅用于比较和散列，字节序无关
+inline uint32_t load32(const unsigned char* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline uint32_t xxhRound(uint32_t acc, uint32_t input) {
+    acc += input * kPrime2;
+    return rotl32(acc, 13) * kPrime1;
+}
+
+inline uint32_t hashSequence(uint32_t sequence) {
+    return (sequence * kPrime1) >> (32 - kHashLog);
+}
+
+// 写出 LZ4 长度字段的扩展字节（值 >= 15 时）
+inline unsigned char* writeLengthTail(unsigned char* op, size_t length) {
+    while (length >= 255) {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = static_cast<unsigned char>(length);
+    return op;
+}
+
+size_t blockSizeForId(uint8_t id) {
+    return static_cast<size_t>(1) << (8 + 2 * id);  // 4: 64K, 5: 256K, 6: 1M, 7: 4M
+}
+
+bool readExact(std::istream& in, void* data, size_t size) {
+    in.read(static_cast<char*>(data), static_cast<std::streamsize>(size));
+    return static_cast<size_t>(in.gcount()) == size;
+}
+
+} // namespace
+
+// ---------------- XXH32 ----------------
+
+Xxh32::Xxh32(uint32_t seed) : seed(seed) {
+    acc[0] = seed + kPrime1 + kPrime2;
+    acc[1] = seed + kPrime2;
+    acc[2] = seed;
+    acc[3] = seed - kPrime1;
+}
+
+void Xxh32::update(const void* data, size_t size) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    const unsigned char* end = p + size;
+    totalSize += size;
+
+    if (pendingSize + size < 16) {
+        std::memcpy(pending + pendingSize, p, size);
+        pendingSize += size;
+        return;
+    }
+
+    if (pendingSize > 0) {
+        size_t fill = 16 - pendingSize;
+        std::memcpy(pending + pendingSize, p, fill);
+        p += fill;
+        for (int i = 0; i < 4; i++) {
+            acc[i] = xxhRound(acc[i], readLE32(pending + 4 * i));
+        }
+        pendingSize = 0;
+    }
+
+    while (end - p >= 16) {
+        for (int i = 0; i < 4; i++) {
+            acc[i] = xxhRound(acc[i], readLE32(p + 4 * i));
+        }
+        p += 16;
+    }
+
+    pendingSize = static_cast<size_t>(end - p);
+    std::memcpy(pending, p, pendingSize);
+}
+
+uint32_t Xxh32::digest() const {
+    uint32_t h;
+    if (totalSize >= 16) {
+        h = rotl32(acc[0], 1) + rotl32(acc[1], 7) + rotl32(acc[2], 12) + rotl32(acc[3], 18);
+    } else {
+        h = seed + kPrime5;
+    }
+    h += static_cast<uint32_t>(totalSize);
+
+    const unsigned char* p = pending;
+    const unsigned char* end = pending + pendingSize;
+    while (end - p >= 4) {
+        h += readLE32(p) * kPrime3;
+        h = rotl32(h, 17) * kPrime4;
+        p += 4;
+    }
+    while (p < end) {
+        h += *p * kPrime5;
+        h = rotl32(h, 11) * kPrime1;
+        p++;
+    }
+
+    h ^= h >> 15;
+    h *= kPrime2;
+    h ^= h >> 13;
+    h *= kPrime3;
+    h ^= h >> 16;
+    return h;
+}
+
+uint32_t Xxh32::hash(const void* data, size_t size, uint32_t seed) {
+    Xxh32 state(seed);
+    state.update(data, size);
+    return state.digest();
+}
+
+// ---------------- 块编解码 ----------------
+
+size_t lz4BlockBound(size_t srcSize) {
+    return srcSize + srcSize / 255 + 16;
+}
+
+size_t lz4CompressBlock(const char* src, size_t srcSize, char* dst, std::vector<uint32_t>& hashTable) {
+    const unsigned char* base = reinterpret_cast<const unsigned char*>(src);
+    const unsigned char* end = base + srcSize;
+    const unsigned char* anchor = base;
+    unsigned char* op = reinterpret_cast<unsigned char*>(dst);
+
+    if (srcSize > kMatchFindLimit) {
+        hashTable.assign(static_cast<size_t>(1) << kHashLog, 0);
+        const unsigned char* matchLimit = end - kLastLiterals;
+        const unsigned char* searchLimit = end - kMatchFindLimit;
+        const unsigned char* ip = base + 1;
+        hashTable[hashSequence(load32(base))] = 0;
+
+        while (ip < searchLimit) {
+            uint32_t sequence = load32(ip);
+            uint32_t& slot = hashTable[hashSequence(sequence)];
+            const unsigned char* ref = base + slot;
+            slot = static_cast<uint32_t>(ip - base);
+
+            if (ref >= ip || static_cast<size_t>(ip - ref) > kMaxDistance || load32(ref) != sequence) {
+                // 越久没有找到匹配，跳得越远，避免在不可压缩的数据上浪费时间
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+
+            // 向前扩展匹配
+            while (ip > anchor && ref > base && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+            size_t matchLength = kMinMatch;
+            while (ip + matchLength < matchLimit && ip[matchLength] == ref[matchLength]) {
+                matchLength++;
+            }
+
+            size_t literalLength = static_cast<size_t>(ip - anchor);
+            unsigned char* token = op++;
+            if (literalLength >= 15) {
+                *token = 15 << 4;
+                op = writeLengthTail(op, literalLength - 15);
+            } else {
+                *token = static_cast<unsigned char>(literalLength << 4);
+            }
+            std::memcpy(op, anchor, literalLength);
+            op += literalLength;
+
+            size_t offset = static_cast<size_t>(ip - ref);
+            *op++ = static_cast<unsigned char>(offset);
+            *op++ = static_cast<unsigned char>(offset >> 8);
+
+            size_t extra = matchLength - kMinMatch;
+            if (extra >= 15) {
+                *token |= 15;
+                op = writeLengthTail(op, extra - 15);
+            } else {
+                *token |= static_cast<unsigned char>(extra);
+            }
+
+            ip += matchLength;
+            anchor = ip;
+            if (ip - 2 > base && ip < searchLimit) {
+                hashTable[hashSequence(load32(ip - 2))] = static_cast<uint32_t>(ip - 2 - base);
+            }
+        }
+    }
+
+    // 剩余部分全部作为字面量
+    size_t literalLength = static_cast<size_t>(end - anchor);
+    if (literalLength >= 15) {
+        *op++ = 15 << 4;
+        op = writeLengthTail(op, literalLength - 15);
+    } else {
+        *op++ = static_cast<unsigned char>(literalLength << 4);
+    }
+    std::memcpy(op, anchor, literalLength);
+    op += literalLength;
+
+    return static_cast<size_t>(op - reinterpret_cast<unsigned char*>(dst));
+}
+
+bool lz4DecompressBlock(const char* src, size_t srcSize, char* dst, size_t dstCapacity,
+                        size_t historySize, size_t& decodedSize) {
+    const unsigned char* ip = reinterpret_cast<const unsigned char*>(src);
+    const unsigned char* end = ip + srcSize;
+    unsigned char* start = reinterpret_cast<unsigned char*>(dst);
+    unsigned char* op = start;
+    unsigned char* outEnd = start + dstCapacity;
+
+    while (true) {
+        if (ip >= end) {
+            return false;
+        }
+        unsigned token = *ip++;
+
+        size_t literalLength = token >> 4;
+        if (literalLength == 15) {
+            unsigned char byte;
+            do {
+                if (ip >= end) {
+                    return false;
+                }
+                byte = *ip++;
+                literalLength += byte;
+            } while (byte == 255);
+        }
+        if (literalLength > static_cast<size_t>(end - ip) || literalLength > static_cast<size_t>(outEnd - op)) {
+            return false;
+        }
+        std::memcpy(op, ip, literalLength);
+        op += literalLength;
+        ip += literalLength;
+
+        if (ip == end) {
+            break;  // 最后一个序列只有字面量
+        }
+
+        if (end - ip < 2) {
+            return false;
+        }
+        size_t offset = static_cast<size_t>(ip[0]) | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+        if (offset == 0 || offset > static_cast<size_t>(op - start) + historySize) {
+            return false;
+        }
+
+        size_t matchLength = token & 15;
+        if (matchLength == 15) {
+            unsigned char byte;
+            do {
+                if (ip >= end) {
+                    return false;
+                }
+                byte = *ip++;
+                matchLength += byte;
+            } while (byte == 255);
+        }
+        matchLength += kMinMatch;
+        if (matchLength > static_cast<size_t>(outEnd - op)) {
+            return false;
+        }
+
+        // 匹配可能与输出重叠（offset < matchLength），必须逐字节复制
+        const unsigned char* match = op - offset;
+        for (size_t i = 0; i < matchLength; i++) {
+            op[i] = match[i];
+        }
+        op += matchLength;
+    }
+
+    decodedSize = static_cast<size_t>(op - start);
+    return true;
+}
+
+// ---------------- 帧编码 ----------------
+
+Lz4FrameWriter::Lz4FrameWriter(std::ostream& sink, size_t blockSize) : sink(sink) {
+    blockSizeId = 4;
+    while (blockSizeId < 7 && blockSizeForId(blockSizeId) < blockSize) {
+        blockSizeId++;
+    }
+    input.resize(blockSizeForId(blockSizeId));
+    output.resize(lz4BlockBound(input.size()));
+    setp(input.data(), input.data() + input.size());
+}
+
+Lz4FrameWriter::~Lz4FrameWriter() {
+    finish();
+}
+
+void Lz4FrameWriter::emit(const void* data, size_t size) {
+    sink.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    produced += size;
+}
+
+void Lz4FrameWriter::writeHeader() {
+    // FLG: 版本 01，独立块，带内容校验和；BD: 最大块大小
+    unsigned char header[7];
+    writeLE32(header, kFrameMagic);
+    header[4] = 0x40 | 0x20 | 0x04;
+    header[5] = static_cast<unsigned char>(blockSizeId << 4);
+    header[6] = static_cast<unsigned char>((Xxh32::hash(header + 4, 2) >> 8) & 0xFF);
+    emit(header, sizeof(header));
+    headerWritten = true;
+}
+
+bool Lz4FrameWriter::flushBlock() {
+    size_t size = static_cast<size_t>(pptr() - pbase());
+    if (size == 0) {
+        return true;
+    }
+    if (!headerWritten) {
+        writeHeader();
+    }
+
+    contentHash.update(pbase(), size);
+    consumed += size;
+
+    size_t compressed = lz4CompressBlock(pbase(), size, output.data(), hashTable);
+    unsigned char blockHeader[4];
+    if (compressed < size) {
+        writeLE32(blockHeader, static_cast<uint32_t>(compressed));
+        emit(blockHeader, sizeof(blockHeader));
+        emit(output.data(), compressed);
+    } else {
+        // 不可压缩的块原样保存
+        writeLE32(blockHeader, static_cast<uint32_t>(size) | kUncompressedBlockFlag);
+        emit(blockHeader, sizeof(blockHeader));
+        emit(pbase(), size);
+    }
+
+    setp(input.data(), input.data() + input.size());
+    return sink.good();
+}
+
+Lz4FrameWriter::int_type Lz4FrameWriter::overflow(int_type ch) {
+    if (finished || !flushBlock()) {
+        return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+std::streamsize Lz4FrameWriter::xsputn(const char* data, std::streamsize size) {
+    if (finished) {
+        return 0;
+    }
+    std::streamsize written = 0;
+    while (written < size) {
+        std::streamsize room = epptr() - pptr();
+        if (room == 0) {
+            if (!flushBlock()) {
+                break;
+            }
+            continue;
+        }
+        std::streamsize count = std::min(room, size - written);
+        std::memcpy(pptr(), data + written, static_cast<size_t>(count));
+        pbump(static_cast<int>(count));
+        written += count;
+    }
+    return written;
+}
+
+int Lz4FrameWriter::sync() {
+    // 不提前压缩未写满的块，否则频繁 flush 会明显降低压缩率
+    sink.flush();
+    return sink.good() ? 0 : -1;
+}
+
+bool Lz4FrameWriter::finish() {
+    if (finished) {
+        return sink.good();
+    }
+    if (!headerWritten) {
+        writeHeader();
+    }
+    flushBlock();
+    finished = true;
+
+    unsigned char trailer[8];
+    writeLE32(trailer, 0);  // 结束标记
+    writeLE32(trailer + 4, contentHash.digest());
+    emit(trailer, sizeof(trailer));
+    sink.flush();
+    return sink.good();
+}
+
+// ---------------- 帧解码 ----------------
+
+bool decodeLz4Frames(std::istream& in, std::ostream& out) {
+    size_t frames = 0;
+    std::vector<char> compressed;
+    std::vector<char> window;
+
+    while (true) {
+        unsigned char magicBytes[4];
+        in.read(reinterpret_cast<char*>(magicBytes), sizeof(magicBytes));
+        if (in.gcount() == 0 && frames > 0) {
+            return true;
+        }
+        if (in.gcount() != sizeof(magicBytes)) {
+            std::cerr << u8"不是 LZ4 文件或文件不完整" << std::endl;
+            return false;
+        }
+        uint32_t magic = readLE32(magicBytes);
+
+        if ((magic & kSkippableMagicMask) == kSkippableMagic) {
+            unsigned char sizeBytes[4];
+            if (!readExact(in, sizeBytes, sizeof(sizeBytes))) {
+                std::cerr << u8"可跳过帧不完整" << std::endl;
+                return false;
+            }
+            in.seekg(readLE32(sizeBytes), std::ios::cur);
+            frames++;
+            continue;
+        }
+        if (magic != kFrameMagic) {
+            std::cerr << u8"不是 LZ4 帧（魔数 0x" << std::hex << magic << std::dec << u8"）" << std::endl;
+            return false;
+        }
+
+        unsigned char descriptor[15];
+        if (!readExact(in, descriptor, 2)) {
+            std::cerr << u8"帧头不完整" << std::endl;
+            return false;
+        }
+        uint8_t flags = descriptor[0];
+        uint8_t blockSizeId = (descriptor[1] >> 4) & 0x07;
+        if ((flags >> 6) != 1 || blockSizeId < 4) {
+            std::cerr << u8"不支持的 LZ4 帧版本或块大小" << std::endl;
+            return false;
+        }
+        bool independentBlocks = flags & 0x20;
+        bool blockChecksum = flags & 0x10;
+        bool hasContentSize = flags & 0x08;
+        bool contentChecksum = flags & 0x04;
+        if (flags & 0x01) {
+            std::cerr << u8"不支持带字典的 LZ4 帧" << std::endl;
+            return false;
+        }
+
+        size_t descriptorSize = 2 + (hasContentSize ? 8 : 0);
+        if (!readExact(in, descriptor + 2, descriptorSize - 2 + 1)) {
+            std::cerr << u8"帧头不完整" << std::endl;
+            return false;
+        }
+        if (((Xxh32::hash(descriptor, descriptorSize) >> 8) & 0xFF) != descriptor[descriptorSize]) {
+            std::cerr << u8"帧头校验失败" << std::endl;
+            return false;
+        }
+        uint64_t contentSize = 0;
+        if (hasContentSize) {
+            for (int i = 7; i >= 0; i--) {
+                contentSize = (contentSize << 8) | descriptor[2 + i];
+            }
+        }
+
+        size_t maxBlockSize = blockSizeForId(blockSizeId);
+        compressed.resize(maxBlockSize);
+        window.resize(kWindowSize + maxBlockSize);
+        size_t history = 0;
+        uint64_t decodedTotal = 0;
+        Xxh32 hash;
+
+        while (true) {
+            unsigned char sizeBytes[4];
+            if (!readExact(in, sizeBytes, sizeof(sizeBytes))) {
+                std::cerr << u8"数据块不完整" << std::endl;
+                return false;
+            }
+            uint32_t blockSize = readLE32(sizeBytes);
+            if (blockSize == 0) {
+                break;  // 结束标记
+            }
+            bool stored = blockSize & kUncompressedBlockFlag;
+            blockSize &= ~kUncompressedBlockFlag;
+            if (blockSize > maxBlockSize || !readExact(in, compressed.data(), blockSize)) {
+                std::cerr << u8"数据块损坏或不完整" << std::endl;
+                return false;
+            }
+            if (blockChecksum) {
+                unsigned char checksum[4];
+                if (!readExact(in, checksum, sizeof(checksum)) ||
+                    readLE32(checksum) != Xxh32::hash(compressed.data(), blockSize)) {
+                    std::cerr << u8"数据块校验失败" << std::endl;
+                    return false;
+                }
+            }
+
+            char* target = window.data() + history;
+            size_t decoded = blockSize;
+            if (stored) {
+                std::memcpy(target, compressed.data(), blockSize);
+            } else if (!lz4DecompressBlock(compressed.data(), blockSize, target, maxBlockSize, history, decoded)) {
+                std::cerr << u8"数据块解压失败" << std::endl;
+                return false;
+            }
+
+            out.write(target, static_cast<std::streamsize>(decoded));
+            hash.update(target, decoded);
+            decodedTotal += decoded;
+
+            // 非独立块需要保留最近 64 KB 的输出供下一块引用
+            if (!independentBlocks) {
+                size_t available = history + decoded;
+                size_t keep = std::min(available, kWindowSize);
+                std::memmove(window.data(), window.data() + available - keep, keep);
+                history = keep;
+            }
+        }
+
+        if (contentChecksum) {
+            unsigned char checksum[4];
+            if (!readExact(in, checksum, sizeof(checksum)) || readLE32(checksum) != hash.digest()) {
+                std::cerr << u8"内容校验失败" << std::endl;
+                return false;
+            }
+        }
+        if (hasContentSize && contentSize != decodedTotal) {
+            std::cerr << u8"解压后大小与帧头记录不一致" << std::endl;
+            return false;
+        }
+        frames++;
+    }
+}
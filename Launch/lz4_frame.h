@@ -0,0 +1,80 @@
+#ifndef LZ4_FRAME_H
+#define LZ4_FRAME_H
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <streambuf>
+#include <vector>
+
+// 自带的 LZ4 帧格式（https://github.com/lz4/lz4/blob/dev/doc/lz4_Frame_format.md）编解码，
+// 生成的文件可以直接用 lz4 -d 解压。构建时不依赖外部库。
+
+// XXH32 流式校验和，用于帧头和内容校验
+class Xxh32 {
+public:
+    explicit Xxh32(uint32_t seed = 0);
+
+    void update(const void* data, size_t size);
+    uint32_t digest() const;
+
+    static uint32_t hash(const void* data, size_t size, uint32_t seed = 0);
+
+private:
+    uint32_t acc[4];
+    uint32_t seed;
+    uint64_t totalSize = 0;
+    unsigned char pending[16];
+    size_t pendingSize = 0;
+};
+
+// 压缩一个独立的 LZ4 块。dst 至少需要 lz4BlockBound(srcSize) 字节，hashTable 为可复用的工作区
+size_t lz4BlockBound(size_t srcSize);
+size_t lz4CompressBlock(const char* src, size_t srcSize, char* dst, std::vector<uint32_t>& hashTable);
+
+// 解压一个 LZ4 块到 dst。dst 之前的 historySize 字节是已解压的输出，可被匹配引用（非独立块）。
+// 数据损坏时返回 false
+bool lz4DecompressBlock(const char* src, size_t srcSize, char* dst, size_t dstCapacity,
+                        size_t historySize, size_t& decodedSize);
+
+// 流式 LZ4 帧编码器：作为 std::ostream 的缓冲区使用，写满一个块就压缩并写入 sink，
+// 内存占用固定为两个块的大小。finish() 写出结束标记与内容校验和
+class Lz4FrameWriter : public std::streambuf {
+public:
+    explicit Lz4FrameWriter(std::ostream& sink, size_t blockSize = 256 * 1024);
+    ~Lz4FrameWriter() override;
+    Lz4FrameWriter(const Lz4FrameWriter&) = delete;
+    Lz4FrameWriter& operator=(const Lz4FrameWriter&) = delete;
+
+    bool finish();
+
+    uint64_t inputBytes() const { return consumed; }
+    uint64_t outputBytes() const { return produced; }
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char* data, std::streamsize size) override;
+    int sync() override;
+
+private:
+    void writeHeader();
+    bool flushBlock();
+    void emit(const void* data, size_t size);
+
+    std::ostream& sink;
+    std::vector<char> input;
+    std::vector<char> output;
+    std::vector<uint32_t> hashTable;
+    Xxh32 contentHash;
+    uint8_t blockSizeId = 5;
+    bool headerWritten = false;
+    bool finished = false;
+    uint64_t consumed = 0;
+    uint64_t produced = 0;
+};
+
+// 解码 in 中的一个或多个 LZ4 帧（跳过可跳过帧）写入 out；格式或校验错误时输出原因并返回 false
+bool decodeLz4Frames(std::istream& in, std::ostream& out);
+
+#endif // LZ4_FRAME_H
@@ -1,6 +1,14 @@
 #include "system_info.h"
 #include <iostream>
+#include "child_pool.h"
 #include "crash_log.h"
+#include "launch_options.h"
+#include "notification.h"
+#include "cgroup_sandbox.h"
+#include "output_buffer.h"
+#include "payload_prefetch.h"
+#include "payload_verify.h"
+#include "startup_trace.h"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -22,36 +30,35 @@ public:
 };
 #endif
 
-void ShowMessageBox(const std::string& message, const std::string& title) {
-#ifdef _WIN32
-    int len = MultiByteToWideChar(CP_UTF8, 0, message.c_str(), -1, NULL, 0);
-    std::wstring wMessage(len, 0);
-    MultiByteToWideChar(CP_UTF8, 0, message.c_str(), -1, &wMessage[0], len);
-    
-    int len2 = MultiByteToWideChar(CP_UTF8, 0, title.c_str(), -1, NULL, 0);
-    std::wstring wTitle(len2, 0);
-    MultiByteToWideChar(CP_UTF8, 0, title.c_str(), -1, &wTitle[0], len2);
-    
-    MessageBoxW(NULL, wMessage.c_str(), wTitle.c_str(), MB_OK | MB_ICONERROR);
-#elif __APPLE__
-    // macOS使用osascript显示消息框
-    std::string command = "osascript -e 'display alert \"" + title + "\" message \"" + message + "\"'";
-    system(command.c_str());
-#else
-    // Linux使用zenity或xmessage显示消息框
-    std::string command = "zenity --error --title=\"" + title + "\" --text=\"" + message + "\" 2>/dev/null";
-    if (system(command.c_str()) != 0) {
-        // 如果zenity不可用，尝试使用xmessage
-        command = "xmessage -center \"" + title + "\\n" + message + "\" 2>/dev/null";
-        system(command.c_str());
-    }
-#endif
-}
-
-int main()
+int main(int argc, char* argv[])
 {
+    int64_t mainEntryNs = monotonicNanos();
     CodePageRestorer _; // 设置控制台代码页为UTF-8
 
+    LaunchOptions options = parseLaunchOptions(argc, argv);
+    relaunchInDelegatedScope(options, argc, argv);
+    configureStartupTrace(options.startupTraceFile, mainEntryNs);
+    int64_t phaseStartNs = monotonicNanos();
+    configureNotifications(options.notifySocket, options.notifyLogFile);
+    traceStartupPhase("configure notifications", phaseStartNs, monotonicNanos());
+
+    // 按配置文件监管多个程序，不做单程序模式下的载荷校验与预读
+    if (!options.poolConfigFile.empty()) {
+        std::vector<PoolChildConfig> children;
+        std::string error;
+        if (!loadPoolConfig(options.poolConfigFile, argc, argv, children, error)) {
+            std::cerr << u8"配置文件有误: " << error << std::endl;
+            ShowMessageBox(std::string(u8"配置文件有误: ") + error, u8"启动错误");
+            return 1;
+        }
+        if (runChildPool(children, options.controlSocket)) {
+            std::cout << u8"全部程序正常完成" << std::endl;
+        } else {
+            std::cout << u8"部分程序异常终止" << std::endl;
+        }
+        return 0;
+    }
+
     std::string relativePath = "launcher";
 #ifdef _WIN32
     std::string programName = "SwarmCloneLauncher.exe";
@@ -59,8 +66,23 @@ int main()
     std::string programName = "SwarmCloneLauncher";
 #endif
 
+    // 发布时为载荷目录生成安装清单
+    if (options.writePayloadManifest) {
+        std::string error;
+        if (!writePayloadManifest(relativePath, options.payloadManifest, error)) {
+            std::cerr << u8"生成安装清单失败: " << error << std::endl;
+            return 1;
+        }
+        std::cout << u8"安装清单已生成: " << relativePath << "/" << options.payloadManifest << std::endl;
+        return 0;
+    }
+
+    // 在下面的检查与监管准备期间于后台预读载荷
+    PayloadPrefetcher prefetcher(relativePath, programName, options);
+
     // 检查launcher目录和程序文件是否存在
     std::string fullPath = relativePath + "/" + programName;
+    phaseStartNs = monotonicNanos();
     std::ifstream fileCheck(fullPath);
     if (!fileCheck.good()) {
         std::cerr << u8"错误：启动器文件损坏或缺失，建议您重新安装启动器。 " << fullPath << std::endl;
@@ -69,8 +91,39 @@ int main()
         return 1;
     }
     fileCheck.close();
+    traceStartupPhase("check program file", phaseStartNs, monotonicNanos());
+
+    // 按安装清单校验载荷，损坏的文件列在提示中
+    if (options.verifyMode != VerifyMode::Off) {
+        StartupPhase phase("verify payload");
+        PayloadVerifyResult verify;
+        if (!verifyPayload(relativePath, options.payloadManifest, options.verifyCacheFile,
+                           options.verifyMode == VerifyMode::Full, verify)) {
+            std::cerr << u8"无法读取安装清单: " << relativePath << "/" << options.payloadManifest << std::endl;
+        } else if (!verify.manifestFound && options.verifyMode == VerifyMode::Full) {
+            std::cerr << u8"没有找到安装清单，跳过完整性校验" << std::endl;
+        } else if (!verify.ok()) {
+            const size_t maxListed = 10;
+            std::string errorMsg = u8"以下启动器文件损坏或缺失，建议您重新安装启动器:\n";
+            std::vector<std::string> files = verify.missing;
+            files.insert(files.end(), verify.corrupted.begin(), verify.corrupted.end());
+            for (size_t i = 0; i < files.size() && i < maxListed; i++) {
+                bool missing = i < verify.missing.size();
+                errorMsg += files[i] + (missing ? u8"（缺失）" : u8"（已损坏）") + "\n";
+            }
+            if (files.size() > maxListed) {
+                errorMsg += u8"……等共 " + std::to_string(files.size()) + u8" 个文件\n";
+            }
+            std::cerr << u8"错误：" << errorMsg;
+            ShowMessageBox(errorMsg, u8"启动错误");
+            return 1;
+        } else if (verify.filesHashed > 0) {
+            std::cout << u8"已校验 " << verify.filesHashed << u8" 个文件（" << verify.bytesHashed / 1048576
+                      << " MB）" << std::endl;
+        }
+    }
 
-    bool success = runProgramWithCrashLogging(relativePath, programName);
+    bool success = runProgramWithCrashLogging(relativePath, programName, options, &prefetcher);
 
     if (success) {
         std::cout << u8"程序正常完成" << std::endl;
@@ -0,0 +1,156 @@
+#include "mapped_capture.h"
+
+#ifndef _WIN32
+
+#include <iostream>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+
+const char kCaptureMagic[8] = {'S', 'C', 'C', 'A', 'P', 'T', '0', '1'};
+const uint32_t kCaptureVersion = 1;
+const size_t kCaptureHeaderSize = 4096;
+
+static_assert(sizeof(CaptureFileHeader) <= kCaptureHeaderSize, "capture header must fit in one page");
+
+} // namespace
+
+MappedCaptureFile::~MappedCaptureFile() {
+    unmap();
+}
+
+bool MappedCaptureFile::create(const std::string& filePath, size_t dataSize, const std::string& programPath) {
+    unmap();
+    path = filePath;
+
+    // 保留上一次启动器异常退出时留下的捕获文件
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0) {
+        std::rename(path.c_str(), (path + ".prev").c_str());
+    }
+
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        std::cerr << u8"无法创建映射捕获文件: " << path << std::endl;
+        return false;
+    }
+
+    size_t length = kCaptureHeaderSize + dataSize;
+#ifdef __linux__
+    // 预先分配磁盘空间，避免写入映射时因磁盘已满收到 SIGBUS
+    int allocResult = posix_fallocate(fd, 0, static_cast<off_t>(length));
+#else
+    int allocResult = ftruncate(fd, static_cast<off_t>(length));
+#endif
+    if (allocResult != 0) {
+        std::cerr << u8"无法为映射捕获文件分配空间: " << path << std::endl;
+        close(fd);
+        ::remove(path.c_str());
+        return false;
+    }
+
+    bool mapped = mapFile(fd, length, true);
+    close(fd);
+    if (!mapped) {
+        ::remove(path.c_str());
+        return false;
+    }
+
+    std::memset(fileHeader, 0, sizeof(CaptureFileHeader));
+    std::memcpy(fileHeader->magic, kCaptureMagic, sizeof(kCaptureMagic));
+    fileHeader->version = kCaptureVersion;
+    fileHeader->headerSize = kCaptureHeaderSize;
+    fileHeader->dataSize = dataSize;
+    fileHeader->createdUnixMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    fileHeader->launcherPid = static_cast<int32_t>(getpid());
+    std::strncpy(fileHeader->programPath, programPath.c_str(), sizeof(fileHeader->programPath) - 1);
+
+    ringBuffer.reset(new OutputRingBuffer(static_cast<char*>(mapping) + kCaptureHeaderSize,
+                                          dataSize, &fileHeader->ring));
+    return true;
+}
+
+bool MappedCaptureFile::openExisting(const std::string& filePath) {
+    unmap();
+    path = filePath;
+
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        std::cerr << u8"无法打开捕获文件: " << path << std::endl;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < kCaptureHeaderSize) {
+        std::cerr << u8"捕获文件不完整: " << path << std::endl;
+        close(fd);
+        return false;
+    }
+
+    // 私有映射：读取工具不会修改原文件
+    bool mapped = mapFile(fd, static_cast<size_t>(st.st_size), false);
+    close(fd);
+    if (!mapped) {
+        return false;
+    }
+
+    if (std::memcmp(fileHeader->magic, kCaptureMagic, sizeof(kCaptureMagic)) != 0 ||
+        fileHeader->version != kCaptureVersion ||
+        fileHeader->headerSize < sizeof(CaptureFileHeader) ||
+        fileHeader->headerSize + fileHeader->dataSize > mappingSize) {
+        std::cerr << u8"不是有效的捕获文件: " << path << std::endl;
+        unmap();
+        return false;
+    }
+
+    ringBuffer.reset(new OutputRingBuffer(static_cast<char*>(mapping) + fileHeader->headerSize,
+                                          static_cast<size_t>(fileHeader->dataSize), &fileHeader->ring));
+    return true;
+}
+
+void MappedCaptureFile::remove() {
+    unmap();
+    if (!path.empty()) {
+        ::remove(path.c_str());
+    }
+}
+
+void MappedCaptureFile::setChildPid(int pid) {
+    if (fileHeader) {
+        fileHeader->childPid = static_cast<int32_t>(pid);
+    }
+}
+
+bool MappedCaptureFile::mapFile(int fd, size_t length, bool writable) {
+    int flags = writable ? MAP_SHARED : MAP_PRIVATE;
+    void* address = mmap(nullptr, length, PROT_READ | PROT_WRITE, flags, fd, 0);
+    if (address == MAP_FAILED) {
+        std::cerr << u8"映射捕获文件失败: " << path << std::endl;
+        return false;
+    }
+
+    mapping = address;
+    mappingSize = length;
+    fileHeader = static_cast<CaptureFileHeader*>(mapping);
+    return true;
+}
+
+void MappedCaptureFile::unmap() {
+    ringBuffer.reset();
+    if (mapping) {
+        munmap(mapping, mappingSize);
+        mapping = nullptr;
+        mappingSize = 0;
+        fileHeader = nullptr;
+    }
+}
+
+#endif // _WIN32
@@ -0,0 +1,65 @@
+#ifndef MAPPED_CAPTURE_H
+#define MAPPED_CAPTURE_H
+
+#ifndef _WIN32
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "output_buffer.h"
+
+// 映射捕获文件的文件头，占用文件的第一页
+struct CaptureFileHeader {
+    char magic[8];              // "SCCAPT01"
+    uint32_t version;
+    uint32_t headerSize;        // 数据区在文件中的偏移
+    uint64_t dataSize;          // 数据区大小
+    int64_t createdUnixMs;
+    int32_t launcherPid;
+    int32_t childPid;
+    OutputRingState ring;       // 写入位置与回绕次数
+    char programPath[256];
+};
+
+// 预分配、内存映射的环形捕获文件。
+// 子进程输出直接写入共享映射，启动器本身不在堆上保留输出；
+// 即使启动器与子进程同时崩溃，内容也留在文件里，可以用 launch_capture_reader 读出。
+class MappedCaptureFile {
+public:
+    MappedCaptureFile() = default;
+    ~MappedCaptureFile();
+    MappedCaptureFile(const MappedCaptureFile&) = delete;
+    MappedCaptureFile& operator=(const MappedCaptureFile&) = delete;
+
+    // 创建并映射新的捕获文件；已有的文件会被改名为 <path>.prev 保留
+    bool create(const std::string& path, size_t dataSize, const std::string& programPath);
+
+    // 以只读方式打开一个已有的捕获文件
+    bool openExisting(const std::string& path);
+
+    // 删除捕获文件（程序正常结束时不再需要）
+    void remove();
+
+    void setChildPid(int pid);
+
+    bool isOpen() const { return mapping != nullptr; }
+    const CaptureFileHeader& header() const { return *fileHeader; }
+    OutputRingBuffer& ring() { return *ringBuffer; }
+    const OutputRingBuffer& ring() const { return *ringBuffer; }
+
+private:
+    bool mapFile(int fd, size_t length, bool writable);
+    void unmap();
+
+    std::string path;
+    void* mapping = nullptr;
+    size_t mappingSize = 0;
+    CaptureFileHeader* fileHeader = nullptr;
+    std::unique_ptr<OutputRingBuffer> ringBuffer;
+};
+
+#endif // _WIN32
+
+#endif // MAPPED_CAPTURE_H
@@ -0,0 +1,182 @@
+#include "notification.h"
+#include "system_info.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <csignal>
+    #include <fcntl.h>
+    #include <spawn.h>
+    #include <unistd.h>
+    #include <sys/socket.h>
+    #include <sys/un.h>
+    #include <sys/wait.h>
+
+    extern char** environ;
+#endif
+
+namespace {
+
+std::string notifySocketPath;
+std::string notifyLogFile = "launcher_notifications.log";
+
+#ifndef _WIN32
+std::vector<pid_t> dialogPids;
+
+bool hasGraphicalSession() {
+#ifdef __APPLE__
+    // 通过 SSH 登录且没有转发 X11 时无法连接窗口服务器
+    return !std::getenv("SSH_CONNECTION") || std::getenv("DISPLAY");
+#else
+    const char* x11 = std::getenv("DISPLAY");
+    const char* wayland = std::getenv("WAYLAND_DISPLAY");
+    return (x11 && *x11) || (wayland && *wayland);
+#endif
+}
+
+// 在 PATH 中查找并启动 args[0]，不等待其退出。找不到程序或无法启动时返回 false
+bool spawnDetached(const std::vector<std::string>& args) {
+    std::vector<char*> argv;
+    for (const std::string& arg : args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+
+    // 监管循环屏蔽了 SIGCHLD，对话框进程应恢复默认的信号掩码；
+    // 放入独立的进程组，终端上的 Ctrl+C 不会连带关闭对话框
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t emptyMask;
+    sigemptyset(&emptyMask);
+    posix_spawnattr_setsigmask(&attr, &emptyMask);
+    sigset_t defaultSignals;
+    sigemptyset(&defaultSignals);
+    sigaddset(&defaultSignals, SIGPIPE);
+    sigaddset(&defaultSignals, SIGCHLD);
+    posix_spawnattr_setsigdefault(&attr, &defaultSignals);
+    posix_spawnattr_setpgroup(&attr, 0);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETPGROUP);
+
+    pid_t pid = -1;
+    int error = posix_spawnp(&pid, argv[0], &actions, &attr, argv.data(), environ);
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+    if (error != 0) {
+        return false;
+    }
+    dialogPids.push_back(pid);
+    return true;
+}
+
+bool showDialog(const std::string& message, const std::string& title) {
+#ifdef __APPLE__
+    // 标题与内容作为脚本参数传入，无需转义
+    return spawnDetached({"osascript", "-e", "on run argv", "-e",
+                          "display alert (item 1 of argv) message (item 2 of argv) as critical", "-e", "end run",
+                          title, message});
+#else
+    return spawnDetached({"zenity", "--error", "--no-markup", "--title=" + title, "--text=" + message}) ||
+           spawnDetached({"kdialog", "--title", title, "--error", message}) ||
+           spawnDetached({"xmessage", "-center", title + "\n" + message});
+#endif
+}
+
+// 以非阻塞方式向通知套接字发送一个数据报，没有接收方时直接失败
+bool sendToSocket(const std::string& path, const std::string& text) {
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    if (path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size());
+
+    int fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+    if (fd == -1) {
+        return false;
+    }
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    ssize_t sent = sendto(fd, text.data(), text.size(), 0, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    close(fd);
+    return sent == static_cast<ssize_t>(text.size());
+}
+
+bool appendToLog(const std::string& file, const std::string& message, const std::string& title) {
+    std::ofstream log(file, std::ios::app);
+    if (!log.is_open()) {
+        return false;
+    }
+    log << "[" << getFormattedTime() << "] " << title << u8"：";
+    for (char c : message) {
+        log << c;
+        if (c == '\n') {
+            log << "    ";
+        }
+    }
+    log << "\n";
+    return true;
+}
+#endif
+
+} // namespace
+
+void configureNotifications(const std::string& socketPath, const std::string& logFile) {
+    notifySocketPath = socketPath;
+    notifyLogFile = logFile;
+}
+
+void ShowMessageBox(const std::string& message, const std::string& title) {
+#ifdef _WIN32
+    int len = MultiByteToWideChar(CP_UTF8, 0, message.c_str(), -1, NULL, 0);
+    std::wstring wMessage(len, 0);
+    MultiByteToWideChar(CP_UTF8, 0, message.c_str(), -1, &wMessage[0], len);
+
+    int len2 = MultiByteToWideChar(CP_UTF8, 0, title.c_str(), -1, NULL, 0);
+    std::wstring wTitle(len2, 0);
+    MultiByteToWideChar(CP_UTF8, 0, title.c_str(), -1, &wTitle[0], len2);
+
+    MessageBoxW(NULL, wMessage.c_str(), wTitle.c_str(), MB_OK | MB_ICONERROR);
+#else
+    reapNotifications();
+    if (hasGraphicalSession() && showDialog(message, title)) {
+        return;
+    }
+
+    // 无法弹窗：交给本地通知套接字的接收方，没有接收方时写入日志文件
+    std::string socketPath = notifySocketPath;
+    if (socketPath.empty() && std::getenv("SWARMCLONE_NOTIFY_SOCKET")) {
+        socketPath = std::getenv("SWARMCLONE_NOTIFY_SOCKET");
+    }
+    if (!socketPath.empty() && sendToSocket(socketPath, title + "\n" + message)) {
+        return;
+    }
+    if (!notifyLogFile.empty() && appendToLog(notifyLogFile, message, title)) {
+        std::cerr << u8"无法显示对话框，通知已写入 " << notifyLogFile << std::endl;
+    }
+#endif
+}
+
+void reapNotifications() {
+#ifndef _WIN32
+    for (size_t i = 0; i < dialogPids.size();) {
+        if (waitpid(dialogPids[i], nullptr, WNOHANG) != 0) {
+            dialogPids.erase(dialogPids.begin() + static_cast<std::ptrdiff_t>(i));
+        } else {
+            i++;
+        }
+    }
+#endif
+}
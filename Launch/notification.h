@@ -0,0 +1,22 @@
+#ifndef NOTIFICATION_H
+#define NOTIFICATION_H
+
+#include <string>
+
+// 崩溃与启动错误的用户通知。
+// Linux/macOS 上用 posix_spawn 以参数数组启动对话框程序（不经过 shell），启动后立即返回，不等待用户关闭，
+// 监管循环因此不会被阻塞；没有图形会话（未设置 DISPLAY/WAYLAND_DISPLAY）或找不到对话框程序时，
+// 通知改为发送到本地通知套接字（Unix 数据报套接字），未配置套接字时追加到通知日志文件。
+// Windows 上仍使用 MessageBox。
+
+// 设置无图形会话时的通知去向：socketPath 为空时使用环境变量 SWARMCLONE_NOTIFY_SOCKET，
+// 仍为空时写入 logFile
+void configureNotifications(const std::string& socketPath, const std::string& logFile);
+
+// 显示一条错误通知，不等待用户响应
+void ShowMessageBox(const std::string& message, const std::string& title);
+
+// 回收已关闭的对话框进程，不阻塞
+void reapNotifications();
+
+#endif // NOTIFICATION_H
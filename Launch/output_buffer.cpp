@@ -0,0 +1,129 @@
+#include "output_buffer.h"
+
+#include <atomic>
+#include <cstring>
+
+OutputRingBuffer::OutputRingBuffer(size_t capacity)
+    : ownedStorage(capacity), storage(ownedStorage.data()), cap(capacity), state(&ownedState) {}
+
+OutputRingBuffer::OutputRingBuffer(char* region, size_t capacity, OutputRingState* state)
+    : storage(region), cap(capacity), state(state) {}
+
+void OutputRingBuffer::clear() {
+    // 先让 tail 追上 head，读取方在任何时刻看到的都是空区间或完整记录
+    state->tail = state->head;
+    state->retained = 0;
+    state->total = 0;
+}
+
+void OutputRingBuffer::append(OutputStream stream, int64_t timestampNs, const char* data, size_t size) {
+    state->total += size;
+
+    const size_t headerSize = sizeof(RecordHeader);
+    if (cap < headerSize * 2 || size == 0) {
+        return;
+    }
+
+    // 单次写入超过容量时只需要保留最后一部分
+    if (size > cap - headerSize) {
+        data += size - (cap - headerSize);
+        size = cap - headerSize;
+    }
+
+    // 记录不跨越环尾，放不下时先用填充区占满剩余空间。
+    // 先推进 tail 再覆盖数据，最后才发布 head，这样任何时刻 [tail, head) 内的记录都是完整的
+    const size_t need = headerSize + size;
+    uint64_t head = state->head;
+    size_t padding = 0;
+    while (true) {
+        size_t offset = static_cast<size_t>(head % cap);
+        padding = (cap - offset < need) ? cap - offset : 0;
+        if (head + padding + need - state->tail <= cap) {
+            break;
+        }
+        if (state->tail == head) {
+            // 缓冲区已空，直接跳到环首
+            head += padding;
+            state->head = head;
+            state->tail = head;
+            state->wrapCount++;
+            continue;
+        }
+        evictOldest();
+    }
+
+    if (padding > 0) {
+        if (padding >= headerSize) {
+            RecordHeader pad{};
+            pad.size = static_cast<uint32_t>(padding - headerSize);
+            std::memcpy(storage + head % cap, &pad, headerSize);
+        }
+        head += padding;
+        state->wrapCount++;
+    }
+
+    RecordHeader header{};
+    header.size = static_cast<uint32_t>(size);
+    header.stream = static_cast<uint8_t>(stream);
+    header.timestampNs = timestampNs;
+    char* dest = storage + head % cap;
+    std::memcpy(dest, &header, headerSize);
+    std::memcpy(dest + headerSize, data, size);
+
+    std::atomic_thread_fence(std::memory_order_release);
+    state->retained += size;
+    state->head = head + need;
+}
+
+void OutputRingBuffer::evictOldest() {
+    const size_t headerSize = sizeof(RecordHeader);
+    size_t offset = static_cast<size_t>(state->tail % cap);
+
+    // 环尾剩余空间不足一个记录头时是隐式填充
+    if (cap - offset < headerSize) {
+        state->tail += cap - offset;
+        return;
+    }
+
+    RecordHeader header;
+    std::memcpy(&header, storage + offset, headerSize);
+    if (header.stream != 0) {
+        state->retained -= header.size;
+    }
+    state->tail += headerSize + header.size;
+}
+
+void OutputRingBuffer::forEachChunk(const std::function<void(const OutputChunk&)>& visitor) const {
+    const size_t headerSize = sizeof(RecordHeader);
+    if (cap < headerSize * 2) {
+        return;
+    }
+
+    uint64_t pos = state->tail;
+    const uint64_t head = state->head;
+    while (pos < head) {
+        size_t offset = static_cast<size_t>(pos % cap);
+        if (cap - offset < headerSize) {
+            pos += cap - offset;
+            continue;
+        }
+
+        RecordHeader header;
+        std::memcpy(&header, storage + offset, headerSize);
+        if (header.size > cap - offset - headerSize) {
+            break; // 记录头损坏（例如读取的是异常退出时留下的文件）
+        }
+        if (header.stream != 0) {
+            OutputChunk chunk{static_cast<OutputStream>(header.stream), header.timestampNs,
+                              storage + offset + headerSize, header.size};
+            visitor(chunk);
+        }
+        pos += headerSize + header.size;
+    }
+}
+
+void OutputRingBuffer::writeTo(std::ostream& out) const {
+    forEachChunk([&out](const OutputChunk& chunk) {
+        out.write(chunk.data, static_cast<std::streamsize>(chunk.size));
+    });
+}
@@ -0,0 +1,92 @@
+#ifndef OUTPUT_BUFFER_H
+#define OUTPUT_BUFFER_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <vector>
+
+// 输出来源
+enum class OutputStream : uint8_t {
+    Stdout = 1,
+    Stderr = 2,
+};
+
+// 单调时钟时间戳（纳秒），用于标记每段输出的到达时间
+inline int64_t monotonicNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 墙上时钟时间（Unix 毫秒），用于报告中的绝对时间
+inline int64_t unixMillis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// 一段带来源和时间戳的输出，data 指向缓冲区内部，仅在回调期间有效
+struct OutputChunk {
+    OutputStream stream;
+    int64_t timestampNs;
+    const char* data;
+    size_t size;
+};
+
+// 环形缓冲区的位置计数，全部为绝对偏移。
+// 映射到文件时这部分直接位于文件头中，启动器意外退出后仍可据此读出内容。
+struct OutputRingState {
+    uint64_t head;       // 下一条记录的写入位置
+    uint64_t tail;       // 最旧记录的位置
+    uint64_t retained;   // 当前保留的输出字节数（不含记录头）
+    uint64_t total;      // 累计写入的输出字节数
+    uint64_t wrapCount;  // 写入位置回绕到环首的次数
+};
+
+// 固定容量的环形缓冲区，只保留子进程最近输出的内容。
+// 每段输出连同来源和时间戳一起保存，空间不足时整段丢弃最旧的输出。
+// 存储可以由缓冲区自己分配，也可以是外部提供的内存（例如映射的捕获文件），
+// 两种情况下 append 都不会再分配内存。
+class OutputRingBuffer {
+public:
+    explicit OutputRingBuffer(size_t capacity);
+    OutputRingBuffer(char* region, size_t capacity, OutputRingState* state);
+    OutputRingBuffer(const OutputRingBuffer&) = delete;
+    OutputRingBuffer& operator=(const OutputRingBuffer&) = delete;
+
+    // 追加一段输出，超出容量时覆盖最旧的数据
+    void append(OutputStream stream, int64_t timestampNs, const char* data, size_t size);
+
+    // 丢弃全部内容并重新开始计数，用于子进程重启后
+    void clear();
+
+    // 按时间顺序遍历当前保留的每段输出
+    void forEachChunk(const std::function<void(const OutputChunk&)>& visitor) const;
+
+    // 按时间顺序写出当前保留的全部内容
+    void writeTo(std::ostream& out) const;
+
+    size_t capacity() const { return cap; }
+    size_t size() const { return static_cast<size_t>(state->retained); }
+    uint64_t totalBytes() const { return state->total; }
+    uint64_t droppedBytes() const { return state->total - state->retained; }
+
+private:
+    struct RecordHeader {
+        uint32_t size;      // 数据长度
+        uint8_t stream;     // 0 表示环尾的填充区
+        uint8_t reserved[3];
+        int64_t timestampNs;
+    };
+
+    void evictOldest();
+
+    std::vector<char> ownedStorage;
+    OutputRingState ownedState{};
+    char* storage;
+    size_t cap;
+    OutputRingState* state;
+};
+
+#endif // OUTPUT_BUFFER_H
@@ -0,0 +1,263 @@
+#include "output_tee.h"
+
+#ifndef _WIN32
+
+#include <iostream>
+
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+namespace {
+
+void writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written > 0) {
+            data += written;
+            size -= static_cast<size_t>(written);
+        } else if (written == -1 && errno == EINTR) {
+            continue;
+        } else if (written == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            pollfd pfd{fd, POLLOUT, 0};
+            poll(&pfd, 1, -1);
+        } else {
+            return;
+        }
+    }
+}
+
+#ifdef __linux__
+bool createTeePipe(int fds[2]) {
+    if (pipe2(fds, O_CLOEXEC) == -1) {
+        fds[0] = fds[1] = -1;
+        return false;
+    }
+    // 中间管道至少要能容纳一次读取的数据量
+    fcntl(fds[1], F_SETPIPE_SZ, 1024 * 1024);
+    return true;
+}
+#endif
+
+void closePipe(int fds[2]) {
+    for (int i = 0; i < 2; i++) {
+        if (fds[i] != -1) {
+            close(fds[i]);
+            fds[i] = -1;
+        }
+    }
+}
+
+} // namespace
+
+// ---------------- RollingCaptureFile ----------------
+
+RollingCaptureFile::~RollingCaptureFile() {
+    if (fd != -1) {
+        close(fd);
+    }
+}
+
+bool RollingCaptureFile::open(const std::string& filePath, size_t maxFileSize) {
+    path = filePath;
+    maxSize = maxFileSize;
+
+    // 保留上一次运行的捕获文件
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0 && st.st_size > 0) {
+        std::rename(path.c_str(), (path + ".1").c_str());
+    }
+
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        std::cerr << u8"无法创建输出捕获文件: " << path << std::endl;
+        return false;
+    }
+    offset = 0;
+    return true;
+}
+
+void RollingCaptureFile::write(const char* data, size_t size) {
+    if (fd == -1) {
+        return;
+    }
+    while (size > 0) {
+        ssize_t written = pwrite(fd, data, size, offset);
+        if (written > 0) {
+            data += written;
+            size -= static_cast<size_t>(written);
+            offset += written;
+        } else if (!(written == -1 && errno == EINTR)) {
+            break;
+        }
+    }
+    rotateIfNeeded();
+}
+
+size_t RollingCaptureFile::spliceFrom(int pipeFd, size_t size) {
+    size_t moved = 0;
+#ifdef __linux__
+    while (fd != -1 && moved < size) {
+        ssize_t result = splice(pipeFd, nullptr, fd, &offset, size - moved, SPLICE_F_MOVE);
+        if (result > 0) {
+            moved += static_cast<size_t>(result);
+        } else if (!(result == -1 && errno == EINTR)) {
+            break;
+        }
+    }
+    rotateIfNeeded();
+#else
+    (void)pipeFd;
+    (void)size;
+#endif
+    return moved;
+}
+
+void RollingCaptureFile::rotateIfNeeded() {
+    if (fd == -1 || maxSize == 0 || static_cast<size_t>(offset) < maxSize) {
+        return;
+    }
+
+    close(fd);
+    std::rename(path.c_str(), (path + ".1").c_str());
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    offset = 0;
+}
+
+// ---------------- PipeTee ----------------
+
+PipeTee::PipeTee(int consoleFd, RollingCaptureFile* capture, bool zeroCopy)
+    : consoleFd(consoleFd), capture(capture && capture->isOpen() ? capture : nullptr), zeroCopy(zeroCopy) {
+#ifdef __linux__
+    if (this->zeroCopy) {
+        bool ok = true;
+        if (consoleFd != -1) {
+            ok = createTeePipe(consolePipe) && ok;
+        }
+        if (this->capture) {
+            ok = createTeePipe(capturePipe) && ok;
+        }
+        if (!ok || (consoleFd == -1 && !this->capture)) {
+            this->zeroCopy = false;
+        }
+    }
+#else
+    this->zeroCopy = false;
+#endif
+}
+
+PipeTee::~PipeTee() {
+    closePipe(consolePipe);
+    closePipe(capturePipe);
+}
+
+ssize_t PipeTee::pump(int srcFd, char* buffer, size_t capacity) {
+    if (zeroCopy) {
+        ssize_t result = pumpZeroCopy(srcFd, buffer, capacity);
+        if (zeroCopy) {
+            return result;
+        }
+        // 源不是管道等原因导致 tee 不可用，改走普通路径
+    }
+
+    ssize_t bytesRead = read(srcFd, buffer, capacity);
+    if (bytesRead > 0) {
+        forward(buffer, static_cast<size_t>(bytesRead));
+    }
+    return bytesRead;
+}
+
+ssize_t PipeTee::pumpZeroCopy(int srcFd, char* buffer, size_t capacity) {
+#ifdef __linux__
+    // 先在内核中复制出转发用的副本（不消耗源管道），再把同样多的数据读到用户态
+    int firstPipe = (consoleFd != -1) ? consolePipe[1] : capturePipe[1];
+    ssize_t teed = tee(srcFd, firstPipe, capacity, SPLICE_F_NONBLOCK);
+    if (teed == -1) {
+        if (errno == EINVAL) {
+            zeroCopy = false;
+        }
+        return -1;
+    }
+    if (teed == 0) {
+        return read(srcFd, buffer, capacity); // 写端已关闭
+    }
+
+    size_t size = static_cast<size_t>(teed);
+    size_t captureTeed = 0;
+    if (capture) {
+        if (consoleFd != -1) {
+            ssize_t result = tee(srcFd, capturePipe[1], size, SPLICE_F_NONBLOCK);
+            captureTeed = result > 0 ? static_cast<size_t>(result) : 0;
+        } else {
+            captureTeed = size;
+        }
+    }
+
+    ssize_t bytesRead;
+    do {
+        bytesRead = read(srcFd, buffer, size);
+    } while (bytesRead == -1 && errno == EINTR);
+
+    if (consoleFd != -1) {
+        size_t sent = 0;
+        while (consoleSplice && sent < size) {
+            ssize_t result = splice(consolePipe[0], nullptr, consoleFd, nullptr, size - sent, SPLICE_F_MOVE);
+            if (result > 0) {
+                sent += static_cast<size_t>(result);
+            } else if (!(result == -1 && errno == EINTR)) {
+                consoleSplice = false; // 控制台不支持 splice
+            }
+        }
+        if (sent < size) {
+            discardPipe(consolePipe[0], size - sent);
+            if (bytesRead > 0 && sent < static_cast<size_t>(bytesRead)) {
+                writeAll(consoleFd, buffer + sent, static_cast<size_t>(bytesRead) - sent);
+            }
+        }
+    }
+
+    if (capture) {
+        size_t moved = capture->spliceFrom(capturePipe[0], captureTeed);
+        if (moved < captureTeed) {
+            discardPipe(capturePipe[0], captureTeed - moved);
+        }
+        if (bytesRead > 0 && moved < static_cast<size_t>(bytesRead)) {
+            capture->write(buffer + moved, static_cast<size_t>(bytesRead) - moved);
+        }
+    }
+
+    return bytesRead;
+#else
+    (void)srcFd;
+    (void)buffer;
+    (void)capacity;
+    zeroCopy = false;
+    return -1;
+#endif
+}
+
+void PipeTee::forward(const char* data, size_t size) {
+    if (consoleFd != -1) {
+        writeAll(consoleFd, data, size);
+    }
+    if (capture) {
+        capture->write(data, size);
+    }
+}
+
+void PipeTee::discardPipe(int pipeFd, size_t size) {
+    char scratch[4096];
+    while (size > 0) {
+        ssize_t result = read(pipeFd, scratch, size < sizeof(scratch) ? size : sizeof(scratch));
+        if (result > 0) {
+            size -= static_cast<size_t>(result);
+        } else if (!(result == -1 && errno == EINTR)) {
+            return;
+        }
+    }
+}
+
+#endif // _WIN32
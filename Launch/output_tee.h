@@ -0,0 +1,65 @@
+#ifndef OUTPUT_TEE_H
+#define OUTPUT_TEE_H
+
+#ifndef _WIN32
+
+#include <cstddef>
+#include <string>
+
+#include <sys/types.h>
+
+// 滚动捕获文件：超过 maxSize 后把当前文件改名为 <path>.1 并重新开始写入
+class RollingCaptureFile {
+public:
+    RollingCaptureFile() = default;
+    ~RollingCaptureFile();
+    RollingCaptureFile(const RollingCaptureFile&) = delete;
+    RollingCaptureFile& operator=(const RollingCaptureFile&) = delete;
+
+    bool open(const std::string& path, size_t maxSize);
+    bool isOpen() const { return fd != -1; }
+
+    void write(const char* data, size_t size);
+
+    // 把管道 pipeFd 中的 size 字节直接搬运到文件，不经过用户态；返回实际写入的字节数
+    size_t spliceFrom(int pipeFd, size_t size);
+
+private:
+    void rotateIfNeeded();
+
+    std::string path;
+    size_t maxSize = 0;
+    int fd = -1;
+    off_t offset = 0;  // 不能用 O_APPEND，splice 不支持追加模式的目标文件
+};
+
+// 把子进程的一个输出管道同时转发到控制台和捕获文件。
+// Linux 上使用 tee(2)/splice(2) 在内核中完成转发，只有崩溃日志需要的那份数据会复制到用户态；
+// 不支持时退回到 read + write。
+class PipeTee {
+public:
+    PipeTee(int consoleFd, RollingCaptureFile* capture, bool zeroCopy);
+    ~PipeTee();
+    PipeTee(const PipeTee&) = delete;
+    PipeTee& operator=(const PipeTee&) = delete;
+
+    // 从 srcFd 读取最多 capacity 字节到 buffer，并把相同的数据转发出去。
+    // 返回值与 read(2) 相同
+    ssize_t pump(int srcFd, char* buffer, size_t capacity);
+
+private:
+    ssize_t pumpZeroCopy(int srcFd, char* buffer, size_t capacity);
+    void forward(const char* data, size_t size);
+    void discardPipe(int pipeFd, size_t size);
+
+    int consoleFd;
+    RollingCaptureFile* capture;
+    bool zeroCopy;
+    bool consoleSplice = true;   // 控制台不支持 splice 时（例如部分终端）改为 write
+    int consolePipe[2] = {-1, -1};
+    int capturePipe[2] = {-1, -1};
+};
+
+#endif // _WIN32
+
+#endif // OUTPUT_TEE_H
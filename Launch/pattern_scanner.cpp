@@ -0,0 +1,444 @@
+#include "pattern_scanner.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define PATTERN_SCANNER_X86 1
+    #include <immintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+        #define TARGET_AVX2
+    #else
+        #define TARGET_AVX2 __attribute__((target("avx2")))
+    #endif
+#endif
+
+namespace {
+
+const size_t kContextLines = 2;       // 匹配行之前保留的行数
+const size_t kFollowLines = 3;        // 匹配行之后保留的行数，之后的行再次匹配时重新计数
+const size_t kRecentBytes = 1024;
+const size_t kMaxHighlightBytes = 8 * 1024;
+
+// 字节在一般文本输出中的常见程度，越小越常见
+int byteRank(unsigned char c) {
+    if (c == ' ') {
+        return 0;
+    }
+    if (std::strchr("etaoinsrhl", c) != nullptr && c != '\0') {
+        return 1;
+    }
+    if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9')) {
+        return 2;
+    }
+    return 3;
+}
+
+inline unsigned countTrailingZeros(uint32_t mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+using Literal = PatternScanner::Literal;
+
+bool matchesAt(const char* data, size_t size, size_t position, const Literal& literal) {
+    return position + literal.text.size() <= size &&
+           std::memcmp(data + position, literal.text.data(), literal.text.size()) == 0;
+}
+
+// 从 position 起逐字节查找，用于不支持 SIMD 的平台与数据末尾不足一个向量的部分
+size_t findScalar(const std::vector<Literal>& literals, const char* data, size_t size, size_t position,
+                  size_t& pattern) {
+    for (; position < size; position++) {
+        for (size_t i = 0; i < literals.size(); i++) {
+            const Literal& literal = literals[i];
+            if (position + literal.text.size() <= size &&
+                data[position + literal.anchor1] == literal.text[literal.anchor1] &&
+                data[position + literal.anchor2] == literal.text[literal.anchor2] &&
+                matchesAt(data, size, position, literal)) {
+                pattern = i;
+                return position;
+            }
+        }
+    }
+    return size;
+}
+
+#ifdef PATTERN_SCANNER_X86
+// 在 mask 标出的候选位置中找出最早的完整匹配，best 为目前找到的最早位置（相对于 base）
+inline void verifyCandidates(uint32_t mask, const char* data, size_t size, size_t base, const Literal& literal,
+                             size_t index, size_t& best, size_t& pattern) {
+    while (mask != 0) {
+        size_t offset = countTrailingZeros(mask);
+        if (offset >= best) {
+            return;
+        }
+        if (matchesAt(data, size, base + offset, literal)) {
+            best = offset;
+            pattern = index;
+            return;
+        }
+        mask &= mask - 1;
+    }
+}
+
+size_t findSse2(const std::vector<Literal>& literals, size_t reach, const char* data, size_t size, size_t& pattern) {
+    __m128i first[PatternScanner::kMaxPatterns];
+    __m128i second[PatternScanner::kMaxPatterns];
+    for (size_t i = 0; i < literals.size(); i++) {
+        first[i] = _mm_set1_epi8(literals[i].text[literals[i].anchor1]);
+        second[i] = _mm_set1_epi8(literals[i].text[literals[i].anchor2]);
+    }
+    size_t position = 0;
+    for (; position + 16 + reach <= size; position += 16) {
+        // 先只比较锚点，合并全部模式后取一次掩码，都没有候选时（绝大多数情况）直接进入下一块
+        __m128i both[PatternScanner::kMaxPatterns];
+        __m128i any = _mm_setzero_si128();
+        for (size_t i = 0; i < literals.size(); i++) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + position + literals[i].anchor1));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + position + literals[i].anchor2));
+            both[i] = _mm_and_si128(_mm_cmpeq_epi8(a, first[i]), _mm_cmpeq_epi8(b, second[i]));
+            any = _mm_or_si128(any, both[i]);
+        }
+        if (_mm_movemask_epi8(any) == 0) {
+            continue;
+        }
+        size_t best = 16;
+        for (size_t i = 0; i < literals.size(); i++) {
+            uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(both[i]));
+            verifyCandidates(mask, data, size, position, literals[i], i, best, pattern);
+        }
+        if (best < 16) {
+            return position + best;
+        }
+    }
+    return findScalar(literals, data, size, position, pattern);
+}
+
+// 每次处理 32 个位置：data[position + j] 与 data[position + j + 1] 是否可能是某个模式的锚点对。
+// 候选位置 j 对应的模式起点为 position + j - anchor1，因此找到匹配后还要继续扫描 reach 个字节，
+// 锚点更靠后的模式可能从更早的位置开始
+TARGET_AVX2
+size_t findAvx2(const std::vector<Literal>& literals, const PatternScanner::PairFilter& filter, size_t reach,
+                const char* data, size_t size, size_t& pattern) {
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    __m256i low[2];
+    __m256i high[2];
+    for (int k = 0; k < 2; k++) {
+        low[k] = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(filter.low[k])));
+        high[k] = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(filter.high[k])));
+    }
+    size_t best = size;
+    size_t position = 0;
+    for (; position + 33 <= size; position += 32) {
+        if (best != size && position > best + reach) {
+            return best;
+        }
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + position));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + position + 1));
+        __m256i lowA = _mm256_shuffle_epi8(low[0], _mm256_and_si256(a, nibble));
+        __m256i highA = _mm256_shuffle_epi8(high[0], _mm256_and_si256(_mm256_srli_epi16(a, 4), nibble));
+        __m256i lowB = _mm256_shuffle_epi8(low[1], _mm256_and_si256(b, nibble));
+        __m256i highB = _mm256_shuffle_epi8(high[1], _mm256_and_si256(_mm256_srli_epi16(b, 4), nibble));
+        __m256i buckets = _mm256_and_si256(_mm256_and_si256(lowA, highA), _mm256_and_si256(lowB, highB));
+        __m256i none = _mm256_cmpeq_epi8(buckets, _mm256_setzero_si256());
+        uint32_t candidates = ~static_cast<uint32_t>(_mm256_movemask_epi8(none));
+        if (candidates == 0) {
+            continue;
+        }
+        alignas(32) uint8_t bits[32];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(bits), buckets);
+        while (candidates != 0) {
+            size_t offset = countTrailingZeros(candidates);
+            candidates &= candidates - 1;
+            for (uint32_t bucketBits = bits[offset]; bucketBits != 0; bucketBits &= bucketBits - 1) {
+                uint32_t members = filter.buckets[countTrailingZeros(bucketBits)];
+                for (; members != 0; members &= members - 1) {
+                    size_t index = countTrailingZeros(members);
+                    const Literal& literal = literals[index];
+                    if (position + offset < literal.anchor1) {
+                        continue;
+                    }
+                    size_t start = position + offset - literal.anchor1;
+                    if (start < best && matchesAt(data, size, start, literal)) {
+                        best = start;
+                        pattern = index;
+                    }
+                }
+            }
+        }
+    }
+    // 末尾不足一块的部分逐字节查找，起点可能比已扫描的位置早 reach 个字节
+    size_t tailPattern = 0;
+    size_t tail = findScalar(literals, data, size, position > reach ? position - reach : 0, tailPattern);
+    if (tail < best) {
+        best = tail;
+        pattern = tailPattern;
+    }
+    return best;
+}
+
+bool cpuHasAvx2() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    return osSavesYmm && (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+} // namespace
+
+std::vector<std::string> defaultHighlightPatterns() {
+    return {"Exception", "Unhandled", "FATAL", "Traceback", "\n   at ", "\n\tat "};
+}
+
+PatternScanner::PatternScanner(const std::vector<std::string>& patterns) {
+    for (const std::string& text : patterns) {
+        if (text.empty()) {
+            continue;
+        }
+        if (literals.size() == kMaxPatterns) {
+            std::cerr << u8"摘要模式超过 " << kMaxPatterns << u8" 个，其余已忽略" << std::endl;
+            break;
+        }
+        // 锚点取常见程度之和最小的一对相邻字节，相同时取靠前的
+        Literal literal;
+        literal.text = text;
+        int bestRank = -1;
+        for (size_t i = 0; i == 0 || i + 1 < text.size(); i++) {
+            int rank = byteRank(static_cast<unsigned char>(text[i]));
+            if (i + 1 < text.size()) {
+                rank += byteRank(static_cast<unsigned char>(text[i + 1]));
+            }
+            if (rank > bestRank) {
+                literal.anchor1 = i;
+                bestRank = rank;
+            }
+        }
+        literal.anchor2 = std::min(literal.anchor1 + 1, text.size() - 1);
+
+        // 模式 i 放入第 i % 8 个桶；只有一个字节的模式对锚点对的第二个字节不设限制
+        uint8_t bucket = static_cast<uint8_t>(1u << (literals.size() % 8));
+        filter.buckets[literals.size() % 8] |= static_cast<uint16_t>(1u << literals.size());
+        for (int k = 0; k < 2; k++) {
+            if (k == 1 && text.size() == 1) {
+                for (int n = 0; n < 16; n++) {
+                    filter.low[1][n] |= bucket;
+                    filter.high[1][n] |= bucket;
+                }
+                continue;
+            }
+            unsigned char byte = static_cast<unsigned char>(text[literal.anchor1 + k]);
+            filter.low[k][byte & 0x0f] |= bucket;
+            filter.high[k][byte >> 4] |= bucket;
+        }
+        longest = std::max(longest, text.size());
+        reach = std::max(reach, std::max(literal.anchor1, literal.anchor2));
+        literals.push_back(std::move(literal));
+    }
+
+#ifdef PATTERN_SCANNER_X86
+    level = cpuHasAvx2() ? 2 : 1;
+#endif
+}
+
+size_t PatternScanner::find(const char* data, size_t size, size_t& pattern) const {
+    if (literals.empty()) {
+        return size;
+    }
+#ifdef PATTERN_SCANNER_X86
+    if (level == 2) {
+        return findAvx2(literals, filter, reach, data, size, pattern);
+    }
+    if (level == 1) {
+        return findSse2(literals, reach, data, size, pattern);
+    }
+#endif
+    return findScalar(literals, data, size, 0, pattern);
+}
+
+const char* PatternScanner::implementation() const {
+    return level == 2 ? "avx2" : level == 1 ? "sse2" : "scalar";
+}
+
+OutputHighlights::OutputHighlights(const std::vector<std::string>& patterns, size_t capacity)
+    : scanner(patterns), capacity(capacity) {
+}
+
+void OutputHighlights::scan(const OutputChunk& chunk) {
+    if (scanner.empty() || chunk.size == 0) {
+        return;
+    }
+    StreamState& state = streams[chunk.stream == OutputStream::Stderr ? 1 : 0];
+    const char* data = chunk.data;
+    size_t size = chunk.size;
+    size_t position = 0;
+
+    if (state.active) {
+        position = follow(state, data, size);
+    } else if (scanner.maxLength() > 1 && !state.recent.empty()) {
+        // 跨越上一段末尾与本段开头的匹配
+        size_t keep = std::min(state.recent.size(), scanner.maxLength() - 1);
+        std::string joined = state.recent.substr(state.recent.size() - keep);
+        joined.append(data, std::min(size, scanner.maxLength() - 1));
+        size_t from = 0;
+        while (from < keep) {
+            size_t pattern = 0;
+            size_t at = from + scanner.find(joined.data() + from, joined.size() - from, pattern);
+            if (at >= keep) {
+                break;
+            }
+            if (at + scanner.pattern(pattern).size() > keep) {
+                startHighlight(state, chunk, 0, pattern);
+                position = follow(state, data, size);
+                break;
+            }
+            from = at + 1;
+        }
+    }
+
+    while (!state.active && position < size) {
+        size_t pattern = 0;
+        size_t at = position + scanner.find(data + position, size - position, pattern);
+        if (at >= size) {
+            break;
+        }
+        // 以换行开头的模式（栈帧）所在的行从换行之后开始
+        size_t lineStart = at;
+        while (lineStart < size && data[lineStart] == '\n') {
+            lineStart++;
+        }
+        while (lineStart > 0 && data[lineStart - 1] != '\n') {
+            lineStart--;
+        }
+        startHighlight(state, chunk, lineStart, pattern);
+        position = lineStart + follow(state, data + lineStart, size - lineStart);
+    }
+
+    remember(state, data, size);
+}
+
+void OutputHighlights::startHighlight(StreamState& state, const OutputChunk& chunk, size_t lineStart,
+                                      size_t pattern) {
+    matches++;
+    // 匹配行之前的 kContextLines 行：取自本段中匹配行之前的部分，不够时加上之前保存的输出
+    std::string before;
+    if (lineStart < kRecentBytes) {
+        before = state.recent;
+    }
+    size_t window = std::min(lineStart, kRecentBytes);
+    before.append(chunk.data + lineStart - window, window);
+    size_t start = before.size();
+    size_t newlines = 0;
+    while (start > 0) {
+        if (before[start - 1] == '\n') {
+            if (newlines == kContextLines) {
+                break;
+            }
+            newlines++;
+        }
+        start--;
+    }
+
+    state.active = true;
+    state.followLines = kFollowLines + 1;  // 包括匹配行自身的换行
+    state.building.stream = chunk.stream;
+    state.building.timestampNs = chunk.timestampNs;
+    state.building.pattern = scanner.pattern(pattern);
+    state.building.text.assign(before, start, std::string::npos);
+}
+
+size_t OutputHighlights::follow(StreamState& state, const char* data, size_t size) {
+    size_t position = 0;
+    while (position < size && state.followLines > 0) {
+        const char* newline = static_cast<const char*>(std::memchr(data + position, '\n', size - position));
+        size_t lineEnd = newline ? static_cast<size_t>(newline - data) + 1 : size;
+        std::string& text = state.building.text;
+        if (text.size() < kMaxHighlightBytes) {
+            text.append(data + position, std::min(lineEnd - position, kMaxHighlightBytes - text.size()));
+            // 一行可能分几段到达，行完整后从上一行的换行开始检查，以换行开头的模式才能匹配
+            size_t checkFrom = text.size() >= 2 ? text.rfind('\n', text.size() - 2) : std::string::npos;
+            checkFrom = checkFrom == std::string::npos ? 0 : checkFrom;
+            size_t pattern = 0;
+            if (newline && state.followLines <= kFollowLines &&
+                scanner.find(text.data() + checkFrom, text.size() - checkFrom, pattern) < text.size() - checkFrom) {
+                // 后续行再次匹配（例如下一个栈帧），重新计数
+                matches++;
+                state.followLines = kFollowLines + 1;
+            }
+        }
+        if (newline) {
+            state.followLines--;
+        }
+        position = lineEnd;
+    }
+    if (state.followLines == 0) {
+        finish(state);
+    }
+    return position;
+}
+
+void OutputHighlights::finish(StreamState& state) {
+    state.active = false;
+    stored += state.building.text.size();
+    completed.push_back(std::move(state.building));
+    state.building = OutputHighlight();
+    while (stored > capacity && completed.size() > 1) {
+        stored -= completed.front().text.size();
+        completed.pop_front();
+        dropped++;
+    }
+}
+
+void OutputHighlights::remember(StreamState& state, const char* data, size_t size) {
+    if (size >= kRecentBytes) {
+        state.recent.assign(data + size - kRecentBytes, kRecentBytes);
+        return;
+    }
+    state.recent.append(data, size);
+    if (state.recent.size() > kRecentBytes) {
+        state.recent.erase(0, state.recent.size() - kRecentBytes);
+    }
+}
+
+void OutputHighlights::clear() {
+    completed.clear();
+    stored = 0;
+    matches = 0;
+    dropped = 0;
+    for (StreamState& state : streams) {
+        state = StreamState();
+    }
+}
+
+std::vector<const OutputHighlight*> OutputHighlights::highlights() const {
+    std::vector<const OutputHighlight*> result;
+    for (const OutputHighlight& highlight : completed) {
+        result.push_back(&highlight);
+    }
+    for (const StreamState& state : streams) {
+        if (state.active) {
+            result.push_back(&state.building);
+        }
+    }
+    std::stable_sort(result.begin(), result.end(), [](const OutputHighlight* a, const OutputHighlight* b) {
+        return a->timestampNs < b->timestampNs;
+    });
+    return result;
+}
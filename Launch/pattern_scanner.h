@@ -0,0 +1,104 @@
+#ifndef PATTERN_SCANNER_H
+#define PATTERN_SCANNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "output_buffer.h"
+
+// 崩溃摘要缺省查找的模式：异常、致命错误、Python Traceback，以及 .NET（"   at "）与 Java（"\tat "）的栈帧
+std::vector<std::string> defaultHighlightPatterns();
+
+// 同时查找多个字面量。每个模式取最不常见的一对相邻字节作为锚点，锚点都相等的位置再完整比较。
+// AVX2 实现对所有模式只加载两次（锚点对的两个字节）：按半字节查表得到每个位置可能匹配的桶，
+// 全部模式共用这次预筛；SSE2 实现每个模式比较一次锚点。运行时按 CPU 选择 AVX2、SSE2 或逐字节实现
+class PatternScanner {
+public:
+    static constexpr size_t kMaxPatterns = 16;
+
+    explicit PatternScanner(const std::vector<std::string>& patterns);
+
+    // data 中最早的匹配位置，pattern 为匹配的模式下标；没有匹配时返回 size
+    size_t find(const char* data, size_t size, size_t& pattern) const;
+
+    const std::string& pattern(size_t index) const { return literals[index].text; }
+    size_t maxLength() const { return longest; }
+    bool empty() const { return literals.empty(); }
+
+    // 当前使用的实现："avx2"、"sse2" 或 "scalar"
+    const char* implementation() const;
+
+    struct Literal {
+        std::string text;
+        size_t anchor1 = 0;  // 两个锚点在模式中的偏移，anchor2 为 anchor1 + 1（只有一个字节的模式两者相同）
+        size_t anchor2 = 0;
+    };
+
+    // AVX2 预筛表：锚点对的两个字节分别按低、高半字节查表，得到可能匹配的桶（每桶一位），
+    // 两者相与后仍非零的位置再验证桶中的模式。不足 8 个模式时每个模式独占一个桶，预筛是精确的
+    struct PairFilter {
+        uint8_t low[2][16] = {};
+        uint8_t high[2][16] = {};
+        uint16_t buckets[8] = {};  // 每个桶中的模式下标（按位）
+    };
+
+private:
+    std::vector<Literal> literals;
+    PairFilter filter;
+    size_t longest = 0;
+    size_t reach = 0;        // 锚点的最大偏移
+    int level = 0;           // 0 逐字节，1 SSE2，2 AVX2
+};
+
+// 输出中一处匹配及其上下文：匹配行之前的几行、匹配行，以及之后的几行（之后的行再次匹配时继续延长，
+// 因此整段栈回溯会归入同一条摘要）
+struct OutputHighlight {
+    OutputStream stream = OutputStream::Stdout;
+    int64_t timestampNs = 0;
+    std::string pattern;
+    std::string text;
+};
+
+// 在捕获路径上逐段扫描子进程输出，只保留最近的若干条摘要，总大小不超过 capacity 字节。
+// 没有匹配时每段输出只做一次 SIMD 扫描并更新末尾 1 KB 的上下文，不复制整段数据
+class OutputHighlights {
+public:
+    explicit OutputHighlights(const std::vector<std::string>& patterns, size_t capacity = 64 * 1024);
+
+    void scan(const OutputChunk& chunk);
+
+    // 子进程重启后丢弃全部摘要
+    void clear();
+
+    // 按时间顺序的全部摘要，包括仍在收集后续行的
+    std::vector<const OutputHighlight*> highlights() const;
+    uint64_t matchCount() const { return matches; }
+    uint64_t droppedCount() const { return dropped; }
+    bool enabled() const { return !scanner.empty(); }
+
+private:
+    struct StreamState {
+        std::string recent;       // 最近的输出，用于匹配之前的上下文与跨段的匹配
+        bool active = false;      // building 是否仍在收集后续行
+        size_t followLines = 0;   // 还需收集的换行数
+        OutputHighlight building;
+    };
+
+    void startHighlight(StreamState& state, const OutputChunk& chunk, size_t lineStart, size_t pattern);
+    size_t follow(StreamState& state, const char* data, size_t size);
+    void finish(StreamState& state);
+    void remember(StreamState& state, const char* data, size_t size);
+
+    PatternScanner scanner;
+    size_t capacity;
+    size_t stored = 0;
+    std::deque<OutputHighlight> completed;
+    StreamState streams[2];  // stdout、stderr
+    uint64_t matches = 0;
+    uint64_t dropped = 0;
+};
+
+#endif // PATTERN_SCANNER_H
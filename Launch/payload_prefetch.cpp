@@ -0,0 +1,331 @@
+#include "payload_prefetch.h"
+
+#include <iostream>
+
+#include "output_buffer.h"
+
+#ifdef __linux__
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+
+// 驻留区间之间的空洞小于这么多页时合并，减少清单条目与 fadvise 调用次数
+const uint64_t kMergeGapPages = 16;
+
+void walkDirectory(const std::string& root, const std::string& relative, std::vector<std::pair<std::string, uint64_t>>& files) {
+    std::string path = relative.empty() ? root : root + "/" + relative;
+    DIR* dir = opendir(path.c_str());
+    if (!dir) {
+        return;
+    }
+    while (dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name == "." || name == ".." || name.find('\n') != std::string::npos) {
+            continue;
+        }
+        std::string child = relative.empty() ? name : relative + "/" + name;
+        struct stat info;
+        if (lstat((root + "/" + child).c_str(), &info) != 0) {
+            continue;
+        }
+        if (S_ISDIR(info.st_mode)) {
+            walkDirectory(root, child, files);
+        } else if (S_ISREG(info.st_mode) && info.st_size > 0) {
+            files.emplace_back(child, static_cast<uint64_t>(info.st_size));
+        }
+    }
+    closedir(dir);
+}
+
+bool statFile(const std::string& path, uint64_t& size, int64_t& mtimeNs) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        return false;
+    }
+    size = static_cast<uint64_t>(info.st_size);
+    mtimeNs = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+    return true;
+}
+
+// 用 mincore 找出文件中驻留在页缓存里的区间；映射文件本身不会读入任何页
+bool residentRanges(const std::string& path, uint64_t size, std::vector<std::pair<uint64_t, uint64_t>>& ranges) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return false;
+    }
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    const uint64_t pageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    std::vector<unsigned char> resident((size + pageSize - 1) / pageSize);
+    bool ok = mincore(mapping, size, resident.data()) == 0;
+    munmap(mapping, size);
+    if (!ok) {
+        return false;
+    }
+
+    uint64_t runStart = 0;
+    uint64_t runEnd = 0;  // 以页为单位，runEnd == runStart 表示当前没有区间
+    for (uint64_t page = 0; page < resident.size(); page++) {
+        if (!(resident[page] & 1)) {
+            continue;
+        }
+        if (runEnd > runStart && page - runEnd <= kMergeGapPages) {
+            runEnd = page + 1;
+            continue;
+        }
+        if (runEnd > runStart) {
+            ranges.emplace_back(runStart * pageSize, (runEnd - runStart) * pageSize);
+        }
+        runStart = page;
+        runEnd = page + 1;
+    }
+    if (runEnd > runStart) {
+        ranges.emplace_back(runStart * pageSize, std::min(size, runEnd * pageSize) - runStart * pageSize);
+    }
+    return true;
+}
+
+} // namespace
+
+std::vector<PrefetchRange> listPayloadFiles(const std::string& payloadDir, const std::string& programName) {
+    std::vector<std::pair<std::string, uint64_t>> files;
+    walkDirectory(payloadDir, "", files);
+    // 程序本身在 exec 时最先被读取，其余文件按大小降序，让大文件尽早开始预读
+    std::sort(files.begin(), files.end(), [&programName](const std::pair<std::string, uint64_t>& a,
+                                                         const std::pair<std::string, uint64_t>& b) {
+        if ((a.first == programName) != (b.first == programName)) {
+            return a.first == programName;
+        }
+        return a.second > b.second;
+    });
+    std::vector<PrefetchRange> ranges;
+    for (const auto& file : files) {
+        PrefetchRange range;
+        range.path = payloadDir + "/" + file.first;
+        ranges.push_back(range);
+    }
+    return ranges;
+}
+
+uint64_t adviseWillNeed(const PrefetchRange& range) {
+    int fd = open(range.path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return 0;
+    }
+    uint64_t length = range.length;
+    if (length == 0) {
+        struct stat info;
+        length = fstat(fd, &info) == 0 && static_cast<uint64_t>(info.st_size) > range.offset ?
+                 static_cast<uint64_t>(info.st_size) - range.offset : 0;
+    }
+    // WILLNEED 在内核中发起与 readahead(2) 相同的预读，提交 I/O 后即返回，不把数据复制到用户态
+    int result = posix_fadvise(fd, static_cast<off_t>(range.offset), static_cast<off_t>(length), POSIX_FADV_WILLNEED);
+    close(fd);
+    return result == 0 ? length : 0;
+}
+
+bool loadPrefetchManifest(const std::string& manifestPath, const std::string& payloadDir,
+                          PrefetchManifest& manifest) {
+    std::ifstream file(manifestPath);
+    if (!file.is_open()) {
+        return false;
+    }
+    PrefetchManifest loaded;
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) {
+            continue;
+        }
+        std::string name = line.substr(0, eq);
+        std::istringstream value(line.substr(eq + 1));
+        if (name == "file") {
+            loaded.files.emplace_back();
+            loaded.files.back().path = line.substr(eq + 1);
+        } else if (loaded.files.empty()) {
+            continue;
+        } else if (name == "stat") {
+            value >> loaded.files.back().size >> loaded.files.back().mtime;
+        } else if (name == "range") {
+            uint64_t offset = 0;
+            uint64_t length = 0;
+            if (value >> offset >> length) {
+                loaded.files.back().ranges.emplace_back(offset, length);
+            }
+        }
+    }
+    if (loaded.files.empty()) {
+        return false;
+    }
+
+    // 载荷更新后旧清单中的偏移没有意义，任一文件变化都重新记录
+    for (const PrefetchManifest::File& entry : loaded.files) {
+        uint64_t size;
+        int64_t mtime;
+        if (!statFile(payloadDir + "/" + entry.path, size, mtime) || size != entry.size || mtime != entry.mtime) {
+            return false;
+        }
+    }
+    manifest = std::move(loaded);
+    return true;
+}
+
+bool recordPrefetchManifest(const std::string& manifestPath, const std::string& payloadDir) {
+    std::vector<std::pair<std::string, uint64_t>> files;
+    walkDirectory(payloadDir, "", files);
+
+    std::string tempPath = manifestPath + ".tmp";
+    {
+        std::ofstream file(tempPath);
+        if (!file.is_open()) {
+            return false;
+        }
+        for (const auto& entry : files) {
+            std::string path = payloadDir + "/" + entry.first;
+            uint64_t size;
+            int64_t mtime;
+            std::vector<std::pair<uint64_t, uint64_t>> ranges;
+            if (!statFile(path, size, mtime) || !residentRanges(path, size, ranges)) {
+                continue;
+            }
+            // 没有驻留页的文件也记录下来，用于检测载荷是否更新
+            file << "file=" << entry.first << "\n";
+            file << "stat=" << size << " " << mtime << "\n";
+            for (const auto& range : ranges) {
+                file << "range=" << range.first << " " << range.second << "\n";
+            }
+        }
+        if (!file.good()) {
+            return false;
+        }
+    }
+    // rename 原子地替换旧清单，失败时旧清单仍然完整
+    return std::rename(tempPath.c_str(), manifestPath.c_str()) == 0;
+}
+
+PayloadPrefetcher::PayloadPrefetcher(const std::string& payloadDir, const std::string& programName,
+                                     const LaunchOptions& options)
+    : payloadDir(payloadDir), manifestPath(options.prefetchManifest) {
+    if (options.prefetchMode == PrefetchMode::Off) {
+        return;
+    }
+    startNs = monotonicNanos();
+
+    PrefetchManifest manifest;
+    if (options.prefetchMode == PrefetchMode::Auto && loadPrefetchManifest(manifestPath, payloadDir, manifest)) {
+        for (const PrefetchManifest::File& file : manifest.files) {
+            for (const auto& range : file.ranges) {
+                PrefetchRange item;
+                item.path = payloadDir + "/" + file.path;
+                item.offset = range.first;
+                item.length = range.second;
+                work.push_back(item);
+            }
+        }
+    } else if (options.prefetchMode == PrefetchMode::Auto) {
+        // 没有可用的清单：本次不预读，避免把整个目录读入后无法区分哪些页是启动真正需要的
+        learning = true;
+        std::cout << u8"未找到有效的预读清单，将在本次启动后记录" << std::endl;
+        return;
+    } else {
+        work = listPayloadFiles(payloadDir, programName);
+    }
+
+    // 线程只负责提交预读请求，多于 CPU 数时反而与启动器自身争抢 CPU
+    int cpuCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    int threadCount = std::max(1, std::min({options.prefetchThreads, cpuCount, static_cast<int>(work.size())}));
+    workersRunning = threadCount;
+    for (int i = 0; i < threadCount; i++) {
+        workers.emplace_back([this]() { runWorker(); });
+    }
+}
+
+PayloadPrefetcher::~PayloadPrefetcher() {
+    wait();
+}
+
+void PayloadPrefetcher::runWorker() {
+    for (size_t index = nextWork++; index < work.size(); index = nextWork++) {
+        bytesAdvised += adviseWillNeed(work[index]);
+    }
+    if (--workersRunning == 0) {
+        finishedNs = monotonicNanos();
+    }
+}
+
+bool PayloadPrefetcher::childStarted() {
+    if (childStartedCalled) {
+        return false;
+    }
+    childStartedCalled = true;
+    if (learning) {
+        recorder = std::thread([this]() {
+            if (recordPrefetchManifest(manifestPath, payloadDir)) {
+                std::cout << u8"预读清单已记录: " << manifestPath << std::endl;
+            }
+        });
+    }
+    return true;
+}
+
+void PayloadPrefetcher::wait() {
+    for (std::thread& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    if (recorder.joinable()) {
+        recorder.join();
+    }
+}
+
+#else
+
+std::vector<PrefetchRange> listPayloadFiles(const std::string&, const std::string&) {
+    return {};
+}
+
+uint64_t adviseWillNeed(const PrefetchRange&) {
+    return 0;
+}
+
+bool loadPrefetchManifest(const std::string&, const std::string&, PrefetchManifest&) {
+    return false;
+}
+
+bool recordPrefetchManifest(const std::string&, const std::string&) {
+    return false;
+}
+
+PayloadPrefetcher::PayloadPrefetcher(const std::string& payloadDir, const std::string&, const LaunchOptions& options)
+    : payloadDir(payloadDir) {
+    if (options.prefetchMode != PrefetchMode::Off) {
+        std::cerr << u8"当前平台不支持载荷预读，已忽略 --prefetch" << std::endl;
+    }
+}
+
+PayloadPrefetcher::~PayloadPrefetcher() {}
+
+void PayloadPrefetcher::runWorker() {}
+
+bool PayloadPrefetcher::childStarted() {
+    return false;
+}
+
+void PayloadPrefetcher::wait() {}
+
+#endif // __linux__
@@ -0,0 +1,85 @@
+#ifndef PAYLOAD_PREFETCH_H
+#define PAYLOAD_PREFETCH_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "launch_options.h"
+
+// 需要预读的一段文件内容；length 为 0 表示从 offset 到文件末尾
+struct PrefetchRange {
+    std::string path;
+    uint64_t offset = 0;
+    uint64_t length = 0;
+};
+
+// 热点页清单：上一次启动时子进程第一次输出那一刻仍在页缓存中的文件区间。
+// 每个文件记录大小与修改时间，载荷更新后清单自动失效
+struct PrefetchManifest {
+    struct File {
+        std::string path;  // 相对于载荷目录
+        uint64_t size = 0;
+        int64_t mtime = 0;
+        std::vector<std::pair<uint64_t, uint64_t>> ranges;  // (offset, length)
+    };
+    std::vector<File> files;
+};
+
+// 读取清单，并检查其中每个文件的大小与修改时间是否与当前载荷一致
+bool loadPrefetchManifest(const std::string& manifestPath, const std::string& payloadDir,
+                          PrefetchManifest& manifest);
+// 用 mincore 记录载荷目录中各文件当前驻留在页缓存中的区间，写入清单
+bool recordPrefetchManifest(const std::string& manifestPath, const std::string& payloadDir);
+
+// 载荷预读：启动器做自身检查的同时，由几个后台线程对载荷目录中的文件发出
+// posix_fadvise(POSIX_FADV_WILLNEED)，让子进程 exec 后的缺页大多命中页缓存。
+// 有有效清单时只预读清单中的热点区间；没有时 --prefetch=auto 本次不预读，
+// 在子进程第一次输出后记录热点页，--prefetch=dir 则预读整个目录。仅在 Linux 上实现
+class PayloadPrefetcher {
+public:
+    // 立即在后台开始预读
+    PayloadPrefetcher(const std::string& payloadDir, const std::string& programName, const LaunchOptions& options);
+    ~PayloadPrefetcher();
+    PayloadPrefetcher(const PayloadPrefetcher&) = delete;
+    PayloadPrefetcher& operator=(const PayloadPrefetcher&) = delete;
+
+    // 子进程第一次输出时调用：需要时在后台记录热点页清单。只有第一次调用返回 true
+    bool childStarted();
+
+    // 是否有预读线程在运行或已运行；预读开始与结束的时刻（仍在进行时结束时刻为 0）与已发出预读的字节数
+    bool active() const { return !workers.empty(); }
+    int64_t startTimestampNs() const { return startNs; }
+    int64_t finishTimestampNs() const { return finishedNs; }
+    uint64_t advisedBytes() const { return bytesAdvised; }
+
+    // 等待全部后台线程结束
+    void wait();
+
+private:
+    void runWorker();
+
+    std::string payloadDir;
+    std::string manifestPath;
+    bool learning = false;        // 本次记录热点页清单
+    bool childStartedCalled = false;
+
+    std::vector<PrefetchRange> work;
+    std::atomic<size_t> nextWork{0};
+    std::atomic<uint64_t> bytesAdvised{0};
+    std::atomic<int> workersRunning{0};
+    std::atomic<int64_t> finishedNs{0};
+    int64_t startNs = 0;
+    std::vector<std::thread> workers;
+    std::thread recorder;
+};
+
+// 列出载荷目录下的全部普通文件（递归），program 排在最前，其余按大小降序
+std::vector<PrefetchRange> listPayloadFiles(const std::string& payloadDir, const std::string& programName);
+
+// 对一个区间发出 POSIX_FADV_WILLNEED，返回涉及的字节数
+uint64_t adviseWillNeed(const PrefetchRange& range);
+
+#endif // PAYLOAD_PREFETCH_H
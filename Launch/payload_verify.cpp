@@ -0,0 +1,487 @@
+#include "payload_verify.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+// ---------------- XXH64 ----------------
+
+namespace {
+
+const uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+const uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+const uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+const uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+const uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+
+inline uint64_t rotl64(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+inline uint64_t readLE64(const unsigned char* p) {
+    // 按字节拼装，编译器在小端机器上合并为一次 8 字节读取
+    return static_cast<uint64_t>(p[0]) | (static_cast<uint64_t>(p[1]) << 8) | (static_cast<uint64_t>(p[2]) << 16) |
+           (static_cast<uint64_t>(p[3]) << 24) | (static_cast<uint64_t>(p[4]) << 32) |
+           (static_cast<uint64_t>(p[5]) << 40) | (static_cast<uint64_t>(p[6]) << 48) |
+           (static_cast<uint64_t>(p[7]) << 56);
+}
+
+inline uint32_t readLE32(const unsigned char* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) |
+           (static_cast<uint32_t>(p[3]) << 24);
+}
+
+inline uint64_t xxhRound(uint64_t acc, uint64_t input) {
+    acc += input * kPrime2;
+    acc = rotl64(acc, 31);
+    return acc * kPrime1;
+}
+
+inline uint64_t mergeRound(uint64_t acc, uint64_t value) {
+    acc ^= xxhRound(0, value);
+    return acc * kPrime1 + kPrime4;
+}
+
+} // namespace
+
+Xxh64::Xxh64(uint64_t seed) : seed(seed) {
+    acc[0] = seed + kPrime1 + kPrime2;
+    acc[1] = seed + kPrime2;
+    acc[2] = seed;
+    acc[3] = seed - kPrime1;
+}
+
+void Xxh64::update(const void* data, size_t size) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    const unsigned char* end = p + size;
+    totalSize += size;
+
+    if (pendingSize + size < 32) {
+        std::memcpy(pending + pendingSize, p, size);
+        pendingSize += size;
+        return;
+    }
+
+    if (pendingSize > 0) {
+        size_t fill = 32 - pendingSize;
+        std::memcpy(pending + pendingSize, p, fill);
+        p += fill;
+        for (int i = 0; i < 4; i++) {
+            acc[i] = xxhRound(acc[i], readLE64(pending + 8 * i));
+        }
+        pendingSize = 0;
+    }
+
+    // 四路累加器互不依赖，放在局部变量中让编译器保持在寄存器里交错执行
+    uint64_t v1 = acc[0], v2 = acc[1], v3 = acc[2], v4 = acc[3];
+    while (end - p >= 32) {
+        v1 = xxhRound(v1, readLE64(p));
+        v2 = xxhRound(v2, readLE64(p + 8));
+        v3 = xxhRound(v3, readLE64(p + 16));
+        v4 = xxhRound(v4, readLE64(p + 24));
+        p += 32;
+    }
+    acc[0] = v1;
+    acc[1] = v2;
+    acc[2] = v3;
+    acc[3] = v4;
+
+    pendingSize = static_cast<size_t>(end - p);
+    std::memcpy(pending, p, pendingSize);
+}
+
+uint64_t Xxh64::digest() const {
+    uint64_t h;
+    if (totalSize >= 32) {
+        h = rotl64(acc[0], 1) + rotl64(acc[1], 7) + rotl64(acc[2], 12) + rotl64(acc[3], 18);
+        for (int i = 0; i < 4; i++) {
+            h = mergeRound(h, acc[i]);
+        }
+    } else {
+        h = seed + kPrime5;
+    }
+    h += totalSize;
+
+    const unsigned char* p = pending;
+    const unsigned char* end = pending + pendingSize;
+    while (end - p >= 8) {
+        h ^= xxhRound(0, readLE64(p));
+        h = rotl64(h, 27) * kPrime1 + kPrime4;
+        p += 8;
+    }
+    if (end - p >= 4) {
+        h ^= static_cast<uint64_t>(readLE32(p)) * kPrime1;
+        h = rotl64(h, 23) * kPrime2 + kPrime3;
+        p += 4;
+    }
+    while (p < end) {
+        h ^= *p * kPrime5;
+        h = rotl64(h, 11) * kPrime1;
+        p++;
+    }
+
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+uint64_t Xxh64::hash(const void* data, size_t size, uint64_t seed) {
+    Xxh64 state(seed);
+    state.update(data, size);
+    return state.digest();
+}
+
+// ---------------- 清单与校验 ----------------
+
+namespace {
+
+const char kManifestHeader[] = "# SwarmClone payload manifest v1: xxh64 of 8 MiB chunk hashes, size, path";
+
+struct FileState {
+    uint64_t size = 0;
+    int64_t mtime = 0;
+};
+
+bool statPayloadFile(const fs::path& path, FileState& state) {
+    std::error_code error;
+    if (!fs::is_regular_file(path, error)) {
+        return false;
+    }
+    state.size = fs::file_size(path, error);
+    if (error) {
+        return false;
+    }
+    fs::file_time_type mtime = fs::last_write_time(path, error);
+    if (error) {
+        return false;
+    }
+    state.mtime = static_cast<int64_t>(mtime.time_since_epoch().count());
+    return true;
+}
+
+std::string formatHash(uint64_t hash) {
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(hash));
+    return text;
+}
+
+bool parseHash(const std::string& text, uint64_t& hash) {
+    if (text.size() != 16) {
+        return false;
+    }
+    char* end;
+    hash = std::strtoull(text.c_str(), &end, 16);
+    return *end == '\0';
+}
+
+// "<hash> <数字...> <路径>"：路径可能含空格，取剩余的整行
+bool splitLine(const std::string& line, size_t numberCount, uint64_t& hash, std::vector<int64_t>& numbers,
+               std::string& path) {
+    std::istringstream fields(line);
+    std::string hashText;
+    if (!(fields >> hashText) || !parseHash(hashText, hash)) {
+        return false;
+    }
+    numbers.assign(numberCount, 0);
+    for (int64_t& number : numbers) {
+        if (!(fields >> number)) {
+            return false;
+        }
+    }
+    fields.get();
+    std::getline(fields, path);
+    return !path.empty();
+}
+
+bool readManifest(const fs::path& manifestPath, std::vector<PayloadManifestEntry>& entries) {
+    std::ifstream file(manifestPath);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        PayloadManifestEntry entry;
+        std::vector<int64_t> numbers;
+        if (!splitLine(line, 1, entry.hash, numbers, entry.path)) {
+            return false;
+        }
+        entry.size = static_cast<uint64_t>(numbers[0]);
+        entries.push_back(entry);
+    }
+    return true;
+}
+
+// 已校验缓存：清单本身的状态与每个校验通过的文件当时的大小、修改时间和哈希
+struct VerifiedCache {
+    std::map<std::string, std::pair<FileState, uint64_t>> files;
+};
+
+void loadVerifiedCache(const std::string& cachePath, const FileState& manifestState, VerifiedCache& cache) {
+    std::ifstream file(cachePath);
+    std::string line;
+    if (!file.is_open() || !std::getline(file, line)) {
+        return;
+    }
+    long long size = 0;
+    long long mtime = 0;
+    if (std::sscanf(line.c_str(), "manifest=%lld %lld", &size, &mtime) != 2 ||
+        static_cast<uint64_t>(size) != manifestState.size || mtime != manifestState.mtime) {
+        return;  // 清单已更新，缓存作废
+    }
+    while (std::getline(file, line)) {
+        uint64_t hash;
+        std::vector<int64_t> numbers;
+        std::string path;
+        if (splitLine(line, 2, hash, numbers, path)) {
+            FileState state;
+            state.size = static_cast<uint64_t>(numbers[0]);
+            state.mtime = numbers[1];
+            cache.files[path] = {state, hash};
+        }
+    }
+}
+
+bool saveVerifiedCache(const std::string& cachePath, const FileState& manifestState, const VerifiedCache& cache) {
+    std::string tempPath = cachePath + ".tmp";
+    {
+        std::ofstream file(tempPath);
+        if (!file.is_open()) {
+            return false;
+        }
+        file << "manifest=" << manifestState.size << " " << manifestState.mtime << "\n";
+        for (const auto& entry : cache.files) {
+            file << formatHash(entry.second.second) << " " << entry.second.first.size << " "
+                 << entry.second.first.mtime << " " << entry.first << "\n";
+        }
+        if (!file.good()) {
+            return false;
+        }
+    }
+    // 直接覆盖旧缓存：filesystem::rename 在 POSIX 上是原子的 rename，在 Windows 上使用
+    // MoveFileExW(MOVEFILE_REPLACE_EXISTING)，不会出现旧缓存已删除、新缓存尚未就位的时刻
+    std::error_code error;
+    fs::rename(tempPath, cachePath, error);
+    return !error;
+}
+
+// 并行计算一组文件的哈希：每个工作项是一个文件中的一块，块哈希全部算完后按顺序合并
+class ParallelHasher {
+public:
+    struct Job {
+        fs::path path;
+        uint64_t size = 0;
+        std::vector<uint64_t> chunkHashes;
+        std::vector<char> chunkFailed;  // 每块只由一个线程写入
+    };
+
+    explicit ParallelHasher(std::vector<Job>& jobs) : jobs(jobs) {
+        for (size_t i = 0; i < jobs.size(); i++) {
+            size_t chunks = std::max<uint64_t>(1, (jobs[i].size + kPayloadHashChunk - 1) / kPayloadHashChunk);
+            jobs[i].chunkHashes.assign(chunks, 0);
+            jobs[i].chunkFailed.assign(chunks, 0);
+            for (size_t chunk = 0; chunk < chunks; chunk++) {
+                work.emplace_back(i, chunk);
+            }
+        }
+    }
+
+    void run() {
+        size_t threadCount = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), work.size());
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < threadCount; i++) {
+            threads.emplace_back([this]() { runWorker(); });
+        }
+        runWorker();
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+    // 文件的最终哈希，读取失败时返回 false
+    static bool combine(const Job& job, uint64_t& hash) {
+        if (std::find(job.chunkFailed.begin(), job.chunkFailed.end(), 1) != job.chunkFailed.end()) {
+            return false;
+        }
+        Xxh64 state;
+        for (uint64_t chunkHash : job.chunkHashes) {
+            unsigned char bytes[8];
+            for (int i = 0; i < 8; i++) {
+                bytes[i] = static_cast<unsigned char>(chunkHash >> (8 * i));
+            }
+            state.update(bytes, sizeof(bytes));
+        }
+        hash = state.digest();
+        return true;
+    }
+
+private:
+    void runWorker() {
+        std::vector<char> buffer(1024 * 1024);
+        for (size_t index = next++; index < work.size(); index = next++) {
+            Job& job = jobs[work[index].first];
+            uint64_t offset = work[index].second * kPayloadHashChunk;
+            uint64_t remaining = std::min(kPayloadHashChunk, job.size - std::min(job.size, offset));
+            std::ifstream file(job.path, std::ios::binary);
+            file.seekg(static_cast<std::streamoff>(offset));
+            Xxh64 state;
+            while (remaining > 0 && file) {
+                file.read(buffer.data(), static_cast<std::streamsize>(std::min<uint64_t>(remaining, buffer.size())));
+                state.update(buffer.data(), static_cast<size_t>(file.gcount()));
+                remaining -= static_cast<uint64_t>(file.gcount());
+            }
+            if (remaining > 0 || !file.is_open()) {
+                job.chunkFailed[work[index].second] = 1;
+            }
+            job.chunkHashes[work[index].second] = state.digest();
+        }
+    }
+
+    std::vector<Job>& jobs;
+    std::vector<std::pair<size_t, size_t>> work;
+    std::atomic<size_t> next{0};
+};
+
+} // namespace
+
+bool verifyPayload(const std::string& payloadDir, const std::string& manifestName, const std::string& cachePath,
+                   bool full, PayloadVerifyResult& result) {
+    fs::path root = fs::u8path(payloadDir);
+    fs::path manifestPath = root / fs::u8path(manifestName);
+    FileState manifestState;
+    if (!statPayloadFile(manifestPath, manifestState)) {
+        result.manifestFound = false;
+        return true;
+    }
+    result.manifestFound = true;
+
+    std::vector<PayloadManifestEntry> entries;
+    if (!readManifest(manifestPath, entries)) {
+        return false;
+    }
+    VerifiedCache cache;
+    if (!full) {
+        loadVerifiedCache(cachePath, manifestState, cache);
+    }
+
+    // 大小不符的文件不必读取；大小与修改时间都和缓存一致的文件视为完好
+    VerifiedCache updated;
+    std::vector<ParallelHasher::Job> jobs;
+    std::vector<const PayloadManifestEntry*> jobEntries;
+    std::vector<FileState> jobStates;
+    for (const PayloadManifestEntry& entry : entries) {
+        result.filesChecked++;
+        FileState state;
+        if (!statPayloadFile(root / fs::u8path(entry.path), state)) {
+            result.missing.push_back(entry.path);
+            continue;
+        }
+        if (state.size != entry.size) {
+            result.corrupted.push_back(entry.path);
+            continue;
+        }
+        auto cached = cache.files.find(entry.path);
+        if (cached != cache.files.end() && cached->second.first.size == state.size &&
+            cached->second.first.mtime == state.mtime && cached->second.second == entry.hash) {
+            updated.files[entry.path] = cached->second;
+            continue;
+        }
+        ParallelHasher::Job job;
+        job.path = root / fs::u8path(entry.path);
+        job.size = state.size;
+        jobs.push_back(job);
+        jobEntries.push_back(&entry);
+        jobStates.push_back(state);
+    }
+
+    if (!jobs.empty()) {
+        ParallelHasher hasher(jobs);
+        hasher.run();
+        for (size_t i = 0; i < jobs.size(); i++) {
+            uint64_t hash;
+            result.filesHashed++;
+            result.bytesHashed += jobs[i].size;
+            if (!ParallelHasher::combine(jobs[i], hash) || hash != jobEntries[i]->hash) {
+                result.corrupted.push_back(jobEntries[i]->path);
+            } else {
+                updated.files[jobEntries[i]->path] = {jobStates[i], hash};
+            }
+        }
+    }
+
+    if (!jobs.empty() || updated.files.size() != cache.files.size()) {
+        saveVerifiedCache(cachePath, manifestState, updated);
+    }
+    return true;
+}
+
+bool writePayloadManifest(const std::string& payloadDir, const std::string& manifestName, std::string& error) {
+    fs::path root = fs::u8path(payloadDir);
+    std::error_code walkError;
+    std::vector<PayloadManifestEntry> entries;
+    for (fs::recursive_directory_iterator it(root, walkError), end; it != end && !walkError; it.increment(walkError)) {
+        if (!it->is_regular_file()) {
+            continue;
+        }
+        std::string path = it->path().lexically_relative(root).generic_u8string();
+        if (path == manifestName || path.find('\n') != std::string::npos) {
+            continue;
+        }
+        PayloadManifestEntry entry;
+        entry.path = path;
+        entries.push_back(entry);
+    }
+    if (walkError) {
+        error = walkError.message();
+        return false;
+    }
+    std::sort(entries.begin(), entries.end(), [](const PayloadManifestEntry& a, const PayloadManifestEntry& b) {
+        return a.path < b.path;
+    });
+
+    std::vector<ParallelHasher::Job> jobs(entries.size());
+    for (size_t i = 0; i < entries.size(); i++) {
+        FileState state;
+        jobs[i].path = root / fs::u8path(entries[i].path);
+        if (!statPayloadFile(jobs[i].path, state)) {
+            error = u8"无法读取 " + entries[i].path;
+            return false;
+        }
+        jobs[i].size = entries[i].size = state.size;
+    }
+    ParallelHasher hasher(jobs);
+    hasher.run();
+
+    std::ofstream file(root / fs::u8path(manifestName));
+    if (!file.is_open()) {
+        error = u8"无法写入清单文件";
+        return false;
+    }
+    file << kManifestHeader << "\n";
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (!ParallelHasher::combine(jobs[i], entries[i].hash)) {
+            error = u8"无法读取 " + entries[i].path;
+            return false;
+        }
+        file << formatHash(entries[i].hash) << " " << entries[i].size << " " << entries[i].path << "\n";
+    }
+    if (!file.good()) {
+        error = u8"无法写入清单文件";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,59 @@
+#ifndef PAYLOAD_VERIFY_H
+#define PAYLOAD_VERIFY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// XXH64 流式哈希（https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md），与 xxhsum -H1 的结果相同
+class Xxh64 {
+public:
+    explicit Xxh64(uint64_t seed = 0);
+
+    void update(const void* data, size_t size);
+    uint64_t digest() const;
+
+    static uint64_t hash(const void* data, size_t size, uint64_t seed = 0);
+
+private:
+    uint64_t acc[4];
+    uint64_t seed;
+    uint64_t totalSize = 0;
+    unsigned char pending[32];
+    size_t pendingSize = 0;
+};
+
+// 载荷文件的哈希：把文件切成 kPayloadHashChunk 大小的块分别计算 XXH64，再对各块哈希（小端序拼接）计算 XXH64。
+// 分块让单个大文件也能由多个线程并行校验
+constexpr uint64_t kPayloadHashChunk = 8 * 1024 * 1024;
+
+// 安装清单中的一个文件
+struct PayloadManifestEntry {
+    std::string path;   // 相对于载荷目录，以 '/' 分隔
+    uint64_t size = 0;
+    uint64_t hash = 0;
+};
+
+// 一次校验的结果
+struct PayloadVerifyResult {
+    bool manifestFound = false;
+    std::vector<std::string> missing;    // 清单中有但不存在的文件
+    std::vector<std::string> corrupted;  // 大小或哈希与清单不符的文件
+    size_t filesChecked = 0;
+    size_t filesHashed = 0;              // 未命中已校验缓存、实际读取计算的文件数
+    uint64_t bytesHashed = 0;
+
+    bool ok() const { return missing.empty() && corrupted.empty(); }
+};
+
+// 按载荷目录中的安装清单 manifestName 校验全部文件。大小与修改时间都与 cachePath 中记录的上一次
+// 校验结果一致的文件直接视为完好；full 为 true 时忽略缓存，重新计算全部文件。
+// 没有清单时 manifestFound 为 false 并返回 true（开发环境中的构建不带清单）。读取清单失败时返回 false
+bool verifyPayload(const std::string& payloadDir, const std::string& manifestName, const std::string& cachePath,
+                   bool full, PayloadVerifyResult& result);
+
+// 为载荷目录生成安装清单（发布时使用），清单文件本身不列入
+bool writePayloadManifest(const std::string& payloadDir, const std::string& manifestName, std::string& error);
+
+#endif // PAYLOAD_VERIFY_H
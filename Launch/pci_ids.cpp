@@ -0,0 +1,60 @@
+#include "pci_ids.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+struct PciVendorEntry {
+    uint16_t id;
+    const char* name;
+};
+
+struct PciDeviceEntry {
+    uint32_t id;  // 厂商 ID << 16 | 设备 ID
+    const char* name;
+};
+
+#ifdef LAUNCH_HAVE_PCI_IDS
+#include "pci_ids_generated.h"
+#else
+// 构建时没有找到 pci.ids，只内置常见显卡厂商的名称
+static const PciVendorEntry kPciVendors[] = {
+    {0x1002, "Advanced Micro Devices, Inc. [AMD/ATI]"},
+    {0x102b, "Matrox Electronics Systems Ltd."},
+    {0x10de, "NVIDIA Corporation"},
+    {0x1234, "QEMU"},
+    {0x1414, "Microsoft Corporation"},
+    {0x15ad, "VMware"},
+    {0x1a03, "ASPEED Technology, Inc."},
+    {0x1af4, "Red Hat, Inc."},
+    {0x1ed5, "Moore Threads Technology Co.,Ltd"},
+    {0x5143, "Qualcomm Technologies, Inc"},
+    {0x80ee, "InnoTek Systemberatung GmbH"},
+    {0x8086, "Intel Corporation"},
+    {0xffff, nullptr},
+};
+
+static const PciDeviceEntry kPciDevices[] = {
+    {0xffffffffu, nullptr},
+};
+#endif
+
+} // namespace
+
+const char* lookupPciVendor(uint16_t vendorId) {
+    auto begin = std::begin(kPciVendors);
+    auto end = std::end(kPciVendors) - 1; // 跳过结束标记
+    auto it = std::lower_bound(begin, end, vendorId,
+                               [](const PciVendorEntry& entry, uint16_t id) { return entry.id < id; });
+    return (it != end && it->id == vendorId) ? it->name : nullptr;
+}
+
+const char* lookupPciDevice(uint16_t vendorId, uint16_t deviceId) {
+    uint32_t key = (static_cast<uint32_t>(vendorId) << 16) | deviceId;
+    auto begin = std::begin(kPciDevices);
+    auto end = std::end(kPciDevices) - 1;
+    auto it = std::lower_bound(begin, end, key,
+                               [](const PciDeviceEntry& entry, uint32_t id) { return entry.id < id; });
+    return (it != end && it->id == key) ? it->name : nullptr;
+}
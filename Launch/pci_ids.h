@@ -0,0 +1,11 @@
+#ifndef PCI_IDS_H
+#define PCI_IDS_H
+
+#include <cstdint>
+
+// PCI 厂商与设备名称查询，表在编译期嵌入（见 cmake/GeneratePciIds.cmake）。
+// 找不到时返回 nullptr
+const char* lookupPciVendor(uint16_t vendorId);
+const char* lookupPciDevice(uint16_t vendorId, uint16_t deviceId);
+
+#endif // PCI_IDS_H
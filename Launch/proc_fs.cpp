@@ -0,0 +1,111 @@
+#include "proc_fs.h"
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+
+ssize_t readSmallFile(const char* path, char* buffer, size_t size) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return -1;
+    }
+    ssize_t length = read(fd, buffer, size - 1);
+    close(fd);
+    if (length < 0) {
+        return -1;
+    }
+    while (length > 0 && (buffer[length - 1] == '\n' || buffer[length - 1] == ' ')) {
+        length--;
+    }
+    buffer[length] = '\0';
+    return length;
+}
+
+ssize_t readSmallFile(const std::string& path, char* buffer, size_t size) {
+    return readSmallFile(path.c_str(), buffer, size);
+}
+
+void collectProcessTree(int rootPid, std::vector<int>& pids) {
+    pids.clear();
+    pids.push_back(rootPid);
+
+    char path[32 + NAME_MAX];  // "/proc/<pid>/task/<tid>/children"，tid 来自 d_name
+    char buffer[4096];
+    for (size_t i = 0; i < pids.size(); i++) {
+        std::snprintf(path, sizeof(path), "/proc/%d/task", pids[i]);
+        DIR* dir = opendir(path);
+        if (!dir) {
+            continue;
+        }
+        while (dirent* entry = readdir(dir)) {
+            if (entry->d_name[0] == '.') {
+                continue;
+            }
+            std::snprintf(path, sizeof(path), "/proc/%d/task/%s/children", pids[i], entry->d_name);
+            if (readSmallFile(path, buffer, sizeof(buffer)) <= 0) {
+                continue;
+            }
+            char* p = buffer;
+            while (*p) {
+                char* end = nullptr;
+                long child = std::strtol(p, &end, 10);
+                if (end == p) {
+                    break;
+                }
+                pids.push_back(static_cast<int>(child));
+                p = end;
+            }
+        }
+        closedir(dir);
+    }
+}
+
+bool readSysfsLong(const std::string& path, long& value, int base) {
+    char buffer[64];
+    if (readSmallFile(path, buffer, sizeof(buffer)) <= 0) {
+        return false;
+    }
+    char* end = nullptr;
+    value = std::strtol(buffer, &end, base);
+    return end != buffer;
+}
+
+std::vector<long> parseCpuList(const char* text) {
+    std::vector<long> cpus;
+    const char* p = text;
+    while (*p) {
+        char* end = nullptr;
+        long first = std::strtol(p, &end, 10);
+        if (end == p || first < 0) {
+            return {};
+        }
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            last = std::strtol(p + 1, &end, 10);
+            if (end == p + 1) {
+                return {};
+            }
+            p = end;
+        }
+        // 超出 cpu_set_t 能表示的范围、区间颠倒或后面跟着其他字符时整个列表无效
+        if (last < first || last >= CPU_SETSIZE || (*p != ',' && *p != '\0')) {
+            return {};
+        }
+        for (long cpu = first; cpu <= last; cpu++) {
+            cpus.push_back(cpu);
+        }
+        if (*p == ',') {
+            p++;
+        }
+    }
+    return cpus;
+}
+
+#endif
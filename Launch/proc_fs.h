@@ -0,0 +1,27 @@
+#ifndef PROC_FS_H
+#define PROC_FS_H
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+// 读取 sysfs/procfs 中的小文件到 buffer（以 '\0' 结尾），去掉末尾换行；失败时返回 -1。
+// 不经过 iostream，也不分配内存，适合在采样等高频路径中使用
+ssize_t readSmallFile(const char* path, char* buffer, size_t size);
+ssize_t readSmallFile(const std::string& path, char* buffer, size_t size);
+
+// 读取只含一个整数的文件
+bool readSysfsLong(const std::string& path, long& value, int base = 10);
+
+// 通过每个线程的 children 文件逐层找出 rootPid 及其全部后代进程，rootPid 在最前
+void collectProcessTree(int rootPid, std::vector<int>& pids);
+
+// 解析 "0-3,5,7-8" 形式的 CPU 列表；格式错误、区间颠倒或编号不小于 CPU_SETSIZE 时返回空列表
+std::vector<long> parseCpuList(const char* text);
+
+#endif
+
+#endif // PROC_FS_H
@@ -0,0 +1,350 @@
+#include "process_spawn.h"
+
+#ifndef _WIN32
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <sstream>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#ifdef __linux__
+    #include <sched.h>
+    #include <sys/mman.h>
+    #include <sys/syscall.h>
+#endif
+
+extern char** environ;
+
+namespace {
+
+// 子进程在 exec 前各步骤的编号，失败时连同 errno 写入状态管道
+enum SpawnStep {
+    StepLimit,
+    StepNice,
+    StepIoPriority,
+    StepAffinity,
+    StepCgroup,
+    StepFdMap,
+    StepChdir,
+    StepExec,
+};
+
+struct StepFailure {
+    int step;
+    int index;
+    int error;
+};
+
+// 子进程直接使用的数据，全部在父进程中准备好
+struct SpawnPlan {
+    const char* program = nullptr;
+    char* const* argv = nullptr;
+    char* const* envp = nullptr;
+    const char* workDir = nullptr;
+    const int* limitResources = nullptr;
+    const struct rlimit* limits = nullptr;
+    size_t limitCount = 0;
+    bool setNice = false;
+    int niceValue = 0;
+    int ioPriority = -1;
+#ifdef __linux__
+    bool setAffinity = false;
+    cpu_set_t affinity;
+#endif
+    const std::pair<int, int>* fdMap = nullptr;
+    size_t fdCount = 0;
+    const char* cgroupProcs = nullptr;
+    int statusFd = -1;
+};
+
+void reportFailure(int statusFd, int step, int index, int error) {
+    StepFailure failure{step, index, error};
+    (void)!write(statusFd, &failure, sizeof(failure));
+}
+
+// 子进程 exec 前的全部工作。vfork 语义下与父进程共享内存，因此只能调用异步信号安全的函数
+[[noreturn]] void runChild(const SpawnPlan& plan) {
+    // 父进程的信号处理函数不能在子进程中运行，恢复为默认处理；忽略的信号按惯例保持忽略
+    for (int sig = 1; sig < NSIG; sig++) {
+        struct sigaction action;
+        if (sigaction(sig, nullptr, &action) == 0 && action.sa_handler != SIG_DFL && action.sa_handler != SIG_IGN) {
+            action.sa_handler = SIG_DFL;
+            action.sa_flags = 0;
+            sigemptyset(&action.sa_mask);
+            sigaction(sig, &action, nullptr);
+        }
+    }
+
+    for (size_t i = 0; i < plan.limitCount; i++) {
+        if (setrlimit(plan.limitResources[i], &plan.limits[i]) != 0) {
+            reportFailure(plan.statusFd, StepLimit, static_cast<int>(i), errno);
+        }
+    }
+    if (plan.setNice && setpriority(PRIO_PROCESS, 0, plan.niceValue) != 0) {
+        reportFailure(plan.statusFd, StepNice, 0, errno);
+    }
+#ifdef __linux__
+    // ioprio_set(IOPRIO_WHO_PROCESS, 0, prio)，glibc 没有提供包装函数
+    if (plan.ioPriority >= 0 && syscall(SYS_ioprio_set, 1, 0, plan.ioPriority) != 0) {
+        reportFailure(plan.statusFd, StepIoPriority, 0, errno);
+    }
+    if (plan.setAffinity && sched_setaffinity(0, sizeof(plan.affinity), &plan.affinity) != 0) {
+        reportFailure(plan.statusFd, StepAffinity, 0, errno);
+    }
+#endif
+
+    // 写入 "0" 表示移动写入者自己
+    if (plan.cgroupProcs) {
+        int fd = open(plan.cgroupProcs, O_WRONLY | O_CLOEXEC);
+        if (fd == -1 || write(fd, "0", 1) != 1) {
+            reportFailure(plan.statusFd, StepCgroup, 0, errno);
+        }
+        if (fd != -1) {
+            close(fd);
+        }
+    }
+
+    for (size_t i = 0; i < plan.fdCount; i++) {
+        int target = plan.fdMap[i].first;
+        int source = plan.fdMap[i].second;
+        int result;
+        if (target == source) {
+            int flags = fcntl(source, F_GETFD);
+            result = flags == -1 ? -1 : fcntl(source, F_SETFD, flags & ~FD_CLOEXEC);
+        } else {
+            result = dup2(source, target);
+        }
+        if (result == -1) {
+            reportFailure(plan.statusFd, StepFdMap, static_cast<int>(i), errno);
+            _exit(127);
+        }
+    }
+
+    if (plan.workDir && chdir(plan.workDir) != 0) {
+        reportFailure(plan.statusFd, StepChdir, 0, errno);
+        _exit(127);
+    }
+
+    sigset_t emptyMask;
+    sigemptyset(&emptyMask);
+    sigprocmask(SIG_SETMASK, &emptyMask, nullptr);
+
+    execve(plan.program, plan.argv, plan.envp);
+    reportFailure(plan.statusFd, StepExec, 0, errno);
+    _exit(127);
+}
+
+#ifdef __linux__
+int cloneEntry(void* arg) {
+    runChild(*static_cast<const SpawnPlan*>(arg));
+}
+#endif
+
+// 启动器自身的环境变量加上 spec.env，同名变量以 spec.env 为准
+std::vector<std::string> buildEnvironment(const std::vector<std::string>& overrides) {
+    std::map<std::string, size_t> index;
+    std::vector<std::string> result;
+    auto add = [&](const std::string& entry) {
+        std::string key = entry.substr(0, entry.find('='));
+        auto it = index.find(key);
+        if (it != index.end()) {
+            result[it->second] = entry;
+        } else {
+            index.emplace(key, result.size());
+            result.push_back(entry);
+        }
+    };
+    for (char** p = environ; p && *p; p++) {
+        add(*p);
+    }
+    for (const std::string& entry : overrides) {
+        add(entry);
+    }
+    return result;
+}
+
+std::string describeFailure(const StepFailure& failure, const LaunchSpec& spec) {
+    std::string what;
+    switch (failure.step) {
+        case StepLimit: what = u8"设置第 " + std::to_string(failure.index + 1) + u8" 项资源限制失败"; break;
+        case StepNice: what = u8"设置 nice 值 " + std::to_string(spec.niceValue) + u8" 失败"; break;
+        case StepIoPriority: what = u8"设置 I/O 优先级失败"; break;
+        case StepAffinity: what = u8"设置 CPU 亲和性失败"; break;
+        case StepCgroup: what = u8"无法加入 cgroup " + spec.cgroupProcs; break;
+        case StepFdMap: what = u8"映射文件描述符失败"; break;
+        case StepChdir: what = u8"无法切换到目录 " + spec.workDir; break;
+        default: what = u8"无法执行 " + spec.program; break;
+    }
+    return what + ": " + std::strerror(failure.error);
+}
+
+} // namespace
+
+std::string findExecutable(const char* name) {
+    const char* path = std::getenv("PATH");
+    if (!path) {
+        return "";
+    }
+    std::stringstream dirs(path);
+    std::string dir;
+    while (std::getline(dirs, dir, ':')) {
+        std::string candidate = (dir.empty() ? "." : dir) + "/" + name;
+        if (access(candidate.c_str(), X_OK) == 0) {
+            return candidate;
+        }
+    }
+    return "";
+}
+
+pid_t spawnProcess(const LaunchSpec& spec, SpawnMethod method, std::vector<std::string>& warnings,
+                   std::string& error) {
+    // argv 与 envp
+    std::vector<char*> argv;
+    argv.push_back(const_cast<char*>(spec.program.c_str()));
+    for (const std::string& arg : spec.args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+
+    std::vector<std::string> environment = buildEnvironment(spec.env);
+    std::vector<char*> envp;
+    for (const std::string& entry : environment) {
+        envp.push_back(const_cast<char*>(entry.c_str()));
+    }
+    envp.push_back(nullptr);
+
+    std::vector<int> limitResources;
+    std::vector<struct rlimit> limits;
+    for (const ResourceLimit& limit : spec.limits) {
+        struct rlimit value;
+        value.rlim_cur = limit.soft == kLimitUnlimited ? RLIM_INFINITY : static_cast<rlim_t>(limit.soft);
+        value.rlim_max = limit.hard == kLimitUnlimited ? RLIM_INFINITY : static_cast<rlim_t>(limit.hard);
+        limitResources.push_back(limit.resource);
+        limits.push_back(value);
+    }
+
+    SpawnPlan plan;
+    plan.program = spec.program.c_str();
+    plan.argv = argv.data();
+    plan.envp = envp.data();
+    plan.workDir = spec.workDir.empty() ? nullptr : spec.workDir.c_str();
+    plan.limitResources = limitResources.data();
+    plan.limits = limits.data();
+    plan.limitCount = limits.size();
+    plan.setNice = spec.setNice;
+    plan.niceValue = spec.niceValue;
+    plan.fdMap = spec.fdMap.data();
+    plan.fdCount = spec.fdMap.size();
+    plan.cgroupProcs = spec.cgroupProcs.empty() ? nullptr : spec.cgroupProcs.c_str();
+
+    if (spec.ioClass != IoPriorityClass::Unchanged) {
+        // IOPRIO_PRIO_VALUE(class, level)：class 位于第 13 位之上；idle 类没有级别
+        int ioClass = spec.ioClass == IoPriorityClass::RealTime ? 1 : spec.ioClass == IoPriorityClass::BestEffort ? 2 : 3;
+        int level = ioClass == 3 ? 0 : std::min(std::max(spec.ioLevel, 0), 7);
+        plan.ioPriority = (ioClass << 13) | level;
+    }
+#ifdef __linux__
+    CPU_ZERO(&plan.affinity);
+    for (int cpu : spec.cpuAffinity) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &plan.affinity);
+            plan.setAffinity = true;
+        }
+    }
+#else
+    if (!spec.cpuAffinity.empty()) {
+        warnings.push_back(u8"当前平台不支持设置 CPU 亲和性");
+    }
+    if (spec.ioClass != IoPriorityClass::Unchanged) {
+        warnings.push_back(u8"当前平台不支持设置 I/O 优先级");
+    }
+#endif
+
+    // exec 成功时状态管道随 CLOEXEC 自动关闭，子进程在此之前写入的都是失败记录
+    int status[2];
+#ifdef __linux__
+    if (pipe2(status, O_CLOEXEC) == -1) {
+#else
+    if (pipe(status) == -1 || fcntl(status[0], F_SETFD, FD_CLOEXEC) == -1 || fcntl(status[1], F_SETFD, FD_CLOEXEC) == -1) {
+#endif
+        error = std::string(u8"创建管道失败: ") + std::strerror(errno);
+        return -1;
+    }
+    plan.statusFd = status[1];
+
+    // 创建子进程期间屏蔽全部信号，子进程恢复默认处理后再在 exec 前解除屏蔽
+    sigset_t allSignals;
+    sigset_t previousMask;
+    sigfillset(&allSignals);
+    pthread_sigmask(SIG_SETMASK, &allSignals, &previousMask);
+
+    pid_t pid = -1;
+    int spawnError = 0;
+#ifdef __linux__
+    if (method == SpawnMethod::Auto) {
+        // 子进程共享父进程的地址空间直到 exec，父进程在此期间挂起，只需为它准备一小块栈
+        const size_t stackSize = 64 * 1024;
+        void* stack = mmap(nullptr, stackSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+        if (stack != MAP_FAILED) {
+            pid = clone(cloneEntry, static_cast<char*>(stack) + stackSize, CLONE_VM | CLONE_VFORK | SIGCHLD, &plan);
+            spawnError = errno;
+            munmap(stack, stackSize);
+        }
+        // seccomp 等策略可能禁止带 CLONE_VM 的 clone，此时退回到 fork
+    }
+#else
+    (void)method;
+#endif
+    if (pid == -1) {
+        pid = fork();
+        if (pid == 0) {
+            runChild(plan);
+        }
+        spawnError = errno;
+    }
+
+    pthread_sigmask(SIG_SETMASK, &previousMask, nullptr);
+    close(status[1]);
+
+    if (pid == -1) {
+        close(status[0]);
+        error = std::string(u8"无法创建子进程: ") + std::strerror(spawnError);
+        return -1;
+    }
+
+    bool fatal = false;
+    StepFailure failure;
+    while (true) {
+        ssize_t bytesRead = read(status[0], &failure, sizeof(failure));
+        if (bytesRead == -1 && errno == EINTR) {
+            continue;
+        }
+        if (bytesRead != sizeof(failure)) {
+            break;
+        }
+        if (failure.step == StepFdMap || failure.step == StepChdir || failure.step == StepExec) {
+            fatal = true;
+            error = describeFailure(failure, spec);
+        } else {
+            warnings.push_back(describeFailure(failure, spec));
+        }
+    }
+    close(status[0]);
+
+    if (fatal) {
+        waitpid(pid, nullptr, 0);
+        return -1;
+    }
+    return pid;
+}
+
+#endif // _WIN32
@@ -0,0 +1,60 @@
+#ifndef PROCESS_SPAWN_H
+#define PROCESS_SPAWN_H
+
+#ifndef _WIN32
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/types.h>
+
+#include "launch_options.h"
+
+// 子进程的一项资源限制（setrlimit），kLimitUnlimited 表示 RLIM_INFINITY
+struct ResourceLimit {
+    int resource = 0;  // RLIMIT_*
+    uint64_t soft = kLimitUnlimited;
+    uint64_t hard = kLimitUnlimited;
+};
+
+// 启动一个子进程所需的全部信息。字符串与数组都在父进程中准备好，
+// 子进程在 exec 前只调用异步信号安全的系统调用，不分配内存、不使用 iostream
+struct LaunchSpec {
+    std::string program;             // 可执行文件，相对路径基于 workDir
+    std::vector<std::string> args;   // argv[1..]，argv[0] 为 program
+    std::vector<std::string> env;    // "KEY=VALUE"，覆盖或追加到启动器自身的环境变量
+    std::string workDir;             // 为空时不切换目录
+
+    std::vector<ResourceLimit> limits;
+    bool setNice = false;
+    int niceValue = 0;
+    IoPriorityClass ioClass = IoPriorityClass::Unchanged;
+    int ioLevel = 4;                 // 0（最高）到 7
+    std::vector<int> cpuAffinity;    // 允许运行的 CPU 编号，为空时不限制（仅 Linux）
+
+    // 子进程中的 fd 编号 -> 父进程中的 fd。两者相同时只清除 CLOEXEC 让子进程继承
+    std::vector<std::pair<int, int>> fdMap;
+
+    // 非空时子进程在 exec 前把自己写入该 cgroup.procs，其后代从一开始就计入这个 cgroup
+    std::string cgroupProcs;
+};
+
+// 创建子进程的方式
+enum class SpawnMethod {
+    Auto,  // Linux 上使用 clone(CLONE_VM | CLONE_VFORK)，不复制页表；失败时退回到 fork
+    Fork,  // 传统的 fork + exec
+};
+
+// 启动 spec 描述的程序，返回时新程序已经 exec 成功。失败时返回 -1 并在 error 中说明原因；
+// 优先级、亲和性等非必需的设置失败时照常启动，原因写入 warnings
+pid_t spawnProcess(const LaunchSpec& spec, SpawnMethod method, std::vector<std::string>& warnings,
+                   std::string& error);
+
+// 在 PATH 中查找可执行文件，返回完整路径；找不到时返回空字符串
+std::string findExecutable(const char* name);
+
+#endif // _WIN32
+
+#endif // PROCESS_SPAWN_H
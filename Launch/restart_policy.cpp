@@ -0,0 +1,91 @@
+#include "restart_policy.h"
+
+#include "output_buffer.h"
+
+#include <algorithm>
+#include <cstdio>
+
+RestartPolicy::RestartPolicy(const LaunchOptions& options)
+    : mode(options.restartMode),
+      initialDelayMs(std::max(options.restartDelayMs, 0)),
+      maxDelayMs(std::max(options.restartMaxDelayMs, options.restartDelayMs)),
+      crashLimit(static_cast<size_t>(std::max(options.crashLoopLimit, 1))),
+      windowNs(static_cast<int64_t>(std::max(options.crashLoopWindowSeconds, 1)) * 1000000000LL),
+      random(static_cast<unsigned>(monotonicNanos())) {}
+
+RestartPolicy::Decision RestartPolicy::recordExit(const RunAttempt& attempt) {
+    int64_t now = attempt.exitTimestampNs;
+
+    history.push_back(attempt);
+    while (history.size() > 1 && now - history.front().exitTimestampNs > windowNs) {
+        history.pop_front();
+    }
+
+    // 运行了一个完整窗口才退出的视为已经稳定，退避重新开始计算
+    if (attempt.exitTimestampNs - attempt.startTimestampNs >= windowNs) {
+        quickExits = 0;
+    }
+    quickExits++;
+
+    if (attempt.crashed) {
+        crashTimes.push_back(now);
+    }
+    while (!crashTimes.empty() && now - crashTimes.front() > windowNs) {
+        crashTimes.pop_front();
+    }
+
+    if (mode == RestartMode::Never || (mode == RestartMode::OnFailure && !attempt.crashed)) {
+        return Decision::Stop;
+    }
+    if (crashTimes.size() >= crashLimit) {
+        return Decision::CrashLoop;
+    }
+
+    // 等量抖动：一半固定，一半随机，避免多台机器同时重启
+    if (quickExits <= 1) {
+        delayMs = 0;
+    } else {
+        int shift = std::min(quickExits - 2, 30);
+        int64_t base = std::min(maxDelayMs, initialDelayMs << shift);
+        std::uniform_int_distribution<int64_t> jitter(0, base / 2);
+        delayMs = base - base / 2 + jitter(random);
+    }
+    return Decision::Restart;
+}
+
+void RestartPolicy::setLastCrashLog(const std::string& name) {
+    if (!history.empty()) {
+        history.back().crashLogName = name;
+    }
+}
+
+void RestartPolicy::recordRestartLatency(int64_t latencyNs) {
+    restarts++;
+    latencyTotalNs += latencyNs;
+    latencyMaxNs = std::max(latencyMaxNs, latencyNs);
+}
+
+void RestartPolicy::writeSummary(std::ostream& out) const {
+    if (history.empty()) {
+        return;
+    }
+
+    int64_t origin = history.front().startTimestampNs;
+    char line[160];
+    for (const RunAttempt& attempt : history) {
+        std::snprintf(line, sizeof(line), u8"#%-4d 启动于 +%.3fs  运行 %.3fs  ",
+                      attempt.number, (attempt.startTimestampNs - origin) / 1e9,
+                      (attempt.exitTimestampNs - attempt.startTimestampNs) / 1e9);
+        out << line << attempt.outcome;
+        if (!attempt.crashLogName.empty()) {
+            out << u8"  崩溃日志: " << attempt.crashLogName;
+        }
+        out << "\n";
+    }
+
+    if (restarts > 0) {
+        std::snprintf(line, sizeof(line), u8"重启 %zu 次，重启耗时平均 %.2f ms，最长 %.2f ms（不含退避等待）\n",
+                      restarts, latencyTotalNs / 1e6 / restarts, latencyMaxNs / 1e6);
+        out << line;
+    }
+}
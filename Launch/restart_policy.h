@@ -0,0 +1,70 @@
+#ifndef RESTART_POLICY_H
+#define RESTART_POLICY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <ostream>
+#include <random>
+#include <string>
+
+#include "launch_options.h"
+
+// 一次运行的结果摘要
+struct RunAttempt {
+    int number = 0;               // 从 1 开始
+    int64_t startTimestampNs = 0; // 单调时钟
+    int64_t exitTimestampNs = 0;
+    bool crashed = false;
+    std::string outcome;          // 例如 "退出码 1"、"信号 11"
+    std::string crashLogName;     // 本次单独写出的崩溃日志，为空表示没有
+};
+
+// 根据重启策略决定子进程退出后是否重启、等待多久，并检测崩溃循环
+class RestartPolicy {
+public:
+    enum class Decision {
+        Stop,       // 按策略不再重启
+        Restart,    // 等待 nextDelayMs() 后重启
+        CrashLoop,  // 短时间内崩溃过多，停止重启
+    };
+
+    explicit RestartPolicy(const LaunchOptions& options);
+
+    // 记录一次运行结果并给出下一步动作
+    Decision recordExit(const RunAttempt& attempt);
+
+    // 下一次重启前的等待时间：第一次快速退出后立即重启，之后按指数退避并加入抖动
+    int64_t nextDelayMs() const { return delayMs; }
+
+    // 记下最近一次运行单独写出的崩溃日志文件名
+    void setLastCrashLog(const std::string& name);
+
+    // 当前崩溃窗口内的崩溃次数（含刚记录的一次）
+    size_t crashesInWindow() const { return crashTimes.size(); }
+
+    // 重启时统计从检测到退出到新进程 exec 完成的耗时（不含退避等待）
+    void recordRestartLatency(int64_t latencyNs);
+
+    // 写出窗口内各次运行的摘要与重启耗时，用于崩溃循环汇总报告
+    void writeSummary(std::ostream& out) const;
+
+private:
+    RestartMode mode;
+    int64_t initialDelayMs;
+    int64_t maxDelayMs;
+    size_t crashLimit;
+    int64_t windowNs;
+
+    std::deque<RunAttempt> history;  // 窗口内的运行记录
+    std::deque<int64_t> crashTimes;  // 窗口内各次崩溃的时刻
+    int quickExits = 0;              // 连续运行时间短于窗口的次数
+    int64_t delayMs = 0;
+    std::minstd_rand random;
+
+    size_t restarts = 0;
+    int64_t latencyTotalNs = 0;
+    int64_t latencyMaxNs = 0;
+};
+
+#endif // RESTART_POLICY_H
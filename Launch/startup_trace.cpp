@@ -0,0 +1,326 @@
+#include "startup_trace.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include "crash_report.h"
+#include "output_buffer.h"
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <unistd.h>
+#endif
+
+#ifdef __linux__
+    #include <cstdlib>
+    #include <cstring>
+    #include <ctime>
+    #include <dirent.h>
+    #include "proc_fs.h"
+#endif
+
+namespace {
+
+struct TraceEvent {
+    std::string name;
+    const char* category;
+    int pid;
+    int tid;
+    int64_t beginNs;
+    int64_t endNs;  // 与 beginNs 相同时写为瞬时事件
+    std::vector<std::pair<const char*, double>> args;
+};
+
+struct StartupTraceState {
+    bool enabled = false;
+    bool written = false;
+    bool hasBackground = false;
+    std::string fileName;
+    int launcherPid = 0;
+    int childPid = 0;
+    int64_t childStartNs = 0;
+    std::vector<TraceEvent> events;
+};
+
+StartupTraceState& state() {
+    static StartupTraceState instance;
+    return instance;
+}
+
+bool recording() {
+    return state().enabled && !state().written;
+}
+
+int currentPid() {
+#ifdef _WIN32
+    return static_cast<int>(GetCurrentProcessId());
+#else
+    return static_cast<int>(getpid());
+#endif
+}
+
+#ifdef __linux__
+// /proc/<pid>/stat 中 ')' 之后的字段，fields[0] 对应 man proc 中的第 3 个字段（state）
+bool readStatFields(const std::string& path, std::vector<unsigned long long>& fields) {
+    char buffer[1024];
+    if (readSmallFile(path, buffer, sizeof(buffer)) <= 0) {
+        return false;
+    }
+    const char* cursor = std::strrchr(buffer, ')');
+    if (!cursor) {
+        return false;
+    }
+    cursor += 2;
+    fields.clear();
+    fields.push_back(0);  // state 不是数字
+    cursor = std::strchr(cursor, ' ');
+    while (cursor && *cursor) {
+        char* end;
+        fields.push_back(std::strtoull(cursor + 1, &end, 10));
+        cursor = (*end == ' ') ? end : nullptr;
+    }
+    return fields.size() > 20;
+}
+
+// 启动器进程的创建时刻（换算到单调时钟）。内核以时钟滴答记录，精度通常为 10 ms
+int64_t launcherProcessStartNs(int64_t nowNs) {
+    std::vector<unsigned long long> fields;
+    timespec bootTime;
+    long ticksPerSecond = sysconf(_SC_CLK_TCK);
+    if (!readStatFields("/proc/self/stat", fields) || clock_gettime(CLOCK_BOOTTIME, &bootTime) != 0 ||
+        ticksPerSecond <= 0) {
+        return 0;
+    }
+    int64_t startSinceBootNs = static_cast<int64_t>(fields[19]) * 1000000000 / ticksPerSecond;
+    int64_t nowSinceBootNs = static_cast<int64_t>(bootTime.tv_sec) * 1000000000 + bootTime.tv_nsec;
+    return nowNs - (nowSinceBootNs - startSinceBootNs);
+}
+
+// 子进程全部线程的调度统计与整个进程的缺页次数、CPU 时间
+void addChildSchedulingArgs(int pid, TraceEvent& event) {
+    std::string procDir = "/proc/" + std::to_string(pid);
+    std::vector<unsigned long long> fields;
+    if (readStatFields(procDir + "/stat", fields)) {
+        long ticksPerSecond = sysconf(_SC_CLK_TCK);
+        event.args.emplace_back("minor_faults", static_cast<double>(fields[7]));
+        event.args.emplace_back("major_faults", static_cast<double>(fields[9]));
+        event.args.emplace_back("user_ms", fields[11] * 1000.0 / ticksPerSecond);
+        event.args.emplace_back("system_ms", fields[12] * 1000.0 / ticksPerSecond);
+        event.args.emplace_back("threads", static_cast<double>(fields[17]));
+    }
+
+    // schedstat：在 CPU 上运行的时间、在运行队列中等待的时间（纳秒）与被调度的次数
+    DIR* tasks = opendir((procDir + "/task").c_str());
+    if (!tasks) {
+        return;
+    }
+    unsigned long long runNs = 0, waitNs = 0, slices = 0;
+    bool found = false;
+    while (dirent* entry = readdir(tasks)) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        char buffer[128];
+        std::string path = procDir + "/task/" + entry->d_name + "/schedstat";
+        unsigned long long run, wait, count;
+        if (readSmallFile(path, buffer, sizeof(buffer)) > 0 &&
+            std::sscanf(buffer, "%llu %llu %llu", &run, &wait, &count) == 3) {
+            runNs += run;
+            waitNs += wait;
+            slices += count;
+            found = true;
+        }
+    }
+    closedir(tasks);
+    if (found) {
+        event.args.emplace_back("on_cpu_ms", runNs / 1e6);
+        event.args.emplace_back("runqueue_wait_ms", waitNs / 1e6);
+        event.args.emplace_back("timeslices", static_cast<double>(slices));
+    }
+}
+#endif
+
+void writeEvent(JsonLinesWriter& writer, const TraceEvent& event, int64_t originNs) {
+    writer.beginObject();
+    writer.key("name");
+    writer.value(event.name);
+    writer.key("cat");
+    writer.value(event.category);
+    writer.key("ph");
+    writer.value(event.endNs == event.beginNs ? "i" : "X");
+    // 时间戳与时长都写为整数微秒：浮点数按 %.6g 写出，超过 1 秒后会丢失精度。
+    // 时长取两端各自取整后的差，嵌套的阶段在查看器中不会因为取整而越出外层阶段
+    int64_t beginUs = (event.beginNs - originNs) / 1000;
+    writer.key("ts");
+    writer.value(beginUs);
+    if (event.endNs == event.beginNs) {
+        writer.key("s");
+        writer.value("p");
+    } else {
+        writer.key("dur");
+        writer.value((event.endNs - originNs) / 1000 - beginUs);
+    }
+    writer.key("pid");
+    writer.value(event.pid);
+    writer.key("tid");
+    writer.value(event.tid);
+    if (!event.args.empty()) {
+        writer.key("args");
+        writer.beginObject();
+        for (const auto& arg : event.args) {
+            writer.key(arg.first);
+            writer.value(arg.second);
+        }
+        writer.endObject();
+    }
+    writer.endObject();
+}
+
+void writeMetadata(JsonLinesWriter& writer, const char* kind, int pid, int tid, const char* name) {
+    writer.beginObject();
+    writer.key("name");
+    writer.value(kind);
+    writer.key("ph");
+    writer.value("M");
+    writer.key("pid");
+    writer.value(pid);
+    writer.key("tid");
+    writer.value(tid);
+    writer.key("args");
+    writer.beginObject();
+    writer.key("name");
+    writer.value(name);
+    writer.endObject();
+    writer.endObject();
+}
+
+} // namespace
+
+void configureStartupTrace(const std::string& fileName, int64_t mainEntryNs) {
+    StartupTraceState& trace = state();
+    trace.enabled = !fileName.empty();
+    if (!trace.enabled) {
+        return;
+    }
+    trace.fileName = fileName;
+    trace.launcherPid = currentPid();
+#ifdef __linux__
+    int64_t processStartNs = launcherProcessStartNs(monotonicNanos());
+    if (processStartNs > 0 && processStartNs < mainEntryNs) {
+        traceStartupPhase("process start -> main", processStartNs, mainEntryNs);
+        trace.events.back().args.emplace_back("resolution_ms", 1000.0 / sysconf(_SC_CLK_TCK));
+    }
+#endif
+    traceStartupPhase("parse options", mainEntryNs, monotonicNanos());
+}
+
+bool startupTraceEnabled() {
+    return state().enabled;
+}
+
+void traceStartupPhase(const char* name, int64_t beginNs, int64_t endNs) {
+    if (!recording()) {
+        return;
+    }
+    state().events.push_back({name, "launcher", state().launcherPid, state().launcherPid, beginNs, endNs, {}});
+}
+
+void traceBackgroundPhase(const char* name, int64_t beginNs, int64_t endNs, const char* argName, double argValue) {
+    if (!recording()) {
+        return;
+    }
+    // 后台线程的轨道编号只用于显示，不是真实的线程号
+    state().hasBackground = true;
+    state().events.push_back({name, "launcher", state().launcherPid, 1, beginNs, endNs, {}});
+    if (argName) {
+        state().events.back().args.emplace_back(argName, argValue);
+    }
+}
+
+StartupPhase::StartupPhase(const char* name) : name(name) {
+    if (recording()) {
+        beginNs = monotonicNanos();
+    }
+}
+
+StartupPhase::~StartupPhase() {
+    if (beginNs != 0) {
+        traceStartupPhase(name, beginNs, monotonicNanos());
+    }
+}
+
+void traceChildStarted(int pid, int64_t timestampNs) {
+    if (!recording() || state().childPid != 0) {
+        return;
+    }
+    state().childPid = pid;
+    state().childStartNs = timestampNs;
+    state().events.push_back({"exec", "child", pid, pid, timestampNs, timestampNs, {}});
+}
+
+void traceChildFirstOutput(int pid, int64_t timestampNs) {
+    StartupTraceState& trace = state();
+    if (!recording() || pid != trace.childPid) {
+        return;
+    }
+    TraceEvent firstOutput{"exec -> first output", "child", pid, pid, trace.childStartNs, timestampNs, {}};
+#ifdef __linux__
+    addChildSchedulingArgs(pid, firstOutput);
+#endif
+    trace.events.push_back(firstOutput);
+    trace.events.push_back({"first output", "child", pid, pid, timestampNs, timestampNs, {}});
+    writeStartupTrace();
+}
+
+bool writeStartupTrace() {
+    StartupTraceState& trace = state();
+    if (!recording()) {
+        return false;
+    }
+    trace.written = true;
+
+    std::ofstream file(trace.fileName, std::ios::out | std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << u8"无法写入启动耗时记录: " << trace.fileName << std::endl;
+        return false;
+    }
+
+    // 时间轴以最早的事件为零点
+    int64_t originNs = trace.events.empty() ? 0 : trace.events.front().beginNs;
+    for (const TraceEvent& event : trace.events) {
+        originNs = std::min(originNs, event.beginNs);
+    }
+
+    JsonLinesWriter writer(file);
+    writer.beginObject();
+    writer.key("traceEvents");
+    writer.beginArray();
+    writeMetadata(writer, "process_name", trace.launcherPid, trace.launcherPid, "launcher");
+    if (trace.hasBackground) {
+        writeMetadata(writer, "thread_name", trace.launcherPid, 1, "background");
+    }
+    if (trace.childPid != 0) {
+        writeMetadata(writer, "process_name", trace.childPid, trace.childPid, "SwarmCloneLauncher");
+    }
+    for (const TraceEvent& event : trace.events) {
+        writeEvent(writer, event, originNs);
+    }
+    writer.endArray();
+    writer.key("displayTimeUnit");
+    writer.value("ms");
+    writer.endObject();
+    writer.endRecord();
+
+    if (!file.good()) {
+        std::cerr << u8"无法写入启动耗时记录: " << trace.fileName << std::endl;
+        return false;
+    }
+    std::cout << u8"启动耗时记录已生成: " << trace.fileName << std::endl;
+    trace.events.clear();
+    return true;
+}
@@ -0,0 +1,45 @@
+#ifndef STARTUP_TRACE_H
+#define STARTUP_TRACE_H
+
+#include <cstdint>
+#include <string>
+
+// 启动耗时分解（--trace-startup）：记录启动器各阶段与子进程第一次输出的单调时钟时间，
+// 并在第一次输出时读取子进程的调度统计与缺页次数，写出 Chrome trace 格式的 JSON
+// （可在 chrome://tracing 或 Perfetto 中打开）。只记录第一次运行，写出后不再记录。
+// 未启用时各函数只做一次判断，不读取时钟
+
+// fileName 为空时关闭；mainEntryNs 为 main() 入口处的 monotonicNanos()
+void configureStartupTrace(const std::string& fileName, int64_t mainEntryNs);
+bool startupTraceEnabled();
+
+// 记录一个已完成的启动器阶段
+void traceStartupPhase(const char* name, int64_t beginNs, int64_t endNs);
+
+// 记录一个与主线程并行的后台阶段（显示在单独的轨道上），可附带一个数值参数
+void traceBackgroundPhase(const char* name, int64_t beginNs, int64_t endNs, const char* argName = nullptr,
+                          double argValue = 0);
+
+// 在作用域内计时的启动器阶段
+class StartupPhase {
+public:
+    explicit StartupPhase(const char* name);
+    ~StartupPhase();
+    StartupPhase(const StartupPhase&) = delete;
+    StartupPhase& operator=(const StartupPhase&) = delete;
+
+private:
+    const char* name;
+    int64_t beginNs = 0;
+};
+
+// 子进程 exec 成功的时刻
+void traceChildStarted(int pid, int64_t timestampNs);
+
+// 子进程第一次输出的时刻：读取调度统计后写出 trace
+void traceChildFirstOutput(int pid, int64_t timestampNs);
+
+// 写出 trace 文件，只在第一次调用时生效。子进程没有任何输出就退出时由调用方在退出后调用
+bool writeStartupTrace();
+
+#endif // STARTUP_TRACE_H
@@ -0,0 +1,534 @@
+#include "supervisor.h"
+#include "startup_trace.h"
+
+#ifndef _WIN32
+
+#include <iostream>
+
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#ifdef __linux__
+    #include <sys/epoll.h>
+    #include <sys/signalfd.h>
+    #include <sys/syscall.h>
+#endif
+
+namespace {
+
+void setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags != -1) {
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    }
+}
+
+void setCloseOnExec(int fd) {
+    int flags = fcntl(fd, F_GETFD, 0);
+    if (flags != -1) {
+        fcntl(fd, F_SETFD, flags | FD_CLOEXEC);
+    }
+}
+
+bool createPipe(int fds[2]) {
+    if (pipe(fds) == -1) {
+        return false;
+    }
+    setCloseOnExec(fds[0]);
+    setCloseOnExec(fds[1]);
+    return true;
+}
+
+int openPidFd(pid_t pid) {
+#if defined(__linux__) && defined(SYS_pidfd_open)
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+    (void)pid;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+#ifndef __linux__
+// 非 Linux 系统使用自管道把 SIGCHLD 转换为可读事件
+int sigchldPipe[2] = {-1, -1};
+
+void sigchldHandler(int) {
+    int savedErrno = errno;
+    char byte = 0;
+    ssize_t ignored = write(sigchldPipe[1], &byte, 1);
+    (void)ignored;
+    errno = savedErrno;
+}
+#endif
+
+} // namespace
+
+// ---------------- EventLoop ----------------
+
+EventLoop::EventLoop() {
+#ifdef __linux__
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd == -1) {
+        std::cerr << u8"创建 epoll 失败，改用 poll" << std::endl;
+    }
+#endif
+}
+
+EventLoop::~EventLoop() {
+    for (const auto& entry : childPidFds) {
+        close(entry.second);
+    }
+#ifdef __linux__
+    if (sigchldFd != -1) {
+        close(sigchldFd);
+    }
+#endif
+    if (epollFd != -1) {
+        close(epollFd);
+    }
+}
+
+bool EventLoop::addFd(int fd, FdCallback onReadable) {
+#ifdef __linux__
+    if (epollFd != -1) {
+        epoll_event event{};
+        event.events = onReadable ? EPOLLIN : 0;
+        event.data.fd = fd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) == -1) {
+            return false;
+        }
+    }
+#endif
+    fdCallbacks[fd] = std::move(onReadable);
+    return true;
+}
+
+void EventLoop::removeFd(int fd) {
+    writeCallbacks.erase(fd);
+    if (fdCallbacks.erase(fd) == 0) {
+        return;
+    }
+#ifdef __linux__
+    if (epollFd != -1) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    }
+#endif
+}
+
+bool EventLoop::setWritable(int fd, FdCallback onWritable) {
+    if (fdCallbacks.count(fd) == 0) {
+        return false;
+    }
+    bool enable = static_cast<bool>(onWritable);
+    if (enable) {
+        writeCallbacks[fd] = std::move(onWritable);
+    } else {
+        writeCallbacks.erase(fd);
+    }
+#ifdef __linux__
+    if (epollFd != -1) {
+        epoll_event event{};
+        event.events = (fdCallbacks[fd] ? static_cast<uint32_t>(EPOLLIN) : 0u) |
+                       (enable ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+        event.data.fd = fd;
+        return epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event) == 0;
+    }
+#endif
+    return true;
+}
+
+int EventLoop::addTimer(std::chrono::milliseconds interval, TimerCallback callback) {
+    int timerId = nextTimerId++;
+    timers[timerId] = Timer{std::chrono::steady_clock::now() + interval, interval, std::move(callback)};
+    return timerId;
+}
+
+void EventLoop::cancelTimer(int timerId) {
+    timers.erase(timerId);
+}
+
+void EventLoop::post(std::function<void()> callback) {
+    posted.push_back(std::move(callback));
+}
+
+void EventLoop::watchChild(pid_t pid, std::function<void()> onMaybeExited) {
+    int pidFd = openPidFd(pid);
+    if (pidFd != -1) {
+        setCloseOnExec(pidFd);
+        childPidFds[pid] = pidFd;
+        addFd(pidFd, onMaybeExited);
+    } else {
+        if (!ensureSigchldSource()) {
+            std::cerr << u8"无法监听子进程退出信号" << std::endl;
+        }
+        childWatchers[pid] = onMaybeExited;
+    }
+
+    // 子进程可能在开始监听之前就已退出，立即检查一次
+    post(std::move(onMaybeExited));
+}
+
+void EventLoop::unwatchChild(pid_t pid) {
+    auto it = childPidFds.find(pid);
+    if (it != childPidFds.end()) {
+        removeFd(it->second);
+        close(it->second);
+        childPidFds.erase(it);
+    }
+    childWatchers.erase(pid);
+}
+
+bool EventLoop::ensureSigchldSource() {
+    if (sigchldFd != -1) {
+        return true;
+    }
+
+#ifdef __linux__
+    // 屏蔽 SIGCHLD 后通过 signalfd 读取；子进程在 exec 前会恢复信号掩码
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    if (sigprocmask(SIG_BLOCK, &mask, nullptr) == -1) {
+        return false;
+    }
+    sigchldFd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+#else
+    if (!createPipe(sigchldPipe)) {
+        return false;
+    }
+    setNonBlocking(sigchldPipe[0]);
+    setNonBlocking(sigchldPipe[1]);
+
+    struct sigaction action{};
+    action.sa_handler = sigchldHandler;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+    if (sigaction(SIGCHLD, &action, nullptr) == -1) {
+        return false;
+    }
+    sigchldFd = sigchldPipe[0];
+#endif
+
+    if (sigchldFd == -1) {
+        return false;
+    }
+    return addFd(sigchldFd, [this]() { handleSigchld(); });
+}
+
+void EventLoop::handleSigchld() {
+    // 清空通知，然后让每个被监听的子进程自行确认是否已退出
+    char buffer[256];
+    while (read(sigchldFd, buffer, sizeof(buffer)) > 0) {
+    }
+
+    std::vector<std::function<void()>> watchers;
+    for (const auto& entry : childWatchers) {
+        watchers.push_back(entry.second);
+    }
+    for (const auto& watcher : watchers) {
+        watcher();
+    }
+}
+
+int EventLoop::nextTimeoutMs() const {
+    if (!posted.empty()) {
+        return 0;
+    }
+    if (timers.empty()) {
+        return -1;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    auto nearest = timers.begin()->second.deadline;
+    for (const auto& entry : timers) {
+        if (entry.second.deadline < nearest) {
+            nearest = entry.second.deadline;
+        }
+    }
+    if (nearest <= now) {
+        return 0;
+    }
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(nearest - now).count();
+    return static_cast<int>(remaining) + 1;
+}
+
+void EventLoop::fireDueTimers() {
+    auto now = std::chrono::steady_clock::now();
+
+    std::vector<int> due;
+    for (const auto& entry : timers) {
+        if (entry.second.deadline <= now) {
+            due.push_back(entry.first);
+        }
+    }
+
+    for (int timerId : due) {
+        auto it = timers.find(timerId);
+        if (it == timers.end()) {
+            continue; // 已被前面的回调取消
+        }
+        it->second.deadline += it->second.interval;
+        if (it->second.deadline <= now) {
+            it->second.deadline = now + it->second.interval;
+        }
+        TimerCallback callback = it->second.callback;
+        callback();
+    }
+}
+
+void EventLoop::runPosted() {
+    while (!posted.empty()) {
+        std::vector<std::function<void()>> callbacks;
+        callbacks.swap(posted);
+        for (const auto& callback : callbacks) {
+            callback();
+        }
+    }
+}
+
+void EventLoop::run() {
+    stopped = false;
+
+    std::vector<std::pair<int, bool>> readyFds;  // (fd, 是否为可写事件)
+    while (!stopped) {
+        runPosted();
+        if (stopped) {
+            break;
+        }
+
+        int timeoutMs = nextTimeoutMs();
+        readyFds.clear();
+
+#ifdef __linux__
+        if (epollFd != -1) {
+            epoll_event events[16];
+            int count = epoll_wait(epollFd, events, 16, timeoutMs);
+            if (count == -1 && errno != EINTR) {
+                std::cerr << u8"epoll_wait 失败: " << errno << std::endl;
+                return;
+            }
+            for (int i = 0; i < count; i++) {
+                int fd = events[i].data.fd;
+                if (events[i].events & EPOLLOUT) {
+                    readyFds.emplace_back(fd, true);
+                }
+                if (events[i].events & ~EPOLLOUT) {
+                    readyFds.emplace_back(fd, false);
+                }
+            }
+        } else
+#endif
+        {
+            std::vector<pollfd> pollFds;
+            for (const auto& entry : fdCallbacks) {
+                short events = (entry.second ? POLLIN : 0) | (writeCallbacks.count(entry.first) ? POLLOUT : 0);
+                pollFds.push_back(pollfd{entry.first, events, 0});
+            }
+            int count = poll(pollFds.data(), pollFds.size(), timeoutMs);
+            if (count == -1 && errno != EINTR) {
+                std::cerr << u8"poll 失败: " << errno << std::endl;
+                return;
+            }
+            for (const auto& pfd : pollFds) {
+                if (pfd.revents & POLLOUT) {
+                    readyFds.emplace_back(pfd.fd, true);
+                }
+                if (pfd.revents & ~POLLOUT) {
+                    readyFds.emplace_back(pfd.fd, false);
+                }
+            }
+        }
+
+        for (const auto& ready : readyFds) {
+            // 只写的 fd 没有可读回调，出错或挂断时由可写回调处理
+            auto readable = fdCallbacks.find(ready.first);
+            bool writeOnly = readable != fdCallbacks.end() && !readable->second;
+            std::map<int, FdCallback>& callbacks = ready.second || writeOnly ? writeCallbacks : fdCallbacks;
+            auto it = callbacks.find(ready.first);
+            if (it == callbacks.end()) {
+                continue; // 已被前面的回调移除
+            }
+            FdCallback callback = it->second;
+            callback();
+        }
+
+        fireDueTimers();
+    }
+}
+
+// ---------------- SupervisedChild ----------------
+
+SupervisedChild::SupervisedChild(EventLoop& loop) : loop(loop) {}
+
+SupervisedChild::~SupervisedChild() {
+    if (childPid > 0) {
+        loop.unwatchChild(childPid);
+    }
+    closePipes();
+}
+
+void SupervisedChild::setForwarding(int stdoutConsole, int stderrConsole, RollingCaptureFile* capture, bool zeroCopy) {
+    stdoutConsoleFd = stdoutConsole;
+    stderrConsoleFd = stderrConsole;
+    captureFile = capture;
+    zeroCopyTee = zeroCopy;
+}
+
+void SupervisedChild::inheritFd(int fd, const std::string& envName) {
+    inheritedFds.emplace_back(fd, envName);
+}
+
+bool SupervisedChild::start(const LaunchSpec& spec) {
+    int64_t pipeStartNs = monotonicNanos();
+    int stdoutPipe[2];
+    int stderrPipe[2];
+    if (!createPipe(stdoutPipe)) {
+        std::cerr << u8"创建管道失败" << std::endl;
+        return false;
+    }
+    if (!createPipe(stderrPipe)) {
+        std::cerr << u8"创建管道失败" << std::endl;
+        close(stdoutPipe[0]);
+        close(stdoutPipe[1]);
+        return false;
+    }
+
+    // 标准输出与错误接到各自的管道，继承的 fd 通过环境变量告知编号
+    LaunchSpec childSpec = spec;
+    childSpec.fdMap.insert(childSpec.fdMap.begin(), {{STDOUT_FILENO, stdoutPipe[1]}, {STDERR_FILENO, stderrPipe[1]}});
+    for (const auto& inherited : inheritedFds) {
+        childSpec.fdMap.emplace_back(inherited.first, inherited.first);
+        childSpec.env.push_back(inherited.second + "=" + std::to_string(inherited.first));
+    }
+    inheritedFds.clear();
+
+    std::vector<std::string> warnings;
+    std::string error;
+    int64_t spawnStartNs = monotonicNanos();
+    traceStartupPhase("create pipes", pipeStartNs, spawnStartNs);
+    pid_t pid = spawnProcess(childSpec, SpawnMethod::Auto, warnings, error);
+    int64_t spawnEndNs = monotonicNanos();
+    traceStartupPhase("spawn", spawnStartNs, spawnEndNs);
+    close(stdoutPipe[1]);
+    close(stderrPipe[1]);
+    for (const std::string& warning : warnings) {
+        std::cerr << warning << std::endl;
+    }
+    if (pid == -1) {
+        std::cerr << u8"无法启动程序: " << error << std::endl;
+        close(stdoutPipe[0]);
+        close(stderrPipe[0]);
+        return false;
+    }
+
+    childPid = pid;
+    reaped = false;
+    traceChildStarted(pid, spawnEndNs);
+    stdoutFd = stdoutPipe[0];
+    stderrFd = stderrPipe[0];
+    setNonBlocking(stdoutFd);
+    setNonBlocking(stderrFd);
+    stdoutTee.reset(new PipeTee(stdoutConsoleFd, captureFile, zeroCopyTee));
+    stderrTee.reset(new PipeTee(stderrConsoleFd, captureFile, zeroCopyTee));
+
+    loop.addFd(stdoutFd, [this]() { drainPipe(stdoutFd, OutputStream::Stdout, false); });
+    loop.addFd(stderrFd, [this]() { drainPipe(stderrFd, OutputStream::Stderr, false); });
+    loop.watchChild(childPid, [this]() { handleExitNotification(); });
+    return true;
+}
+
+void SupervisedChild::drainPipe(int& fd, OutputStream stream, bool untilEmpty) {
+    // 子进程退出后最多再读取这么多次，避免孙进程持续写入时无法结束
+    const int maxReadsAfterExit = 64;
+
+    PipeTee* tee = (stream == OutputStream::Stderr) ? stderrTee.get() : stdoutTee.get();
+
+    char buffer[65536];
+    int reads = 0;
+    while (fd != -1) {
+        ssize_t bytesRead = tee ? tee->pump(fd, buffer, sizeof(buffer)) : read(fd, buffer, sizeof(buffer));
+        if (bytesRead > 0) {
+            if (outputHandler) {
+                OutputChunk chunk{stream, monotonicNanos(), buffer, static_cast<size_t>(bytesRead)};
+                outputHandler(chunk);
+            }
+            if (!untilEmpty || ++reads >= maxReadsAfterExit) {
+                return;
+            }
+            continue;
+        }
+        if (bytesRead == -1 && errno == EINTR) {
+            continue;
+        }
+        if (bytesRead == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        }
+
+        // EOF 或读取错误：该输出流已结束
+        loop.removeFd(fd);
+        close(fd);
+        fd = -1;
+    }
+}
+
+void SupervisedChild::closePipes() {
+    for (int* fd : {&stdoutFd, &stderrFd}) {
+        if (*fd != -1) {
+            loop.removeFd(*fd);
+            close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+void SupervisedChild::handleExitNotification() {
+    if (childPid <= 0 || reaped) {
+        return;
+    }
+
+    int status = 0;
+    pid_t result = waitpid(childPid, &status, WNOHANG);
+    if (result == 0) {
+        return; // 尚未退出
+    }
+    if (result == -1 && errno == EINTR) {
+        return;
+    }
+
+    reaped = true;
+    loop.unwatchChild(childPid);
+
+    // 读取管道中剩余的输出，但不等待仍持有管道的孙进程
+    drainPipe(stdoutFd, OutputStream::Stdout, true);
+    drainPipe(stderrFd, OutputStream::Stderr, true);
+    closePipes();
+
+    ChildExitStatus exitStatus;
+    if (result == childPid) {
+        if (WIFEXITED(status)) {
+            exitStatus.exited = true;
+            exitStatus.exitCode = WEXITSTATUS(status);
+        } else if (WIFSIGNALED(status)) {
+            exitStatus.signaled = true;
+            exitStatus.signal = WTERMSIG(status);
+#ifdef WCOREDUMP
+            exitStatus.coreDumped = WCOREDUMP(status);
+#endif
+        }
+    } else {
+        std::cerr << u8"获取子进程状态失败: " << errno << std::endl;
+    }
+
+    if (exitHandler) {
+        exitHandler(exitStatus);
+    }
+}
+
+#endif // _WIN32
@@ -0,0 +1,145 @@
+#ifndef SUPERVISOR_H
+#define SUPERVISOR_H
+
+#ifndef _WIN32
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+#include "output_buffer.h"
+#include "output_tee.h"
+#include "process_spawn.h"
+
+// 单线程事件循环：Linux 上基于 epoll，其他 POSIX 系统上基于 poll。
+// 文件描述符可读事件与定时器在同一个循环中处理。
+class EventLoop {
+public:
+    using FdCallback = std::function<void()>;
+    using TimerCallback = std::function<void()>;
+
+    EventLoop();
+    ~EventLoop();
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // onReadable 为空时只通过 setWritable 监听可写事件（用于只写的 fd），出错或挂断也交给可写回调
+    bool addFd(int fd, FdCallback onReadable);
+    void removeFd(int fd);
+
+    // 为已添加的 fd 设置可写回调，回调为空时不再监听可写事件。用于分段写出较大的响应
+    bool setWritable(int fd, FdCallback onWritable);
+
+    // 添加周期性定时器，返回定时器编号
+    int addTimer(std::chrono::milliseconds interval, TimerCallback callback);
+    void cancelTimer(int timerId);
+
+    // 在下一轮循环开始时执行一次
+    void post(std::function<void()> callback);
+
+    // 监听子进程退出：子进程可能已退出时调用 onMaybeExited，由调用方 waitpid(WNOHANG) 确认。
+    // 优先使用 pidfd，不支持时退回到所有子进程共享的 SIGCHLD 通知
+    void watchChild(pid_t pid, std::function<void()> onMaybeExited);
+    void unwatchChild(pid_t pid);
+
+    // 运行直到 stop() 被调用
+    void run();
+    void stop() { stopped = true; }
+
+private:
+    struct Timer {
+        std::chrono::steady_clock::time_point deadline;
+        std::chrono::milliseconds interval;
+        TimerCallback callback;
+    };
+
+    int nextTimeoutMs() const;
+    void fireDueTimers();
+    void runPosted();
+    bool ensureSigchldSource();
+    void handleSigchld();
+
+    int epollFd = -1;
+    bool stopped = false;
+    std::map<int, FdCallback> fdCallbacks;
+    std::map<int, FdCallback> writeCallbacks;
+    std::map<int, Timer> timers;
+    int nextTimerId = 1;
+    std::vector<std::function<void()>> posted;
+
+    std::map<pid_t, int> childPidFds;  // pid -> pidfd
+    std::map<pid_t, std::function<void()>> childWatchers;
+    int sigchldFd = -1;                // signalfd 或自管道读端
+};
+
+// 子进程的退出状态
+struct ChildExitStatus {
+    bool exited = false;      // 正常退出
+    int exitCode = 0;
+    bool signaled = false;    // 被信号终止
+    int signal = 0;
+    bool coreDumped = false;
+};
+
+// 受监管的子进程：stdout 与 stderr 使用独立的非阻塞管道，
+// 退出通过 pidfd（Linux 5.3+）、signalfd 或 SIGCHLD 自管道在事件循环中通知。
+// 子进程退出后只读取管道中已有的数据，不等待孙进程关闭管道。
+class SupervisedChild {
+public:
+    using OutputHandler = std::function<void(const OutputChunk&)>;
+    using ExitHandler = std::function<void(const ChildExitStatus&)>;
+
+    explicit SupervisedChild(EventLoop& loop);
+    ~SupervisedChild();
+    SupervisedChild(const SupervisedChild&) = delete;
+    SupervisedChild& operator=(const SupervisedChild&) = delete;
+
+    void onOutput(OutputHandler handler) { outputHandler = std::move(handler); }
+    void onExit(ExitHandler handler) { exitHandler = std::move(handler); }
+
+    // 设置输出转发目标（-1 表示不转发），需在 start() 之前调用。
+    // 转发在内核中完成时 onOutput 仍会收到同样的数据
+    void setForwarding(int stdoutConsoleFd, int stderrConsoleFd, RollingCaptureFile* capture, bool zeroCopy);
+
+    // 让下一次启动的子进程继承 fd，并通过环境变量 envName 告知其编号；只对下一次 start() 有效
+    void inheritFd(int fd, const std::string& envName);
+
+    // 按 spec 启动程序，标准输出与错误接到监管管道上，返回时新程序已经 exec 成功。
+    // 可在上一次运行退出后再次调用
+    bool start(const LaunchSpec& spec);
+
+    pid_t pid() const { return childPid; }
+    bool running() const { return childPid > 0 && !reaped; }
+
+private:
+    void handleExitNotification();
+    void drainPipe(int& fd, OutputStream stream, bool untilEmpty);
+    void closePipes();
+
+    EventLoop& loop;
+    OutputHandler outputHandler;
+    ExitHandler exitHandler;
+
+    pid_t childPid = -1;
+    bool reaped = false;
+    int stdoutFd = -1;
+    int stderrFd = -1;
+
+    int stdoutConsoleFd = -1;
+    int stderrConsoleFd = -1;
+    RollingCaptureFile* captureFile = nullptr;
+    bool zeroCopyTee = false;
+    std::vector<std::pair<int, std::string>> inheritedFds;
+    std::unique_ptr<PipeTee> stdoutTee;
+    std::unique_ptr<PipeTee> stderrTee;
+};
+
+#endif // _WIN32
+
+#endif // SUPERVISOR_H
@@ -1,9 +1,15 @@
 #include "system_info.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <iomanip>
 #include <sstream>
 #include <fstream>
 #include <iostream>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
 
 #ifdef _WIN32
     #include <windows.h>
@@ -24,9 +30,16 @@
     #include <fcntl.h>
     #include <sys/utsname.h>
     #include <sys/sysinfo.h>
+    #include <dirent.h>
     #ifdef __APPLE__
         #include <sys/types.h>
         #include <sys/sysctl.h>
+    #else
+        #include "pci_ids.h"
+        #include "proc_fs.h"
+        #if defined(__x86_64__) || defined(__i386__)
+            #include <cpuid.h>
+        #endif
     #endif
 #endif
 
@@ -276,6 +289,107 @@ std::string getSystemType() {
 
 #else
 // Linux/macOS系统信息获取
+#ifndef __APPLE__
+// 处理器型号：x86 上直接读取 CPUID 品牌字符串，其他架构只读取 /proc/cpuinfo 的开头部分
+static std::string getCpuModelName() {
+#if defined(__x86_64__) || defined(__i386__)
+    if (__get_cpuid_max(0x80000000, nullptr) >= 0x80000004) {
+        unsigned int brand[12];
+        for (unsigned int i = 0; i < 3; i++) {
+            __get_cpuid(0x80000002 + i, &brand[i * 4], &brand[i * 4 + 1], &brand[i * 4 + 2], &brand[i * 4 + 3]);
+        }
+        std::string name(reinterpret_cast<const char*>(brand), sizeof(brand));
+        name = name.c_str();
+        size_t first = name.find_first_not_of(' ');
+        if (first != std::string::npos) {
+            return name.substr(first);
+        }
+    }
+#endif
+
+    char buffer[4096];
+    if (readSmallFile("/proc/cpuinfo", buffer, sizeof(buffer)) <= 0) {
+        return "";
+    }
+    for (const char* key : {"model name", "Hardware", "Processor", "cpu model"}) {
+        const char* line = std::strstr(buffer, key);
+        if (!line) {
+            continue;
+        }
+        const char* colon = std::strchr(line, ':');
+        const char* end = std::strchr(line, '\n');
+        if (colon && (!end || colon < end)) {
+            colon++;
+            while (*colon == ' ' || *colon == '\t') {
+                colon++;
+            }
+            return end ? std::string(colon, end) : std::string(colon);
+        }
+    }
+    return "";
+}
+
+// 从 /sys/devices/system/cpu 读取插槽、核心、线程、缓存与频率范围
+static std::string getCpuTopology() {
+    const std::string base = "/sys/devices/system/cpu/";
+    char buffer[256];
+    if (readSmallFile(base + "online", buffer, sizeof(buffer)) <= 0) {
+        return "";
+    }
+
+    std::vector<long> cpus = parseCpuList(buffer);
+    std::vector<long> packages;
+    std::vector<std::pair<long, long>> cores;
+    for (long cpu : cpus) {
+        std::string topology = base + "cpu" + std::to_string(cpu) + "/topology/";
+        long package = 0;
+        long core = cpu;
+        readSysfsLong(topology + "physical_package_id", package);
+        readSysfsLong(topology + "core_id", core);
+        if (std::find(packages.begin(), packages.end(), package) == packages.end()) {
+            packages.push_back(package);
+        }
+        if (std::find(cores.begin(), cores.end(), std::make_pair(package, core)) == cores.end()) {
+            cores.emplace_back(package, core);
+        }
+    }
+
+    std::string result = std::to_string(packages.size()) + u8" 个插槽，" + std::to_string(cores.size()) +
+                         u8" 核 " + std::to_string(cpus.size()) + u8" 线程";
+
+    std::string caches;
+    for (int index = 0; index < 8; index++) {
+        std::string cacheDir = base + "cpu0/cache/index" + std::to_string(index) + "/";
+        long level = 0;
+        char type[32];
+        char size[32];
+        if (!readSysfsLong(cacheDir + "level", level) ||
+            readSmallFile(cacheDir + "type", type, sizeof(type)) <= 0 ||
+            readSmallFile(cacheDir + "size", size, sizeof(size)) <= 0) {
+            break;
+        }
+        std::string name = "L" + std::to_string(level);
+        if (std::strcmp(type, "Data") == 0) {
+            name += "d";
+        } else if (std::strcmp(type, "Instruction") == 0) {
+            name += "i";
+        }
+        caches += (caches.empty() ? "" : " / ") + name + " " + size;
+    }
+    if (!caches.empty()) {
+        result += u8"，" + caches;
+    }
+
+    long minKHz = 0;
+    long maxKHz = 0;
+    if (readSysfsLong(base + "cpu0/cpufreq/cpuinfo_min_freq", minKHz) &&
+        readSysfsLong(base + "cpu0/cpufreq/cpuinfo_max_freq", maxKHz)) {
+        result += u8"，" + std::to_string(minKHz / 1000) + "-" + std::to_string(maxKHz / 1000) + " MHz";
+    }
+    return result;
+}
+#endif
+
 std::string getUnixVersion() {
     struct utsname buf;
     if (uname(&buf) == 0) {
@@ -298,19 +412,10 @@ std::string getCpuInfo() {
     }
 #else
     // Linux 获取CPU信息
-    std::ifstream cpuinfo("/proc/cpuinfo");
-    if (cpuinfo.is_open()) {
-        std::string line;
-        while (std::getline(cpuinfo, line)) {
-            if (line.find("model name") != std::string::npos) {
-                size_t pos = line.find(":");
-                if (pos != std::string::npos) {
-                    cpuInfo = line.substr(pos + 2);
-                    break;
-                }
-            }
-        }
-        cpuinfo.close();
+    cpuInfo = getCpuModelName();
+    std::string topology = getCpuTopology();
+    if (!topology.empty()) {
+        cpuInfo = (cpuInfo.empty() ? "Unknown CPU" : cpuInfo) + u8"（" + topology + u8"）";
     }
 #endif
 
@@ -366,19 +471,49 @@ std::vector<std::string> getGpuInfo() {
         pclose(pipe);
     }
 #else
-    // Linux 获取GPU信息
-    FILE* pipe = popen("lspci | grep -i vga", "r");
-    if (pipe) {
-        char buffer[256];
-        while (fgets(buffer, sizeof(buffer), pipe) != NULL) {
-            std::string line(buffer);
-            // 提取GPU名称
-            size_t pos = line.find(": ");
-            if (pos != std::string::npos) {
-                gpus.push_back(line.substr(pos + 2));
+    // Linux 获取GPU信息：扫描 PCI 设备中的显示控制器（类别 0x03xxxx）
+    const std::string pciRoot = "/sys/bus/pci/devices/";
+    std::vector<std::string> slots;
+    if (DIR* dir = opendir(pciRoot.c_str())) {
+        while (dirent* entry = readdir(dir)) {
+            if (entry->d_name[0] != '.') {
+                slots.push_back(entry->d_name);
             }
         }
-        pclose(pipe);
+        closedir(dir);
+    }
+    std::sort(slots.begin(), slots.end());
+
+    for (const auto& slot : slots) {
+        std::string device = pciRoot + slot + "/";
+        long classCode = 0;
+        long vendorId = 0;
+        long deviceId = 0;
+        if (!readSysfsLong(device + "class", classCode, 16) || (classCode >> 16) != 0x03 ||
+            !readSysfsLong(device + "vendor", vendorId, 16) ||
+            !readSysfsLong(device + "device", deviceId, 16)) {
+            continue;
+        }
+
+        char ids[16];
+        std::snprintf(ids, sizeof(ids), "%04lx:%04lx", vendorId, deviceId);
+
+        const char* vendorName = lookupPciVendor(static_cast<uint16_t>(vendorId));
+        const char* deviceName = lookupPciDevice(static_cast<uint16_t>(vendorId), static_cast<uint16_t>(deviceId));
+        std::string name = vendorName ? vendorName : "Vendor " + std::string(ids, 4);
+        name += " ";
+        name += deviceName ? deviceName : "Device " + std::string(ids + 5);
+        name += " [" + std::string(ids) + "]";
+
+        // 附上正在使用的驱动，便于排查驱动问题
+        char driverPath[256];
+        ssize_t length = readlink((device + "driver").c_str(), driverPath, sizeof(driverPath) - 1);
+        if (length > 0) {
+            driverPath[length] = '\0';
+            const char* driver = std::strrchr(driverPath, '/');
+            name += u8"（驱动: " + std::string(driver ? driver + 1 : driverPath) + u8"）";
+        }
+        gpus.push_back(name);
     }
 #endif
 
@@ -406,3 +541,177 @@ std::string getSystemType() {
     return "Unknown System Type";
 }
 #endif
+
+// ---------------- 系统信息缓存 ----------------
+
+namespace {
+
+uint64_t fnv1a64(const std::string& text) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : text) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// 缓存文件每行一个字段，值中的换行和反斜杠需要转义
+std::string escapeCacheValue(const std::string& value) {
+    std::string escaped;
+    for (char c : value) {
+        if (c == '\\') {
+            escaped += "\\\\";
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+std::string unescapeCacheValue(const std::string& value) {
+    std::string result;
+    for (size_t i = 0; i < value.size(); i++) {
+        if (value[i] == '\\' && i + 1 < value.size()) {
+            result += (value[i + 1] == 'n') ? '\n' : value[i + 1];
+            i++;
+        } else {
+            result += value[i];
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+SystemInventory collectSystemInventory() {
+    SystemInventory inventory;
+#ifdef _WIN32
+    inventory.osVersion = getWindowsVersion();
+#else
+    inventory.osVersion = getUnixVersion();
+#endif
+    inventory.cpu = getCpuInfo();
+    inventory.memory = getMemoryInfo();
+    inventory.gpus = getGpuInfo();
+    inventory.systemType = getSystemType();
+    return inventory;
+}
+
+std::string systemInventoryKey() {
+    std::string identity;
+
+#ifdef _WIN32
+    // 开机时间 = 当前时间 - 已运行时间，取整到分钟以抵消两次读取之间的误差
+    auto now = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    long long bootMinute = (now - static_cast<long long>(GetTickCount64() / 1000)) / 60;
+    identity = getWindowsVersion() + "|" + std::to_string(bootMinute);
+#else
+    struct utsname buf;
+    if (uname(&buf) == 0) {
+        identity = std::string(buf.sysname) + "|" + buf.release + "|" + buf.version + "|" + buf.machine;
+    }
+    #ifdef __APPLE__
+        struct timeval bootTime;
+        size_t size = sizeof(bootTime);
+        if (sysctlbyname("kern.boottime", &bootTime, &size, NULL, 0) == 0) {
+            identity += "|" + std::to_string(bootTime.tv_sec);
+        }
+    #else
+        std::ifstream bootId("/proc/sys/kernel/random/boot_id");
+        std::string line;
+        if (std::getline(bootId, line)) {
+            identity += "|" + line;
+        }
+    #endif
+#endif
+
+    std::stringstream ss;
+    ss << std::hex << std::setfill('0') << std::setw(16) << fnv1a64(identity);
+    return ss.str();
+}
+
+bool loadSystemInventoryCache(const std::string& path, const std::string& key, SystemInventory& inventory) {
+    std::ifstream cache(path);
+    if (!cache.is_open()) {
+        return false;
+    }
+
+    SystemInventory loaded;
+    bool keyMatched = false;
+    std::string line;
+    while (std::getline(cache, line)) {
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) {
+            continue;
+        }
+        std::string name = line.substr(0, eq);
+        std::string value = unescapeCacheValue(line.substr(eq + 1));
+
+        if (name == "key") {
+            keyMatched = (value == key);
+        } else if (name == "os") {
+            loaded.osVersion = value;
+        } else if (name == "cpu") {
+            loaded.cpu = value;
+        } else if (name == "memory") {
+            loaded.memory = value;
+        } else if (name == "gpu") {
+            loaded.gpus.push_back(value);
+        } else if (name == "systemType") {
+            loaded.systemType = value;
+        }
+    }
+
+    if (!keyMatched || loaded.gpus.empty()) {
+        return false;
+    }
+    inventory = loaded;
+    return true;
+}
+
+bool saveSystemInventoryCache(const std::string& path, const std::string& key, const SystemInventory& inventory) {
+    // 先写临时文件再改名，避免多个启动器同时写入时留下半个文件
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream cache(tempPath, std::ios::trunc);
+        if (!cache.is_open()) {
+            return false;
+        }
+        cache << "key=" << key << "\n";
+        cache << "os=" << escapeCacheValue(inventory.osVersion) << "\n";
+        cache << "cpu=" << escapeCacheValue(inventory.cpu) << "\n";
+        cache << "memory=" << escapeCacheValue(inventory.memory) << "\n";
+        for (const auto& gpu : inventory.gpus) {
+            cache << "gpu=" << escapeCacheValue(gpu) << "\n";
+        }
+        cache << "systemType=" << escapeCacheValue(inventory.systemType) << "\n";
+        if (!cache.good()) {
+            return false;
+        }
+    }
+    // filesystem::rename 直接覆盖旧缓存（Windows 上为 MoveFileExW(MOVEFILE_REPLACE_EXISTING)），
+    // 并发启动的另一个启动器不会读到缓存缺失的中间状态
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    return !error;
+}
+
+SystemInventoryPrefetcher::SystemInventoryPrefetcher(const std::string& cachePath) {
+    result = std::async(std::launch::async, [cachePath]() {
+        std::string key = systemInventoryKey();
+        SystemInventory inventory;
+        if (loadSystemInventoryCache(cachePath, key, inventory)) {
+            return inventory;
+        }
+        inventory = collectSystemInventory();
+        saveSystemInventoryCache(cachePath, key, inventory);
+        return inventory;
+    }).share();
+}
+
+const SystemInventory& SystemInventoryPrefetcher::get() {
+    return result.get();
+}
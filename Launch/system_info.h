@@ -5,6 +5,7 @@
 #include <vector>
 #include <chrono>
 #include <fstream>
+#include <future>
 
 std::string getCurrentTimestamp();
 std::string getFormattedTime();
@@ -15,4 +16,35 @@ std::vector<std::string> getGpuInfo();
 std::string getSystemType();
 std::string getUnixVersion();
 
+// 崩溃日志中使用的系统信息
+struct SystemInventory {
+    std::string osVersion;
+    std::string cpu;
+    std::string memory;
+    std::vector<std::string> gpus;
+    std::string systemType;
+};
+
+// 逐项探测当前系统信息（较慢：Windows 上会查询 WMI，macOS 上会运行 system_profiler；Linux 上直接读取
+// sysfs 与 CPUID，不启动子进程）
+SystemInventory collectSystemInventory();
+
+// 标识当前内核与本次开机的键值，重启或升级系统后会变化
+std::string systemInventoryKey();
+
+bool loadSystemInventoryCache(const std::string& path, const std::string& key, SystemInventory& inventory);
+bool saveSystemInventoryCache(const std::string& path, const std::string& key, const SystemInventory& inventory);
+
+// 在后台线程中预先获取系统信息，优先使用与当前开机匹配的磁盘缓存
+class SystemInventoryPrefetcher {
+public:
+    explicit SystemInventoryPrefetcher(const std::string& cachePath);
+
+    // 等待后台获取完成并返回结果
+    const SystemInventory& get();
+
+private:
+    std::shared_future<SystemInventory> result;
+};
+
 #endif // SYSTEM_INFO_H
\ No newline at end of file
@@ -0,0 +1,232 @@
+#include "telemetry.h"
+
+#include "output_buffer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __linux__
+    #include "proc_fs.h"
+    #include <dirent.h>
+    #include <sys/stat.h>
+    #include <time.h>
+    #include <unistd.h>
+#endif
+
+ProcessTreeSampler::ProcessTreeSampler(int rootPid, size_t capacity)
+    : rootPid(rootPid), samples(std::max<size_t>(capacity, 1)) {
+#ifdef __linux__
+    ticksPerSecond = sysconf(_SC_CLK_TCK);
+    pageSize = sysconf(_SC_PAGESIZE);
+#endif
+}
+
+const TelemetrySample* ProcessTreeSampler::latest() const {
+    if (count == 0) {
+        return nullptr;
+    }
+    return &samples[(next + samples.size() - 1) % samples.size()];
+}
+
+double ProcessTreeSampler::selfCpuShare() const {
+    if (lastTimestampNs <= firstTimestampNs) {
+        return 0;
+    }
+    return static_cast<double>(selfCpu) / static_cast<double>(lastTimestampNs - firstTimestampNs);
+}
+
+#ifdef __linux__
+namespace {
+
+int64_t threadCpuNanos() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+// 读取 "key: value" 形式文件中某一项的数值
+uint64_t findField(const char* text, const char* key) {
+    const char* p = std::strstr(text, key);
+    if (!p) {
+        return 0;
+    }
+    p += std::strlen(key);
+    while (*p == ':' || *p == ' ' || *p == '\t') {
+        p++;
+    }
+    return std::strtoull(p, nullptr, 10);
+}
+
+uint32_t countFds(int pid) {
+    char path[64];
+    std::snprintf(path, sizeof(path), "/proc/%d/fd", pid);
+
+    // Linux 6.2 起 fd 目录的大小就是打开的文件数，免去遍历目录
+    struct stat st;
+    if (stat(path, &st) == 0 && st.st_size > 0) {
+        return static_cast<uint32_t>(st.st_size);
+    }
+
+    DIR* dir = opendir(path);
+    if (!dir) {
+        return 0;
+    }
+    uint32_t fds = 0;
+    while (dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] != '.') {
+            fds++;
+        }
+    }
+    closedir(dir);
+    return fds;
+}
+
+} // namespace
+
+#endif
+
+void ProcessTreeSampler::sample() {
+#ifdef __linux__
+    int64_t cpuStart = threadCpuNanos();
+
+    std::vector<int> pids;
+    pids.reserve(8);
+    collectProcessTree(rootPid, pids);
+
+    TelemetrySample current;
+    current.timestampNs = monotonicNanos();
+
+    uint64_t deltaTicks = 0;
+    std::map<int, uint64_t> cpuTicks;
+    char path[64];
+    char buffer[4096];
+
+    for (int pid : pids) {
+        std::snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+        if (readSmallFile(path, buffer, sizeof(buffer)) <= 0) {
+            continue; // 进程已退出
+        }
+
+        // 进程名可能包含空格和括号，从最后一个 ')' 之后开始解析；其后第一项是第 3 个字段
+        const char* p = std::strrchr(buffer, ')');
+        if (!p) {
+            continue;
+        }
+        p++;
+        unsigned long long fields[18] = {};
+        for (int field = 3; field <= 20; field++) {
+            while (*p == ' ') {
+                p++;
+            }
+            char* end = nullptr;
+            fields[field - 3] = std::strtoull(p, &end, 10);
+            if (end == p) {
+                // 第 3 个字段是状态字母
+                while (*p && *p != ' ') {
+                    p++;
+                }
+            } else {
+                p = end;
+            }
+        }
+        uint64_t ticks = fields[14 - 3] + fields[15 - 3];
+        current.threads += static_cast<uint32_t>(fields[20 - 3]);
+        current.processes++;
+
+        cpuTicks[pid] = ticks;
+        auto last = lastCpuTicks.find(pid);
+        if (last != lastCpuTicks.end() && ticks >= last->second) {
+            deltaTicks += ticks - last->second;
+        }
+
+        std::snprintf(path, sizeof(path), "/proc/%d/statm", pid);
+        if (readSmallFile(path, buffer, sizeof(buffer)) > 0) {
+            const char* resident = std::strchr(buffer, ' ');
+            if (resident) {
+                current.rssBytes += std::strtoull(resident + 1, nullptr, 10) * static_cast<uint64_t>(pageSize);
+            }
+        }
+
+        std::snprintf(path, sizeof(path), "/proc/%d/io", pid);
+        if (readSmallFile(path, buffer, sizeof(buffer)) > 0) {
+            current.readBytes += findField(buffer, "\nread_bytes");
+            current.writeBytes += findField(buffer, "\nwrite_bytes");
+        }
+
+        std::snprintf(path, sizeof(path), "/proc/%d/status", pid);
+        if (readSmallFile(path, buffer, sizeof(buffer)) > 0) {
+            current.contextSwitches += findField(buffer, "\nvoluntary_ctxt_switches") +
+                                       findField(buffer, "nonvoluntary_ctxt_switches");
+        }
+
+        current.fds += countFds(pid);
+    }
+
+    if (lastTimestampNs != 0 && current.timestampNs > lastTimestampNs && ticksPerSecond > 0) {
+        double seconds = (current.timestampNs - lastTimestampNs) / 1e9;
+        current.cpuPercent = static_cast<float>(deltaTicks * 100.0 / ticksPerSecond / seconds);
+    }
+    lastCpuTicks.swap(cpuTicks);
+    if (firstTimestampNs == 0) {
+        firstTimestampNs = current.timestampNs;
+    }
+    lastTimestampNs = current.timestampNs;
+
+    if (current.processes > 0) {
+        samples[next] = current;
+        next = (next + 1) % samples.size();
+        count = std::min(count + 1, samples.size());
+    }
+
+    selfCpu += threadCpuNanos() - cpuStart;
+#endif
+}
+
+void ProcessTreeSampler::writeTable(std::ostream& out, int64_t endTimestampNs, size_t maxRows) const {
+    if (count == 0 || maxRows == 0) {
+        return;
+    }
+
+    // 样本过多时按组合并：CPU 与内存取组内最大值，其余取组内最后一个样本
+    size_t stride = (count + maxRows - 1) / maxRows;
+
+    char line[160];
+    std::snprintf(line, sizeof(line), "%9s %7s %9s %5s %6s %6s %10s %10s %9s\n",
+                  "t(s)", "CPU%", "RSS(MB)", "proc", "thread", "fd", "read(MB)", "write(MB)", "ctxsw/s");
+    out << line;
+
+    size_t index = 0;
+    TelemetrySample group;
+    float groupCpu = 0;
+    uint64_t groupRss = 0;
+    const TelemetrySample* previous = nullptr;
+    TelemetrySample previousCopy;
+
+    forEachSample([&](const TelemetrySample& s) {
+        groupCpu = std::max(groupCpu, s.cpuPercent);
+        groupRss = std::max(groupRss, s.rssBytes);
+        group = s;
+        index++;
+        if (index % stride != 0 && index != count) {
+            return;
+        }
+
+        double ctxRate = 0;
+        if (previous && group.timestampNs > previous->timestampNs && group.contextSwitches >= previous->contextSwitches) {
+            ctxRate = (group.contextSwitches - previous->contextSwitches) / ((group.timestampNs - previous->timestampNs) / 1e9);
+        }
+
+        std::snprintf(line, sizeof(line), "%9.2f %7.1f %9.1f %5u %6u %6u %10.1f %10.1f %9.0f\n",
+                      (group.timestampNs - endTimestampNs) / 1e9, groupCpu, groupRss / 1048576.0,
+                      group.processes, group.threads, group.fds,
+                      group.readBytes / 1048576.0, group.writeBytes / 1048576.0, ctxRate);
+        out << line;
+
+        previousCopy = group;
+        previous = &previousCopy;
+        groupCpu = 0;
+        groupRss = 0;
+    });
+}
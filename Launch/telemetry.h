@@ -0,0 +1,65 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <vector>
+
+// 子进程及其全部后代进程在某一时刻的资源占用汇总
+struct TelemetrySample {
+    int64_t timestampNs = 0;     // 单调时钟
+    float cpuPercent = 0;        // 相对单个核心，可能超过 100
+    uint64_t rssBytes = 0;
+    uint32_t processes = 0;
+    uint32_t threads = 0;
+    uint32_t fds = 0;
+    uint64_t readBytes = 0;      // 累计值
+    uint64_t writeBytes = 0;     // 累计值
+    uint64_t contextSwitches = 0; // 累计值（自愿 + 非自愿）
+};
+
+// 定时读取 /proc/<pid>/stat、statm、io、status 与 fd 目录，
+// 把进程树的资源占用写入固定大小的时间序列环。仅在 Linux 上采集，其他平台上 sample() 不做任何事。
+class ProcessTreeSampler {
+public:
+    ProcessTreeSampler(int rootPid, size_t capacity);
+
+    // 采集一次，由监管循环的定时器调用
+    void sample();
+
+    // 按时间顺序遍历保留的样本
+    template <typename Visitor>
+    void forEachSample(Visitor visitor) const {
+        size_t start = (next + samples.size() - count) % samples.size();
+        for (size_t i = 0; i < count; i++) {
+            visitor(samples[(start + i) % samples.size()]);
+        }
+    }
+
+    size_t size() const { return count; }
+    const TelemetrySample* latest() const;
+
+    // 采样器自身消耗的 CPU 时间（纳秒），以及占单个核心的比例
+    int64_t selfCpuNs() const { return selfCpu; }
+    double selfCpuShare() const;
+
+    // 以紧凑表格的形式写出，时间列为相对 endTimestampNs 的秒数，最多 maxRows 行
+    void writeTable(std::ostream& out, int64_t endTimestampNs, size_t maxRows) const;
+
+private:
+    int rootPid;
+    std::vector<TelemetrySample> samples;
+    size_t next = 0;
+    size_t count = 0;
+
+    std::map<int, uint64_t> lastCpuTicks;  // pid -> 上次采样时的 utime + stime
+    int64_t firstTimestampNs = 0;
+    int64_t lastTimestampNs = 0;
+    int64_t selfCpu = 0;
+    long ticksPerSecond = 100;
+    long pageSize = 4096;
+};
+
+#endif // TELEMETRY_H